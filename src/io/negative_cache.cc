@@ -0,0 +1,154 @@
+// Copyright (c) 2015, Baidu.com, Inc. All Rights Reserved
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "io/negative_cache.h"
+
+#include <set>
+
+#include <gflags/gflags.h>
+
+#include "util/hash.h"
+#include "utils/counter.h"
+
+DECLARE_int64(tera_tabletnode_negative_cache_size);
+
+namespace tera {
+namespace io {
+
+// slots of the write sequences
+static const uint32_t kSlotNum = 4096;
+// memory of a cached key besides the key itself
+static const size_t kKeyOverhead = 64;
+// memory taken by the cached keys of all tablets in the tabletnode
+static Counter s_node_memory_size;
+// the caches of all tablets, never locked while a cache is locked
+static Mutex s_caches_mutex;
+static std::set<NegativeCache*> s_caches;
+
+NegativeCache::NegativeCache()
+    : m_sequence(0), m_clear_sequence(0),
+      m_slot_sequence(kSlotNum, 0), m_memory_size(0) {
+    MutexLock lock(&s_caches_mutex);
+    s_caches.insert(this);
+}
+
+NegativeCache::~NegativeCache() {
+    {
+        MutexLock lock(&s_caches_mutex);
+        s_caches.erase(this);
+    }
+    MutexLock lock(&m_mutex);
+    Evict(0);
+}
+
+uint64_t NegativeCache::GetSequence() const {
+    MutexLock lock(&m_mutex);
+    return m_sequence;
+}
+
+bool NegativeCache::Contains(const std::string& row_key) {
+    MutexLock lock(&m_mutex);
+    std::map<std::string, KeyList::iterator>::iterator it = m_index.find(row_key);
+    if (it == m_index.end()) {
+        return false;
+    }
+    m_keys.splice(m_keys.end(), m_keys, it->second);
+    return true;
+}
+
+void NegativeCache::Put(const std::string& row_key, uint64_t sequence) {
+    {
+        MutexLock lock(&m_mutex);
+        if (sequence < m_clear_sequence
+            || m_slot_sequence[Slot(row_key)] > sequence
+            || m_index.find(row_key) != m_index.end()) {
+            return;
+        }
+        m_index[row_key] = m_keys.insert(m_keys.end(), row_key);
+        m_memory_size += row_key.size() + kKeyOverhead;
+        s_node_memory_size.Add(row_key.size() + kKeyOverhead);
+    }
+    EvictNode();
+}
+
+void NegativeCache::Invalidate(const std::string& row_key) {
+    MutexLock lock(&m_mutex);
+    m_slot_sequence[Slot(row_key)] = ++m_sequence;
+    std::map<std::string, KeyList::iterator>::iterator it = m_index.find(row_key);
+    if (it != m_index.end()) {
+        m_memory_size -= row_key.size() + kKeyOverhead;
+        s_node_memory_size.Sub(row_key.size() + kKeyOverhead);
+        m_keys.erase(it->second);
+        m_index.erase(it);
+    }
+}
+
+void NegativeCache::Clear() {
+    MutexLock lock(&m_mutex);
+    m_clear_sequence = ++m_sequence;
+    Evict(0);
+}
+
+size_t NegativeCache::MemorySize() const {
+    MutexLock lock(&m_mutex);
+    return m_memory_size;
+}
+
+size_t NegativeCache::NodeMemorySize() {
+    return s_node_memory_size.Get();
+}
+
+void NegativeCache::EvictNode() {
+    int64_t max_size = FLAGS_tera_tabletnode_negative_cache_size << 10;
+    MutexLock lock(&s_caches_mutex);
+    while (s_node_memory_size.Get() > max_size) {
+        // charge the largest cache, down to the size of the second largest
+        // at most
+        NegativeCache* largest = NULL;
+        size_t largest_size = 0;
+        size_t second_size = 0;
+        std::set<NegativeCache*>::iterator it = s_caches.begin();
+        for (; it != s_caches.end(); ++it) {
+            size_t size = (*it)->MemorySize();
+            if (size > largest_size) {
+                second_size = largest_size;
+                largest_size = size;
+                largest = *it;
+            } else if (size > second_size) {
+                second_size = size;
+            }
+        }
+        if (largest == NULL) {
+            break;
+        }
+        size_t over_size = s_node_memory_size.Get() - max_size;
+        size_t target_size = largest_size > over_size ? largest_size - over_size : 0;
+        if (target_size < second_size) {
+            target_size = second_size;
+        }
+        if (target_size >= largest_size) {
+            target_size = largest_size - 1;
+        }
+        MutexLock cache_lock(&largest->m_mutex);
+        largest->Evict(target_size);
+    }
+}
+
+void NegativeCache::Evict(size_t max_size) {
+    m_mutex.AssertHeld();
+    while (!m_keys.empty() && m_memory_size > max_size) {
+        size_t key_size = m_keys.front().size() + kKeyOverhead;
+        m_memory_size -= key_size;
+        s_node_memory_size.Sub(key_size);
+        m_index.erase(m_keys.front());
+        m_keys.pop_front();
+    }
+}
+
+uint32_t NegativeCache::Slot(const std::string& row_key) const {
+    return leveldb::Hash(row_key.data(), row_key.size(), 0) % kSlotNum;
+}
+
+} // namespace io
+} // namespace tera
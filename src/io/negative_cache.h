@@ -0,0 +1,82 @@
+// Copyright (c) 2015, Baidu.com, Inc. All Rights Reserved
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef TERA_IO_NEGATIVE_CACHE_H_
+#define TERA_IO_NEGATIVE_CACHE_H_
+
+#include <stdint.h>
+
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "common/mutex.h"
+
+namespace tera {
+namespace io {
+
+// Remembers the row keys a tablet is known not to hold, so that a repeated
+// read of an absent row is answered without a lookup in every locality
+// group and level.
+//
+// A read takes a sequence by GetSequence() before it looks the row up, and
+// passes it to Put() if the row is not found. Every write of a row bumps
+// the sequence of the slot the row hashes to, like a one-hash counting
+// bloom filter of recent writes, and Put() refuses a key whose slot was
+// written after the read began. So a key never stays cached after a write
+// that the read missed.
+//
+// The memory of the caches is limited for the whole tabletnode: once the
+// node is over the limit, the largest cache evicts its least recently hit
+// keys.
+class NegativeCache {
+public:
+    NegativeCache();
+    ~NegativeCache();
+
+    uint64_t GetSequence() const;
+
+    // whether "row_key" is known to be absent
+    bool Contains(const std::string& row_key);
+
+    // cache "row_key" as absent, as read at "sequence"
+    void Put(const std::string& row_key, uint64_t sequence);
+
+    // must be called after "row_key" is written
+    void Invalidate(const std::string& row_key);
+
+    // forget all keys, e.g. after files are ingested into the tablet
+    void Clear();
+
+    // memory (in bytes) taken by cached keys
+    size_t MemorySize() const;
+
+    // memory (in bytes) taken by the cached keys of all caches
+    static size_t NodeMemorySize();
+
+private:
+    typedef std::list<std::string> KeyList;
+
+    // evict the least recently hit keys until the cache is within "max_size"
+    void Evict(size_t max_size);
+    // evict keys of the largest caches until the node is within the limit
+    static void EvictNode();
+    uint32_t Slot(const std::string& row_key) const;
+
+    mutable Mutex m_mutex;
+    uint64_t m_sequence;
+    uint64_t m_clear_sequence;
+    // the sequence of the last write to each slot
+    std::vector<uint64_t> m_slot_sequence;
+    // least recently hit keys first
+    KeyList m_keys;
+    std::map<std::string, KeyList::iterator> m_index;
+    size_t m_memory_size;
+};
+
+} // namespace io
+} // namespace tera
+
+#endif // TERA_IO_NEGATIVE_CACHE_H_
@@ -0,0 +1,86 @@
+// Copyright (c) 2015, Baidu.com, Inc. All Rights Reserved
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "io/scan_cursor_cache.h"
+
+#include <gflags/gflags.h>
+
+#include "utils/timer.h"
+
+DECLARE_int32(tera_tabletnode_scan_cursor_cache_num);
+DECLARE_int64(tera_tabletnode_scan_cursor_cache_timeout);
+
+namespace tera {
+namespace io {
+
+ScanCursorCache::ScanCursorCache() {}
+
+ScanCursorCache::~ScanCursorCache() {
+    Clear();
+}
+
+leveldb::Iterator* ScanCursorCache::Get(const std::string& key,
+                                        leveldb::CompactStrategy** strategy) {
+    MutexLock lock(&m_mutex);
+    Evict(FLAGS_tera_tabletnode_scan_cursor_cache_num, get_micros() / 1000);
+    std::map<std::string, CursorList::iterator>::iterator it = m_index.find(key);
+    if (it == m_index.end()) {
+        return NULL;
+    }
+    leveldb::Iterator* cursor = it->second->it;
+    *strategy = it->second->strategy;
+    m_cursors.erase(it->second);
+    m_index.erase(it);
+    return cursor;
+}
+
+void ScanCursorCache::Put(const std::string& key, leveldb::Iterator* it,
+                          leveldb::CompactStrategy* strategy) {
+    MutexLock lock(&m_mutex);
+    std::map<std::string, CursorList::iterator>::iterator old = m_index.find(key);
+    if (old != m_index.end()) {
+        delete old->second->it;
+        delete old->second->strategy;
+        m_cursors.erase(old->second);
+        m_index.erase(old);
+    }
+    Cursor cursor;
+    cursor.key = key;
+    cursor.it = it;
+    cursor.strategy = strategy;
+    cursor.put_time = get_micros() / 1000;
+    m_index[key] = m_cursors.insert(m_cursors.end(), cursor);
+    Evict(FLAGS_tera_tabletnode_scan_cursor_cache_num, cursor.put_time);
+}
+
+void ScanCursorCache::EvictExpired() {
+    MutexLock lock(&m_mutex);
+    Evict(FLAGS_tera_tabletnode_scan_cursor_cache_num, get_micros() / 1000);
+}
+
+void ScanCursorCache::Clear() {
+    MutexLock lock(&m_mutex);
+    Evict(0, 0);
+}
+
+size_t ScanCursorCache::Size() const {
+    MutexLock lock(&m_mutex);
+    return m_cursors.size();
+}
+
+void ScanCursorCache::Evict(size_t max_num, int64_t now) {
+    m_mutex.AssertHeld();
+    int64_t expire_time = now - FLAGS_tera_tabletnode_scan_cursor_cache_timeout;
+    while (!m_cursors.empty()
+           && (m_cursors.size() > max_num
+               || m_cursors.front().put_time < expire_time)) {
+        delete m_cursors.front().it;
+        delete m_cursors.front().strategy;
+        m_index.erase(m_cursors.front().key);
+        m_cursors.pop_front();
+    }
+}
+
+} // namespace io
+} // namespace tera
@@ -0,0 +1,69 @@
+// Copyright (c) 2015, Baidu.com, Inc. All Rights Reserved
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef TERA_IO_SCAN_CURSOR_CACHE_H_
+#define TERA_IO_SCAN_CURSOR_CACHE_H_
+
+#include <list>
+#include <map>
+#include <string>
+
+#include "common/mutex.h"
+#include "leveldb/compact_strategy.h"
+#include "leveldb/iterator.h"
+
+namespace tera {
+namespace io {
+
+// Keeps the iterators of paged scans, so that the next page of a scan
+// continues on the iterator where the last page stopped, instead of
+// seeking again through all levels. A page may stop in the middle of a
+// row, so the compact strategy which has seen the beginning of the row is
+// cached along with the iterator. An iterator is keyed by the scan
+// options and the position the next page starts at, and is evicted
+// when it is not resumed in time or the cache is full.
+class ScanCursorCache {
+public:
+    ScanCursorCache();
+    ~ScanCursorCache();
+
+    // take out the iterator cached for "key" and its compact strategy,
+    // NULL if not found
+    leveldb::Iterator* Get(const std::string& key,
+                           leveldb::CompactStrategy** strategy);
+
+    // cache "it" and "strategy" for "key", the cache takes the ownership
+    // of both
+    void Put(const std::string& key, leveldb::Iterator* it,
+             leveldb::CompactStrategy* strategy);
+
+    // delete the iterators not resumed in time
+    void EvictExpired();
+
+    // delete all cached iterators, must be called before the db is closed
+    void Clear();
+
+    size_t Size() const;
+
+private:
+    struct Cursor {
+        std::string key;
+        leveldb::Iterator* it;
+        leveldb::CompactStrategy* strategy;
+        int64_t put_time;
+    };
+    typedef std::list<Cursor> CursorList;
+
+    void Evict(size_t max_num, int64_t now);
+
+    mutable Mutex m_mutex;
+    // in the order of put time
+    CursorList m_cursors;
+    std::map<std::string, CursorList::iterator> m_index;
+};
+
+} // namespace io
+} // namespace tera
+
+#endif // TERA_IO_SCAN_CURSOR_CACHE_H_
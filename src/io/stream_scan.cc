@@ -12,6 +12,7 @@
 #include "glog/logging.h"
 
 #include "utils/atomic.h"
+#include "utils/timer.h"
 
 DECLARE_int64(tera_io_scan_stream_task_max_num);
 DECLARE_int64(tera_io_scan_stream_task_pending_time);
@@ -21,16 +22,16 @@ DECLARE_int32(tera_io_retry_period);
 namespace tera {
 namespace io {
 
-StreamScan::StreamScan()
-    : m_shutdown(false), m_is_completed(false), m_status(kTabletNodeOk),
-      m_ref_count(0) {}
+StreamScan::StreamScan(const ScanTabletRequest& request)
+    : m_iterator(NULL), m_compact_strategy(NULL), m_data_id(0), m_request(request), m_producing(false),
+      m_last_active_time(get_micros()), m_is_completed(false),
+      m_status(kTabletNodeOk), m_ref_count(0) {}
 
 StreamScan::~StreamScan() {
     MutexLock lock(&m_mutex);
-    m_shutdown = true;
-    m_push_event.Set();
-
     DropTask();
+    delete m_compact_strategy;
+    delete m_iterator;
 }
 
 bool StreamScan::PushTask(uint64_t sequence_id, ScanTabletResponse* response,
@@ -42,7 +43,7 @@ bool StreamScan::PushTask(uint64_t sequence_id, ScanTabletResponse* response,
     }
     Task* task = new Task(response, done);
     m_task_queue.push(task);
-    m_push_event.Set();
+    m_last_active_time = get_micros();
 
     VLOG(10) << "push task, queue size: " << m_task_queue.size();
     return true;
@@ -62,26 +63,13 @@ void StreamScan::DropTask() {
 bool StreamScan::PushData(uint64_t data_id, const RowResult& result) {
     VLOG(10) << "begin push data, data id: " << data_id;
     Task* task = NULL;
-    while (task == NULL) {
-        if (m_shutdown) {
+    {
+        MutexLock lock(&m_mutex);
+        if (m_task_queue.empty()) {
             return false;
         }
-        {
-            MutexLock lock(&m_mutex);
-            if (m_task_queue.size() != 0) {
-                task = m_task_queue.front();
-                if (task) {
-                    m_task_queue.pop();
-                }
-            }
-        }
-        if (!task && !m_shutdown) {
-            LOG(INFO) << "not task, waiting ...";
-            if (!m_push_event.TimeWait(FLAGS_tera_io_scan_stream_task_pending_time * 1000)) {
-                LOG(INFO) << "timeout, clean the session";
-                return false;
-            }
-        }
+        task = m_task_queue.front();
+        m_task_queue.pop();
     }
 
     VLOG(10) << "push data, sequence id: " << task->first->sequence_id()
@@ -96,6 +84,30 @@ bool StreamScan::PushData(uint64_t data_id, const RowResult& result) {
     return true;
 }
 
+bool StreamScan::StartProduce() {
+    MutexLock lock(&m_mutex);
+    if (m_producing || m_task_queue.empty()) {
+        return false;
+    }
+    m_producing = true;
+    return true;
+}
+
+bool StreamScan::FinishProduce() {
+    MutexLock lock(&m_mutex);
+    if (!m_task_queue.empty()) {
+        return false;
+    }
+    m_producing = false;
+    m_last_active_time = get_micros();
+    return true;
+}
+
+int64_t StreamScan::GetLastActiveTime() {
+    MutexLock lock(&m_mutex);
+    return m_last_active_time;
+}
+
 void StreamScan::SetCompleted(bool completed) {
     m_is_completed = completed;
 }
@@ -120,53 +132,49 @@ int32_t StreamScan::GetRef() {
 
 StreamScanManager::StreamScanManager() {}
 
-StreamScanManager::~StreamScanManager() {}
+StreamScanManager::~StreamScanManager() {
+    Clear();
+}
 
-void StreamScanManager::PushTask(const ScanTabletRequest* request,
-                                 ScanTabletResponse* response,
-                                 google::protobuf::Closure* done,
-                                 bool* is_first) {
+StreamScan* StreamScanManager::PushTask(const ScanTabletRequest* request,
+                                       ScanTabletResponse* response,
+                                       google::protobuf::Closure* done) {
     VLOG(10) << "push task for session id: " << request->session_id()
         << ", sequence id: " << request->sequence_id();
     StreamScan* scan = NULL;
     {
         MutexLock lock(&m_mutex);
+        RemoveIdleSessions();
         std::map<uint64_t, StreamScan*>::iterator it =
             m_session_list.find(request->session_id());
         if (it == m_session_list.end()) {
             if (request->part_of_session() == false) {
-                scan = m_session_list[request->session_id()] = new StreamScan;
-                *is_first = true;
+                scan = m_session_list[request->session_id()] = new StreamScan(*request);
                 VLOG(6) << "new session id: " << request->session_id();
             } else {
                 DropInvalidTask(request, response, done);
                 VLOG(10) << "drop invalid rpc pack";
-                return;
+                return NULL;
             }
         } else {
             scan = it->second;
         }
+        scan->AddRef();
     }
     CHECK(scan != NULL);
-    scan->AddRef();
     if (!scan->PushTask(request->sequence_id(), response, done)) {
         // too busy
         LOG(WARNING) << "session: " << request->sequence_id() << " is too busy";
         response->set_status(kTabletNodeIsBusy);
         done->Run();
+        scan->DecRef();
+        return NULL;
     }
-    scan->DecRef();
+    return scan;
 }
 
-StreamScan* StreamScanManager::GetStream(uint64_t session_id) {
-    MutexLock lock(&m_mutex);
-    std::map<uint64_t, StreamScan*>::iterator it =
-        m_session_list.find(session_id);
-    if (it != m_session_list.end()) {
-        it->second->AddRef();
-        return it->second;
-    }
-    return NULL;
+void StreamScanManager::ReleaseStream(StreamScan* scan) {
+    scan->DecRef();
 }
 
 void StreamScanManager::RemoveSession(uint64_t session_id) {
@@ -188,6 +196,39 @@ void StreamScanManager::RemoveSession(uint64_t session_id) {
     m_session_list.erase(it);
 }
 
+void StreamScanManager::Clear() {
+    MutexLock lock(&m_mutex);
+    std::map<uint64_t, StreamScan*>::iterator it = m_session_list.begin();
+    for (; it != m_session_list.end(); ++it) {
+        delete it->second;
+    }
+    m_session_list.clear();
+}
+
+void StreamScanManager::ReleaseIdleSessions() {
+    MutexLock lock(&m_mutex);
+    RemoveIdleSessions();
+}
+
+void StreamScanManager::RemoveIdleSessions() {
+    m_mutex.AssertHeld();
+    int64_t expire_time = get_micros()
+        - FLAGS_tera_io_scan_stream_task_pending_time * 1000000;
+    std::map<uint64_t, StreamScan*>::iterator it = m_session_list.begin();
+    while (it != m_session_list.end()) {
+        // a session without reference is parked, and no one can take
+        // a new reference of it while m_mutex is held
+        if (it->second->GetRef() == 0
+            && it->second->GetLastActiveTime() < expire_time) {
+            LOG(INFO) << "timeout, clean the session: " << it->first;
+            delete it->second;
+            m_session_list.erase(it++);
+        } else {
+            ++it;
+        }
+    }
+}
+
 void StreamScanManager::DropInvalidTask(const ScanTabletRequest* request,
                                         ScanTabletResponse* response,
                                         google::protobuf::Closure* done) {
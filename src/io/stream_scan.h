@@ -9,9 +9,11 @@
 
 #include <map>
 #include <queue>
+#include <string>
 
-#include "common/event.h"
 #include "common/mutex.h"
+#include "leveldb/compact_strategy.h"
+#include "leveldb/iterator.h"
 
 #include "proto/table_meta.pb.h"
 #include "proto/tabletnode_rpc.pb.h"
@@ -19,21 +21,45 @@
 namespace tera {
 namespace io {
 
+// The state of a streaming scan session. Rpcs of the session are queued
+// as tasks, and a chunk of rows is produced for each of them on the
+// iterator parked here, by whichever scan thread holds the producer role.
+// No thread waits for the client, the session is parked while no task is
+// queued.
 class StreamScan {
 public:
-    StreamScan();
+    explicit StreamScan(const ScanTabletRequest& request);
     ~StreamScan();
 
     bool PushTask(uint64_t sequence_id, ScanTabletResponse* request,
                   google::protobuf::Closure* done);
     void DropTask();
 
+    // answer the first queued task with "result"
     bool PushData(uint64_t data_id, const RowResult& result);
 
+    // take the producer role if a task is queued and no other thread holds it
+    bool StartProduce();
+    // give up the producer role if no task is queued, return false otherwise
+    bool FinishProduce();
+
     void SetCompleted(bool completed);
 
     void SetStatusCode(StatusCode status);
 
+    // the request that created the session
+    const ScanTabletRequest& GetRequest() const { return m_request; }
+
+    // only accessed by the producer
+    leveldb::Iterator* m_iterator;
+    // has seen all records before m_iterator
+    leveldb::CompactStrategy* m_compact_strategy;
+    std::string m_start_tera_key;
+    std::string m_end_row_key;
+    uint64_t m_data_id;
+
+    int64_t GetLastActiveTime();
+
     int32_t AddRef();
     int32_t DecRef();
     int32_t GetRef();
@@ -43,8 +69,9 @@ public:
 
 private:
     mutable Mutex m_mutex;
-    AutoResetEvent m_push_event;
-    bool m_shutdown;
+    const ScanTabletRequest m_request;
+    bool m_producing;
+    int64_t m_last_active_time;
 
     std::queue<Task*> m_task_queue;
     bool m_is_completed;
@@ -58,20 +85,31 @@ public:
     StreamScanManager();
     ~StreamScanManager();
 
-    void PushTask(const ScanTabletRequest* request,
-                  ScanTabletResponse* response,
-                  google::protobuf::Closure* done,
-                  bool* is_first);
+    // queue the rpc to its session, return the session with a reference
+    // held, or NULL if the rpc is already answered
+    StreamScan* PushTask(const ScanTabletRequest* request,
+                         ScanTabletResponse* response,
+                         google::protobuf::Closure* done);
 
-    StreamScan* GetStream(uint64_t session_id);
+    void ReleaseStream(StreamScan* scan);
 
+    // remove a session, the caller holds a reference of it
     void RemoveSession(uint64_t session_id);
 
+    // remove all sessions, must be called before the db is closed
+    void Clear();
+
+    // remove the parked sessions not resumed by the client in time
+    void ReleaseIdleSessions();
+
 private:
     void DropInvalidTask(const ScanTabletRequest* request,
                          ScanTabletResponse* response,
                          google::protobuf::Closure* done);
 
+    // remove the sessions not resumed by the client in time
+    void RemoveIdleSessions();
+
 private:
     mutable Mutex m_mutex;
     std::map<uint64_t, StreamScan*> m_session_list;
@@ -5,9 +5,13 @@
 #include "io/tablet_io.h"
 
 #include <stdint.h>
+
+#include <algorithm>
+
 #include <gflags/gflags.h>
 #include <glog/logging.h>
 
+#include "common/base/string_number.h"
 #include "common/this_thread.h"
 #include "io/coding.h"
 #include "io/default_compact_strategy.h"
@@ -33,8 +37,13 @@
 DECLARE_string(tera_leveldb_env_type);
 DECLARE_int64(tera_tablet_log_file_size);
 DECLARE_int64(tera_tablet_write_buffer_size);
+DECLARE_int32(tera_tablet_max_imm_memtable_num);
 DECLARE_int64(tera_tablet_write_block_size);
 DECLARE_int32(tera_tablet_level0_file_limit);
+DECLARE_int32(tera_tablet_level0_file_throttle);
+DECLARE_int64(tera_tablet_pending_compaction_throttle_size);
+DECLARE_int64(tera_tablet_pending_compaction_limit_size);
+DECLARE_int32(tera_tablet_max_write_delay);
 DECLARE_int32(tera_tablet_max_block_log_number);
 DECLARE_int64(tera_tablet_write_log_time_out);
 DECLARE_bool(tera_log_async_mode);
@@ -57,10 +66,19 @@ DECLARE_int32(tera_leveldb_env_dfs_seek_latency);
 DECLARE_int32(tera_leveldb_max_open_files);
 
 DECLARE_bool(tera_tablet_use_memtable_on_leveldb);
+DECLARE_bool(tera_tablet_use_concurrent_memtable);
+DECLARE_int32(tera_tabletnode_compress_thread_num);
+DECLARE_int32(tera_tabletnode_log_recover_thread_num);
+DECLARE_bool(tera_tablet_kv_memtable_hash_index);
+DECLARE_int32(tera_tablet_load_sample_interval);
 DECLARE_int64(tera_tablet_memtable_ldb_write_buffer_size);
 DECLARE_int64(tera_tablet_memtable_ldb_block_size);
+DECLARE_int64(tera_tablet_prewarm_data_size);
+DECLARE_int32(tera_tabletnode_scan_cursor_cache_num);
+DECLARE_int64(tera_tabletnode_negative_cache_size);
 
 extern tera::Counter row_read_delay;
+extern tera::Counter negative_cache_hit_counter;
 
 namespace tera {
 namespace io {
@@ -91,9 +109,11 @@ TabletIO::TabletIO()
       m_compact_status(kTableNotCompact),
       m_status(kNotInit),
       m_ref_count(1), m_db_ref_count(0), m_db(NULL),
+      m_warm_handle(NULL), m_prewarm_io(NULL),
       m_mem_store_activated(false),
       m_kv_only(false),
-      m_key_operator(NULL) {
+      m_key_operator(NULL),
+      m_sample_pos(0) {
 }
 
 TabletIO::~TabletIO() {
@@ -103,8 +123,17 @@ TabletIO::~TabletIO() {
             delete m_async_writer;
             m_async_writer = NULL;
         }
+        m_scan_cursor_cache.Clear();
+        m_stream_scan.Clear();
+        m_negative_cache.Clear();
         delete m_db;
     }
+    if (m_prewarm_io != NULL) {
+        m_prewarm_io->DecRef();
+    }
+    if (m_warm_handle != NULL) {
+        ReleasePrewarm();
+    }
 }
 
 std::string TabletIO::GetTableName() const {
@@ -162,6 +191,134 @@ bool TabletIO::Load(const TableSchema& schema,
         m_db_ref_count++;
     }
 
+    SetupOptions(schema, key_start, key_end, parent_tablets,
+                 logger, block_cache, table_cache);
+
+    m_tablet_path = FLAGS_tera_tabletnode_path_prefix + path;
+    LOG(INFO) << "[Load] Start Open " << m_tablet_path;
+    // recover snapshot
+    std::map<uint64_t, uint64_t>::iterator it = snapshots.begin();
+    for (; it != snapshots.end(); ++it) {
+        id_to_snapshot_num_[it->first] = it->second;
+        m_ldb_options.snapshots_sequence.push_back(it->second);
+    }
+    leveldb::Status db_status = leveldb::DB::Open(m_ldb_options, m_tablet_path, &m_db);
+    if (!db_status.ok()) {
+        LOG(ERROR) << "fail to open table: " << m_tablet_path
+            << ", " << db_status.ToString() << ", repair it";
+        db_status = leveldb::RepairDB(m_tablet_path, m_ldb_options);
+        if (db_status.ok()) {
+            db_status = leveldb::DB::Open(m_ldb_options, m_tablet_path, &m_db);
+        }
+    }
+
+    if (!db_status.ok()) {
+        LOG(ERROR) << "fail to open table: " << m_tablet_path
+            << ", " << db_status.ToString();
+        {
+            MutexLock lock(&m_mutex);
+            m_status = kNotInit;
+            m_db_ref_count--;
+        }
+        SetStatusCode(db_status, status);
+//         delete m_ldb_options.env;
+        return false;
+    }
+
+    m_start_key = key_start;
+    m_end_key = key_end;
+
+    m_async_writer = new TabletWriter(this);
+    m_async_writer->Start();
+
+    {
+        MutexLock lock(&m_mutex);
+        m_status = kReady;
+        m_db_ref_count--;
+    }
+
+    LOG(INFO) << "[Load] Load " << m_tablet_path << " done";
+    return true;
+}
+
+bool TabletIO::Prewarm(const TableSchema& schema,
+                       const std::string& key_start,
+                       const std::string& key_end,
+                       const std::string& path,
+                       const std::vector<uint64_t>& parent_tablets,
+                       leveldb::Logger* logger,
+                       leveldb::Cache* block_cache,
+                       leveldb::TableCache* table_cache,
+                       StatusCode* status) {
+    {
+        MutexLock lock(&m_mutex);
+        if (m_status != kNotInit || m_warm_handle != NULL) {
+            SetStatusCode(m_status, status);
+            return false;
+        }
+        m_status = kOnLoad;
+    }
+
+    SetupOptions(schema, key_start, key_end, parent_tablets,
+                 logger, block_cache, table_cache);
+    m_tablet_path = FLAGS_tera_tabletnode_path_prefix + path;
+    LOG(INFO) << "[Prewarm] start " << m_tablet_path;
+    leveldb::Status db_status;
+    if (m_mem_store_activated) {
+        // memory store has its own block cache for each load
+        db_status = leveldb::Status::NotSupported("prewarm memory store");
+    } else {
+        db_status = leveldb::WarmUpDB(m_tablet_path, m_ldb_options,
+                                      FLAGS_tera_tablet_prewarm_data_size << 20,
+                                      &m_warm_handle);
+    }
+    if (db_status.ok()) {
+        m_start_key = key_start;
+        m_end_key = key_end;
+        LOG(INFO) << "[Prewarm] done " << m_tablet_path;
+    } else {
+        LOG(WARNING) << "[Prewarm] fail to warm up " << m_tablet_path
+            << ", " << db_status.ToString();
+        SetStatusCode(db_status, status);
+        ReleasePrewarm();
+    }
+
+    {
+        MutexLock lock(&m_mutex);
+        m_status = kNotInit;
+    }
+    return db_status.ok();
+}
+
+void TabletIO::SetPrewarmed(TabletIO* prewarm_io) {
+    prewarm_io->AddRef();
+    MutexLock lock(&m_mutex);
+    if (m_prewarm_io != NULL) {
+        m_prewarm_io->DecRef();
+    }
+    m_prewarm_io = prewarm_io;
+}
+
+void TabletIO::ReleasePrewarm() {
+    // tables cached by the warm up refer to its options
+    delete m_warm_handle;
+    m_warm_handle = NULL;
+    delete m_ldb_options.filter_policy;
+    m_ldb_options.filter_policy = NULL;
+    if (m_mem_store_activated) {
+        delete m_ldb_options.block_cache;
+        m_mem_store_activated = false;
+    }
+    TearDownOptionsForLG();
+}
+
+void TabletIO::SetupOptions(const TableSchema& schema,
+                            const std::string& key_start,
+                            const std::string& key_end,
+                            const std::vector<uint64_t>& parent_tablets,
+                            leveldb::Logger* logger,
+                            leveldb::Cache* block_cache,
+                            leveldb::TableCache* table_cache) {
     // any type of table should have at least 1lg+1cf.
     m_table_schema.CopyFrom(schema);
     if (m_table_schema.locality_groups_size() == 0) {
@@ -196,7 +353,14 @@ bool TabletIO::Load(const TableSchema& schema,
     m_ldb_options.key_start = m_raw_start_key;
     m_ldb_options.key_end = m_raw_end_key;
     m_ldb_options.write_buffer_size = FLAGS_tera_tablet_write_buffer_size * 1024 * 1024;
+    m_ldb_options.max_imm_num = FLAGS_tera_tablet_max_imm_memtable_num;
     m_ldb_options.l0_slowdown_writes_trigger = FLAGS_tera_tablet_level0_file_limit;
+    m_ldb_options.l0_throttle_writes_trigger = FLAGS_tera_tablet_level0_file_throttle;
+    m_ldb_options.pending_compaction_throttle_bytes =
+        FLAGS_tera_tablet_pending_compaction_throttle_size << 20;
+    m_ldb_options.pending_compaction_limit_bytes =
+        FLAGS_tera_tablet_pending_compaction_limit_size << 20;
+    m_ldb_options.max_write_delay_micros = FLAGS_tera_tablet_max_write_delay * 1000ULL;
     m_ldb_options.block_size = FLAGS_tera_tablet_write_block_size * 1024;
     m_ldb_options.max_block_log_number = FLAGS_tera_tablet_max_block_log_number;
     m_ldb_options.write_log_time_out = FLAGS_tera_tablet_write_log_time_out;
@@ -206,6 +370,9 @@ bool TabletIO::Load(const TableSchema& schema,
     m_ldb_options.max_open_files = FLAGS_tera_leveldb_max_open_files;
 
     m_ldb_options.use_memtable_on_leveldb = FLAGS_tera_tablet_use_memtable_on_leveldb;
+    m_ldb_options.use_concurrent_memtable = FLAGS_tera_tablet_use_concurrent_memtable;
+    m_ldb_options.parallel_compression_threads = FLAGS_tera_tabletnode_compress_thread_num;
+    m_ldb_options.parallel_recover_threads = FLAGS_tera_tabletnode_log_recover_thread_num;
     m_ldb_options.memtable_ldb_write_buffer_size =
             FLAGS_tera_tablet_memtable_ldb_write_buffer_size * 1024 * 1024;
     m_ldb_options.memtable_ldb_block_size = FLAGS_tera_tablet_memtable_ldb_block_size * 1024;
@@ -235,54 +402,10 @@ bool TabletIO::Load(const TableSchema& schema,
     } else { // Readable-Table && KV-Pair-Without-TTL
         m_ldb_options.raw_key_format = leveldb::kReadable;
         m_ldb_options.comparator = leveldb::BytewiseComparator();
+        // bytewise keys of kv table can be indexed by hash
+        m_ldb_options.memtable_hash_index = m_kv_only && FLAGS_tera_tablet_kv_memtable_hash_index;
     }
     SetupOptionsForLG();
-
-    m_tablet_path = FLAGS_tera_tabletnode_path_prefix + path;
-    LOG(INFO) << "[Load] Start Open " << m_tablet_path;
-    // recover snapshot
-    std::map<uint64_t, uint64_t>::iterator it = snapshots.begin();
-    for (; it != snapshots.end(); ++it) {
-        id_to_snapshot_num_[it->first] = it->second;
-        m_ldb_options.snapshots_sequence.push_back(it->second);
-    }
-    leveldb::Status db_status = leveldb::DB::Open(m_ldb_options, m_tablet_path, &m_db);
-    if (!db_status.ok()) {
-        LOG(ERROR) << "fail to open table: " << m_tablet_path
-            << ", " << db_status.ToString() << ", repair it";
-        db_status = leveldb::RepairDB(m_tablet_path, m_ldb_options);
-        if (db_status.ok()) {
-            db_status = leveldb::DB::Open(m_ldb_options, m_tablet_path, &m_db);
-        }
-    }
-
-    if (!db_status.ok()) {
-        LOG(ERROR) << "fail to open table: " << m_tablet_path
-            << ", " << db_status.ToString();
-        {
-            MutexLock lock(&m_mutex);
-            m_status = kNotInit;
-            m_db_ref_count--;
-        }
-        SetStatusCode(db_status, status);
-//         delete m_ldb_options.env;
-        return false;
-    }
-
-    m_start_key = key_start;
-    m_end_key = key_end;
-
-    m_async_writer = new TabletWriter(this);
-    m_async_writer->Start();
-
-    {
-        MutexLock lock(&m_mutex);
-        m_status = kReady;
-        m_db_ref_count--;
-    }
-
-    LOG(INFO) << "[Load] Load " << m_tablet_path << " done";
-    return true;
 }
 
 bool TabletIO::Unload(StatusCode* status) {
@@ -310,6 +433,9 @@ bool TabletIO::Unload(StatusCode* status) {
             << ", try again unload: " << retry++ << " " << m_tablet_path;
         ThisThread::Sleep(FLAGS_tera_io_retry_period);
     }
+    m_scan_cursor_cache.Clear();
+    m_stream_scan.Clear();
+    m_negative_cache.Clear();
 
     LOG(INFO) << "[Unload] stop async writer " << m_tablet_path;
     m_async_writer->Stop();
@@ -325,6 +451,10 @@ bool TabletIO::Unload(StatusCode* status) {
 
     delete m_db;
     m_db = NULL;
+    if (m_prewarm_io != NULL) {
+        m_prewarm_io->DecRef();
+        m_prewarm_io = NULL;
+    }
 
     delete m_ldb_options.filter_policy;
     if (m_mem_store_activated) {
@@ -366,6 +496,15 @@ bool TabletIO::Split(std::string* split_key, StatusCode* status) {
         return false;
     }
 
+    if (!split_key->empty() && *split_key > m_start_key
+        && (m_end_key.empty() || *split_key < m_end_key)) {
+        VLOG(5) << "split by given key: [" << DebugString(*split_key) << "]";
+        MutexLock lock(&m_mutex);
+        m_status = kSplited;
+        m_db_ref_count--;
+        return true;
+    }
+
     std::string raw_split_key;
     if (!m_db->FindSplitKey(m_raw_start_key, m_raw_end_key, 0.5,
                             &raw_split_key)) {
@@ -418,6 +557,42 @@ bool TabletIO::Split(std::string* split_key, StatusCode* status) {
     return true;
 }
 
+bool TabletIO::FindLoadSplitKey(std::string* split_key) {
+    std::vector<std::string> samples;
+    {
+        MutexLock lock(&m_sample_mutex);
+        samples = m_row_samples;
+    }
+    // too few samples to tell the load distribution
+    if (samples.size() < 64) {
+        return false;
+    }
+    std::vector<std::string>::iterator mid = samples.begin() + samples.size() / 2;
+    std::nth_element(samples.begin(), mid, samples.end());
+    if (*mid <= m_start_key || (!m_end_key.empty() && *mid >= m_end_key)) {
+        return false;
+    }
+    VLOG(5) << "load split key of " << m_tablet_path << ": ["
+        << DebugString(*mid) << "], samples: " << samples.size();
+    *split_key = *mid;
+    return true;
+}
+
+void TabletIO::SampleRowKey(const std::string& row_key) {
+    const int32_t kMaxRowSamples = 1024;
+    int32_t interval = FLAGS_tera_tablet_load_sample_interval;
+    if (interval <= 0 || m_row_access_count.Inc() % interval != 0) {
+        return;
+    }
+    MutexLock lock(&m_sample_mutex);
+    if (m_row_samples.size() < static_cast<size_t>(kMaxRowSamples)) {
+        m_row_samples.push_back(row_key);
+    } else {
+        m_row_samples[m_sample_pos] = row_key;
+        m_sample_pos = (m_sample_pos + 1) % kMaxRowSamples;
+    }
+}
+
 bool TabletIO::Compact(StatusCode* status) {
     {
         MutexLock lock(&m_mutex);
@@ -462,6 +637,41 @@ bool TabletIO::CompactMinor(StatusCode* status) {
     return true;
 }
 
+bool TabletIO::IngestFiles(const std::map<uint32_t, std::vector<std::string> >& lg_files,
+                           StatusCode* status) {
+    {
+        MutexLock lock(&m_mutex);
+        if (m_status != kReady) {
+            SetStatusCode(m_status, status);
+            return false;
+        }
+        m_db_ref_count++;
+    }
+
+    std::map<uint32_t, std::vector<std::string> > full_lg_files;
+    std::map<uint32_t, std::vector<std::string> >::const_iterator it;
+    for (it = lg_files.begin(); it != lg_files.end(); ++it) {
+        std::vector<std::string>& files = full_lg_files[it->first];
+        for (size_t i = 0; i < it->second.size(); ++i) {
+            files.push_back(FLAGS_tera_tabletnode_path_prefix + "/" + it->second[i]);
+        }
+    }
+    CHECK_NOTNULL(m_db);
+    leveldb::Status db_status = m_db->IngestFiles(full_lg_files);
+    // the ingested files may hold rows known to be absent
+    m_negative_cache.Clear();
+    if (!db_status.ok()) {
+        LOG(ERROR) << "fail to ingest files to tablet: " << m_tablet_path
+            << ", " << db_status.ToString();
+        SetStatusCode(db_status, status);
+    }
+    {
+        MutexLock lock(&m_mutex);
+        m_db_ref_count--;
+    }
+    return db_status.ok();
+}
+
 int64_t TabletIO::GetDataSize(const std::string& start_key,
                               const std::string& end_key,
                               StatusCode* status) {
@@ -536,6 +746,38 @@ bool TabletIO::IsBusy() {
     return is_busy;
 }
 
+void TabletIO::ReleaseIdleScans() {
+    {
+        MutexLock lock(&m_mutex);
+        if (m_status != kReady) {
+            return;
+        }
+        m_db_ref_count++;
+    }
+    m_scan_cursor_cache.EvictExpired();
+    m_stream_scan.ReleaseIdleSessions();
+    {
+        MutexLock lock(&m_mutex);
+        m_db_ref_count--;
+    }
+}
+
+uint64_t TabletIO::GetWriteThrottleDelay(std::string* reason) {
+    {
+        MutexLock lock(&m_mutex);
+        if (m_status != kReady) {
+            return 0;
+        }
+        m_db_ref_count++;
+    }
+    uint64_t delay = m_db->WriteThrottleDelay(reason);
+    {
+        MutexLock lock(&m_mutex);
+        m_db_ref_count--;
+    }
+    return delay;
+}
+
 bool TabletIO::SnapshotIDToSeq(uint64_t snapshot_id, uint64_t* snapshot_sequence) {
     std::map<uint64_t, uint64_t>::iterator it = id_to_snapshot_num_.find(snapshot_id);
     if (it == id_to_snapshot_num_.end()) {
@@ -632,9 +874,12 @@ bool TabletIO::LowLevelScan(const std::string& start_tera_key,
         return false;
     }
 
+    leveldb::CompactStrategy* compact_strategy =
+        m_ldb_options.compact_strategy_factory->NewInstance();
     bool ret = LowLevelScan(start_tera_key, end_row_key, scan_options, it,
-                            value_list, read_row_count, read_bytes,
-                            is_complete, status);
+                            compact_strategy, value_list, read_row_count,
+                            read_bytes, is_complete, status);
+    delete compact_strategy;
     delete it;
     return ret;
 }
@@ -643,14 +888,12 @@ inline bool TabletIO::LowLevelScan(const std::string& start_tera_key,
                             const std::string& end_row_key,
                             const ScanOptions& scan_options,
                             leveldb::Iterator* it,
+                            leveldb::CompactStrategy* compact_strategy,
                             RowResult* value_list,
                             uint32_t* read_row_count,
                             uint32_t* read_bytes,
                             bool* is_complete,
                             StatusCode* status) {
-    // init compact strategy
-    leveldb::CompactStrategy* compact_strategy =
-        m_ldb_options.compact_strategy_factory->NewInstance();
     std::list<KeyValuePair> row_buf;
     std::string last_key, last_col, last_qual;
     uint32_t buffer_size = 0;
@@ -764,8 +1007,6 @@ inline bool TabletIO::LowLevelScan(const std::string& start_tera_key,
         it_status = it->status();
     }
 
-    delete compact_strategy;
-
     if (!it_status.ok()) {
         SetStatusCode(it_status, status);
         VLOG(10) << "ll-scan fail: " << "tablet=[" << m_tablet_path <<
@@ -797,6 +1038,26 @@ bool TabletIO::ReadCells(const RowReaderInfo& row_reader, RowResult* value_list,
     }
 
     int64_t read_ms = get_micros();
+    SampleRowKey(row_reader.key());
+
+    // rows known to be absent are only cached for reads of the latest data
+    bool use_negative_cache =
+        FLAGS_tera_tabletnode_negative_cache_size > 0 && snapshot_id == 0;
+    uint64_t negative_cache_sequence = 0;
+    if (use_negative_cache) {
+        if (m_negative_cache.Contains(row_reader.key())) {
+            negative_cache_hit_counter.Inc();
+            m_counter.read_rows.Inc();
+            row_read_delay.Add(get_micros() - read_ms);
+            {
+                MutexLock lock(&m_mutex);
+                m_db_ref_count--;
+            }
+            SetStatusCode(kKeyNotExist, status);
+            return false;
+        }
+        negative_cache_sequence = m_negative_cache.GetSequence();
+    }
 
     if (m_kv_only) {
         std::string key(row_reader.key());
@@ -805,6 +1066,9 @@ bool TabletIO::ReadCells(const RowReaderInfo& row_reader, RowResult* value_list,
             key.append(8, '\0');
         }
         if (!Read(key, &value, snapshot_id, status)) {
+            if (use_negative_cache && status != NULL && *status == kKeyNotExist) {
+                m_negative_cache.Put(row_reader.key(), negative_cache_sequence);
+            }
             m_counter.read_rows.Inc();
             row_read_delay.Add(get_micros() - read_ms);
             {
@@ -881,6 +1145,13 @@ bool TabletIO::ReadCells(const RowReaderInfo& row_reader, RowResult* value_list,
         return false;
     }
     if (value_list->key_values_size() == 0) {
+        // only a read of all columns at any time tells the row is absent,
+        // the sdk always sends the time range
+        if (use_negative_cache && row_reader.cf_list_size() == 0
+            && scan_options.ts_start <= kOldestTs
+            && scan_options.ts_end >= kLatestTs) {
+            m_negative_cache.Put(row_reader.key(), negative_cache_sequence);
+        }
         SetStatusCode(kKeyNotExist, status);
         return false;
     }
@@ -910,7 +1181,10 @@ bool TabletIO::WriteOne(const std::string& key, const std::string& value,
                         bool sync, StatusCode* status) {
     leveldb::WriteBatch batch;
     batch.Put(key, value);
-    return WriteBatch(&batch, sync, status);
+    bool ret = WriteBatch(&batch, sync, status);
+    // "key" is a raw key, the row it belongs to is unknown here
+    m_negative_cache.Clear();
+    return ret;
 }
 
 bool TabletIO::Write(const WriteTabletRequest* request,
@@ -928,6 +1202,9 @@ bool TabletIO::Write(const WriteTabletRequest* request,
         }
         m_db_ref_count++;
     }
+    for (size_t i = 0; i < index_list->size(); ++i) {
+        SampleRowKey(request->row_list((*index_list)[i]).row_key());
+    }
     m_async_writer->Write(request, response, done, index_list,
                           done_counter, timer);
     {
@@ -1001,80 +1278,173 @@ bool TabletIO::ScanRowsRestricted(const ScanTabletRequest* request,
 
     StatusCode status = kTabletNodeOk;
     bool ret = false;
-    if (LowLevelScan(start_tera_key, end_row_key, scan_options,
-                     response->mutable_results(), &read_row_count, &read_bytes,
-                     &is_complete, &status)) {
+    leveldb::Iterator* it = NULL;
+    leveldb::CompactStrategy* compact_strategy = NULL;
+    if (FLAGS_tera_tabletnode_scan_cursor_cache_num > 0) {
+        it = m_scan_cursor_cache.Get(ScanCursorKey(*request, start_tera_key),
+                                     &compact_strategy);
+    }
+    if (it == NULL) {
+        status = InitedScanInterator(start_tera_key, scan_options, &it);
+        compact_strategy = m_ldb_options.compact_strategy_factory->NewInstance();
+    } else {
+        VLOG(10) << "continue scan on cached iterator: " << m_tablet_path;
+    }
+    if (status == kTabletNodeOk
+        && LowLevelScan(start_tera_key, end_row_key, scan_options, it,
+                        compact_strategy, response->mutable_results(),
+                        &read_row_count, &read_bytes, &is_complete, &status)) {
         response->set_complete(is_complete);
         m_counter.scan_rows.Add(read_row_count);
         m_counter.scan_size.Add(read_bytes);
         ret = true;
+        if (!is_complete && FLAGS_tera_tabletnode_scan_cursor_cache_num > 0
+            && CacheScanCursor(request, response->results(), it,
+                               compact_strategy)) {
+            it = NULL;
+            compact_strategy = NULL;
+        }
     }
+    delete compact_strategy;
+    delete it;
 
     response->set_status(status);
     done->Run();
     return ret;
 }
 
+std::string TabletIO::ScanCursorKey(const ScanTabletRequest& request,
+                                    const std::string& start_tera_key) {
+    // pages of a scan differ only in where they start
+    ScanTabletRequest options(request);
+    options.clear_sequence_id();
+    options.clear_start();
+    options.clear_start_family();
+    options.clear_start_qualifier();
+    options.clear_start_timestamp();
+    std::string key;
+    options.SerializeToString(&key);
+    key.append(start_tera_key);
+    return NumberToString(key.size() - start_tera_key.size()) + ":" + key;
+}
+
+bool TabletIO::CacheScanCursor(const ScanTabletRequest* request,
+                               const RowResult& results,
+                               leveldb::Iterator* it,
+                               leveldb::CompactStrategy* compact_strategy) {
+    if (results.key_values_size() == 0 || !it->Valid()) {
+        return false;
+    }
+    // the next page starts right after the last cell returned, the same
+    // as the sdk does, see ResultStreamSyncImpl::Done
+    const KeyValuePair& kv = results.key_values(results.key_values_size() - 1);
+    ScanTabletRequest next_request(*request);
+    next_request.set_start(kv.key());
+    next_request.clear_start_family();
+    next_request.clear_start_qualifier();
+    next_request.clear_start_timestamp();
+    std::string next_qualifier = kv.qualifier();
+    int64_t next_timestamp = kv.timestamp() - 1;
+    if (kv.timestamp() == 0) {
+        next_qualifier.append(1, '\x1');
+        next_timestamp = 0;
+    }
+    if (kv.column_family() != "") {
+        next_request.set_start_family(kv.column_family());
+    }
+    if (next_qualifier != "") {
+        next_request.set_start_qualifier(next_qualifier);
+    }
+    if (next_timestamp != 0) {
+        next_request.set_start_timestamp(next_timestamp);
+    }
+    std::string next_tera_key;
+    std::string end_row_key;
+    SetupScanInternalTeraKey(&next_request, &next_tera_key, &end_row_key);
+
+    // cells between the last returned one and the iterator, if any, were
+    // filtered out in this page and would be missed by the next page
+    if (m_key_operator->Compare(it->key(), next_tera_key) > 0) {
+        return false;
+    }
+    // the iterator stays on the last returned cell, which the compact
+    // strategy has seen already
+    if (m_key_operator->Compare(it->key(), next_tera_key) < 0) {
+        it->Next();
+    }
+    m_scan_cursor_cache.Put(ScanCursorKey(next_request, next_tera_key), it,
+                            compact_strategy);
+    return true;
+}
+
 bool TabletIO::ScanRowsStreaming(const ScanTabletRequest* request,
                                  ScanTabletResponse* response,
                                  google::protobuf::Closure* done) {
-    bool is_first_scan = false;
-    std::string table_name = request->table_name();
-    m_stream_scan.PushTask(request, response, done, &is_first_scan);
-    if (!is_first_scan) {
-        LOG(INFO) << "not first rpc to call scan: " << table_name;
+    StreamScan* scan_stream = m_stream_scan.PushTask(request, response, done);
+    if (scan_stream == NULL) {
+        return true;
+    }
+    if (!scan_stream->StartProduce()) {
+        // the task is answered by the thread producing for the session,
+        // or by the next rpc of the session
+        VLOG(10) << "task queued to session: " << request->session_id();
+        m_stream_scan.ReleaseStream(scan_stream);
         return true;
     }
 
-    std::string start_tera_key;
-    std::string end_row_key;
-    SetupScanInternalTeraKey(request, &start_tera_key, &end_row_key);
-
+    uint64_t session_id = request->session_id();
+    const ScanTabletRequest& session_request = scan_stream->GetRequest();
     ScanOptions scan_options;
-    SetupScanRowOptions(request, &scan_options);
+    SetupScanRowOptions(&session_request, &scan_options);
+    if (scan_stream->m_iterator == NULL) {
+        SetupScanInternalTeraKey(&session_request, &scan_stream->m_start_tera_key,
+                                 &scan_stream->m_end_row_key);
+        StatusCode ret_code = InitedScanInterator(scan_stream->m_start_tera_key,
+                                                  scan_options,
+                                                  &scan_stream->m_iterator);
+        if (ret_code != kTabletNodeOk) {
+            scan_stream->SetStatusCode(ret_code);
+            m_stream_scan.RemoveSession(session_id);
+            return false;
+        }
+        scan_stream->m_compact_strategy =
+            m_ldb_options.compact_strategy_factory->NewInstance();
+    }
 
+    // produce a chunk for each queued task, and park the session when
+    // the client has no more rpc waiting instead of waiting for it
+    leveldb::Iterator* it = scan_stream->m_iterator;
     uint32_t read_row_count = 0;
     uint32_t read_bytes = 0;
     bool is_complete = false;
-
-    uint64_t session_id = request->session_id();
-    StreamScan* scan_stream = m_stream_scan.GetStream(session_id);
-    leveldb::Iterator* it = NULL;
-    StatusCode ret_code = InitedScanInterator(start_tera_key, scan_options, &it);
-    if (ret_code != kTabletNodeOk) {
-        scan_stream->SetStatusCode(ret_code);
-        m_stream_scan.RemoveSession(session_id);
-        return false;
-    }
-
     StatusCode status = kTabletNodeOk;
-    uint64_t data_id = 0;
-    while (status == kTabletNodeOk) {
+    do {
         RowResult value_list;
-        if (LowLevelScan(start_tera_key, end_row_key, scan_options, it,
-                         &value_list, &read_row_count, &read_bytes,
-                         &is_complete, &status)) {
-            m_counter.scan_rows.Add(read_row_count);
-            m_counter.scan_size.Add(read_bytes);
-
-            scan_stream->SetCompleted(is_complete);
-            if (!scan_stream->PushData(data_id, value_list)) {
-                break;
-            }
-
-            data_id++;
-            if (it->Valid()) {
-                it->Next();
-            }
+        if (!LowLevelScan(scan_stream->m_start_tera_key, scan_stream->m_end_row_key,
+                          scan_options, it, scan_stream->m_compact_strategy,
+                          &value_list, &read_row_count, &read_bytes,
+                          &is_complete, &status)) {
+            scan_stream->SetStatusCode(status);
+            m_stream_scan.RemoveSession(session_id);
+            return false;
         }
+        m_counter.scan_rows.Add(read_row_count);
+        m_counter.scan_size.Add(read_bytes);
+
+        scan_stream->SetCompleted(is_complete);
         scan_stream->SetStatusCode(status);
+        scan_stream->PushData(scan_stream->m_data_id, value_list);
+        scan_stream->m_data_id++;
         if (is_complete) {
-            break;
+            m_stream_scan.RemoveSession(session_id);
+            return true;
         }
-    }
+        if (it->Valid()) {
+            it->Next();
+        }
+    } while (!scan_stream->FinishProduce());
 
-    delete it;
-    m_stream_scan.RemoveSession(session_id);
+    m_stream_scan.ReleaseStream(scan_stream);
     return true;
 }
 
@@ -1283,7 +1653,10 @@ void TabletIO::SetupOptionsForLG() {
                 m_ldb_options.seek_latency = FLAGS_tera_leveldb_env_dfs_seek_latency;
             }
         }
-        if (compress) {
+        if (compress && lg_schema.compress_with_dict()) {
+            lg_info->compression = leveldb::kZlibDictCompression;
+            lg_info->compression_dict_size = lg_schema.compress_dict_size() * 1024;
+        } else if (compress) {
             lg_info->compression = leveldb::kSnappyCompression;
         }
 
@@ -1301,6 +1674,7 @@ void TabletIO::SetupOptionsForLG() {
         LOG(INFO) << ", sst_size: " << lg_schema.sst_size() << " Bytes.";
         lg_info->sst_size = lg_schema.sst_size();
         m_ldb_options.sst_size = lg_schema.sst_size();
+        lg_info->block_hash_index = lg_schema.block_hash_index();
         exist_lg_list->insert(lg_i);
         (*lg_info_list)[lg_i] = lg_info;
     }
@@ -1531,6 +1905,9 @@ void TabletIO::GetAndClearCounter(TabletCounter* counter, int64_t interval) {
     counter->set_write_kvs(m_counter.write_kvs.Clear() * 1000000 / interval);
     counter->set_write_size(m_counter.write_size.Clear() * 1000000 / interval);
     counter->set_is_on_busy(IsBusy());
+    std::string delay_reason;
+    counter->set_write_delay(GetWriteThrottleDelay(&delay_reason));
+    counter->set_write_delay_reason(delay_reason);
 }
 
 int32_t TabletIO::AddRef() {
@@ -13,6 +13,8 @@
 
 #include "common/base/scoped_ptr.h"
 #include "common/mutex.h"
+#include "io/negative_cache.h"
+#include "io/scan_cursor_cache.h"
 #include "io/stream_scan.h"
 #include "leveldb/db.h"
 #include "leveldb/options.h"
@@ -96,9 +98,29 @@ public:
                       leveldb::TableCache* table_cache = NULL,
                       StatusCode* status = NULL);
     virtual bool Unload(StatusCode* status = NULL);
+    // Warm up the block cache, table cache and flash copies of a tablet
+    // that is still served by another node, the status stays kNotInit.
+    bool Prewarm(const TableSchema& schema,
+                 const std::string& key_start, const std::string& key_end,
+                 const std::string& path,
+                 const std::vector<uint64_t>& parent_tablets,
+                 leveldb::Logger* logger, leveldb::Cache* block_cache,
+                 leveldb::TableCache* table_cache,
+                 StatusCode* status = NULL);
+    // Let a prewarmed tablet io live until this tablet is unloaded, as
+    // the tables it cached are used by this one.  Takes one reference.
+    void SetPrewarmed(TabletIO* prewarm_io);
+    // if *split_key is not empty, it is used as the split point when it
+    // falls inside the tablet; otherwise a size-balanced key is chosen
     virtual bool Split(std::string* split_key, StatusCode* status = NULL);
+    // median of the recently accessed row keys, for splitting hot tablets
+    bool FindLoadSplitKey(std::string* split_key);
     virtual bool Compact(StatusCode* status = NULL);
     bool CompactMinor(StatusCode* status = NULL);
+    // add sst files built by bulk load to the lgs, the file paths
+    // are relative to the tabletnode path prefix
+    bool IngestFiles(const std::map<uint32_t, std::vector<std::string> >& lg_files,
+                     StatusCode* status = NULL);
     bool Destroy(StatusCode* status = NULL);
     virtual int64_t GetDataSize(StatusCode* status = NULL);
     virtual int64_t GetDataSize(const std::string& start_key,
@@ -107,6 +129,10 @@ public:
     virtual bool AddInheritedLiveFiles(std::vector<std::set<uint64_t> >* live);
 
     bool IsBusy();
+    // delete the iterators of scans not resumed by the clients in time
+    void ReleaseIdleScans();
+    // the delay (in us) suggested before next write, and its reason
+    uint64_t GetWriteThrottleDelay(std::string* reason);
 
     bool SnapshotIDToSeq(uint64_t snapshot_id, uint64_t* snapshot_sequence);
 
@@ -168,8 +194,14 @@ private:
                           bool sync = false, StatusCode* status = NULL);
 //     int64_t GetDataSizeWithoutLock(StatusCode* status = NULL);
 
+    void SetupOptions(const TableSchema& schema,
+                      const std::string& key_start, const std::string& key_end,
+                      const std::vector<uint64_t>& parent_tablets,
+                      leveldb::Logger* logger, leveldb::Cache* block_cache,
+                      leveldb::TableCache* table_cache);
     void SetupOptionsForLG();
     void TearDownOptionsForLG();
+    void ReleasePrewarm();
     void IndexingCfToLG();
 
     void SetupIteratorOptions(const ScanOptions& scan_options,
@@ -197,17 +229,30 @@ private:
                                   std::string* end_row_key);
     void SetupScanRowOptions(const ScanTabletRequest* request,
                              ScanOptions* scan_options);
-
+    // key of the cached iterator to continue a paged scan from "request"
+    std::string ScanCursorKey(const ScanTabletRequest& request,
+                              const std::string& start_tera_key);
+    // cache "it" and "compact_strategy" if the next page of "request"
+    // can continue on them
+    bool CacheScanCursor(const ScanTabletRequest* request,
+                         const RowResult& results,
+                         leveldb::Iterator* it,
+                         leveldb::CompactStrategy* compact_strategy);
+
+    // "compact_strategy" must have seen all records before "it"
     bool LowLevelScan(const std::string& start_tera_key,
                       const std::string& end_row_key,
                       const ScanOptions& scan_options,
                       leveldb::Iterator* it,
+                      leveldb::CompactStrategy* compact_strategy,
                       RowResult* value_list,
                       uint32_t* read_row_count,
                       uint32_t* read_bytes,
                       bool* is_complete,
                       StatusCode* status);
 
+    void SampleRowKey(const std::string& row_key);
+
 private:
     mutable Mutex m_mutex;
     TabletWriter* m_async_writer;
@@ -224,6 +269,8 @@ private:
     volatile int32_t m_db_ref_count;
     leveldb::Options m_ldb_options;
     leveldb::DB* m_db;
+    leveldb::WarmUpHandle* m_warm_handle;
+    TabletIO* m_prewarm_io;
     bool m_mem_store_activated;
     TableSchema m_table_schema;
     bool m_kv_only;
@@ -234,7 +281,15 @@ private:
     std::map<std::string, uint32_t> m_cf_lg_map;
     std::map<std::string, uint32_t> m_lg_id_map;
     StreamScanManager m_stream_scan;
+    ScanCursorCache m_scan_cursor_cache;
+    NegativeCache m_negative_cache;
     StatCounter m_counter;
+
+    // ring buffer of sampled row keys, for load-based split
+    Counter m_row_access_count;
+    Mutex m_sample_mutex;
+    std::vector<std::string> m_row_samples;
+    uint32_t m_sample_pos;
 };
 
 } // namespace io
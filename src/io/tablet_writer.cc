@@ -15,6 +15,7 @@
 #include "leveldb/lg_coding.h"
 #include "proto/proto_helper.h"
 #include "utils/counter.h"
+#include "utils/cpu_affinity.h"
 #include "utils/timer.h"
 
 DECLARE_int32(tera_asyncwriter_pending_limit);
@@ -22,6 +23,7 @@ DECLARE_bool(tera_enable_level0_limit);
 DECLARE_int32(tera_asyncwriter_sync_interval);
 DECLARE_int32(tera_asyncwriter_sync_size_threshold);
 DECLARE_int32(tera_asyncwriter_batch_size);
+DECLARE_string(tera_tabletnode_writer_cpu_set);
 
 namespace tera {
 namespace io {
@@ -31,7 +33,8 @@ TabletWriter::TabletWriter(TabletIO* tablet_io)
       m_sync_timestamp(0),
       m_active_buffer_instant(false),
       m_active_buffer_size(0),
-      m_tablet_busy(false) {
+      m_tablet_busy(false),
+      m_write_delay(0) {
     m_active_buffer = new WriteTaskBuffer;
     m_sealed_buffer = new WriteTaskBuffer;
 }
@@ -162,6 +165,9 @@ void TabletWriter::Write(const WriteTabletRequest* request,
 }
 
 void TabletWriter::DoWork() {
+    // memtables are filled by this thread, keep it on the cpus of the
+    // memory it writes
+    utils::SetThreadCpuAffinity(FLAGS_tera_tabletnode_writer_cpu_set);
     m_sync_timestamp = GetTimeStampInMs();
     int32_t sync_interval = FLAGS_tera_asyncwriter_sync_interval;
     if (sync_interval == 0) {
@@ -181,6 +187,12 @@ void TabletWriter::DoWork() {
         }
         // 否则 flush
         VLOG(7) << "write data, sleep_duration: " << sleep_duration;
+        if (m_write_delay > 0) {
+            // 按compaction压力限流, 而非直接拒绝写入
+            VLOG(7) << "[" << m_tablet->GetTablePath() << "] write delay: "
+                << m_write_delay << "us";
+            ThisThread::Sleep((m_write_delay + 999) / 1000);
+        }
         FlushToDiskBatch(m_sealed_buffer);
         m_sealed_buffer->clear();
         m_sync_timestamp = GetTimeStampInMs();
@@ -193,6 +205,7 @@ bool TabletWriter::SwapActiveBuffer(bool force) {
     const uint64_t SYNC_SIZE = FLAGS_tera_asyncwriter_sync_size_threshold * 1024UL;
     if (FLAGS_tera_enable_level0_limit == true) {
         m_tablet_busy = m_tablet->IsBusy();
+        m_write_delay = m_tablet->GetWriteThrottleDelay(NULL);
     }
 
     MutexLock lock(&m_task_mutex);
@@ -357,6 +370,14 @@ void TabletWriter::FlushToDiskBatch(WriteTaskBuffer* task_buffer) {
     StatusCode status = kTableOk;
     m_tablet->WriteBatch(&batch, true, &status);
     batch.Clear();
+    // before the writes are acked, no read may find the rows absent
+    for (size_t i = 0; i < task_num; ++i) {
+        const WriteTask& task = (*task_buffer)[i];
+        for (size_t j = 0; j < task.index_list->size(); ++j) {
+            int32_t index = (*task.index_list)[j];
+            m_tablet->m_negative_cache.Invalidate(task.request->row_list(index).row_key());
+        }
+    }
     for (size_t i = 0; i < task_num; i++) {
         FinishTask((*task_buffer)[i], status);
     }
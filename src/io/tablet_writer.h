@@ -86,6 +86,7 @@ private:
     bool m_active_buffer_instant;      ///< active_buffer包含instant请求
     uint64_t m_active_buffer_size;      ///< active_buffer的数据大小
     bool m_tablet_busy;                 ///< tablet处于忙碌状态
+    uint64_t m_write_delay;             ///< 写入前的限流延迟(us)
 };
 
 } // namespace tabletnode
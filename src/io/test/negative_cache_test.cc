@@ -0,0 +1,99 @@
+// Copyright (c) 2015, Baidu.com, Inc. All Rights Reserved
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "io/negative_cache.h"
+
+#include <gflags/gflags.h>
+
+#include "common/base/string_format.h"
+#include "gtest/gtest.h"
+
+DECLARE_int64(tera_tabletnode_negative_cache_size);
+
+namespace tera {
+namespace io {
+
+TEST(NegativeCacheTest, PutAndInvalidate) {
+    NegativeCache cache;
+    uint64_t sequence = cache.GetSequence();
+    EXPECT_FALSE(cache.Contains("row"));
+    cache.Put("row", sequence);
+    EXPECT_TRUE(cache.Contains("row"));
+
+    cache.Invalidate("row");
+    EXPECT_FALSE(cache.Contains("row"));
+    EXPECT_EQ(cache.MemorySize(), 0U);
+}
+
+TEST(NegativeCacheTest, WriteDuringRead) {
+    NegativeCache cache;
+    // the row is written after the read began
+    uint64_t sequence = cache.GetSequence();
+    cache.Invalidate("row");
+    cache.Put("row", sequence);
+    EXPECT_FALSE(cache.Contains("row"));
+
+    // files are ingested after the read began
+    sequence = cache.GetSequence();
+    cache.Clear();
+    cache.Put("row", sequence);
+    EXPECT_FALSE(cache.Contains("row"));
+
+    sequence = cache.GetSequence();
+    cache.Put("row", sequence);
+    EXPECT_TRUE(cache.Contains("row"));
+}
+
+TEST(NegativeCacheTest, MemoryLimit) {
+    int64_t old_size = FLAGS_tera_tabletnode_negative_cache_size;
+    FLAGS_tera_tabletnode_negative_cache_size = 1;
+
+    NegativeCache cache;
+    uint64_t sequence = cache.GetSequence();
+    for (int i = 0; i < 100; ++i) {
+        cache.Put(StringFormat("row%04d", i), sequence);
+        EXPECT_LE(cache.MemorySize(), 1024U);
+    }
+    EXPECT_FALSE(cache.Contains("row0000"));
+    EXPECT_TRUE(cache.Contains("row0099"));
+
+    FLAGS_tera_tabletnode_negative_cache_size = old_size;
+}
+
+TEST(NegativeCacheTest, NodeMemoryLimit) {
+    int64_t old_size = FLAGS_tera_tabletnode_negative_cache_size;
+    FLAGS_tera_tabletnode_negative_cache_size = 1;
+
+    // the limit is shared by the caches of all tablets
+    NegativeCache* cache1 = new NegativeCache;
+    NegativeCache cache2;
+    for (int i = 0; i < 100; ++i) {
+        cache1->Put(StringFormat("row%04d", i), cache1->GetSequence());
+        EXPECT_LE(NegativeCache::NodeMemorySize(), 1024U);
+    }
+    size_t full_size = cache1->MemorySize();
+    EXPECT_GT(full_size, 0U);
+
+    // a cache with few keys takes memory from the largest one
+    for (int i = 0; i < 5; ++i) {
+        cache2.Put(StringFormat("row%04d", i), cache2.GetSequence());
+        EXPECT_TRUE(cache2.Contains(StringFormat("row%04d", i)));
+        EXPECT_LE(NegativeCache::NodeMemorySize(), 1024U);
+    }
+    EXPECT_LT(cache1->MemorySize(), full_size);
+    EXPECT_TRUE(cache1->Contains("row0099"));
+    EXPECT_EQ(NegativeCache::NodeMemorySize(),
+              cache1->MemorySize() + cache2.MemorySize());
+
+    // the memory of a closed tablet is given back
+    delete cache1;
+    EXPECT_EQ(NegativeCache::NodeMemorySize(), cache2.MemorySize());
+    cache2.Clear();
+    EXPECT_EQ(NegativeCache::NodeMemorySize(), 0U);
+
+    FLAGS_tera_tabletnode_negative_cache_size = old_size;
+}
+
+} // namespace io
+} // namespace tera
@@ -0,0 +1,93 @@
+// Copyright (c) 2015, Baidu.com, Inc. All Rights Reserved
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "io/stream_scan.h"
+
+#include <gflags/gflags.h>
+#include <google/protobuf/stubs/common.h>
+
+#include "common/this_thread.h"
+#include "gtest/gtest.h"
+
+DECLARE_int64(tera_io_scan_stream_task_pending_time);
+
+namespace tera {
+namespace io {
+
+static void CountDone(int* count) {
+    ++*count;
+}
+
+TEST(StreamScanTest, ProduceOnlyForQueuedTasks) {
+    ScanTabletRequest request;
+    StreamScan scan(request);
+    ScanTabletResponse response1, response2;
+    int done_count = 0;
+
+    // parked, nothing to produce
+    EXPECT_FALSE(scan.StartProduce());
+
+    EXPECT_TRUE(scan.PushTask(1, &response1,
+                              google::protobuf::NewCallback(&CountDone, &done_count)));
+    EXPECT_TRUE(scan.StartProduce());
+    // only one producer at a time
+    EXPECT_FALSE(scan.StartProduce());
+
+    // a task queued while producing is left to the producer
+    EXPECT_TRUE(scan.PushTask(2, &response2,
+                              google::protobuf::NewCallback(&CountDone, &done_count)));
+    RowResult result;
+    EXPECT_TRUE(scan.PushData(0, result));
+    EXPECT_FALSE(scan.FinishProduce());
+    EXPECT_TRUE(scan.PushData(1, result));
+    EXPECT_EQ(done_count, 2);
+    EXPECT_EQ(response1.results_id(), 0U);
+    EXPECT_EQ(response2.results_id(), 1U);
+
+    // no task left, the session is parked
+    EXPECT_TRUE(scan.FinishProduce());
+    EXPECT_FALSE(scan.PushData(2, result));
+    EXPECT_FALSE(scan.StartProduce());
+}
+
+TEST(StreamScanTest, ReleaseIdleSessions) {
+    int64_t pending_time = FLAGS_tera_io_scan_stream_task_pending_time;
+    FLAGS_tera_io_scan_stream_task_pending_time = 0;
+
+    StreamScanManager manager;
+    ScanTabletRequest request;
+    request.set_session_id(1);
+    ScanTabletResponse response;
+    int done_count = 0;
+    StreamScan* scan = manager.PushTask(&request, &response,
+        google::protobuf::NewCallback(&CountDone, &done_count));
+    ASSERT_TRUE(scan != NULL);
+    ASSERT_TRUE(scan->StartProduce());
+    RowResult result;
+    EXPECT_TRUE(scan->PushData(0, result));
+    EXPECT_TRUE(scan->FinishProduce());
+
+    // a session referenced by a producer is never released
+    manager.ReleaseIdleSessions();
+    EXPECT_EQ(scan->GetRef(), 1);
+
+    // the parked session is released without any new rpc
+    manager.ReleaseStream(scan);
+    ThisThread::Sleep(1);
+    manager.ReleaseIdleSessions();
+
+    // so the next rpc of the session is dropped
+    ScanTabletRequest next_request(request);
+    next_request.set_part_of_session(true);
+    ScanTabletResponse next_response;
+    EXPECT_TRUE(manager.PushTask(&next_request, &next_response,
+        google::protobuf::NewCallback(&CountDone, &done_count)) == NULL);
+    EXPECT_EQ(done_count, 2);
+    EXPECT_FALSE(next_response.complete());
+
+    FLAGS_tera_io_scan_stream_task_pending_time = pending_time;
+}
+
+} // namespace io
+} // namespace tera
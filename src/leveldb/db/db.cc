@@ -133,6 +133,7 @@ Status DestroyDB(const std::string& dbname, const Options& opt) {
                     lg_opt.env = lg_info->env;
                 }
                 lg_opt.compression = lg_info->compression;
+                lg_opt.compression_dict_size = lg_info->compression_dict_size;
                 delete lg_info;
             }
         } else if (options.lg_info_list) {
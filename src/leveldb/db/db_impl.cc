@@ -41,6 +41,7 @@
 #include "util/coding.h"
 #include "util/logging.h"
 #include "util/mutexlock.h"
+#include "util/thread_pool.h"
 
 namespace leveldb {
 
@@ -106,7 +107,15 @@ Options SanitizeOptions(const std::string& dbname,
   result.filter_policy = (src.filter_policy != NULL) ? ipolicy : NULL;
   ClipToRange(&result.max_open_files,    64 + kNumNonTableCacheFiles, 50000);
   ClipToRange(&result.write_buffer_size, 64<<10,                      1<<30);
+  ClipToRange(&result.max_imm_num,       1,                           20);
   ClipToRange(&result.block_size,        1<<10,                       4<<20);
+  if (result.use_memtable_on_leveldb) {
+    result.use_concurrent_memtable = false;
+    result.memtable_hash_index = false;
+  }
+  if (result.memtable_hash_index) {
+    result.use_concurrent_memtable = false;
+  }
   if (result.info_log == NULL) {
     // Open a log file in the same directory as the db
     src.env->CreateDir(dbname);  // In case it does not exist
@@ -141,7 +150,9 @@ DBImpl::DBImpl(const Options& options, const std::string& dbname)
       writting_mem_cv_(&mutex_),
       is_writting_mem_(false),
       mem_(NewMemTable()),
-      imm_(NULL), recover_mem_(NULL),
+      recover_mem_(NULL),
+      recover_imm_(NULL),
+      recover_edit_(NULL),
       logfile_(NULL),
       logfile_number_(0),
       log_(NULL),
@@ -150,7 +161,9 @@ DBImpl::DBImpl(const Options& options, const std::string& dbname)
       bg_compaction_scheduled_(false),
       bg_compaction_score_(0),
       bg_schedule_id_(0),
+      ingest_pending_(0),
       manual_compaction_(NULL),
+      concurrent_writer_(NULL),
       consecutive_compaction_errors_(0),
       flush_on_destroy_(false) {
   mem_->Ref();
@@ -183,16 +196,16 @@ Status DBImpl::Shutdown1() {
     return s;
   }
   Log(options_.info_log, "[%s] fg compact mem table", dbname_.c_str());
-  if (imm_ != NULL) {
+  if (!imm_list_.empty()) {
     s = CompactMemTable();
   }
   if (s.ok()) {
-    assert(imm_ == NULL);
+    assert(imm_list_.empty());
     while (is_writting_mem_) {
         writting_mem_cv_.Wait();
     }
-    imm_ = mem_;
-    has_imm_.Release_Store(imm_);
+    imm_list_.push_back(mem_);
+    has_imm_.Release_Store(mem_);
     mem_ = NewMemTable();
     mem_->Ref();
     bound_log_size_ = 0;
@@ -208,9 +221,9 @@ Status DBImpl::Shutdown2() {
     return s;
   }
   Log(options_.info_log, "[%s] fg compact mem table", dbname_.c_str());
-  assert(imm_ == NULL);
-  imm_ = mem_;
-  has_imm_.Release_Store(imm_);
+  assert(imm_list_.empty());
+  imm_list_.push_back(mem_);
+  has_imm_.Release_Store(mem_);
   mem_ = NULL;
   bound_log_size_ = 0;
   return CompactMemTable();
@@ -221,9 +234,16 @@ DBImpl::~DBImpl() {
     env_->UnlockFile(db_lock_);
   }
 
+  {
+    MutexLock l(&mutex_);
+    WaitForRecoverDump();
+  }
+
   delete versions_;
   if (mem_ != NULL) mem_->Unref();
-  if (imm_ != NULL) imm_->Unref();
+  for (size_t i = 0; i < imm_list_.size(); ++i) {
+    imm_list_[i]->Unref();
+  }
   if (recover_mem_ != NULL) recover_mem_->Unref();
   delete tmp_batch_;
   delete log_;
@@ -443,14 +463,29 @@ Status DBImpl::Recover(VersionEdit* edit) {
 
 Status DBImpl::WriteLevel0Table(MemTable* mem, VersionEdit* edit,
                                 Version* base) {
+  return WriteLevel0Table(std::vector<MemTable*>(1, mem), edit, base);
+}
+
+Status DBImpl::WriteLevel0Table(const std::vector<MemTable*>& mems,
+                                VersionEdit* edit, Version* base) {
   mutex_.AssertHeld();
+  assert(!mems.empty());
   const uint64_t start_micros = env_->NowMicros();
   FileMetaData meta;
   meta.number = BuildFullFileNumber(dbname_, versions_->NewFileNumber());
   pending_outputs_.insert(meta.number);
-  Iterator* iter = mem->NewIterator();
-  Log(options_.info_log, "[%s] Level-0 table #%u: started",
-      dbname_.c_str(), (unsigned int) meta.number);
+  Iterator* iter = NULL;
+  if (mems.size() == 1) {
+    iter = mems[0]->NewIterator();
+  } else {
+    std::vector<Iterator*> list;
+    for (size_t i = 0; i < mems.size(); ++i) {
+      list.push_back(mems[i]->NewIterator());
+    }
+    iter = NewMergingIterator(&internal_comparator_, &list[0], list.size());
+  }
+  Log(options_.info_log, "[%s] Level-0 table #%u: started, %lu memtables",
+      dbname_.c_str(), (unsigned int) meta.number, mems.size());
 
   uint64_t saved_size = 0;
   Status s;
@@ -493,13 +528,17 @@ Status DBImpl::WriteLevel0Table(MemTable* mem, VersionEdit* edit,
 
 Status DBImpl::CompactMemTable() {
   mutex_.AssertHeld();
-  assert(imm_ != NULL);
+  assert(!imm_list_.empty());
 
-  // Save the contents of the memtable as a new Table
+  // Save the contents of all queued memtables as a new Table.
+  // More memtables may be queued while the mutex is released,
+  // they are left to the next compaction.
+  std::vector<MemTable*> imms(imm_list_);
+  MemTable* newest_imm = imms.back();
   VersionEdit edit;
   Version* base = versions_->current();
   base->Ref();
-  Status s = WriteLevel0Table(imm_, &edit, base);
+  Status s = WriteLevel0Table(imms, &edit, base);
   base->Unref();
 
   if (s.ok() && shutting_down_.Acquire_Load()) {
@@ -510,8 +549,8 @@ Status DBImpl::CompactMemTable() {
   if (s.ok()) {
     edit.SetPrevLogNumber(0);
     edit.SetLogNumber(logfile_number_);  // Earlier logs no longer needed
-    if (imm_->GetLastSequence()) {
-      edit.SetLastSequence(imm_->GetLastSequence());
+    if (newest_imm->GetLastSequence()) {
+      edit.SetLastSequence(newest_imm->GetLastSequence());
     }
     Log(options_.info_log, "[%s] CompactMemTable SetLastSequence %lu",
         dbname_.c_str(), edit.GetLastSequence());
@@ -520,9 +559,11 @@ Status DBImpl::CompactMemTable() {
 
   if (s.ok()) {
     // Commit to the new state
-    imm_->Unref();
-    imm_ = NULL;
-    has_imm_.Release_Store(NULL);
+    for (size_t i = 0; i < imms.size(); ++i) {
+      imms[i]->Unref();
+    }
+    imm_list_.erase(imm_list_.begin(), imm_list_.begin() + imms.size());
+    has_imm_.Release_Store(imm_list_.empty() ? NULL : imm_list_.front());
   }
 
   return s;
@@ -588,11 +629,11 @@ Status DBImpl::TEST_CompactMemTable() {
   if (s.ok()) {
     // Wait until the compaction completes
     MutexLock l(&mutex_);
-    while (imm_ != NULL && bg_error_.ok()) {
+    while (!imm_list_.empty() && bg_error_.ok()) {
       bg_cv_.Wait();
     }
     Log(options_.info_log, "[%s] CompactMemTable done", dbname_.c_str());
-    if (imm_ != NULL) {
+    if (!imm_list_.empty()) {
       s = bg_error_;
     }
   }
@@ -601,16 +642,68 @@ Status DBImpl::TEST_CompactMemTable() {
 
 // tera-specific
 
+Status DBImpl::WarmUp(TableCache* table_cache, uint64_t max_data_size,
+                      std::vector<uint64_t>* files) {
+    if (!env_->FileExists(CurrentFileName(dbname_)) &&
+        options_.parent_tablets.size() == 0) {
+        return Status::OK();
+    }
+    Slice start_slice(key_start_);
+    Slice end_slice(key_end_);
+    const Slice* start = key_start_.empty() ? NULL : &start_slice;
+    const Slice* end = key_end_.empty() ? NULL : &end_slice;
+
+    mutex_.Lock();
+    Status s = versions_->Recover();
+    if (!s.ok()) {
+        mutex_.Unlock();
+        return s;
+    }
+    Version* current = versions_->current();
+    current->Ref();
+    mutex_.Unlock();
+    s = current->WarmUp(table_cache, start, end, max_data_size, files);
+    mutex_.Lock();
+    current->Unref();
+    mutex_.Unlock();
+    return s;
+}
+
 bool DBImpl::FindSplitKey(const std::string& start_key,
                           const std::string& end_key,
                           double ratio,
                           std::string* split_key) {
     Slice start_slice(start_key);
     Slice end_slice(end_key);
-    MutexLock l(&mutex_);
-    return versions_->current()->FindSplitKey(start_key.empty()?NULL:&start_slice,
-                                              end_key.empty()?NULL:&end_slice,
-                                              ratio, split_key);
+    const Slice* start = start_key.empty() ? NULL : &start_slice;
+    const Slice* end = end_key.empty() ? NULL : &end_slice;
+
+    // Sampling reads index blocks, do not hold the lock meanwhile.
+    mutex_.Lock();
+    Version* current = versions_->current();
+    current->Ref();
+    mutex_.Unlock();
+    bool sampled = current->FindSplitKeyBySample(start, end, ratio, split_key);
+    mutex_.Lock();
+    bool found = sampled || current->FindSplitKey(start, end, ratio, split_key);
+    current->Unref();
+    mutex_.Unlock();
+    if (!sampled) {
+        return found;
+    }
+
+    // Index keys may be shortened separators, move to the first real key
+    // at or after it, so that the split key can be decoded by tera.
+    Iterator* iter = NewInternalIterator();
+    iter->Seek(InternalKey(*split_key, kMaxSequenceNumber, kValueTypeForSeek).Encode());
+    if (iter->Valid()) {
+        Slice user_key = ExtractUserKey(iter->key());
+        if (end == NULL || user_comparator()->Compare(user_key, *end) < 0) {
+            split_key->assign(user_key.data(), user_key.size());
+        }
+    }
+    delete iter;
+    return true;
 }
 
 uint64_t DBImpl::GetScopeSize(const std::string& start_key,
@@ -697,7 +790,8 @@ void DBImpl::AddInheritedLiveFiles(std::vector<std::set<uint64_t> >* live) {
   //    dbname_.c_str(), (*live)[lg].size());
 }
 
-Status DBImpl::RecoverInsertMem(WriteBatch* batch, VersionEdit* edit) {
+Status DBImpl::RecoverInsertMem(WriteBatch* batch, VersionEdit* edit,
+                                ThreadPool* dump_pool) {
     MutexLock lock(&mutex_);
 
     if (recover_mem_ == NULL) {
@@ -721,6 +815,19 @@ Status DBImpl::RecoverInsertMem(WriteBatch* batch, VersionEdit* edit) {
         return status;
     }
     if (recover_mem_->ApproximateMemoryUsage() > options_.write_buffer_size) {
+        if (dump_pool != NULL) {
+            // keep level-0 files in order, only one dump at a time
+            status = WaitForRecoverDump();
+            if (!status.ok()) {
+                return status;
+            }
+            edit->SetLastSequence(recover_mem_->GetLastSequence());
+            recover_imm_ = recover_mem_;
+            recover_edit_ = edit;
+            recover_mem_ = NULL;
+            dump_pool->Schedule(&DBImpl::RecoverDumpWrapper, this, 0, 0);
+            return status;
+        }
         edit->SetLastSequence(recover_mem_->GetLastSequence());
         status = WriteLevel0Table(recover_mem_, edit, NULL);
         if (!status.ok()) {
@@ -734,13 +841,35 @@ Status DBImpl::RecoverInsertMem(WriteBatch* batch, VersionEdit* edit) {
     return status;
 }
 
+void DBImpl::RecoverDumpWrapper(void* db) {
+    reinterpret_cast<DBImpl*>(db)->RecoverDump();
+}
+
+void DBImpl::RecoverDump() {
+    MutexLock lock(&mutex_);
+    assert(recover_imm_ != NULL);
+    recover_dump_status_ = WriteLevel0Table(recover_imm_, recover_edit_, NULL);
+    recover_imm_->Unref();
+    recover_imm_ = NULL;
+    recover_edit_ = NULL;
+    bg_cv_.SignalAll();
+}
+
+Status DBImpl::WaitForRecoverDump() {
+    mutex_.AssertHeld();
+    while (recover_imm_ != NULL) {
+        bg_cv_.Wait();
+    }
+    return recover_dump_status_;
+}
+
 Status DBImpl::RecoverLastDumpToLevel0(VersionEdit* edit) {
     MutexLock lock(&mutex_);
-    Status status;
+    Status status = WaitForRecoverDump();
     if (recover_mem_ == NULL) {
         return status;
     }
-    if (recover_mem_->GetLastSequence() > 0) {
+    if (status.ok() && recover_mem_->GetLastSequence() > 0) {
         edit->SetLastSequence(recover_mem_->GetLastSequence());
         status = WriteLevel0Table(recover_mem_, edit, NULL);
     }
@@ -749,18 +878,175 @@ Status DBImpl::RecoverLastDumpToLevel0(VersionEdit* edit) {
     return status;
 }
 
+Status DBImpl::PrepareIngestFiles(const std::vector<std::string>& files,
+                                  std::vector<FileMetaData>* metas) {
+    Status s;
+    ReadOptions read_options;
+    read_options.fill_cache = false;
+    for (size_t i = 0; i < files.size() && s.ok(); ++i) {
+        FileMetaData meta;
+        RandomAccessFile* file = NULL;
+        Table* table = NULL;
+        s = env_->GetFileSize(files[i], &meta.file_size);
+        if (s.ok()) {
+            s = env_->NewRandomAccessFile(files[i], &file);
+        }
+        if (s.ok()) {
+            s = Table::Open(options_, file, meta.file_size, &table);
+        }
+        if (s.ok()) {
+            Iterator* iter = table->NewIterator(read_options);
+            iter->SeekToFirst();
+            if (iter->Valid()) {
+                meta.smallest.DecodeFrom(iter->key());
+                iter->SeekToLast();
+                meta.largest.DecodeFrom(iter->key());
+            }
+            s = iter->status();
+            delete iter;
+        }
+        delete table;
+        delete file;
+        if (!s.ok()) {
+            Log(options_.info_log, "[%s] fail to open ingest file %s: %s",
+                dbname_.c_str(), files[i].c_str(), s.ToString().c_str());
+            break;
+        }
+
+        ParsedInternalKey smallest, largest;
+        if (meta.smallest.Encode().empty()
+            || !ParseInternalKey(meta.smallest.Encode(), &smallest)
+            || !ParseInternalKey(meta.largest.Encode(), &largest)) {
+            s = Status::Corruption("bad or empty ingest file", files[i]);
+        } else if (smallest.sequence != 0 || largest.sequence != 0) {
+            s = Status::InvalidArgument("ingest file not built by TableFileWriter",
+                                        files[i]);
+        } else if (!UserKeyInRange(smallest.user_key)
+                   || !UserKeyInRange(largest.user_key)) {
+            s = Status::InvalidArgument("ingest file out of db range", files[i]);
+        }
+        metas->push_back(meta);
+    }
+    return s;
+}
+
+Status DBImpl::AddIngestedFiles(const std::vector<std::string>& files,
+                                const std::vector<FileMetaData>& metas,
+                                std::vector<uint64_t>* numbers) {
+    assert(files.size() == metas.size());
+    MutexLock l(&mutex_);
+    // version changes are serialized with background compactions, so no
+    // running compaction outputs files overlapping the ingested ones
+    ingest_pending_++;
+    while (bg_compaction_scheduled_) {
+        bg_cv_.Wait();
+    }
+
+    // Ingested entries are older than any entry in the db, so they go to
+    // the last level, where they are shadowed by all the levels above.  A
+    // file overlapping the last level, or another ingested file, is
+    // refused: in level-0 it would shadow newer entries of older levels.
+    Version* current = versions_->current();
+    current->Ref();
+    const int last_level = config::kNumLevels - 1;
+    Status s;
+    for (size_t i = 0; i < files.size() && s.ok(); ++i) {
+        Slice smallest = metas[i].smallest.user_key();
+        Slice largest = metas[i].largest.user_key();
+        if (current->OverlapInLevel(last_level, &smallest, &largest)) {
+            s = Status::InvalidArgument("ingest file overlaps the last level", files[i]);
+        }
+        for (size_t j = 0; j < i && s.ok(); ++j) {
+            if (user_comparator()->Compare(smallest, metas[j].largest.user_key()) <= 0
+                && user_comparator()->Compare(largest, metas[j].smallest.user_key()) >= 0) {
+                s = Status::InvalidArgument("ingest files overlap", files[i]);
+            }
+        }
+    }
+    current->Unref();
+
+    VersionEdit edit;
+    std::vector<uint64_t> added;
+    for (size_t i = 0; i < files.size() && s.ok(); ++i) {
+        const FileMetaData& meta = metas[i];
+        uint64_t number = BuildFullFileNumber(dbname_, versions_->NewFileNumber());
+        pending_outputs_.insert(number);
+        s = env_->RenameFile(files[i], TableFileName(dbname_, number));
+        if (!s.ok()) {
+            pending_outputs_.erase(number);
+            break;
+        }
+        added.push_back(number);
+        edit.AddFile(last_level, number, meta.file_size, meta.smallest, meta.largest);
+        Log(options_.info_log, "[%s] ingest %s as #%llu to level %d, %llu bytes",
+            dbname_.c_str(), files[i].c_str(),
+            static_cast<unsigned long long>(number), last_level,
+            static_cast<unsigned long long>(meta.file_size));
+    }
+    if (s.ok()) {
+        s = versions_->LogAndApply(&edit, &mutex_);
+    }
+    if (!s.ok()) {
+        Log(options_.info_log, "[%s] fail to ingest files: %s",
+            dbname_.c_str(), s.ToString().c_str());
+        // give the files back to the caller
+        for (size_t i = 0; i < added.size(); ++i) {
+            env_->RenameFile(TableFileName(dbname_, added[i]), files[i]);
+        }
+    }
+    for (size_t i = 0; i < added.size(); ++i) {
+        pending_outputs_.erase(added[i]);
+    }
+    if (s.ok()) {
+        numbers->swap(added);
+    }
+    return s;
+}
+
+Status DBImpl::RemoveIngestedFiles(const std::vector<std::string>& files,
+                                   const std::vector<uint64_t>& numbers) {
+    assert(files.size() == numbers.size());
+    MutexLock l(&mutex_);
+    assert(ingest_pending_ > 0);
+    VersionEdit edit;
+    for (size_t i = 0; i < numbers.size(); ++i) {
+        // keep the files from DeleteObsoleteFiles() until they are moved out
+        pending_outputs_.insert(numbers[i]);
+        edit.DeleteFile(config::kNumLevels - 1, numbers[i]);
+    }
+    Status s = versions_->LogAndApply(&edit, &mutex_);
+    for (size_t i = 0; i < numbers.size(); ++i) {
+        if (s.ok()) {
+            env_->RenameFile(TableFileName(dbname_, numbers[i]), files[i]);
+        }
+        pending_outputs_.erase(numbers[i]);
+    }
+    Log(options_.info_log, "[%s] remove %lu ingested files: %s",
+        dbname_.c_str(), numbers.size(), s.ToString().c_str());
+    return s;
+}
+
+void DBImpl::EndIngestFiles() {
+    MutexLock l(&mutex_);
+    assert(ingest_pending_ > 0);
+    ingest_pending_--;
+    MaybeScheduleCompaction();
+}
+
 // end of tera-specific
 
 void DBImpl::MaybeScheduleCompaction() {
   mutex_.AssertHeld();
   if (shutting_down_.Acquire_Load()) {
     // DB is being deleted; no more background compactions
+  } else if (ingest_pending_ > 0) {
+    // Scheduled again when the ingestion is done
   } else {
     double score = versions_->CompactionScore();
     if (manual_compaction_ != NULL) {
         score = 10.0;
     }
-    if (imm_ != NULL) {
+    if (!imm_list_.empty()) {
         score = 100.0;
     }
     if (score > 0) {
@@ -791,7 +1077,7 @@ void DBImpl::BGWork(void* db) {
 void DBImpl::BackgroundCall() {
   MutexLock l(&mutex_);
   assert(bg_compaction_scheduled_);
-  if (!shutting_down_.Acquire_Load()) {
+  if (!shutting_down_.Acquire_Load() && ingest_pending_ == 0) {
     Status s = BackgroundCompaction();
     if (s.ok()) {
       // Success
@@ -832,7 +1118,7 @@ void DBImpl::BackgroundCall() {
 Status DBImpl::BackgroundCompaction() {
   mutex_.AssertHeld();
 
-  if (imm_ != NULL) {
+  if (!imm_list_.empty()) {
     return CompactMemTable();
   }
 
@@ -1080,7 +1366,7 @@ Status DBImpl::DoCompactionWork(CompactionState* compact) {
     if (has_imm_.NoBarrier_Load() != NULL) {
       const uint64_t imm_start = env_->NowMicros();
       mutex_.Lock();
-      if (imm_ != NULL) {
+      if (!imm_list_.empty()) {
         CompactMemTable();
         bg_cv_.SignalAll();  // Wakeup MakeRoomForWrite() if necessary
       }
@@ -1233,14 +1519,16 @@ struct IterState {
   port::Mutex* mu;
   Version* version;
   MemTable* mem;
-  MemTable* imm;
+  std::vector<MemTable*> imms;
 };
 
 static void CleanupIteratorState(void* arg1, void* arg2) {
   IterState* state = reinterpret_cast<IterState*>(arg1);
   state->mu->Lock();
   state->mem->Unref();
-  if (state->imm != NULL) state->imm->Unref();
+  for (size_t i = 0; i < state->imms.size(); ++i) {
+    state->imms[i]->Unref();
+  }
   state->version->Unref();
   state->mu->Unlock();
   delete state;
@@ -1253,18 +1541,20 @@ Iterator* DBImpl::NewInternalIterator(const ReadOptions& options,
   *latest_snapshot = GetLastSequence(false);
 
   MemTable* mem = mem_;
-  MemTable* imm = imm_;
+  std::vector<MemTable*> imms(imm_list_);
   Version* current = versions_->current();
   mem->Ref();
-  if (imm != NULL) imm->Ref();
+  for (size_t i = 0; i < imms.size(); ++i) {
+    imms[i]->Ref();
+  }
   current->Ref();
   mutex_.Unlock();
 
   // Collect together all needed child iterators
   std::vector<Iterator*> list;
   list.push_back(mem->NewIterator());
-  if (imm != NULL) {
-    list.push_back(imm->NewIterator());
+  for (size_t i = 0; i < imms.size(); ++i) {
+    list.push_back(imms[i]->NewIterator());
   }
   current->AddIterators(options, &list);
   Iterator* internal_iter =
@@ -1272,7 +1562,7 @@ Iterator* DBImpl::NewInternalIterator(const ReadOptions& options,
 
   cleanup->mu = &mutex_;
   cleanup->mem = mem;
-  cleanup->imm = imm;
+  cleanup->imms.swap(imms);
   cleanup->version = current;
   internal_iter->RegisterCleanup(CleanupIteratorState, cleanup, NULL);
 
@@ -1302,10 +1592,12 @@ Status DBImpl::Get(const ReadOptions& options,
   }
 
   MemTable* mem = mem_;
-  MemTable* imm = imm_;
+  std::vector<MemTable*> imms(imm_list_);
   Version* current = versions_->current();
   mem->Ref();
-  if (imm != NULL) imm->Ref();
+  for (size_t i = 0; i < imms.size(); ++i) {
+    imms[i]->Ref();
+  }
   current->Ref();
 
   bool have_stat_update = false;
@@ -1314,13 +1606,14 @@ Status DBImpl::Get(const ReadOptions& options,
   // Unlock while reading from files and memtables
   {
     mutex_.Unlock();
-    // First look in the memtable, then in the immutable memtable (if any).
+    // First look in the memtable, then in the immutable memtables
+    // from the newest to the oldest.
     LookupKey lkey(key, snapshot);
-    if (mem->Get(lkey, value, &s)) {
-      // Done
-    } else if (imm != NULL && imm->Get(lkey, value, &s)) {
-      // Done
-    } else {
+    bool done = mem->Get(lkey, value, &s);
+    for (size_t i = imms.size(); !done && i > 0; --i) {
+      done = imms[i - 1]->Get(lkey, value, &s);
+    }
+    if (!done) {
       s = current->Get(options, lkey, value, &stats);
       have_stat_update = true;
     }
@@ -1331,7 +1624,9 @@ Status DBImpl::Get(const ReadOptions& options,
     MaybeScheduleCompaction();
   }
   mem->Unref();
-  if (imm != NULL) imm->Unref();
+  for (size_t i = 0; i < imms.size(); ++i) {
+    imms[i]->Unref();
+  }
   current->Unref();
   return s;
 }
@@ -1376,6 +1671,59 @@ bool DBImpl::BusyWrite() {
   return (versions_->NumLevelFiles(0) >= options_.l0_slowdown_writes_trigger);
 }
 
+// Map "value" in [start, limit] linearly to [0, 1].
+static double ThrottleRatio(double value, double start, double limit) {
+  if (limit <= start || value <= start) {
+    return 0;
+  }
+  if (value >= limit) {
+    return 1;
+  }
+  return (value - start) / (limit - start);
+}
+
+uint64_t DBImpl::WriteThrottleDelay(std::string* reason) {
+  MutexLock l(&mutex_);
+  double ratio = 0;
+  const char* dominant = "";
+
+  double l0_ratio = ThrottleRatio(versions_->NumLevelFiles(0),
+                                  options_.l0_throttle_writes_trigger,
+                                  options_.l0_slowdown_writes_trigger);
+  if (l0_ratio > ratio) {
+    ratio = l0_ratio;
+    dominant = "level0_files";
+  }
+
+  if (options_.pending_compaction_limit_bytes > 0) {
+    double pending_ratio = ThrottleRatio(versions_->PendingCompactionBytes(),
+                                         options_.pending_compaction_throttle_bytes,
+                                         options_.pending_compaction_limit_bytes);
+    if (pending_ratio > ratio) {
+      ratio = pending_ratio;
+      dominant = "pending_compaction";
+    }
+  }
+
+  // the immutable memtable queue is full, the writer will
+  // stall once the current one fills up
+  if (imm_list_.size() >= static_cast<size_t>(options_.max_imm_num)
+      && options_.write_buffer_size > 0) {
+    double mem_ratio = ThrottleRatio(mem_->ApproximateMemoryUsage(),
+                                     options_.write_buffer_size / 2,
+                                     options_.write_buffer_size);
+    if (mem_ratio > ratio) {
+      ratio = mem_ratio;
+      dominant = "memtable";
+    }
+  }
+
+  if (reason != NULL) {
+    reason->assign(dominant);
+  }
+  return static_cast<uint64_t>(ratio * options_.max_write_delay_micros);
+}
+
 Status DBImpl::Write(const WriteOptions& options, WriteBatch* my_batch) {
   Writer w(&mutex_);
   w.batch = my_batch;
@@ -1416,7 +1764,7 @@ Status DBImpl::Write(const WriteOptions& options, WriteBatch* my_batch) {
     if (WriteBatchInternal::Count(updates) > 0) {
       mem_->SetNonEmpty();
     }
-    if (mem_->Empty() && imm_ == NULL) {
+    if (mem_->Empty() && imm_list_.empty()) {
       versions_->SetLastSequence(batch_sequence - 1);
     }
   }
@@ -1425,6 +1773,8 @@ Status DBImpl::Write(const WriteOptions& options, WriteBatch* my_batch) {
     Writer* ready = writers_.front();
     writers_.pop_front();
     if (ready != &w) {
+      // writers with NULL batch are never grouped, see BeginConcurrentWrite()
+      assert(ready->batch != NULL);
       ready->status = status;
       ready->done = true;
       ready->cv.Signal();
@@ -1442,6 +1792,63 @@ Status DBImpl::Write(const WriteOptions& options, WriteBatch* my_batch) {
   return status;
 }
 
+Status DBImpl::BeginConcurrentWrite() {
+  assert(options_.use_concurrent_memtable);
+  Writer* w = new Writer(&mutex_);
+  w->batch = NULL;
+  w->sync = false;
+  w->done = false;
+
+  MutexLock l(&mutex_);
+  writers_.push_back(w);
+  // BuildBatchGroup() ends a group at the first writer with NULL batch,
+  // so "w" is never completed by another writer, and leaves the queue
+  // only after it becomes the head.
+  while (w != writers_.front()) {
+    w->cv.Wait();
+  }
+  Status s = MakeRoomForWrite(false);
+  if (s.ok()) {
+    is_writting_mem_ = true;
+    concurrent_writer_ = w;
+    return s;
+  }
+  writers_.pop_front();
+  if (!writers_.empty()) {
+    writers_.front()->cv.Signal();
+  }
+  delete w;
+  return s;
+}
+
+Status DBImpl::InsertConcurrently(WriteBatch* batch) {
+  // mem_ can not be switched until EndConcurrentWrite(), since only the
+  // head of the write queue switches it.
+  assert(concurrent_writer_ != NULL);
+  Status s = WriteBatchInternal::InsertInto(batch, mem_);
+  if (WriteBatchInternal::Count(batch) > 0 && mem_->Empty()) {
+    mem_->SetNonEmpty();
+  }
+  return s;
+}
+
+void DBImpl::EndConcurrentWrite(SequenceNumber last_sequence) {
+  MutexLock l(&mutex_);
+  Writer* w = concurrent_writer_;
+  assert(w != NULL && w == writers_.front());
+  concurrent_writer_ = NULL;
+  if (mem_->Empty() && imm_list_.empty()) {
+    versions_->SetLastSequence(last_sequence);
+  }
+  writers_.pop_front();
+  if (!writers_.empty()) {
+    writers_.front()->cv.Signal();
+  }
+  is_writting_mem_ = false;
+  writting_mem_cv_.Signal();
+  delete w;
+}
+
 // REQUIRES: Writer list must be non-empty
 // REQUIRES: First writer must have a non-NULL batch
 WriteBatch* DBImpl::BuildBatchGroup(Writer** last_writer) {
@@ -1486,6 +1893,8 @@ WriteBatch* DBImpl::BuildBatchGroup(Writer** last_writer) {
       }
       WriteBatchInternal::Append(result, w->batch);
     } else {
+      // A NULL batch is a forced memtable switch or a concurrent write,
+      // which must be handled by its own writer
       break;
     }
     *last_writer = w;
@@ -1524,11 +1933,11 @@ Status DBImpl::MakeRoomForWrite(bool force) {
                (mem_->ApproximateMemoryUsage() <= options_.write_buffer_size)) {
       // There is room in current memtable
       break;
-    } else if (imm_ != NULL) {
+    } else if (imm_list_.size() >= static_cast<size_t>(options_.max_imm_num)) {
       // We have filled up the current memtable, but the previous
-      // one is still being compacted, so we wait.
-      Log(options_.info_log, "[%s] Current memtable full; waiting...\n",
-          dbname_.c_str());
+      // ones are still being compacted, so we wait.
+      Log(options_.info_log, "[%s] Current memtable full, %lu imm queued; waiting...\n",
+          dbname_.c_str(), imm_list_.size());
       bg_cv_.Wait();
     } else if (versions_->NumLevelFiles(0) >= config::kL0_StopWritesTrigger) {
       // There are too many level-0 files.
@@ -1536,8 +1945,8 @@ Status DBImpl::MakeRoomForWrite(bool force) {
           dbname_.c_str());
       bg_cv_.Wait();
     } else {
-      imm_ = mem_;
-      has_imm_.Release_Store(imm_);
+      imm_list_.push_back(mem_);
+      has_imm_.Release_Store(imm_list_.front());
       mem_ = NewMemTable();
       mem_->Ref();
       bound_log_size_ = 0;
@@ -1558,8 +1967,8 @@ void DBImpl::AddBoundLogSize(uint64_t size) {
     if (bound_log_size_ < options_.flush_triggered_log_size) {
       return;
     }
-    if (imm_ != NULL) {
-      Log(options_.info_log, "[%s] [TimeoutCompaction] imm_ != NULL", dbname_.c_str());
+    if (!imm_list_.empty()) {
+      Log(options_.info_log, "[%s] [TimeoutCompaction] imm_list_ not empty", dbname_.c_str());
       return;
     }
   }
@@ -1659,8 +2068,8 @@ uint64_t DBImpl::GetLastSequence(bool is_locked) {
   uint64_t retval;
   if (mem_->GetLastSequence() > 0) {
     retval = mem_->GetLastSequence();
-  } else if (imm_ != NULL && imm_->GetLastSequence()) {
-    retval = imm_->GetLastSequence();
+  } else if (!imm_list_.empty() && imm_list_.back()->GetLastSequence()) {
+    retval = imm_list_.back()->GetLastSequence();
   } else {
     retval = versions_->LastSequence();
   }
@@ -1670,10 +2079,22 @@ uint64_t DBImpl::GetLastSequence(bool is_locked) {
   return retval;
 }
 
+// About one bucket per 256 bytes of write buffer, rounded to a power of 2
+static size_t MemTableHashBuckets(size_t write_buffer_size) {
+  size_t buckets = 1024;
+  while (buckets < (write_buffer_size >> 8) && buckets < (1U << 22)) {
+    buckets <<= 1;
+  }
+  return buckets;
+}
+
 MemTable* DBImpl::NewMemTable() const {
     if (!options_.use_memtable_on_leveldb) {
         return new MemTable(internal_comparator_,
-                  options_.enable_strategy_when_get ? options_.compact_strategy_factory : NULL);
+                  options_.enable_strategy_when_get ? options_.compact_strategy_factory : NULL,
+                  options_.use_concurrent_memtable,
+                  options_.memtable_hash_index ?
+                      MemTableHashBuckets(options_.write_buffer_size) : 0);
     } else {
         return new MemTableOnLevelDB(internal_comparator_,
                                      options_.compact_strategy_factory,
@@ -11,6 +11,7 @@
 
 #include <deque>
 #include <set>
+#include <vector>
 #include "db/db_table.h"
 #include "db/dbformat.h"
 #include "db/log_writer.h"
@@ -23,6 +24,7 @@ namespace leveldb {
 
 class MemTable;
 class TableCache;
+class ThreadPool;
 class Version;
 class VersionEdit;
 class VersionSet;
@@ -51,8 +53,22 @@ class DBImpl : public DB {
 
   void AddBoundLogSize(uint64_t size);
 
+  // Concurrent memtable insertion, used by DBTable to let the writers of
+  // one write group insert their own batches in parallel.
+  // BeginConcurrentWrite() becomes the head of the write queue and makes
+  // room in the memtable, then any number of threads may call
+  // InsertConcurrently() until EndConcurrentWrite() releases the queue.
+  // REQUIRES: options.use_concurrent_memtable
+  Status BeginConcurrentWrite();
+  Status InsertConcurrently(WriteBatch* batch);
+  void EndConcurrentWrite(SequenceNumber last_sequence);
+  bool UseConcurrentMemtable() const {
+    return options_.use_concurrent_memtable;
+  }
+
   // tera-specific
   virtual bool BusyWrite();
+  virtual uint64_t WriteThrottleDelay(std::string* reason);
   bool FindSplitKey(const std::string& start_key,
                     const std::string& end_key,
                     double ratio,
@@ -61,6 +77,13 @@ class DBImpl : public DB {
   uint64_t GetScopeSizeOld(const std::string& start_key, const std::string& end_key);
   void CompactMissFiles(const Slice* begin, const Slice* end);
 
+  // Read the current version from disk and open the files overlapping
+  // [key_start_, key_end_) through table_cache, see WarmUpDB().  Takes no
+  // file lock and writes nothing, so it may run while another node still
+  // owns the db.
+  Status WarmUp(TableCache* table_cache, uint64_t max_data_size,
+                std::vector<uint64_t>* files);
+
   // Add all sst files inherited from other tablets
   virtual void AddInheritedLiveFiles(std::vector<std::set<uint64_t> >* live);
 
@@ -115,6 +138,11 @@ class DBImpl : public DB {
   Status WriteLevel0Table(MemTable* mem, VersionEdit* edit, Version* base)
       EXCLUSIVE_LOCKS_REQUIRED(mutex_);
 
+  // Merge "mems" into one level0 table.
+  Status WriteLevel0Table(const std::vector<MemTable*>& mems,
+                          VersionEdit* edit, Version* base)
+      EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
   Status MakeRoomForWrite(bool force /* compact even if there is room? */)
       EXCLUSIVE_LOCKS_REQUIRED(mutex_);
   WriteBatch* BuildBatchGroup(Writer** last_writer);
@@ -137,8 +165,29 @@ class DBImpl : public DB {
   std::string key_start_;
   std::string key_end_;
   bool UserKeyInRange(const Slice& user_key);
-  Status RecoverInsertMem(WriteBatch* wb, VersionEdit* edit);
+  // If "dump_pool" is not NULL, an oversized recovered memtable is dumped
+  // to level-0 on it while the recovery goes on, at most one at a time.
+  Status RecoverInsertMem(WriteBatch* wb, VersionEdit* edit,
+                          ThreadPool* dump_pool = NULL);
   Status RecoverLastDumpToLevel0(VersionEdit* edit);
+  static void RecoverDumpWrapper(void* db);
+  void RecoverDump();
+  Status WaitForRecoverDump() EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  // Check the sst files to ingest and fill "metas", the db is unchanged.
+  Status PrepareIngestFiles(const std::vector<std::string>& files,
+                            std::vector<FileMetaData>* metas);
+  // Move the prepared files into the db and add them to the last level,
+  // their numbers are stored in "numbers".  Compactions are held off until
+  // EndIngestFiles(), even if this fails, so that RemoveIngestedFiles()
+  // can still take the added files out.
+  Status AddIngestedFiles(const std::vector<std::string>& files,
+                          const std::vector<FileMetaData>& metas,
+                          std::vector<uint64_t>* numbers);
+  // Undo AddIngestedFiles(), the files are moved back to "files".
+  Status RemoveIngestedFiles(const std::vector<std::string>& files,
+                             const std::vector<uint64_t>& numbers);
+  void EndIngestFiles();
 
   uint64_t GetLastSequence(bool is_locked = true);
   uint64_t GetLastVerSequence();
@@ -168,9 +217,14 @@ class DBImpl : public DB {
   port::CondVar writting_mem_cv_; // Writer is writting mem_
   bool is_writting_mem_;
   MemTable* mem_;
-  MemTable* imm_;                // Memtable being compacted
+  // Immutable memtables waiting to be compacted, oldest first.
+  // At most options_.max_imm_num of them are kept before writers stall.
+  std::vector<MemTable*> imm_list_;
   MemTable* recover_mem_;
-  port::AtomicPointer has_imm_;  // So bg thread can detect non-NULL imm_
+  MemTable* recover_imm_;       // Recovered memtable being dumped
+  VersionEdit* recover_edit_;   // Edit to record the dump of recover_imm_
+  Status recover_dump_status_;
+  port::AtomicPointer has_imm_;  // So bg thread can detect non-empty imm_list_
   WritableFile* logfile_;
   uint64_t logfile_number_;
   log::Writer* log_;
@@ -193,6 +247,10 @@ class DBImpl : public DB {
   double bg_compaction_score_;
   int64_t bg_schedule_id_;
 
+  // Number of ingestions waiting for or changing the version, no
+  // background compaction runs meanwhile
+  int ingest_pending_;
+
   // Information for a manual compaction
   struct ManualCompaction {
     int level;
@@ -203,6 +261,10 @@ class DBImpl : public DB {
   };
   ManualCompaction* manual_compaction_;
 
+  // Head of the write queue during a concurrent write, see
+  // BeginConcurrentWrite()
+  Writer* concurrent_writer_;
+
   VersionSet* versions_;
 
   // Have we encountered a background error in paranoid mode?
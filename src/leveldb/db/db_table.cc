@@ -14,7 +14,7 @@
 #include "db/lg_compact_thread.h"
 #include "db/log_reader.h"
 #include "db/memtable.h"
-#include "db/memtable.h"
+#include "db/table_cache.h"
 #include "db/version_edit.h"
 #include "db/version_set.h"
 #include "db/write_batch_internal.h"
@@ -25,7 +25,9 @@
 #include "leveldb/write_batch.h"
 #include "leveldb/table_utils.h"
 #include "table/merger.h"
+#include "util/mutexlock.h"
 #include "util/string_ext.h"
+#include "util/thread_pool.h"
 
 namespace leveldb {
 
@@ -34,11 +36,96 @@ struct DBTable::RecordWriter {
     WriteBatch* batch;
     bool sync;
     bool done;
+    bool insert_pending; // asked by the leader to insert batch concurrently
+    port::CondVar cv;
+
+    explicit RecordWriter(port::Mutex* mu) : insert_pending(false), cv(mu) {}
+};
+
+// Records read ahead of the replay, split into the batches of every lg
+struct DBTable::RecoverChunk {
+    std::vector<std::vector<WriteBatch*> > lg_batches;
+    size_t size;
+
+    explicit RecoverChunk(uint32_t lg_num) : lg_batches(lg_num), size(0) {}
+    ~RecoverChunk() {
+        for (uint32_t i = 0; i < lg_batches.size(); ++i) {
+            for (uint32_t j = 0; j < lg_batches[i].size(); ++j) {
+                delete lg_batches[i][j];
+            }
+        }
+    }
+};
+
+struct DBTable::RecoverTask {
+    DBTable* db;
+    RecoverState* state;
+    uint32_t lg;
+};
+
+struct DBTable::RecoverState {
+    port::Mutex mu;
     port::CondVar cv;
+    ThreadPool* pool;
+    std::vector<RecoverTask> tasks;
+    std::vector<uint64_t> lg_last_seq;
+    std::vector<VersionEdit*>* edit_list;
+    RecoverChunk* chunk;  // being replayed
+    std::vector<Status> lg_status;
+    uint32_t running_lg;
+
+    RecoverState()
+        : cv(&mu), pool(NULL), edit_list(NULL), chunk(NULL), running_lg(0) {}
+};
 
-    explicit RecordWriter(port::Mutex* mu) : cv(mu) {}
+// At most two chunks are kept in memory: the one being replayed and the
+// one being read.
+static const size_t kRecoverChunkSize = 4 << 20;
+
+namespace {
+
+struct LogReporter : public log::Reader::Reporter {
+    Env* env;
+    Logger* info_log;
+    const char* fname;
+    Status* status;  // NULL if options_.paranoid_checks==false
+    virtual void Corruption(size_t bytes, const Status& s) {
+        Log(info_log, "%s%s: dropping %d bytes; %s",
+            (this->status == NULL ? "(ignoring error) " : ""),
+            fname, static_cast<int>(bytes), s.ToString().c_str());
+        if (this->status != NULL && this->status->ok()) *this->status = s;
+    }
 };
 
+port::OnceType recover_pool_once = LEVELDB_ONCE_INIT;
+ThreadPool* recover_pool = NULL;
+// Replays wait for the dumps they schedule, so the dumps have a pool of
+// their own and never queue behind the replays.
+ThreadPool* recover_dump_pool = NULL;
+
+void InitRecoverPool() {
+    recover_pool = new ThreadPool();
+    recover_dump_pool = new ThreadPool();
+}
+
+ThreadPool* RecoverPool(int threads) {
+    port::InitOnce(&recover_pool_once, InitRecoverPool);
+    if (recover_pool->GetThreadNumber() != threads) {
+        recover_pool->SetBackgroundThreads(threads);
+    }
+    return recover_pool;
+}
+
+ThreadPool* RecoverDumpPool(int threads) {
+    port::InitOnce(&recover_pool_once, InitRecoverPool);
+    if (recover_dump_pool->GetThreadNumber() != threads) {
+        recover_dump_pool->SetBackgroundThreads(threads);
+    }
+    return recover_dump_pool;
+}
+
+}  // namespace
+
 Options InitDefaultOptions(const Options& options, const std::string& dbname) {
     Options opt = options;
     Status s = opt.env->CreateDir(dbname);
@@ -83,14 +170,79 @@ Options InitOptionsLG(const Options& options, uint32_t lg_id) {
         opt.env = lg_info->env;
     }
     opt.compression = lg_info->compression;
+    opt.compression_dict_size = lg_info->compression_dict_size;
     opt.block_size = lg_info->block_size;
     opt.use_memtable_on_leveldb = lg_info->use_memtable_on_leveldb;
     opt.memtable_ldb_write_buffer_size = lg_info->memtable_ldb_write_buffer_size;
     opt.memtable_ldb_block_size = lg_info->memtable_ldb_block_size;
     opt.sst_size = lg_info->sst_size;
+    opt.block_hash_index = lg_info->block_hash_index;
     return opt;
 }
 
+// The tables opened by a warm up refer to the comparator and filter
+// policy of its DBImpl, so they are evicted before the DBImpl goes.
+class DBTableWarmUp : public WarmUpHandle {
+public:
+    explicit DBTableWarmUp(TableCache* table_cache)
+        : table_cache_(table_cache) {}
+    virtual ~DBTableWarmUp() {
+        for (uint32_t i = 0; i < lg_list_.size(); ++i) {
+            for (uint32_t j = 0; j < files_[i].size(); ++j) {
+                table_cache_->Evict(lg_names_[i], files_[i][j]);
+            }
+            delete lg_list_[i];
+        }
+    }
+
+    Status WarmUpLG(const Options& options, const std::string& lgname,
+                    uint64_t max_data_size) {
+        // The version set of the warm up must not evict from the shared
+        // table cache on its own, so it is given a private one.
+        Options opt = options;
+        opt.table_cache = NULL;
+        lg_list_.push_back(new DBImpl(opt, lgname));
+        lg_names_.push_back(lgname);
+        files_.resize(files_.size() + 1);
+        return lg_list_.back()->WarmUp(table_cache_, max_data_size, &files_.back());
+    }
+
+private:
+    TableCache* table_cache_;
+    std::vector<DBImpl*> lg_list_;
+    std::vector<std::string> lg_names_;
+    std::vector<std::vector<uint64_t> > files_;
+};
+
+Status WarmUpDB(const std::string& dbname, const Options& options,
+                uint64_t max_data_size, WarmUpHandle** handle) {
+    *handle = NULL;
+    // A private info log would rotate the LOG file of the owner.
+    if (options.block_cache == NULL || options.table_cache == NULL ||
+        options.info_log == NULL) {
+        return Status::InvalidArgument(dbname, "warm up needs shared caches and log");
+    }
+    std::set<uint32_t> default_lg_list;
+    default_lg_list.insert(0);
+    const std::set<uint32_t>* lg_list =
+        options.exist_lg_list ? options.exist_lg_list : &default_lg_list;
+
+    DBTableWarmUp* warm_up = new DBTableWarmUp(options.table_cache);
+    Status s;
+    std::set<uint32_t>::const_iterator it = lg_list->begin();
+    for (; it != lg_list->end() && s.ok(); ++it) {
+        s = warm_up->WarmUpLG(InitOptionsLG(options, *it),
+                              dbname + "/" + Uint64ToString(*it),
+                              max_data_size / lg_list->size());
+    }
+    if (!s.ok()) {
+        delete warm_up;
+        return s;
+    }
+    *handle = warm_up;
+    return s;
+}
+
 DBTable::DBTable(const Options& options, const std::string& dbname)
     : shutdown_phase_(0), shutting_down_(NULL), bg_cv_(&mutex_),
       bg_cv_timer_(&mutex_), bg_cv_sleeper_(&mutex_),
@@ -102,6 +254,7 @@ DBTable::DBTable(const Options& options, const std::string& dbname)
       commit_snapshot_(kMaxSequenceNumber), logfile_(NULL), log_(NULL), force_switch_log_(false),
       last_sequence_(0), current_log_size_(0),
       tmp_batch_(new WriteBatch),
+      concurrent_pending_(0),
       bg_schedule_gc_(false), bg_schedule_gc_id_(0),
       bg_schedule_gc_score_(0), force_clean_log_seq_(0) {
 }
@@ -257,7 +410,13 @@ Status DBTable::Init() {
     // recover log files
     std::vector<uint64_t> logfiles;
     s = GatherLogFile(min_log_sequence + 1, &logfiles);
-    if (s.ok()) {
+    if (s.ok() && options_.parallel_recover_threads > 0 && logfiles.size() > 0) {
+        s = ParallelRecoverLogFiles(logfiles, &lg_edits);
+        if (!s.ok()) {
+            Log(options_.info_log, "[%s] Fail to ParallelRecoverLogFiles",
+                dbname_.c_str());
+        }
+    } else if (s.ok()) {
         for (uint32_t i = 0; i < logfiles.size(); ++i) {
             // If two log files have overlap sequence id, ignore records
             // from old log.
@@ -347,6 +506,26 @@ bool DBTable::BusyWrite() {
     return false;
 }
 
+uint64_t DBTable::WriteThrottleDelay(std::string* reason) {
+    MutexLock l(&mutex_);
+    uint64_t max_delay = 0;
+    std::string lg_reason;
+    for (std::set<uint32_t>::iterator it = options_.exist_lg_list->begin();
+            it != options_.exist_lg_list->end(); ++it) {
+        uint64_t delay = lg_list_[*it]->WriteThrottleDelay(&lg_reason);
+        if (delay > max_delay) {
+            max_delay = delay;
+            if (reason != NULL) {
+                reason->assign(lg_reason);
+            }
+        }
+    }
+    if (max_delay == 0 && reason != NULL) {
+        reason->clear();
+    }
+    return max_delay;
+}
+
 Status DBTable::Write(const WriteOptions& options, WriteBatch* my_batch) {
     RecordWriter w(&mutex_);
     w.batch = my_batch;
@@ -356,6 +535,10 @@ Status DBTable::Write(const WriteOptions& options, WriteBatch* my_batch) {
     MutexLock l(&mutex_);
     writers_.push_back(&w);
     while (!w.done && &w != writers_.front()) {
+        if (w.insert_pending) {
+            ConcurrentInsert(&w);
+            continue;
+        }
         w.cv.Wait();
     }
     if (w.done) {
@@ -450,7 +633,14 @@ Status DBTable::Write(const WriteOptions& options, WriteBatch* my_batch) {
             lg_list_[i]->GetSnapshot(last_sequence_);
         }
         commit_snapshot_ = last_sequence_;
-        if (lg_list_.size() > 1) {
+        bool concurrent = (last_writer != &w);
+        for (uint32_t i = 0; i < lg_list_.size(); ++i) {
+            concurrent = concurrent && lg_list_[i]->UseConcurrentMemtable();
+        }
+        if (concurrent) {
+            s = ConcurrentWriteLG(last_writer,
+                                  last_sequence_ + WriteBatchInternal::Count(updates));
+        } else if (lg_list_.size() > 1) {
             updates->SeperateLocalityGroup(&lg_updates);
             created_new_wb = true;
         } else {
@@ -458,7 +648,7 @@ Status DBTable::Write(const WriteOptions& options, WriteBatch* my_batch) {
         }
         mutex_.Unlock();
         //TODO: should be multi-thread distributed
-        for (uint32_t i = 0; i < lg_updates.size(); ++i) {
+        for (uint32_t i = 0; i < lg_updates.size() && !concurrent; ++i) {
             assert(lg_updates[i] != NULL);
             Status lg_s = lg_list_[i]->Write(WriteOptions(), lg_updates[i]);
             if (!lg_s.ok()) {
@@ -519,6 +709,90 @@ Status DBTable::Write(const WriteOptions& options, WriteBatch* my_batch) {
     return s;
 }
 
+// REQUIRES: mutex_ held, and the log of the write group has been written
+Status DBTable::ConcurrentWriteLG(RecordWriter* last_writer,
+                                  uint64_t last_sequence) {
+    mutex_.Unlock();
+    Status s;
+    uint32_t begun = 0;
+    for (; begun < lg_list_.size(); ++begun) {
+        s = lg_list_[begun]->BeginConcurrentWrite();
+        if (!s.ok()) {
+            break;
+        }
+    }
+    mutex_.Lock();
+
+    if (s.ok()) {
+        // Every writer of the group inserts its own batch,
+        // the leader waits for all of them.
+        RecordWriter* leader = writers_.front();
+        uint64_t sequence = last_sequence_ + 1;
+        concurrent_pending_ = 0;
+        concurrent_status_ = Status::OK();
+        std::deque<RecordWriter*>::iterator iter = writers_.begin();
+        for (; ; ++iter) {
+            RecordWriter* w = *iter;
+            WriteBatchInternal::SetSequence(w->batch, sequence);
+            sequence += WriteBatchInternal::Count(w->batch);
+            w->insert_pending = true;
+            ++concurrent_pending_;
+            if (w != leader) {
+                w->cv.Signal();
+            }
+            if (w == last_writer) {
+                break;
+            }
+        }
+        assert(sequence == last_sequence + 1);
+        ConcurrentInsert(leader);
+        while (concurrent_pending_ > 0) {
+            leader->cv.Wait();
+        }
+        s = concurrent_status_;
+    }
+
+    mutex_.Unlock();
+    for (uint32_t i = 0; i < begun; ++i) {
+        lg_list_[i]->EndConcurrentWrite(last_sequence);
+    }
+    mutex_.Lock();
+    if (!s.ok()) {
+        // 这种情况下内存处于不一致状态
+        Log(options_.info_log, "[%s] [Fatal] Concurrent write to lg fail: %s",
+            dbname_.c_str(), s.ToString().c_str());
+        fatal_error_ = s;
+    }
+    return s;
+}
+
+// REQUIRES: mutex_ held, w->insert_pending
+void DBTable::ConcurrentInsert(RecordWriter* w) {
+    mutex_.Unlock();
+    Status s;
+    if (lg_list_.size() > 1) {
+        std::vector<WriteBatch*> lg_updates(lg_list_.size(), (WriteBatch*)0);
+        s = w->batch->SeperateLocalityGroup(&lg_updates);
+        for (uint32_t i = 0; i < lg_updates.size(); ++i) {
+            if (s.ok()) {
+                s = lg_list_[i]->InsertConcurrently(lg_updates[i]);
+            }
+            delete lg_updates[i];
+        }
+    } else {
+        s = lg_list_[0]->InsertConcurrently(w->batch);
+    }
+    mutex_.Lock();
+
+    w->insert_pending = false;
+    if (!s.ok() && concurrent_status_.ok()) {
+        concurrent_status_ = s;
+    }
+    if (--concurrent_pending_ == 0) {
+        writers_.front()->cv.Signal();
+    }
+}
+
 // REQUIRES: Writer list must be non-empty
 // REQUIRES: First writer must have a non-NULL batch
 WriteBatch* DBTable::GroupWriteBatch(RecordWriter** last_writer) {
@@ -724,19 +998,6 @@ Status DBTable::GatherLogFile(uint64_t begin_num,
 
 Status DBTable::RecoverLogFile(uint64_t log_number, uint64_t recover_limit,
                                std::vector<VersionEdit*>* edit_list) {
-    struct LogReporter : public log::Reader::Reporter {
-        Env* env;
-        Logger* info_log;
-        const char* fname;
-        Status* status;  // NULL if options_.paranoid_checks==false
-        virtual void Corruption(size_t bytes, const Status& s) {
-            Log(info_log, "%s%s: dropping %d bytes; %s",
-                (this->status == NULL ? "(ignoring error) " : ""),
-                fname, static_cast<int>(bytes), s.ToString().c_str());
-            if (this->status != NULL && this->status->ok()) *this->status = s;
-        }
-    };
-
     mutex_.AssertHeld();
 
     // Open the log file
@@ -835,6 +1096,192 @@ Status DBTable::RecoverLogFile(uint64_t log_number, uint64_t recover_limit,
     return status;
 }
 
+Status DBTable::ParallelRecoverLogFiles(const std::vector<uint64_t>& logfiles,
+                                        std::vector<VersionEdit*>* edit_list) {
+    mutex_.AssertHeld();
+    uint32_t lg_num = lg_list_.size();
+
+    RecoverState state;
+    state.pool = RecoverPool(options_.parallel_recover_threads);
+    state.edit_list = edit_list;
+    state.lg_status.resize(lg_num);
+    state.tasks.resize(lg_num);
+    for (uint32_t i = 0; i < lg_num; ++i) {
+        state.lg_last_seq.push_back(lg_list_[i]->GetLastSequence());
+        state.tasks[i].db = this;
+        state.tasks[i].state = &state;
+        state.tasks[i].lg = i;
+    }
+    Log(options_.info_log, "[%s] parallel recover %lu log files, %u lgs",
+        dbname_.c_str(), logfiles.size(), lg_num);
+
+    // this thread reads the log files chunk by chunk, while the lgs replay
+    // the previous chunk on the recover pool
+    RecoverChunk* chunk = new RecoverChunk(lg_num);
+    Status s;
+    for (uint32_t i = 0; i < logfiles.size() && s.ok(); ++i) {
+        // If two log files have overlap sequence id, ignore records
+        // from old log.
+        uint64_t recover_limit = kMaxSequenceNumber;
+        if (i < logfiles.size() - 1) {
+            recover_limit = logfiles[i + 1];
+        }
+        s = ReadLogFile(&state, logfiles[i], recover_limit, &chunk);
+        if (!s.ok()) {
+            Log(options_.info_log, "[%s] Fail to RecoverLogFile %ld",
+                dbname_.c_str(), logfiles[i]);
+        }
+    }
+    if (!s.ok()) {
+        delete chunk;
+        chunk = NULL;
+    }
+    Status replay_s = ReplayChunk(&state, chunk);
+    if (replay_s.ok()) {
+        replay_s = ReplayChunk(&state, NULL);
+    }
+    if (s.ok()) {
+        s = replay_s;
+    }
+    return s;
+}
+
+Status DBTable::ReadLogFile(RecoverState* state, uint64_t log_number,
+                            uint64_t recover_limit, RecoverChunk** chunk) {
+    mutex_.AssertHeld();
+    std::string fname = LogHexFileName(dbname_, log_number);
+    SequentialFile* file;
+    Status status = env_->NewSequentialFile(fname, &file);
+    if (!status.ok()) {
+        MaybeIgnoreError(&status);
+        return status;
+    }
+
+    LogReporter reporter;
+    reporter.env = env_;
+    reporter.info_log = options_.info_log;
+    reporter.fname = fname.c_str();
+    reporter.status = (options_.paranoid_checks ? &status : NULL);
+    log::Reader reader(file, &reporter, true/*checksum*/,
+                       0/*initial_offset*/);
+    Log(options_.info_log, "[%s] Recovering log #%lx, sequence limit %lu",
+        dbname_.c_str(), log_number, recover_limit);
+
+    std::string scratch;
+    Slice record;
+    WriteBatch batch;
+    uint32_t lg_num = lg_list_.size();
+    while (reader.ReadRecord(&record, &scratch) && status.ok()) {
+        if (record.size() < 12) {
+            reporter.Corruption(record.size(),
+                                Status::Corruption("log record too small"));
+            continue;
+        }
+        WriteBatchInternal::SetContents(&batch, record);
+        uint64_t first_seq = WriteBatchInternal::Sequence(&batch);
+        uint64_t last_seq = first_seq + WriteBatchInternal::Count(&batch) - 1;
+        if (last_seq >= recover_limit) {
+            Log(options_.info_log, "[%s] exceed limit %lu, ignore %lu ~ %lu",
+                dbname_.c_str(), recover_limit, first_seq, last_seq);
+            continue;
+        }
+        if (last_seq > last_sequence_) {
+            last_sequence_ = last_seq;
+        }
+
+        std::vector<WriteBatch*> lg_updates(lg_num, (WriteBatch*)NULL);
+        if (lg_num > 1) {
+            status = batch.SeperateLocalityGroup(&lg_updates);
+        } else {
+            lg_updates[0] = new WriteBatch;
+            WriteBatchInternal::SetContents(lg_updates[0], record);
+        }
+        for (uint32_t i = 0; i < lg_num; ++i) {
+            if (lg_updates[i] == NULL) {
+                continue;
+            }
+            if (status.ok() && last_seq > state->lg_last_seq[i]) {
+                (*chunk)->lg_batches[i].push_back(lg_updates[i]);
+            } else {
+                delete lg_updates[i];
+            }
+        }
+        (*chunk)->size += record.size();
+        if (status.ok() && (*chunk)->size >= kRecoverChunkSize) {
+            status = ReplayChunk(state, *chunk);
+            *chunk = new RecoverChunk(lg_num);
+        }
+    }
+    delete file;
+    return status;
+}
+
+Status DBTable::ReplayChunk(RecoverState* state, RecoverChunk* chunk) {
+    MutexLock l(&state->mu);
+    while (state->running_lg > 0) {
+        state->cv.Wait();
+    }
+    delete state->chunk;
+    state->chunk = NULL;
+
+    Status s;
+    for (uint32_t i = 0; i < state->lg_status.size(); ++i) {
+        if (!state->lg_status[i].ok()) {
+            s = state->lg_status[i];
+        }
+    }
+    if (chunk == NULL) {
+        return s;
+    }
+    if (!s.ok()) {
+        delete chunk;
+        return s;
+    }
+    state->chunk = chunk;
+    for (uint32_t i = 0; i < chunk->lg_batches.size(); ++i) {
+        if (chunk->lg_batches[i].size() > 0) {
+            state->running_lg++;
+            state->pool->Schedule(&DBTable::ReplayLogWrapper, &state->tasks[i], 0, 0);
+        }
+    }
+    return s;
+}
+
+void DBTable::ReplayLogWrapper(void* arg) {
+    RecoverTask* task = reinterpret_cast<RecoverTask*>(arg);
+    RecoverState* state = task->state;
+    Status s = task->db->ReplayLog(state, task->lg);
+    MutexLock l(&state->mu);
+    if (!s.ok()) {
+        state->lg_status[task->lg] = s;
+    }
+    state->running_lg--;
+    state->cv.SignalAll();
+}
+
+Status DBTable::ReplayLog(RecoverState* state, uint32_t lg) {
+    ThreadPool* dump_pool = RecoverDumpPool(options_.parallel_recover_threads);
+    DBImpl* impl = lg_list_[lg];
+    VersionEdit* edit = (*state->edit_list)[lg];
+    // every lg only touches its own batches, and frees them as soon as
+    // they are replayed
+    std::vector<WriteBatch*>& batches = state->chunk->lg_batches[lg];
+    for (uint32_t i = 0; i < batches.size(); ++i) {
+        WriteBatch* batch = batches[i];
+        Status s = impl->RecoverInsertMem(batch, edit, dump_pool);
+        if (!s.ok()) {
+            uint64_t first = WriteBatchInternal::Sequence(batch);
+            uint64_t last = first + WriteBatchInternal::Count(batch) - 1;
+            Log(options_.info_log, "[%s] recover log fail lg %u batch first= %lu, last= %lu\n",
+                dbname_.c_str(), lg, first, last);
+            return s;
+        }
+        delete batch;
+        batches[i] = NULL;
+    }
+    return Status::OK();
+}
+
 void DBTable::MaybeIgnoreError(Status* s) const {
     if (s->ok() || options_.paranoid_checks) {
         // No change needed
@@ -922,12 +1369,15 @@ bool DBTable::FindSplitKey(const std::string& start_key,
                            std::string* split_key) {
     // sort by lg size
     std::map<uint64_t, DBImpl*> size_of_lg;
-    MutexLock l(&mutex_);
-    std::set<uint32_t>::iterator it = options_.exist_lg_list->begin();
-    for (; it != options_.exist_lg_list->end(); ++it) {
-        uint64_t size = lg_list_[*it]->GetScopeSize(start_key, end_key);
-        size_of_lg[size] = lg_list_[*it];
+    {
+        MutexLock l(&mutex_);
+        std::set<uint32_t>::iterator it = options_.exist_lg_list->begin();
+        for (; it != options_.exist_lg_list->end(); ++it) {
+            uint64_t size = lg_list_[*it]->GetScopeSize(start_key, end_key);
+            size_of_lg[size] = lg_list_[*it];
+        }
     }
+    // index blocks may be read from disk, don't block writers meanwhile
     std::map<uint64_t, DBImpl*>::reverse_iterator biggest_it =
         size_of_lg.rbegin();
     if (biggest_it == size_of_lg.rend()) {
@@ -987,6 +1437,53 @@ void DBTable::AddInheritedLiveFiles(std::vector<std::set<uint64_t> >* live) {
     //    dbname_.c_str());
 }
 
+Status DBTable::IngestFiles(
+        const std::map<uint32_t, std::vector<std::string> >& lg_files) {
+    std::map<uint32_t, std::vector<FileMetaData> > lg_metas;
+    std::map<uint32_t, std::vector<std::string> >::const_iterator it;
+    for (it = lg_files.begin(); it != lg_files.end(); ++it) {
+        if (it->first >= lg_list_.size()) {
+            return Status::InvalidArgument("ingest to a non-existent lg",
+                                           Uint64ToString(it->first));
+        }
+        Status s = lg_list_[it->first]->PrepareIngestFiles(it->second,
+                                                           &lg_metas[it->first]);
+        if (!s.ok()) {
+            return s;
+        }
+    }
+
+    // Every LG has its own manifest, so the LGs added before a failure are
+    // rolled back, which their held off compactions keep possible.
+    Status s;
+    std::map<uint32_t, std::vector<uint64_t> > lg_numbers;
+    std::map<uint32_t, std::vector<std::string> >::const_iterator added_end;
+    for (added_end = lg_files.begin(); added_end != lg_files.end(); ++added_end) {
+        s = lg_list_[added_end->first]->AddIngestedFiles(
+            added_end->second, lg_metas[added_end->first],
+            &lg_numbers[added_end->first]);
+        if (!s.ok()) {
+            Log(options_.info_log, "[%s] fail to ingest files to lg %u: %s",
+                dbname_.c_str(), added_end->first, s.ToString().c_str());
+            ++added_end;
+            break;
+        }
+    }
+    for (it = lg_files.begin(); it != added_end; ++it) {
+        DBImpl* impl = lg_list_[it->first];
+        const std::vector<uint64_t>& numbers = lg_numbers[it->first];
+        if (!s.ok() && numbers.size() > 0) {
+            Status rs = impl->RemoveIngestedFiles(it->second, numbers);
+            if (!rs.ok()) {
+                Log(options_.info_log, "[%s] fail to roll back ingest of lg %u: %s",
+                    dbname_.c_str(), it->first, rs.ToString().c_str());
+            }
+        }
+        impl->EndIngestFiles();
+    }
+    return s;
+}
+
 // end of tera-specific
 
 // for unit test
@@ -49,6 +49,7 @@ public:
 
     // Is too busy to write.
     virtual bool BusyWrite();
+    virtual uint64_t WriteThrottleDelay(std::string* reason);
 
     // Apply the specified updates to the database.
     // Returns OK on success, non-OK on failure.
@@ -137,6 +138,12 @@ public:
     // Add all sst files inherited from other tablets
     virtual void AddInheritedLiveFiles(std::vector<std::set<uint64_t> >* live);
 
+    // Add sst files built by TableFileWriter to the LGs. All files are
+    // checked before any is added, and if an LG fails the LGs already
+    // added are rolled back.
+    virtual Status IngestFiles(
+        const std::map<uint32_t, std::vector<std::string> >& lg_files);
+
     // for unit test
     Status TEST_CompactMemTable();
     void TEST_CompactRange(int level, const Slice* begin, const Slice* end);
@@ -147,8 +154,29 @@ private:
     struct RecordWriter;
     WriteBatch* GroupWriteBatch(RecordWriter** last_writer);
 
+    // Let every writer of the group [writers_.front(), last_writer] insert
+    // its own batch into the memtables of all LGs in parallel.
+    Status ConcurrentWriteLG(RecordWriter* last_writer, uint64_t last_sequence);
+    void ConcurrentInsert(RecordWriter* w);
+
     Status RecoverLogFile(uint64_t log_number, uint64_t recover_limit,
                           std::vector<VersionEdit*>* edit_list);
+
+    // Read log files in bounded chunks and replay every chunk into the
+    // memtables of all LGs concurrently on a shared thread pool, see
+    // Options::parallel_recover_threads
+    struct RecoverChunk;
+    struct RecoverState;
+    struct RecoverTask;
+    Status ParallelRecoverLogFiles(const std::vector<uint64_t>& logfiles,
+                                   std::vector<VersionEdit*>* edit_list);
+    Status ReadLogFile(RecoverState* state, uint64_t log_number,
+                       uint64_t recover_limit, RecoverChunk** chunk);
+    // Wait for the chunk being replayed, then start replaying "chunk" if
+    // no LG failed. Takes the ownership of "chunk", which may be NULL.
+    Status ReplayChunk(RecoverState* state, RecoverChunk* chunk);
+    static void ReplayLogWrapper(void* arg);
+    Status ReplayLog(RecoverState* state, uint32_t lg);
     void MaybeIgnoreError(Status* s) const;
     Status GatherLogFile(uint64_t begin_num,
                          std::vector<uint64_t>* logfiles);
@@ -191,6 +219,10 @@ private:
     std::deque<RecordWriter*> writers_;
     WriteBatch* tmp_batch_;
 
+    // for concurrent memtable insertion
+    int concurrent_pending_;
+    Status concurrent_status_;
+
     // for GC schedule
     bool bg_schedule_gc_;
     int64_t bg_schedule_gc_id_;
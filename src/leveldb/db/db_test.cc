@@ -10,6 +10,7 @@
 
 #include "db/db_impl.h"
 #include "db/filename.h"
+#include "db/table_cache.h"
 #include "db/version_set.h"
 #include "db/write_batch_internal.h"
 #include "leveldb/cache.h"
@@ -17,6 +18,7 @@
 #include "leveldb/filter_policy.h"
 #include "leveldb/lg_coding.h"
 #include "leveldb/table.h"
+#include "leveldb/table_file_writer.h"
 #include "util/hash.h"
 #include "util/logging.h"
 #include "util/mutexlock.h"
@@ -203,6 +205,9 @@ class DBTest {
     kDefault,
     kFilter,
     kUncompressed,
+    kConcurrentMemtable,
+    kMemtableHashIndex,
+    kParallelRecover,
     kEnd
   };
   int option_config_;
@@ -257,6 +262,15 @@ class DBTest {
       case kUncompressed:
         options.compression = kNoCompression;
         break;
+      case kConcurrentMemtable:
+        options.use_concurrent_memtable = true;
+        break;
+      case kMemtableHashIndex:
+        options.memtable_hash_index = true;
+        break;
+      case kParallelRecover:
+        options.parallel_recover_threads = 4;
+        break;
       default:
         break;
     }
@@ -497,6 +511,21 @@ class DBTest {
     }
     return false;
   }
+
+  int CountTableFiles(int lg_id = 0) {
+    std::string dbname = dbname_ + "/" + Uint64ToString(lg_id);
+    std::vector<std::string> filenames;
+    env_->GetChildren(dbname, &filenames);
+    uint64_t number;
+    FileType type;
+    int count = 0;
+    for (size_t i = 0; i < filenames.size(); i++) {
+      if (ParseFileName(filenames[i], &number, &type) && type == kTableFile) {
+        count++;
+      }
+    }
+    return count;
+  }
 };
 
 TEST(DBTest, Empty) {
@@ -933,6 +962,56 @@ TEST(DBTest, MinorCompactionsHappen) {
   }
 }
 
+TEST(DBTest, MinorCompactionsWithImmQueue) {
+  Options options = CurrentOptions();
+  options.write_buffer_size = 10000;
+  options.max_imm_num = 4;
+  Reopen(&options);
+
+  const int N = 500;
+
+  int starting_num_tables = TotalTableFiles();
+  for (int r = 0; r < 2; r++) {
+    for (int i = 0; i < N; i++) {
+      ASSERT_OK(Put(Key(i), Key(i) + std::string(1000, 'a' + r)));
+    }
+  }
+  int ending_num_tables = TotalTableFiles();
+  ASSERT_GT(ending_num_tables, starting_num_tables);
+
+  // Newer memtables must shadow older ones, wherever they are queued
+  for (int i = 0; i < N; i++) {
+    ASSERT_EQ(Key(i) + std::string(1000, 'b'), Get(Key(i)));
+  }
+}
+
+TEST(DBTest, WriteThrottleDelay) {
+  Options options = CurrentOptions();
+  options.l0_throttle_writes_trigger = 0;
+  options.l0_slowdown_writes_trigger = 4;
+  options.max_write_delay_micros = 1000;
+  Reopen(&options);
+
+  std::string reason = "none";
+  ASSERT_EQ(db_->WriteThrottleDelay(&reason), 0U);
+  ASSERT_EQ(reason, "");
+
+  // Overlapping memtables are pushed down until one stays in level-0
+  while (NumTableFilesAtLevel(0) == 0) {
+    ASSERT_OK(Put("a", "begin"));
+    ASSERT_OK(Put("z", "end"));
+    dbfull()->TEST_CompactMemTable();
+  }
+  ASSERT_EQ(NumTableFilesAtLevel(0), 1);
+  ASSERT_EQ(db_->WriteThrottleDelay(&reason), 250U);
+  ASSERT_EQ(reason, "level0_files");
+
+  // No delay once throttling is disabled
+  options.max_write_delay_micros = 0;
+  Reopen(&options);
+  ASSERT_EQ(db_->WriteThrottleDelay(&reason), 0U);
+}
+
 TEST(DBTest, RecoverWithLargeLog) {
   {
     Options options = CurrentOptions();
@@ -957,6 +1036,54 @@ TEST(DBTest, RecoverWithLargeLog) {
   ASSERT_GT(NumTableFilesAtLevel(0), 1);
 }
 
+TEST(DBTest, ParallelRecoverWithLargeLog) {
+  {
+    Options options = CurrentOptions();
+    Reopen(&options);
+    ASSERT_OK(Put("big1", std::string(200000, '1')));
+    ASSERT_OK(Put("big2", std::string(200000, '2')));
+    ASSERT_OK(Put("small3", std::string(10, '3')));
+    ASSERT_OK(Put("small4", std::string(10, '4')));
+    ASSERT_EQ(NumTableFilesAtLevel(0), 0);
+  }
+
+  // Recovered memtables are dumped in the background while the log
+  // is still being replayed
+  Options options = CurrentOptions();
+  options.write_buffer_size = 100000;
+  options.parallel_recover_threads = 4;
+  Reopen(&options);
+  ASSERT_EQ(std::string(200000, '1'), Get("big1"));
+  ASSERT_EQ(std::string(200000, '2'), Get("big2"));
+  ASSERT_EQ(std::string(10, '3'), Get("small3"));
+  ASSERT_EQ(std::string(10, '4'), Get("small4"));
+}
+
+TEST(DBTest, ParallelRecoverInChunks) {
+  // The log is larger than a few recover chunks
+  const int N = 40;
+  Random rnd(301);
+  std::vector<std::string> values;
+  {
+    Options options = CurrentOptions();
+    Reopen(&options);
+    for (int i = 0; i < N; i++) {
+      values.push_back(RandomString(&rnd, 300000));
+      ASSERT_OK(Put(Key(i), values[i]));
+    }
+    ASSERT_OK(Put(Key(0), "v0"));
+    ASSERT_EQ(NumTableFilesAtLevel(0), 0);
+  }
+
+  Options options = CurrentOptions();
+  options.parallel_recover_threads = 2;
+  Reopen(&options);
+  ASSERT_EQ("v0", Get(Key(0)));
+  for (int i = 1; i < N; i++) {
+    ASSERT_EQ(values[i], Get(Key(i)));
+  }
+}
+
 TEST(DBTest, CompactionsGenerateMultipleFiles) {
   Options options = CurrentOptions();
   options.write_buffer_size = 100000000;        // Large write buffer
@@ -1144,6 +1271,30 @@ TEST(DBTest, ApproximateSizes_MixOfSmallAndLarge) {
   } while (ChangeOptions());
 }
 
+TEST(DBTest, FindSplitKeyByBlockSize) {
+  Options options = CurrentOptions();
+  options.compression = kNoCompression;
+  Reopen(&options);
+
+  // the first 20 keys hold most of the data
+  Random rnd(301);
+  for (int i = 0; i < 100; i++) {
+    ASSERT_OK(Put(Key(i), RandomString(&rnd, i < 20 ? 50000 : 1000)));
+  }
+  Reopen(&options);
+  dbfull()->TEST_CompactRange(0, NULL, NULL);
+  ASSERT_EQ(NumTableFilesAtLevel(0), 0);
+
+  std::string split_key;
+  ASSERT_TRUE(db_->FindSplitKey("", "", 0.5, &split_key));
+  ASSERT_GT(split_key, Key(5));
+  ASSERT_LT(split_key, Key(15));
+
+  ASSERT_TRUE(db_->FindSplitKey(Key(20), "", 0.5, &split_key));
+  ASSERT_GT(split_key, Key(50));
+  ASSERT_LT(split_key, Key(70));
+}
+
 TEST(DBTest, IteratorPinsRef) {
   Put("foo", "hello");
 
@@ -1715,6 +1866,182 @@ TEST(DBTest, BloomFilter) {
   delete options.filter_policy;
 }
 
+TEST(DBTest, WarmUp) {
+  Options options = CurrentOptions();
+  options.env = env_;
+  options.dump_mem_on_shutdown = true;
+  Reopen(&options);
+
+  const int N = 1000;
+  for (int i = 0; i < N; i++) {
+    ASSERT_OK(Put(Key(i), Key(i)));
+  }
+  Close();
+
+  // Warm up another set of caches, like the target node of a move
+  Options warm_options = options;
+  warm_options.block_cache = NewLRUCache(8 << 20);
+  warm_options.table_cache = new TableCache(100);
+  WarmUpHandle* handle = NULL;
+  ASSERT_OK(WarmUpDB(dbname_, warm_options, 1 << 20, &handle));
+
+  // All lookups should be served by the warmed caches
+  Reopen(&warm_options);
+  env_->count_random_reads_ = true;
+  env_->random_read_counter_.Reset();
+  for (int i = 0; i < N; i++) {
+    ASSERT_EQ(Key(i), Get(Key(i)));
+  }
+  ASSERT_EQ(env_->random_read_counter_.Read(), 0);
+
+  env_->count_random_reads_ = false;
+  Close();
+  delete handle;
+  delete warm_options.table_cache;
+  delete warm_options.block_cache;
+}
+
+static Status BuildIngestFile(const Options& options, const std::string& fname,
+                              const std::string& prefix, int begin, int end) {
+  TableFileWriter writer(options, fname);
+  Status s = writer.Open();
+  for (int i = begin; s.ok() && i < end; i++) {
+    s = writer.Add(Key(i), prefix + Key(i));
+  }
+  if (s.ok()) {
+    s = writer.Finish();
+  }
+  return s;
+}
+
+TEST(DBTest, IngestFiles) {
+  Options options = CurrentOptions();
+  Reopen(&options);
+  ASSERT_OK(Put(Key(5), "db"));
+  ASSERT_OK(Put(Key(50), "db"));
+  dbfull()->TEST_CompactMemTable();
+
+  std::string f1 = dbname_ + "/ingest1";
+  std::string f2 = dbname_ + "/ingest2";
+  ASSERT_OK(BuildIngestFile(options, f1, "f1_", 0, 10));
+  ASSERT_OK(BuildIngestFile(options, f2, "f2_", 100, 200));
+
+  std::map<uint32_t, std::vector<std::string> > lg_files;
+  lg_files[1].push_back(f1);
+  ASSERT_TRUE(!db_->IngestFiles(lg_files).ok());
+  lg_files.clear();
+  lg_files[0].push_back(f1);
+  lg_files[0].push_back(f2);
+  ASSERT_OK(db_->IngestFiles(lg_files));
+  ASSERT_TRUE(!env_->FileExists(f1));
+  ASSERT_TRUE(!env_->FileExists(f2));
+
+  // keys written to the db are newer than ingested ones
+  for (int r = 0; r < 2; r++) {
+    ASSERT_EQ("f1_" + Key(0), Get(Key(0)));
+    ASSERT_EQ("db", Get(Key(5)));
+    ASSERT_EQ("f1_" + Key(9), Get(Key(9)));
+    ASSERT_EQ("db", Get(Key(50)));
+    ASSERT_EQ("f2_" + Key(150), Get(Key(150)));
+    ASSERT_EQ("NOT_FOUND", Get(Key(200)));
+    Reopen(&options);
+  }
+
+  // a file not built by TableFileWriter is refused
+  ASSERT_OK(WriteStringToFile(env_, "not a table", f1));
+  ASSERT_TRUE(!db_->IngestFiles(lg_files).ok());
+  env_->DeleteFile(f1);
+}
+
+TEST(DBTest, IngestFilesOverlapLastLevel) {
+  Options options = CurrentOptions();
+  Reopen(&options);
+  ASSERT_OK(Put(Key(5), "old"));
+  dbfull()->TEST_CompactMemTable();
+  for (int level = 0; level < config::kNumLevels - 1; level++) {
+    dbfull()->TEST_CompactRange(level, NULL, NULL);
+  }
+  ASSERT_EQ(NumTableFilesAtLevel(config::kNumLevels - 1), 1);
+  ASSERT_OK(Put(Key(5), "new"));
+  dbfull()->TEST_CompactMemTable();
+
+  // in level-0 the file would shadow the newer entry of the levels between
+  std::string f1 = dbname_ + "/ingest1";
+  ASSERT_OK(BuildIngestFile(options, f1, "f1_", 0, 10));
+  std::map<uint32_t, std::vector<std::string> > lg_files;
+  lg_files[0].push_back(f1);
+  ASSERT_TRUE(!db_->IngestFiles(lg_files).ok());
+  ASSERT_TRUE(env_->FileExists(f1));
+  ASSERT_EQ("new", Get(Key(5)));
+  ASSERT_EQ("NOT_FOUND", Get(Key(0)));
+
+  // so are files overlapping each other
+  std::string f2 = dbname_ + "/ingest2";
+  std::string f3 = dbname_ + "/ingest3";
+  ASSERT_OK(BuildIngestFile(options, f2, "f2_", 100, 200));
+  ASSERT_OK(BuildIngestFile(options, f3, "f3_", 150, 250));
+  lg_files[0].clear();
+  lg_files[0].push_back(f2);
+  lg_files[0].push_back(f3);
+  ASSERT_TRUE(!db_->IngestFiles(lg_files).ok());
+  ASSERT_TRUE(env_->FileExists(f2));
+  ASSERT_TRUE(env_->FileExists(f3));
+  ASSERT_EQ("NOT_FOUND", Get(Key(150)));
+  env_->DeleteFile(f1);
+  env_->DeleteFile(f2);
+  env_->DeleteFile(f3);
+}
+
+TEST(DBTest, IngestFilesRollBack) {
+  std::set<uint32_t> lg_list;
+  lg_list.insert(0);
+  lg_list.insert(1);
+  Options options = CurrentOptions();
+  options.create_if_missing = true;
+  options.exist_lg_list = &lg_list;
+  // the fixture only destroys lg 0, clean up lg 1 left by an earlier run,
+  // DestroyDB() takes the lg list
+  Options destroy_options = options;
+  destroy_options.exist_lg_list = new std::set<uint32_t>(lg_list);
+  Close();
+  ASSERT_OK(DestroyDB(dbname_, destroy_options));
+  Reopen(&options);
+
+  std::string f1 = dbname_ + "/ingest1";
+  std::string f2 = dbname_ + "/ingest2";
+  std::string f3 = dbname_ + "/ingest3";
+  ASSERT_OK(BuildIngestFile(options, f1, "f1_", 0, 10));
+  ASSERT_OK(BuildIngestFile(options, f2, "f2_", 100, 200));
+  ASSERT_OK(BuildIngestFile(options, f3, "f3_", 150, 250));
+
+  // lg 0 is added before lg 1 fails, and is rolled back
+  std::map<uint32_t, std::vector<std::string> > lg_files;
+  lg_files[0].push_back(f1);
+  lg_files[1].push_back(f2);
+  lg_files[1].push_back(f3);
+  ASSERT_TRUE(!db_->IngestFiles(lg_files).ok());
+  ASSERT_TRUE(env_->FileExists(f1));
+  ASSERT_TRUE(env_->FileExists(f2));
+  ASSERT_TRUE(env_->FileExists(f3));
+  for (int r = 0; r < 2; r++) {
+    ASSERT_EQ(CountTableFiles(0), 0);
+    ASSERT_EQ(CountTableFiles(1), 0);
+    Reopen(&options);
+  }
+
+  lg_files[1].pop_back();
+  ASSERT_OK(db_->IngestFiles(lg_files));
+  ASSERT_TRUE(!env_->FileExists(f1));
+  ASSERT_TRUE(!env_->FileExists(f2));
+  Reopen(&options);
+  ASSERT_EQ(CountTableFiles(0), 1);
+  ASSERT_EQ(CountTableFiles(1), 1);
+  env_->DeleteFile(f3);
+  Close();
+  destroy_options.exist_lg_list = new std::set<uint32_t>(lg_list);
+  ASSERT_OK(DestroyDB(dbname_, destroy_options));
+}
+
 // Multi-threaded test:
 namespace {
 
@@ -12,6 +12,7 @@
 #include "leveldb/env.h"
 #include "leveldb/iterator.h"
 #include "util/coding.h"
+#include "util/hash.h"
 
 namespace leveldb {
 
@@ -22,13 +23,24 @@ static Slice GetLengthPrefixedSlice(const char* data) {
   return Slice(p, len);
 }
 
-MemTable::MemTable(const InternalKeyComparator& cmp, CompactStrategyFactory* compact_strategy_factory)
+MemTable::MemTable(const InternalKeyComparator& cmp, CompactStrategyFactory* compact_strategy_factory,
+                   bool concurrent_insert, size_t hash_index_buckets)
     : last_seq_(0),
       comparator_(cmp),
       refs_(0),
       table_(comparator_, &arena_),
       empty_(true),
-      compact_strategy_factory_(compact_strategy_factory) {
+      compact_strategy_factory_(compact_strategy_factory),
+      concurrent_insert_(concurrent_insert),
+      hash_index_(NULL),
+      hash_index_buckets_(concurrent_insert ? 0 : hash_index_buckets) {
+  if (hash_index_buckets_ > 0) {
+    char* mem = arena_.AllocateAligned(sizeof(port::AtomicPointer) * hash_index_buckets_);
+    hash_index_ = reinterpret_cast<port::AtomicPointer*>(mem);
+    for (size_t i = 0; i < hash_index_buckets_; i++) {
+      new (&hash_index_[i]) port::AtomicPointer(NULL);
+    }
+  }
 }
 
 MemTable::~MemTable() {
@@ -100,7 +112,8 @@ void MemTable::Add(SequenceNumber s, ValueType type,
   const size_t encoded_len =
       VarintLength(internal_key_size) + internal_key_size +
       VarintLength(val_size) + val_size;
-  char* buf = arena_.Allocate(encoded_len);
+  char* buf = concurrent_insert_ ? arena_.AllocateAlignedConcurrently(encoded_len)
+                                 : arena_.Allocate(encoded_len);
   char* p = EncodeVarint32(buf, internal_key_size);
   memcpy(p, key.data(), key_size);
   p += key_size;
@@ -109,50 +122,118 @@ void MemTable::Add(SequenceNumber s, ValueType type,
   p = EncodeVarint32(p, val_size);
   memcpy(p, value.data(), val_size);
   assert(static_cast<size_t>((p + val_size) - buf) == encoded_len);
-  table_.Insert(buf);
-  assert(last_seq_ < s || s == 0);
-  last_seq_ = s;
+  if (!concurrent_insert_) {
+    table_.Insert(buf);
+    if (hash_index_ != NULL) {
+      UpdateHashIndex(Slice(buf + VarintLength(internal_key_size), key_size), buf);
+    }
+    assert(last_seq_ < s || s == 0);
+    last_seq_ = s;
+    return;
+  }
+
+  // Concurrent writers may finish out of sequence order,
+  // keep the largest one.
+  table_.InsertConcurrently(buf);
+  SequenceNumber last_seq = last_seq_;
+  while (last_seq < s &&
+         !__sync_bool_compare_and_swap(&last_seq_, last_seq, s)) {
+    last_seq = last_seq_;
+  }
+}
+
+// Entries of a user key are added in sequence order, so the newest one
+// simply replaces the previous one in the index.
+void MemTable::UpdateHashIndex(const Slice& user_key, const char* entry) {
+  HashIndexNode* node = FindHashIndex(user_key);
+  if (node != NULL) {
+    node->entry.Release_Store(const_cast<char*>(entry));
+    return;
+  }
+  port::AtomicPointer* bucket =
+      &hash_index_[Hash(user_key.data(), user_key.size(), 0) % hash_index_buckets_];
+  char* mem = arena_.AllocateAligned(sizeof(HashIndexNode));
+  node = new (mem) HashIndexNode;
+  node->entry.NoBarrier_Store(const_cast<char*>(entry));
+  node->next = reinterpret_cast<HashIndexNode*>(bucket->NoBarrier_Load());
+  bucket->Release_Store(node);
+}
+
+MemTable::HashIndexNode* MemTable::FindHashIndex(const Slice& user_key) const {
+  port::AtomicPointer* bucket =
+      &hash_index_[Hash(user_key.data(), user_key.size(), 0) % hash_index_buckets_];
+  HashIndexNode* node = reinterpret_cast<HashIndexNode*>(bucket->Acquire_Load());
+  for (; node != NULL; node = node->next) {
+    Slice entry_key = GetLengthPrefixedSlice(
+        reinterpret_cast<const char*>(node->entry.Acquire_Load()));
+    if (Slice(entry_key.data(), entry_key.size() - 8) == user_key) {
+      return node;
+    }
+  }
+  return NULL;
 }
 
 bool MemTable::Get(const LookupKey& key, std::string* value, Status* s) {
+  if (hash_index_ != NULL) {
+    HashIndexNode* node = FindHashIndex(key.user_key());
+    if (node == NULL) {
+      // Every entry is indexed, the key is not in this memtable.
+      return false;
+    }
+    const char* entry = reinterpret_cast<const char*>(node->entry.Acquire_Load());
+    Slice entry_key = GetLengthPrefixedSlice(entry);
+    Slice lookup_key = key.internal_key();
+    if (DecodeFixed64(entry_key.data() + entry_key.size() - 8) >> 8 <=
+        DecodeFixed64(lookup_key.data() + lookup_key.size() - 8) >> 8) {
+      return SaveValue(entry, key, value, s);
+    }
+    // The newest entry is not visible to this snapshot, search the
+    // skiplist for an older one.
+  }
+
   Slice memkey = key.memtable_key();
   Table::Iterator iter(&table_);
   iter.Seek(memkey.data());
   if (iter.Valid()) {
-    // entry format is:
-    //    klength  varint32
-    //    userkey  char[klength]
-    //    tag      uint64
-    //    vlength  varint32
-    //    value    char[vlength]
-    // Check that it belongs to same user key.  We do not check the
-    // sequence number since the Seek() call above should have skipped
-    // all entries with overly large sequence numbers.
-    const char* entry = iter.key();
-    uint32_t key_length;
-    const char* key_ptr = GetVarint32Ptr(entry, entry+5, &key_length);
-    if (comparator_.comparator.user_comparator()->Compare(
-            Slice(key_ptr, key_length - 8),
-            key.user_key()) == 0) {
-      // Correct user key
-      const uint64_t tag = DecodeFixed64(key_ptr + key_length - 8);
-      switch (static_cast<ValueType>(tag & 0xff)) {
-        case kTypeValue: {
-          Slice v = GetLengthPrefixedSlice(key_ptr + key_length);
-          CompactStrategy* strategy = compact_strategy_factory_ ?
-                  compact_strategy_factory_->NewInstance() : NULL;
-          if (!strategy || !strategy->Drop(Slice(key_ptr, key_length - 8), 0)) {
-              value->assign(v.data(), v.size());
-          } else {
-              *s = Status::NotFound(Slice());
-          }
-          delete strategy;
-          return true;
+    // We do not check the sequence number since the Seek() call above
+    // should have skipped all entries with overly large sequence numbers.
+    return SaveValue(iter.key(), key, value, s);
+  }
+  return false;
+}
+
+bool MemTable::SaveValue(const char* entry, const LookupKey& key,
+                         std::string* value, Status* s) {
+  // entry format is:
+  //    klength  varint32
+  //    userkey  char[klength]
+  //    tag      uint64
+  //    vlength  varint32
+  //    value    char[vlength]
+  // Check that it belongs to same user key.
+  uint32_t key_length;
+  const char* key_ptr = GetVarint32Ptr(entry, entry+5, &key_length);
+  if (comparator_.comparator.user_comparator()->Compare(
+          Slice(key_ptr, key_length - 8),
+          key.user_key()) == 0) {
+    // Correct user key
+    const uint64_t tag = DecodeFixed64(key_ptr + key_length - 8);
+    switch (static_cast<ValueType>(tag & 0xff)) {
+      case kTypeValue: {
+        Slice v = GetLengthPrefixedSlice(key_ptr + key_length);
+        CompactStrategy* strategy = compact_strategy_factory_ ?
+                compact_strategy_factory_->NewInstance() : NULL;
+        if (!strategy || !strategy->Drop(Slice(key_ptr, key_length - 8), 0)) {
+            value->assign(v.data(), v.size());
+        } else {
+            *s = Status::NotFound(Slice());
         }
-        case kTypeDeletion:
-          *s = Status::NotFound(Slice());
-          return true;
+        delete strategy;
+        return true;
       }
+      case kTypeDeletion:
+        *s = Status::NotFound(Slice());
+        return true;
     }
   }
   return false;
@@ -26,8 +26,18 @@ class MemTable {
  public:
   // MemTables are reference counted.  The initial reference count
   // is zero and the caller must call Ref() at least once.
+  //
+  // If "concurrent_insert" is true, Add() may be called by several
+  // threads at the same time.
+  //
+  // If "hash_index_buckets" > 0, a hash index from user key to the newest
+  // entry of the key is kept beside the skiplist, so that point lookups
+  // do not search the skiplist.  Keys that compare equal must be
+  // bytewise equal, and inserts must not be concurrent.
   explicit MemTable(const InternalKeyComparator& comparator,
-          CompactStrategyFactory* compact_strategy_factory = NULL);
+          CompactStrategyFactory* compact_strategy_factory = NULL,
+          bool concurrent_insert = false,
+          size_t hash_index_buckets = 0);
 
   // Increase reference count.
   void Ref() { ++refs_; }
@@ -95,6 +105,19 @@ class MemTable {
 
   typedef SkipList<const char*, KeyComparator> Table;
 
+  // Chained in the buckets of the hash index
+  struct HashIndexNode {
+    port::AtomicPointer entry;  // Newest entry of the user key
+    HashIndexNode* next;        // Immutable once published
+  };
+
+  void UpdateHashIndex(const Slice& user_key, const char* entry);
+  HashIndexNode* FindHashIndex(const Slice& user_key) const;
+
+  // Fill *value or *s from "entry" if it belongs to the user key of "key".
+  bool SaveValue(const char* entry, const LookupKey& key,
+                 std::string* value, Status* s);
+
   KeyComparator comparator_;
   int refs_;
 
@@ -102,6 +125,11 @@ class MemTable {
   Table table_;
   bool empty_;
   CompactStrategyFactory* compact_strategy_factory_;
+  const bool concurrent_insert_;
+
+  // Hash index, NULL if disabled.  Allocated from arena_.
+  port::AtomicPointer* hash_index_;
+  const size_t hash_index_buckets_;
 
   // No copying allowed
   MemTable(const MemTable&);
@@ -369,6 +369,62 @@ static void RunConcurrent(int run) {
   }
 }
 
+struct InsertState {
+  SkipList<Key, Comparator>* list;
+  int num_threads;
+  int keys_per_thread;
+  int next_id;
+  int done;
+  port::Mutex mu;
+  port::CondVar cv;
+
+  InsertState() : next_id(0), done(0), cv(&mu) {}
+};
+
+static void ConcurrentInserter(void* arg) {
+  InsertState* state = reinterpret_cast<InsertState*>(arg);
+  state->mu.Lock();
+  const int id = state->next_id++;
+  state->mu.Unlock();
+  for (int i = 0; i < state->keys_per_thread; i++) {
+    state->list->InsertConcurrently(i * state->num_threads + id);
+  }
+  state->mu.Lock();
+  state->done++;
+  state->cv.Signal();
+  state->mu.Unlock();
+}
+
+TEST(SkipTest, InsertConcurrently) {
+  Arena arena;
+  Comparator cmp;
+  SkipList<Key, Comparator> list(cmp, &arena);
+  InsertState state;
+  state.list = &list;
+  state.num_threads = 4;
+  state.keys_per_thread = 20000;
+  for (int i = 0; i < state.num_threads; i++) {
+    Env::Default()->StartThread(ConcurrentInserter, &state);
+  }
+  state.mu.Lock();
+  while (state.done < state.num_threads) {
+    state.cv.Wait();
+  }
+  state.mu.Unlock();
+
+  const Key total = state.num_threads * state.keys_per_thread;
+  SkipList<Key, Comparator>::Iterator iter(&list);
+  iter.SeekToFirst();
+  for (Key k = 0; k < total; k++) {
+    ASSERT_TRUE(iter.Valid());
+    ASSERT_EQ(k, iter.key());
+    iter.Next();
+  }
+  ASSERT_TRUE(!iter.Valid());
+  ASSERT_TRUE(list.Contains(total - 1));
+  ASSERT_TRUE(!list.Contains(total));
+}
+
 #if 0 // disabled by anqin for thread blocking, need check!
 
 TEST(SkipTest, Concurrent1) { RunConcurrent(1); }
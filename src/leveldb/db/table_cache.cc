@@ -172,6 +172,21 @@ Status TableCache::Get(const ReadOptions& options,
   return s;
 }
 
+Status TableCache::GetDataBlockSizes(
+    const ReadOptions& options, const std::string& dbname,
+    uint64_t file_number, uint64_t file_size,
+    std::vector<std::pair<std::string, uint64_t> >* blocks) {
+  assert(options.db_opt);
+  Cache::Handle* handle = NULL;
+  Status s = FindTable(dbname, options.db_opt, file_number, file_size, &handle);
+  if (s.ok()) {
+    Table* t = reinterpret_cast<TableAndFile*>(cache_->Value(handle))->table;
+    t->GetDataBlockSizes(blocks);
+    cache_->Release(handle);
+  }
+  return s;
+}
+
 void TableCache::Evict(const std::string& dbname, uint64_t file_number) {
   std::string fname = TableFileName(dbname, file_number);
   cache_->Erase(Slice(fname));
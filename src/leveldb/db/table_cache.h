@@ -61,6 +61,14 @@ class TableCache {
              void* arg,
              void (*handle_result)(void*, const Slice&, const Slice&));
 
+  // Append the index key and the size of every data block of the
+  // specified file to *blocks.
+  Status GetDataBlockSizes(const ReadOptions& options,
+                           const std::string& dbname,
+                           uint64_t file_number,
+                           uint64_t file_size,
+                           std::vector<std::pair<std::string, uint64_t> >* blocks);
+
   // Evict any entry for the specified file number
   void Evict(const std::string& dbname, uint64_t file_number);
 
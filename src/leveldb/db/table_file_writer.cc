@@ -0,0 +1,101 @@
+// Copyright (c) 2015, Baidu.com, Inc. All Rights Reserved
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "leveldb/table_file_writer.h"
+
+#include "db/dbformat.h"
+#include "leveldb/env.h"
+#include "leveldb/table_builder.h"
+
+namespace leveldb {
+
+struct TableFileWriter::Rep {
+  Options options;
+  std::string fname;
+  InternalKeyComparator internal_comparator;
+  InternalFilterPolicy internal_filter_policy;
+  WritableFile* file;
+  TableBuilder* builder;
+  bool finished;
+  std::string internal_key;
+
+  Rep(const Options& opt, const std::string& name)
+      : options(opt),
+        fname(name),
+        internal_comparator(opt.comparator),
+        internal_filter_policy(opt.filter_policy),
+        file(NULL),
+        builder(NULL),
+        finished(false) {
+    options.comparator = &internal_comparator;
+    if (opt.filter_policy != NULL) {
+      options.filter_policy = &internal_filter_policy;
+    }
+  }
+};
+
+TableFileWriter::TableFileWriter(const Options& options,
+                                 const std::string& fname)
+    : rep_(new Rep(options, fname)) {
+}
+
+TableFileWriter::~TableFileWriter() {
+  if (rep_->builder != NULL) {
+    if (!rep_->finished) {
+      rep_->builder->Abandon();
+    }
+    delete rep_->builder;
+  }
+  if (rep_->file != NULL) {
+    delete rep_->file;
+    if (!rep_->finished) {
+      rep_->options.env->DeleteFile(rep_->fname);
+    }
+  }
+  delete rep_;
+}
+
+Status TableFileWriter::Open() {
+  assert(rep_->file == NULL);
+  Status s = rep_->options.env->NewWritableFile(rep_->fname, &rep_->file);
+  if (s.ok()) {
+    rep_->builder = new TableBuilder(rep_->options, rep_->file);
+  }
+  return s;
+}
+
+Status TableFileWriter::Add(const Slice& key, const Slice& value) {
+  assert(rep_->builder != NULL && !rep_->finished);
+  rep_->internal_key.clear();
+  AppendInternalKey(&rep_->internal_key,
+                    ParsedInternalKey(key, 0, kTypeValue));
+  rep_->builder->Add(rep_->internal_key, value);
+  return rep_->builder->status();
+}
+
+Status TableFileWriter::Finish() {
+  assert(rep_->builder != NULL && !rep_->finished);
+  rep_->finished = true;
+  Status s = rep_->builder->Finish();
+  if (s.ok()) {
+    s = rep_->file->Sync();
+  }
+  if (s.ok()) {
+    s = rep_->file->Close();
+  }
+  if (!s.ok()) {
+    rep_->options.env->DeleteFile(rep_->fname);
+  }
+  return s;
+}
+
+uint64_t TableFileWriter::NumEntries() const {
+  return rep_->builder == NULL ? 0 : rep_->builder->NumEntries();
+}
+
+uint64_t TableFileWriter::FileSize() const {
+  return rep_->builder == NULL ? 0 : rep_->builder->FileSize();
+}
+
+}  // namespace leveldb
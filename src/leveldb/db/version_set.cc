@@ -616,6 +616,122 @@ bool Version::FindSplitKey(const Slice* smallest_user_key,
     return true;
 }
 
+namespace {
+struct BlockKeyComparator {
+    const Comparator* user_cmp;
+    explicit BlockKeyComparator(const Comparator* c) : user_cmp(c) {}
+    bool operator()(const std::pair<std::string, uint64_t>& a,
+                    const std::pair<std::string, uint64_t>& b) const {
+        return user_cmp->Compare(ExtractUserKey(a.first),
+                                 ExtractUserKey(b.first)) < 0;
+    }
+};
+}  // namespace
+
+bool Version::FindSplitKeyBySample(const Slice* smallest_user_key,
+                                   const Slice* largest_user_key,
+                                   double ratio,
+                                   std::string* split_key) {
+    assert(ratio >= 0 && ratio <= 1);
+    const Comparator* user_cmp = vset_->icmp_.user_comparator();
+    ReadOptions opts;
+    opts.db_opt = vset_->options_;
+
+    // Every data block is a sample of (index key, size)
+    std::vector<std::pair<std::string, uint64_t> > blocks;
+    for (int level = 1; level < config::kNumLevels; level++) {
+        const std::vector<FileMetaData*>& files = files_[level];
+        for (size_t i = 0; i < files.size(); i++) {
+            FileMetaData* file = files[i];
+            if (BeforeFile(user_cmp, largest_user_key, file) ||
+                AfterFile(user_cmp, smallest_user_key, file)) {
+                continue;
+            }
+            Status s = vset_->table_cache_->GetDataBlockSizes(
+                opts, vset_->dbname_, file->number, file->file_size, &blocks);
+            if (!s.ok()) {
+                Log(vset_->options_->info_log, "[%s] fail to sample file %lu: %s",
+                    vset_->dbname_.c_str(), file->number, s.ToString().c_str());
+                return false;
+            }
+        }
+    }
+
+    // Drop the blocks out of range, they are left by tablet split or merge
+    uint64_t total_size = 0;
+    size_t num = 0;
+    for (size_t i = 0; i < blocks.size(); i++) {
+        Slice user_key = ExtractUserKey(blocks[i].first);
+        if ((smallest_user_key != NULL &&
+             user_cmp->Compare(user_key, *smallest_user_key) < 0) ||
+            (largest_user_key != NULL &&
+             user_cmp->Compare(user_key, *largest_user_key) > 0)) {
+            continue;
+        }
+        total_size += blocks[i].second;
+        blocks[num++].swap(blocks[i]);
+    }
+    blocks.resize(num);
+    if (blocks.empty()) {
+        return false;
+    }
+
+    std::sort(blocks.begin(), blocks.end(), BlockKeyComparator(user_cmp));
+    uint64_t want_split_size = static_cast<uint64_t>(total_size * ratio);
+    uint64_t split_size = 0;
+    size_t i = 0;
+    for (; i + 1 < blocks.size(); i++) {
+        split_size += blocks[i].second;
+        if (split_size >= want_split_size) {
+            break;
+        }
+    }
+    *split_key = ExtractUserKey(blocks[i].first).ToString();
+    return true;
+}
+
+Status Version::WarmUp(TableCache* table_cache,
+                       const Slice* smallest_user_key,
+                       const Slice* largest_user_key,
+                       uint64_t max_data_size,
+                       std::vector<uint64_t>* files) {
+    const Comparator* user_cmp = vset_->icmp_.user_comparator();
+    ReadOptions opts;
+    opts.db_opt = vset_->options_;
+    opts.fill_cache = true;
+
+    // Newer files first, they are the most likely to be read
+    uint64_t data_size = 0;
+    for (int level = 0; level < config::kNumLevels; level++) {
+        const std::vector<FileMetaData*>& level_files = files_[level];
+        for (size_t i = 0; i < level_files.size(); i++) {
+            FileMetaData* file = level_files[i];
+            if (BeforeFile(user_cmp, largest_user_key, file) ||
+                AfterFile(user_cmp, smallest_user_key, file)) {
+                continue;
+            }
+            // Opening the table loads its index and filter blocks
+            Iterator* iter = table_cache->NewIterator(
+                opts, vset_->dbname_, file->number, file->file_size);
+            files->push_back(file->number);
+            for (iter->SeekToFirst();
+                 iter->Valid() && data_size < max_data_size; iter->Next()) {
+                data_size += iter->key().size() + iter->value().size();
+            }
+            Status s = iter->status();
+            delete iter;
+            if (!s.ok()) {
+                Log(vset_->options_->info_log, "[%s] fail to warm up file %lu: %s",
+                    vset_->dbname_.c_str(), file->number, s.ToString().c_str());
+                return s;
+            }
+        }
+    }
+    Log(vset_->options_->info_log, "[%s] warm up %lu bytes",
+        vset_->dbname_.c_str(), data_size);
+    return Status::OK();
+}
+
 void Version::MissFilesInLocal(const Slice* smallest_user_key,
                                const Slice* largest_user_key,
                                std::vector<std::string>* inputs) {
@@ -1619,6 +1735,21 @@ int64_t VersionSet::NumLevelBytes(int level) const {
   return TotalFileSize(current_->files_[level]);
 }
 
+uint64_t VersionSet::PendingCompactionBytes() const {
+  uint64_t pending_bytes = 0;
+  if (current_->files_[0].size() >= static_cast<size_t>(config::kL0_CompactionTrigger)) {
+    pending_bytes += TotalFileSize(current_->files_[0]);
+  }
+  for (int level = 1; level < config::kNumLevels - 1; level++) {
+    const double level_bytes = TotalFileSize(current_->files_[level]);
+    const double max_bytes = MaxBytesForLevel(level);
+    if (level_bytes > max_bytes) {
+      pending_bytes += static_cast<uint64_t>(level_bytes - max_bytes);
+    }
+  }
+  return pending_bytes;
+}
+
 int64_t VersionSet::MaxNextLevelOverlappingBytes() {
   int64_t result = 0;
   std::vector<FileMetaData*> overlaps;
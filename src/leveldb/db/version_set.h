@@ -116,6 +116,20 @@ class Version {
                     const Slice* largest_user_key,
                     double ratio,
                     std::string* split_key);
+  // Find split key at data block granularity by the index blocks of
+  // the overlapping files.  REQUIRES: mutex_ not held.
+  bool FindSplitKeyBySample(const Slice* smallest_user_key,
+                            const Slice* largest_user_key,
+                            double ratio,
+                            std::string* split_key);
+  // Open the overlapping files through table_cache and read about
+  // max_data_size bytes of them into the block cache, the numbers of the
+  // opened files are appended to *files.  REQUIRES: mutex_ not held.
+  Status WarmUp(TableCache* table_cache,
+                const Slice* smallest_user_key,
+                const Slice* largest_user_key,
+                uint64_t max_data_size,
+                std::vector<uint64_t>* files);
   void MissFilesInLocal(const Slice* smallest_user_key,
                         const Slice* largest_user_key,
                         std::vector<Compaction*>* compact_inputs);
@@ -210,6 +224,10 @@ class VersionSet {
   // Return the combined file size of all files at the specified level.
   int64_t NumLevelBytes(int level) const;
 
+  // Return the estimated bytes that compactions must rewrite to bring
+  // every level back under its size limit.
+  uint64_t PendingCompactionBytes() const;
+
   // Return the last sequence number.
   uint64_t LastSequence() const { return last_sequence_; }
 
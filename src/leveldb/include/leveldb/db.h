@@ -148,6 +148,14 @@ class DB {
   // Too busy to write
   virtual bool BusyWrite() = 0;
 
+  // Return the suggested delay (in microseconds) before the next write,
+  // proportional to the number of level0 files, the bytes pending for
+  // compaction and the memtables waiting to be dumped.
+  // If "reason" is non-NULL, it is set to the dominant source of delay.
+  virtual uint64_t WriteThrottleDelay(std::string* reason) {
+    return 0;
+  }
+
   virtual bool FindSplitKey(const std::string& start_key,
                             const std::string& end_key,
                             double ratio,
@@ -162,6 +170,17 @@ class DB {
   // Add all sst files inherited from other tablets
   virtual void AddInheritedLiveFiles(std::vector<std::set<uint64_t> >* live) = 0;
 
+  // Add sst files built by TableFileWriter to the db.  "lg_files" maps a
+  // locality group id to the files of it, which are moved into the db.
+  // All files are added, or none.  Ingested entries are older than any
+  // entry written to the db, so a file overlapping another one of the
+  // same locality group, or data already compacted to its last level, is
+  // refused.
+  virtual Status IngestFiles(
+      const std::map<uint32_t, std::vector<std::string> >& lg_files) {
+    return Status::NotSupported("ingest files");
+  }
+
  private:
   // No copying allowed
   DB(const DB&);
@@ -178,6 +197,28 @@ Status DestroyDB(const std::string& name, const Options& options);
 // on a database that contains important information.
 Status RepairDB(const std::string& dbname, const Options& options);
 
+// Handle of a database warmed up by WarmUpDB().
+class WarmUpHandle {
+ public:
+  WarmUpHandle() { }
+  virtual ~WarmUpHandle() { }
+
+ private:
+  // No copying allowed
+  WarmUpHandle(const WarmUpHandle&);
+  void operator=(const WarmUpHandle&);
+};
+
+// Open the sst files of the specified database and load their index and
+// filter blocks, and about max_data_size bytes of data, into
+// options.table_cache and options.block_cache, so that a DB opened later
+// on the same database with the same caches starts warm.  The database
+// is only read, so this is safe while another process holds it open.
+// The cached tables refer to *handle: delete it only after any such DB
+// is deleted, deleting it evicts the tables it opened.
+Status WarmUpDB(const std::string& dbname, const Options& options,
+                uint64_t max_data_size, WarmUpHandle** handle);
+
 }  // namespace leveldb
 
 #endif  // STORAGE_LEVELDB_INCLUDE_DB_H_
@@ -175,6 +175,10 @@ class Env {
   // Set background thread number
   virtual int SetBackgroundThreads(int number) = 0;
 
+  // Bind the background threads, started or not, to the cpus in "cpus".
+  // An empty list unbinds them.
+  virtual void SetBackgroundThreadsCpuAffinity(const std::vector<int>& cpus) {}
+
  private:
   // No copying allowed
   Env(const Env&);
@@ -378,6 +382,9 @@ class EnvWrapper : public Env {
   int SetBackgroundThreads(int number) {
     return target_->SetBackgroundThreads(number);
   }
+  void SetBackgroundThreadsCpuAffinity(const std::vector<int>& cpus) {
+    target_->SetBackgroundThreadsCpuAffinity(cpus);
+  }
  private:
   Env* target_;
 };
@@ -68,6 +68,8 @@ public:
     static uint32_t s_block_size_;
     static uint32_t s_disk_cache_file_num_;
     static std::string s_disk_cache_file_name_;
+    // keep disk-cache files and their block index across restarts
+    static bool s_disk_cache_persistent_;
 
 private:
     Env* hdfs_env_;
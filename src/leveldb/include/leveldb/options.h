@@ -42,7 +42,9 @@ enum CompressionType {
   kNoCompression     = 0x0,
   kSnappyCompression = 0x1,
   kBmzCompression    = 0x2,
-  kLZ4Compression    = 0x3
+  kLZ4Compression    = 0x3,
+  // zlib with a dictionary trained from, and stored in, each sstable
+  kZlibDictCompression = 0x4
 };
 
 enum RawKeyFormat {
@@ -62,6 +64,9 @@ struct LG_info {
   // compress type
   CompressionType compression;
 
+  // dictionary size for kZlibDictCompression
+  size_t compression_dict_size;
+
   // block size
   size_t block_size;
 
@@ -73,6 +78,8 @@ struct LG_info {
 
   int32_t sst_size;
 
+  bool block_hash_index;
+
   // Other LG properties
   // ...
 
@@ -80,11 +87,13 @@ struct LG_info {
       : lg_id(id),
         env(custom_env),
         compression(kNoCompression),
+        compression_dict_size(16 << 10),
         block_size(kDefaultBlockSize),
         use_memtable_on_leveldb(false),
         memtable_ldb_write_buffer_size(1 << 20),
         memtable_ldb_block_size(kDefaultBlockSize),
-        sst_size(8000000) {}
+        sst_size(8000000),
+        block_hash_index(false) {}
 };
 
 // Options to control the behavior of a database (passed to DB::Open)
@@ -142,10 +151,39 @@ struct Options {
   // Default: 4MB
   size_t write_buffer_size;
 
+  // Max number of immutable memtables waiting to be dumped.  When the
+  // current memtable fills up while the previous one is still being
+  // dumped, it is queued instead of stalling the writer.  All queued
+  // memtables are merged into one level-0 file by the next dump.
+  //
+  // Default: 1
+  int max_imm_num;
+
   // Soft limit on number of level-0 files.
   // BusyWrite return true at this point.
   int l0_slowdown_writes_trigger;
 
+  // Number of level-0 files at which writes begin to be delayed.  The
+  // delay grows linearly up to max_write_delay_micros when the number
+  // reaches l0_slowdown_writes_trigger.
+  //
+  // Default: 6
+  int l0_throttle_writes_trigger;
+
+  // Estimated bytes waiting for compaction at which writes begin to be
+  // delayed, and at which the delay reaches max_write_delay_micros.
+  // A zero limit disables this source of delay.
+  //
+  // Default: 1GB, 4GB
+  uint64_t pending_compaction_throttle_bytes;
+  uint64_t pending_compaction_limit_bytes;
+
+  // Upper bound (in microseconds) of the delay WriteThrottleDelay()
+  // suggests.  Zero disables write throttling.
+  //
+  // Default: 100ms
+  uint64_t max_write_delay_micros;
+
   // Number of open files that can be used by the DB.  You may need to
   // increase this if your database has a large working set (budget
   // one open file per 2MB of working set).
@@ -197,6 +235,14 @@ struct Options {
   // efficiently detect that and will switch to uncompressed mode.
   CompressionType compression;
 
+  // Size of the dictionary used by kZlibDictCompression.  It is trained
+  // from the first data blocks of each sstable, stored in the table's
+  // meta block, and shared by all data blocks of the table.  Values
+  // larger than 32K are clipped, deflate can not refer further back.
+  //
+  // Default: 16K
+  size_t compression_dict_size;
+
   // If non-NULL, use the specified filter policy to reduce disk reads.
   // Many applications will benefit from passing the result of
   // NewBloomFilterPolicy() here.
@@ -267,11 +313,54 @@ struct Options {
 
   size_t memtable_ldb_block_size;
 
+  // Let the writers of one write group insert their batches into the
+  // memtables in parallel, instead of the group leader inserting the
+  // whole group alone.  Ignored by memtable on leveldb.
+  //
+  // Default: false
+  bool use_concurrent_memtable;
+
+  // Keep a hash index from user key to its newest memtable entry, so
+  // that point lookups in the memtable take O(1).  Only valid if keys
+  // that compare equal are bytewise equal.  Disables
+  // use_concurrent_memtable, ignored by memtable on leveldb.
+  //
+  // Default: false
+  bool memtable_hash_index;
+
+  // Number of threads shared by all table builders to compress data
+  // blocks in the background, while the builder keeps encoding the next
+  // blocks.  Blocks are still written to the file in order.  If 0, each
+  // block is compressed inline by the thread building the table.
+  //
+  // Default: 0
+  int parallel_compression_threads;
+
+  // Number of threads shared by all tables to recover log files when a
+  // table is opened.  Log files are read and split by locality group in
+  // chunks of a few MB, every locality group replays a chunk into its own
+  // memtable concurrently while the next one is read, and oversized
+  // recovered memtables are dumped to level-0 in the background.  If 0,
+  // log files are replayed one by one.
+  //
+  // Default: 0
+  int parallel_recover_threads;
+
   bool drop_base_level_del_in_compaction;
 
   // sst file size, in bytes
   int32_t sst_size;
 
+  // Append to each data block the first bytes of the row key at every
+  // restart point, and a hash index from row key to restart point, so
+  // that a seek to a row in the block skips the binary search over the
+  // restart array, or compares cached prefixes rather than full keys.
+  // Blocks are read back whether this is set or not, but tables written
+  // with it can not be read by older versions.
+  //
+  // Default: false
+  bool block_hash_index;
+
   // Create an Options object with default values for all fields.
   Options();
 };
@@ -10,6 +10,9 @@
 #define STORAGE_LEVELDB_INCLUDE_TABLE_H_
 
 #include <stdint.h>
+#include <string>
+#include <utility>
+#include <vector>
 #include "leveldb/iterator.h"
 
 namespace leveldb {
@@ -63,6 +66,10 @@ class Table {
   // be close to the file length.
   uint64_t ApproximateOffsetOf(const Slice& key) const;
 
+  // Append the index key and the size of every data block to *blocks,
+  // in key order.  Only the index block is read.
+  void GetDataBlockSizes(std::vector<std::pair<std::string, uint64_t> >* blocks) const;
+
  private:
   struct Rep;
   Rep* rep_;
@@ -82,6 +89,7 @@ class Table {
 
   void ReadMeta(const Footer& footer);
   void ReadFilter(const Slice& filter_handle_value);
+  void ReadCompressionDict(const Slice& dict_handle_value);
 
   // No copying allowed
   Table(const Table&);
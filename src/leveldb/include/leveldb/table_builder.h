@@ -25,6 +25,7 @@ namespace leveldb {
 
 class BlockBuilder;
 class BlockHandle;
+struct CompressTask;
 class WritableFile;
 
 class TableBuilder {
@@ -76,6 +77,7 @@ class TableBuilder {
 
   // Size of the file generated so far.  If invoked after a successful
   // Finish() call, returns the size of the final generated file.
+  // Blocks still being compressed in parallel are not counted.
   uint64_t FileSize() const;
 
   // Size of the saved space of compression
@@ -85,6 +87,14 @@ class TableBuilder {
   bool ok() const { return status().ok(); }
   void WriteBlock(BlockBuilder* block, BlockHandle* handle);
   void WriteRawBlock(const Slice& data, CompressionType, BlockHandle* handle);
+  // Pipelined compression: queue the data block for compression, or
+  // as a dictionary sample, then write the leading blocks already
+  // compressed, or all of them.
+  void QueueBlock();
+  void StartCompress(CompressTask* task);
+  void TrainDict();
+  void WritePendingBlocks(bool wait_all);
+  void AbandonPendingBlocks();
 
   struct Rep;
   Rep* rep_;
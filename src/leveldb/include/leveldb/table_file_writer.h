@@ -0,0 +1,54 @@
+// Copyright (c) 2015, Baidu.com, Inc. All Rights Reserved
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// TableFileWriter builds an sst file out of a db, to be added to the db
+// later by DB::IngestFiles.  Every entry is stored with sequence number 0,
+// so an ingested entry never shadows the same key written to the db.
+
+#ifndef STORAGE_LEVELDB_INCLUDE_TABLE_FILE_WRITER_H_
+#define STORAGE_LEVELDB_INCLUDE_TABLE_FILE_WRITER_H_
+
+#include <stdint.h>
+#include <string>
+
+#include "leveldb/options.h"
+#include "leveldb/slice.h"
+#include "leveldb/status.h"
+
+namespace leveldb {
+
+class TableFileWriter {
+ public:
+  // options.comparator and options.filter_policy must be the same as the
+  // ones of the db which the file is added to.  options.env is used to
+  // write the file.
+  TableFileWriter(const Options& options, const std::string& fname);
+
+  // Abandon the file if Finish() is not called.
+  ~TableFileWriter();
+
+  Status Open();
+
+  // Add a value of user key "key".
+  // REQUIRES: key is after any previously added key in options.comparator.
+  Status Add(const Slice& key, const Slice& value);
+
+  // Finish building and close the file.
+  Status Finish();
+
+  uint64_t NumEntries() const;
+  uint64_t FileSize() const;
+
+ private:
+  struct Rep;
+  Rep* rep_;
+
+  // No copying allowed
+  TableFileWriter(const TableFileWriter&);
+  void operator=(const TableFileWriter&);
+};
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_INCLUDE_TABLE_FILE_WRITER_H_
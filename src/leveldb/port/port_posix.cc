@@ -24,6 +24,10 @@
 bmz::BmzCodec bmc;
 #endif
 
+#ifdef ZLIB
+#include <zlib.h>
+#endif
+
 namespace leveldb {
 namespace port {
 
@@ -130,6 +134,66 @@ bool Lz4_Uncompress(const char* input, size_t input_size,
 #endif
 }
 
+bool ZlibDict_Compress(const char* input, size_t input_size,
+                       const char* dict, size_t dict_size,
+                       std::string* output) {
+#ifdef ZLIB
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    // negative window bits: raw deflate, no zlib header and checksum
+    if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8,
+                     Z_DEFAULT_STRATEGY) != Z_OK) {
+        return false;
+    }
+    if (dict_size > 0 &&
+        deflateSetDictionary(&stream, reinterpret_cast<const Bytef*>(dict),
+                             dict_size) != Z_OK) {
+        deflateEnd(&stream);
+        return false;
+    }
+    size_t old_size = output->size();
+    output->resize(old_size + deflateBound(&stream, input_size));
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input));
+    stream.avail_in = input_size;
+    stream.next_out = reinterpret_cast<Bytef*>(&(*output)[old_size]);
+    stream.avail_out = output->size() - old_size;
+    int ret = deflate(&stream, Z_FINISH);
+    output->resize(old_size + stream.total_out);
+    deflateEnd(&stream);
+    return ret == Z_STREAM_END;
+#else
+    return false;
+#endif
+}
+
+bool ZlibDict_Uncompress(const char* input, size_t input_size,
+                         const char* dict, size_t dict_size,
+                         char* output, size_t output_size) {
+#ifdef ZLIB
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    if (inflateInit2(&stream, -15) != Z_OK) {
+        return false;
+    }
+    if (dict_size > 0 &&
+        inflateSetDictionary(&stream, reinterpret_cast<const Bytef*>(dict),
+                             dict_size) != Z_OK) {
+        inflateEnd(&stream);
+        return false;
+    }
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input));
+    stream.avail_in = input_size;
+    stream.next_out = reinterpret_cast<Bytef*>(output);
+    stream.avail_out = output_size;
+    int ret = inflate(&stream, Z_FINISH);
+    bool ok = (ret == Z_STREAM_END && stream.total_out == output_size);
+    inflateEnd(&stream);
+    return ok;
+#else
+    return false;
+#endif
+}
+
 //////////////////////////////
 
 }  // namespace port
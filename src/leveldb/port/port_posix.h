@@ -166,6 +166,16 @@ bool Lz4_Compress(const char* input, size_t input_size,
 bool Lz4_Uncompress(const char* input, size_t input_size,
                     char* output, size_t* output_size);
 
+// Raw deflate with a preset dictionary, appended to "*output".
+// Uncompress requires the exact uncompressed size.
+bool ZlibDict_Compress(const char* input, size_t input_size,
+                       const char* dict, size_t dict_size,
+                       std::string* output);
+
+bool ZlibDict_Uncompress(const char* input, size_t input_size,
+                         const char* dict, size_t dict_size,
+                         char* output, size_t output_size);
+
 //////////////////////////////
 
 inline bool GetHeapProfile(void (*func)(void*, const char*, int), void* arg) {
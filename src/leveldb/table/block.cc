@@ -10,34 +10,62 @@
 
 #include "table/block.h"
 
+#include <string.h>
 #include <vector>
 #include <algorithm>
 #include "leveldb/comparator.h"
+#include "table/block_hash_index.h"
 #include "table/format.h"
 #include "util/coding.h"
 #include "util/logging.h"
 
 namespace leveldb {
 
-inline uint32_t Block::NumRestarts() const {
-  assert(size_ >= sizeof(uint32_t));
-  return DecodeFixed32(data_ + size_ - sizeof(uint32_t));
-}
-
 Block::Block(const BlockContents& contents)
     : data_(contents.data.data()),
       size_(contents.data.size()),
-      owned_(contents.heap_allocated) {
+      restart_offset_(0),
+      num_restarts_(0),
+      owned_(contents.heap_allocated),
+      row_prefixes_(NULL),
+      buckets_(NULL),
+      num_buckets_(0),
+      key_format_(kReadable) {
   if (size_ < sizeof(uint32_t)) {
     size_ = 0;  // Error marker
-  } else {
-    size_t max_restarts_allowed = (size_-sizeof(uint32_t)) / sizeof(uint32_t);
-    if (NumRestarts() > max_restarts_allowed) {
-      // The size is too small for NumRestarts()
+    return;
+  }
+  const uint32_t num_restarts = DecodeFixed32(data_ + size_ - sizeof(uint32_t));
+  size_t trailer_size = sizeof(uint32_t);
+  size_t restart_size = sizeof(uint32_t);
+  if (num_restarts & kBlockHashIndexFlag) {
+    // num_buckets, key_format and num_restarts
+    trailer_size += sizeof(uint32_t) + 1;
+    if (size_ < trailer_size) {
       size_ = 0;
-    } else {
-      restart_offset_ = size_ - (1 + NumRestarts()) * sizeof(uint32_t);
+      return;
+    }
+    num_buckets_ = DecodeFixed32(data_ + size_ - trailer_size);
+    const uint8_t key_format = data_[size_ - sizeof(uint32_t) - 1];
+    if (key_format > kTTLKv || num_buckets_ > size_ - trailer_size) {
+      size_ = 0;
+      return;
     }
+    key_format_ = static_cast<RawKeyFormat>(key_format);
+    trailer_size += num_buckets_;
+    restart_size += kRowPrefixSize;
+  }
+  num_restarts_ = num_restarts & ~kBlockHashIndexFlag;
+  size_t max_restarts_allowed = (size_ - trailer_size) / restart_size;
+  if (num_restarts_ > max_restarts_allowed) {
+    // The size is too small for num_restarts_
+    size_ = 0;
+    return;
+  }
+  restart_offset_ = size_ - trailer_size - num_restarts_ * restart_size;
+  if (num_restarts & kBlockHashIndexFlag) {
+    row_prefixes_ = data_ + restart_offset_ + num_restarts_ * sizeof(uint32_t);
+    buckets_ = row_prefixes_ + num_restarts_ * kRowPrefixSize;
   }
 }
 
@@ -83,6 +111,10 @@ class Block::Iter : public Iterator {
   const char* const data_;      // underlying block contents
   uint32_t const restarts_;     // Offset of restart array (list of fixed32)
   uint32_t const num_restarts_; // Number of uint32_t entries in restart array
+  const char* const row_prefixes_;  // NULL if the block has no hash index
+  const unsigned char* const buckets_;
+  uint32_t const num_buckets_;
+  RawKeyFormat const key_format_;
 
   // current_ is offset in data_ of current entry.  >= restarts_ if !Valid
   uint32_t current_;
@@ -119,11 +151,19 @@ class Block::Iter : public Iterator {
   Iter(const Comparator* comparator,
        const char* data,
        uint32_t restarts,
-       uint32_t num_restarts)
+       uint32_t num_restarts,
+       const char* row_prefixes,
+       const char* buckets,
+       uint32_t num_buckets,
+       RawKeyFormat key_format)
       : comparator_(comparator),
         data_(data),
         restarts_(restarts),
         num_restarts_(num_restarts),
+        row_prefixes_(row_prefixes),
+        buckets_(reinterpret_cast<const unsigned char*>(buckets)),
+        num_buckets_(num_buckets),
+        key_format_(key_format),
         current_(restarts_),
         restart_index_(num_restarts_) {
     assert(num_restarts_ > 0);
@@ -167,12 +207,36 @@ class Block::Iter : public Iterator {
   }
 
   virtual void Seek(const Slice& target) {
+    Slice target_row;
+    char target_prefix[kRowPrefixSize];
+    const bool has_prefix = row_prefixes_ != NULL &&
+        ExtractBlockRowKey(target, key_format_, &target_row);
+    if (has_prefix) {
+      if (SeekByHashIndex(target, target_row)) {
+        return;
+      }
+      EncodeRowPrefix(target_row, target_prefix);
+    }
+
     // Binary search in restart array to find the last restart point
     // with a key < target
     uint32_t left = 0;
     uint32_t right = num_restarts_ - 1;
     while (left < right) {
       uint32_t mid = (left + right + 1) / 2;
+      if (has_prefix) {
+        // Rows differ in their prefixes, so the keys compare as the
+        // prefixes do, without decoding the key at "mid"
+        int r = memcmp(row_prefixes_ + mid * kRowPrefixSize,
+                       target_prefix, kRowPrefixSize);
+        if (r < 0) {
+          left = mid;
+          continue;
+        } else if (r > 0) {
+          right = mid - 1;
+          continue;
+        }
+      }
       uint32_t region_offset = GetRestartPoint(mid);
       uint32_t shared, non_shared, value_length;
       const char* key_ptr = DecodeEntry(data_ + region_offset,
@@ -219,6 +283,30 @@ class Block::Iter : public Iterator {
   }
 
  private:
+  // Positions at the first key >= "target" by the restart point the hash
+  // index keeps for the row of "target".  Returns false if the row is not
+  // in the block or shares its bucket, the caller has to binary search.
+  bool SeekByHashIndex(const Slice& target, const Slice& target_row) {
+    if (num_buckets_ == 0) {
+      return false;
+    }
+    uint32_t index = buckets_[BlockRowHash(target_row) % num_buckets_];
+    if (index >= num_restarts_) {
+      // kBucketEmpty or kBucketCollision
+      return false;
+    }
+    SeekToRestartPoint(index);
+    while (ParseNextKey()) {
+      if (Compare(key_, target) >= 0) {
+        // Keys before the restart point are all smaller than "target"
+        // only if it is the restart point of the row of "target"
+        Slice row;
+        return ExtractBlockRowKey(key_, key_format_, &row) && row == target_row;
+      }
+    }
+    return !status_.ok();
+  }
+
   void CorruptionError() {
     current_ = restarts_;
     restart_index_ = num_restarts_;
@@ -261,11 +349,11 @@ Iterator* Block::NewIterator(const Comparator* cmp) {
   if (size_ < sizeof(uint32_t)) {
     return NewErrorIterator(Status::Corruption("bad block contents"));
   }
-  const uint32_t num_restarts = NumRestarts();
-  if (num_restarts == 0) {
+  if (num_restarts_ == 0) {
     return NewEmptyIterator();
   } else {
-    return new Iter(cmp, data_, restart_offset_, num_restarts);
+    return new Iter(cmp, data_, restart_offset_, num_restarts_,
+                    row_prefixes_, buckets_, num_buckets_, key_format_);
   }
 }
 
@@ -12,6 +12,7 @@
 #include <stddef.h>
 #include <stdint.h>
 #include "leveldb/iterator.h"
+#include "leveldb/options.h"
 
 namespace leveldb {
 
@@ -29,13 +30,18 @@ class Block {
   Iterator* NewIterator(const Comparator* comparator);
 
  private:
-  uint32_t NumRestarts() const;
-
   const char* data_;
   size_t size_;
   uint32_t restart_offset_;     // Offset in data_ of restart array
+  uint32_t num_restarts_;
   bool owned_;                  // Block owns data_[]
 
+  // Set if the block is built with Options::block_hash_index
+  const char* row_prefixes_;    // kRowPrefixSize bytes per restart point
+  const char* buckets_;         // Restart index of each hash bucket
+  uint32_t num_buckets_;
+  RawKeyFormat key_format_;
+
   // No copying allowed
   Block(const Block&);
   void operator=(const Block&);
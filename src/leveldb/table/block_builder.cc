@@ -29,6 +29,20 @@
 //     restarts: uint32[num_restarts]
 //     num_restarts: uint32
 // restarts[i] contains the offset within the block of the ith restart point.
+//
+// If options.block_hash_index is set, the trailer has the form:
+//     restarts: uint32[num_restarts]
+//     row_prefixes: char[8][num_restarts]
+//     buckets: uint8[num_buckets]
+//     num_buckets: uint32
+//     key_format: uint8
+//     num_restarts | (1 << 31): uint32
+// row_prefixes[i] holds the first 8 bytes of the row key of the ith restart
+// point, zero padded, which let a binary search skip most key comparisons.
+// A row hashes to buckets[hash % num_buckets], that holds the restart point
+// whose region has the first key of the row, 255 if no row of the block
+// hashes there, or 254 if rows of different regions do.  There are no
+// buckets if the block has more than 254 restart points.
 
 #include "table/block_builder.h"
 
@@ -36,6 +50,7 @@
 #include <assert.h>
 #include "leveldb/comparator.h"
 #include "leveldb/table_builder.h"
+#include "table/block_hash_index.h"
 #include "util/coding.h"
 
 namespace leveldb {
@@ -44,7 +59,8 @@ BlockBuilder::BlockBuilder(const Options* options)
     : options_(options),
       restarts_(),
       counter_(0),
-      finished_(false) {
+      finished_(false),
+      hash_index_(options->block_hash_index) {
   assert(options->block_restart_interval >= 1);
   restarts_.push_back(0);       // First restart point is at offset 0
 }
@@ -56,12 +72,21 @@ void BlockBuilder::Reset() {
   counter_ = 0;
   finished_ = false;
   last_key_.clear();
+  hash_index_ = options_->block_hash_index;
+  row_prefixes_.clear();
+  row_restarts_.clear();
 }
 
 size_t BlockBuilder::CurrentSizeEstimate() const {
-  return (buffer_.size() +                        // Raw data buffer
-          restarts_.size() * sizeof(uint32_t) +   // Restart array
-          sizeof(uint32_t));                      // Restart array length
+  size_t estimate = (buffer_.size() +                        // Raw data buffer
+                     restarts_.size() * sizeof(uint32_t) +   // Restart array
+                     sizeof(uint32_t));                      // Restart array length
+  if (hash_index_) {
+    estimate += (row_prefixes_.size() +                      // Row prefixes
+                 row_restarts_.size() * 4 / 3 + 1 +          // Buckets
+                 sizeof(uint32_t) + 1);              // num_buckets and key_format
+  }
+  return estimate;
 }
 
 Slice BlockBuilder::Finish() {
@@ -69,7 +94,29 @@ Slice BlockBuilder::Finish() {
   for (size_t i = 0; i < restarts_.size(); i++) {
     PutFixed32(&buffer_, restarts_[i]);
   }
-  PutFixed32(&buffer_, restarts_.size());
+  uint32_t num_restarts = restarts_.size();
+  if (hash_index_ && options_->block_hash_index &&
+      row_prefixes_.size() == num_restarts * kRowPrefixSize) {
+    buffer_.append(row_prefixes_);
+    // Load factor of 0.75, no buckets if restart indexes do not fit
+    const uint32_t num_buckets = (num_restarts <= kMaxHashIndexRestarts
+                                  ? row_restarts_.size() * 4 / 3 + 1 : 0);
+    const size_t buckets_offset = buffer_.size();
+    buffer_.append(num_buckets, static_cast<char>(kBucketEmpty));
+    for (size_t i = 0; num_buckets > 0 && i < row_restarts_.size(); i++) {
+      char* bucket = &buffer_[buckets_offset + row_restarts_[i].first % num_buckets];
+      uint8_t restart = static_cast<uint8_t>(*bucket);
+      if (restart == kBucketEmpty || restart == row_restarts_[i].second) {
+        *bucket = static_cast<char>(row_restarts_[i].second);
+      } else {
+        *bucket = static_cast<char>(kBucketCollision);
+      }
+    }
+    PutFixed32(&buffer_, num_buckets);
+    buffer_.push_back(static_cast<char>(options_->raw_key_format));
+    num_restarts |= kBlockHashIndexFlag;
+  }
+  PutFixed32(&buffer_, num_restarts);
   finished_ = true;
   return Slice(buffer_);
 }
@@ -94,6 +141,28 @@ void BlockBuilder::Add(const Slice& key, const Slice& value) {
   }
   const size_t non_shared = key.size() - shared;
 
+  if (hash_index_ && options_->block_hash_index) {
+    Slice row, last_row;
+    if (!ExtractBlockRowKey(key, options_->raw_key_format, &row)) {
+      hash_index_ = false;
+    } else {
+      if (counter_ == 0) {
+        // A new restart point
+        char prefix[kRowPrefixSize];
+        EncodeRowPrefix(row, prefix);
+        row_prefixes_.append(prefix, kRowPrefixSize);
+      }
+      if (buffer_.empty() ||
+          !ExtractBlockRowKey(last_key_piece, options_->raw_key_format, &last_row) ||
+          row != last_row) {
+        row_restarts_.push_back(std::make_pair(BlockRowHash(row),
+                                               restarts_.size() - 1));
+      }
+    }
+  } else {
+    hash_index_ = false;
+  }
+
   // Add "<shared><non_shared><value_size>" to buffer_
   PutVarint32(&buffer_, shared);
   PutVarint32(&buffer_, non_shared);
@@ -9,6 +9,8 @@
 #ifndef STORAGE_LEVELDB_TABLE_BLOCK_BUILDER_H_
 #define STORAGE_LEVELDB_TABLE_BLOCK_BUILDER_H_
 
+#include <string>
+#include <utility>
 #include <vector>
 
 #include <stdint.h>
@@ -51,6 +53,13 @@ class BlockBuilder {
   bool                  finished_;    // Has Finish() been called?
   std::string           last_key_;
 
+  // Hash index, built while options_->block_hash_index is set and the
+  // rows of all keys are known
+  bool                  hash_index_;
+  std::string           row_prefixes_;  // Row prefix of each restart point
+  // Hash and restart point of the first key of each row
+  std::vector<std::pair<uint32_t, uint32_t> > row_restarts_;
+
   // No copying allowed
   BlockBuilder(const BlockBuilder&);
   void operator=(const BlockBuilder&);
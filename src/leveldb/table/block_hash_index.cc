@@ -0,0 +1,64 @@
+// Copyright (c) 2015, Baidu.com, Inc. All Rights Reserved
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "table/block_hash_index.h"
+
+#include <string.h>
+#include "util/coding.h"
+#include "util/hash.h"
+
+namespace leveldb {
+
+static const size_t kInternalKeyTrailerSize = 8;
+
+bool ExtractBlockRowKey(const Slice& internal_key, RawKeyFormat format,
+                        Slice* row_key) {
+  if (internal_key.size() < kInternalKeyTrailerSize) {
+    return false;
+  }
+  const char* key = internal_key.data();
+  const size_t key_size = internal_key.size() - kInternalKeyTrailerSize;
+  switch (format) {
+    case kReadable: {
+      // row\0column family\0qualifier\0..., or a kv key without any '\0'
+      const char* end = static_cast<const char*>(memchr(key, '\0', key_size));
+      *row_key = Slice(key, end == NULL ? key_size : end - key);
+      return true;
+    }
+    case kBinary: {
+      // ...the last 4 bytes keep the row length in the high 16 bits
+      if (key_size < sizeof(uint32_t)) {
+        return false;
+      }
+      const size_t row_size =
+          DecodeBigEndain32(key + key_size - sizeof(uint32_t)) >> 16;
+      if (row_size > key_size - sizeof(uint32_t)) {
+        return false;
+      }
+      *row_key = Slice(key, row_size);
+      return true;
+    }
+    case kTTLKv: {
+      // row followed by the 8 bytes expire time
+      if (key_size < sizeof(int64_t)) {
+        return false;
+      }
+      *row_key = Slice(key, key_size - sizeof(int64_t));
+      return true;
+    }
+  }
+  return false;
+}
+
+void EncodeRowPrefix(const Slice& row_key, char* prefix) {
+  const size_t n = row_key.size() < kRowPrefixSize ? row_key.size() : kRowPrefixSize;
+  memcpy(prefix, row_key.data(), n);
+  memset(prefix + n, 0, kRowPrefixSize - n);
+}
+
+uint32_t BlockRowHash(const Slice& row_key) {
+  return Hash(row_key.data(), row_key.size(), 0x5bd1e995);
+}
+
+}  // namespace leveldb
@@ -0,0 +1,43 @@
+// Copyright (c) 2015, Baidu.com, Inc. All Rights Reserved
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// Helpers shared by BlockBuilder and Block for the data blocks built with
+// Options::block_hash_index, see block_builder.cc for the block format.
+
+#ifndef STORAGE_LEVELDB_TABLE_BLOCK_HASH_INDEX_H_
+#define STORAGE_LEVELDB_TABLE_BLOCK_HASH_INDEX_H_
+
+#include <stdint.h>
+#include "leveldb/options.h"
+#include "leveldb/slice.h"
+
+namespace leveldb {
+
+// Set in the num_restarts field of a block with a hash index
+static const uint32_t kBlockHashIndexFlag = 1u << 31;
+
+// Bytes of the row key kept for each restart point
+static const size_t kRowPrefixSize = 8;
+
+// Hash buckets hold the restart index of a row, or one of these
+static const uint8_t kBucketCollision = 254;
+static const uint8_t kBucketEmpty = 255;
+static const uint32_t kMaxHashIndexRestarts = kBucketCollision;
+
+// Stores the row key of the tera key in "internal_key" in "*row_key".
+// Rows of a block sort bytewise, and keys of different rows sort as their
+// rows do, for all raw key formats.  Returns false if "internal_key" is too
+// short to hold a key of "format".
+bool ExtractBlockRowKey(const Slice& internal_key, RawKeyFormat format,
+                        Slice* row_key);
+
+// Stores the first kRowPrefixSize bytes of "row_key", zero padded, in
+// "prefix".  Prefixes compare bytewise as their rows do, or equal.
+void EncodeRowPrefix(const Slice& row_key, char* prefix);
+
+uint32_t BlockRowHash(const Slice& row_key);
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_TABLE_BLOCK_HASH_INDEX_H_
@@ -70,7 +70,8 @@ Status Footer::DecodeFrom(Slice* input) {
 Status ReadBlock(RandomAccessFile* file,
                  const ReadOptions& options,
                  const BlockHandle& handle,
-                 BlockContents* result) {
+                 BlockContents* result,
+                 const Slice& compression_dict) {
   result->data = Slice();
   result->cachable = false;
   result->heap_allocated = false;
@@ -168,6 +169,29 @@ Status ReadBlock(RandomAccessFile* file,
         result->cachable = true;
         break;
     }
+    case kZlibDictCompression: {
+      Slice input(data, n);
+      uint32_t ulength = 0;
+      char* ubuf = NULL;
+      if (GetVarint32(&input, &ulength)) {
+        ubuf = new char[ulength];
+        if (!port::ZlibDict_Uncompress(input.data(), input.size(),
+                                       compression_dict.data(),
+                                       compression_dict.size(),
+                                       ubuf, ulength)) {
+          delete[] ubuf;
+          ubuf = NULL;
+        }
+      }
+      delete[] buf;
+      if (ubuf == NULL) {
+        return Status::Corruption("zlib: corrupted compressed block contents");
+      }
+      result->data = Slice(ubuf, ulength);
+      result->heap_allocated = true;
+      result->cachable = true;
+      break;
+    }
     default:
       delete[] buf;
       return Status::Corruption("bad block type");
@@ -95,10 +95,12 @@ struct BlockContents {
 
 // Read the block identified by "handle" from "file".  On failure
 // return non-OK.  On success fill *result and return OK.
+// "compression_dict" is the table's dictionary for kZlibDictCompression.
 extern Status ReadBlock(RandomAccessFile* file,
                         const ReadOptions& options,
                         const BlockHandle& handle,
-                        BlockContents* result);
+                        BlockContents* result,
+                        const Slice& compression_dict = Slice());
 
 // Implementation details follow.  Clients should ignore,
 
@@ -9,6 +9,8 @@
 #include "leveldb/table_builder.h"
 
 #include <assert.h>
+#include <algorithm>
+#include <deque>
 #include "leveldb/comparator.h"
 #include "leveldb/env.h"
 #include "leveldb/filter_policy.h"
@@ -18,6 +20,9 @@
 #include "table/format.h"
 #include "util/coding.h"
 #include "util/crc32c.h"
+#include "util/dict_trainer.h"
+#include "util/mutexlock.h"
+#include "util/thread_pool.h"
 #include "../utils/counter.h"
 
 namespace leveldb {
@@ -25,6 +30,119 @@ namespace leveldb {
 tera::Counter snappy_before_size_counter;
 tera::Counter snappy_after_size_counter;
 
+// Data of the first blocks, in multiples of the dictionary size, used
+// to train the dictionary of kZlibDictCompression
+static const size_t kDictSampleRatio = 8;
+
+// Deflate can not refer further back than its 32K window
+static const size_t kMaxDictSize = 32 << 10;
+
+// Compress "raw" with "type", store the result in "*contents", which may
+// refer to "*compressed".  Return the type actually used.
+static CompressionType CompressBlock(CompressionType type, const Slice& raw,
+                                     const Slice& dict,
+                                     std::string* compressed, Slice* contents) {
+  switch (type) {
+    case kNoCompression:
+      *contents = raw;
+      break;
+
+    case kSnappyCompression: {
+      snappy_before_size_counter.Add(raw.size());
+      if (port::Snappy_Compress(raw.data(), raw.size(), compressed) &&
+          compressed->size() < raw.size() - (raw.size() / 8u)) {
+        *contents = *compressed;
+      } else {
+        // Snappy not supported, or compressed less than 12.5%, so just
+        // store uncompressed form
+        *contents = raw;
+        type = kNoCompression;
+      }
+      snappy_after_size_counter.Add(contents->size());
+      break;
+    }
+    case kBmzCompression: {
+      if (port::Bmz_Compress(raw.data(), raw.size(), compressed) &&
+          compressed->size() < raw.size() - (raw.size() / 8u)) {
+        *contents = *compressed;
+      } else {
+        *contents = raw;
+        type = kNoCompression;
+      }
+      break;
+    }
+    case kLZ4Compression: {
+      if (port::Lz4_Compress(raw.data(), raw.size(), compressed) &&
+          compressed->size() < raw.size()) {
+        *contents = *compressed;
+      } else {
+        *contents = raw;
+        type = kNoCompression;
+      }
+      break;
+    }
+    case kZlibDictCompression: {
+      // Uncompressed length first, the reader allocates by it
+      compressed->clear();
+      PutVarint32(compressed, raw.size());
+      if (port::ZlibDict_Compress(raw.data(), raw.size(),
+                                  dict.data(), dict.size(), compressed) &&
+          compressed->size() < raw.size() - (raw.size() / 8u)) {
+        *contents = *compressed;
+      } else {
+        *contents = raw;
+        type = kNoCompression;
+      }
+      break;
+    }
+  }
+  return type;
+}
+
+// A data block handed to the compression threads.  Blocks are written
+// in the order they were built, once compressed and once the key of
+// their index entry is known.
+struct CompressTask {
+  port::Mutex* mu;
+  port::CondVar* cv;
+  std::string raw;
+  std::string compressed;
+  Slice contents;
+  CompressionType type;
+  Slice dict;
+  bool done;              // Guarded by *mu
+
+  bool has_index_key;
+  std::string index_key;
+  std::string filter_keys;              // Flattened keys for the filter
+  std::vector<size_t> filter_key_starts;
+};
+
+static void CompressWork(void* arg) {
+  CompressTask* task = reinterpret_cast<CompressTask*>(arg);
+  CompressionType type = CompressBlock(task->type, task->raw, task->dict,
+                                       &task->compressed, &task->contents);
+  MutexLock l(task->mu);
+  task->type = type;
+  task->done = true;
+  task->cv->SignalAll();
+}
+
+static port::OnceType compress_pool_once = LEVELDB_ONCE_INIT;
+static ThreadPool* compress_pool = NULL;
+
+static void InitCompressPool() {
+  compress_pool = new ThreadPool();
+}
+
+static ThreadPool* CompressPool(int threads) {
+  port::InitOnce(&compress_pool_once, InitCompressPool);
+  if (compress_pool->GetThreadNumber() != threads) {
+    compress_pool->SetBackgroundThreads(threads);
+  }
+  return compress_pool;
+}
+
 struct TableBuilder::Rep {
   Options options;
   Options index_block_options;
@@ -53,6 +171,20 @@ struct TableBuilder::Rep {
 
   std::string compressed_output;
 
+  // Data blocks are queued before being written if true, to compress
+  // them by background threads, or to train the compression dictionary
+  // from the first ones.  Fixed at construction, as it changes how index
+  // and filter entries are emitted.
+  bool pipelined;
+  bool dict_pending;                        // Dictionary not trained yet
+  size_t dict_sample_size;
+  std::string compression_dict;
+  std::deque<CompressTask*> pending_tasks;  // Oldest first
+  port::Mutex compress_mu;
+  port::CondVar compress_cv;
+  std::string filter_keys;                  // Keys of the current block
+  std::vector<size_t> filter_key_starts;
+
   Rep(const Options& opt, WritableFile* f)
       : options(opt),
         index_block_options(opt),
@@ -65,8 +197,15 @@ struct TableBuilder::Rep {
         closed(false),
         filter_block(opt.filter_policy == NULL ? NULL
                      : new FilterBlockBuilder(opt.filter_policy)),
-        pending_index_entry(false) {
+        pending_index_entry(false),
+        pipelined(opt.parallel_compression_threads > 0 ||
+                  opt.compression == kZlibDictCompression),
+        dict_pending(opt.compression == kZlibDictCompression),
+        dict_sample_size(0),
+        compress_cv(&compress_mu) {
     index_block_options.block_restart_interval = 1;
+    // index keys are separators rather than keys of rows
+    index_block_options.block_hash_index = false;
   }
 };
 
@@ -96,6 +235,7 @@ Status TableBuilder::ChangeOptions(const Options& options) {
   rep_->options = options;
   rep_->index_block_options = options;
   rep_->index_block_options.block_restart_interval = 1;
+  rep_->index_block_options.block_hash_index = false;
   return Status::OK();
 }
 
@@ -110,14 +250,26 @@ void TableBuilder::Add(const Slice& key, const Slice& value) {
   if (r->pending_index_entry) {
     assert(r->data_block.empty());
     r->options.comparator->FindShortestSeparator(&r->last_key, key);
-    std::string handle_encoding;
-    r->pending_handle.EncodeTo(&handle_encoding);
-    r->index_block.Add(r->last_key, Slice(handle_encoding));
+    if (r->pipelined) {
+      // The block may not be written yet, its handle is added then
+      r->pending_tasks.back()->index_key = r->last_key;
+      r->pending_tasks.back()->has_index_key = true;
+    } else {
+      std::string handle_encoding;
+      r->pending_handle.EncodeTo(&handle_encoding);
+      r->index_block.Add(r->last_key, Slice(handle_encoding));
+    }
     r->pending_index_entry = false;
   }
 
   if (r->filter_block != NULL) {
-    r->filter_block->AddKey(key);
+    if (r->pipelined) {
+      // Filters are keyed by block offset, add the keys once it is known
+      r->filter_key_starts.push_back(r->filter_keys.size());
+      r->filter_keys.append(key.data(), key.size());
+    } else {
+      r->filter_block->AddKey(key);
+    }
   }
 
   r->last_key.assign(key.data(), key.size());
@@ -136,6 +288,12 @@ void TableBuilder::Flush() {
   if (!ok()) return;
   if (r->data_block.empty()) return;
   assert(!r->pending_index_entry);
+  if (r->pipelined) {
+    QueueBlock();
+    r->pending_index_entry = true;
+    WritePendingBlocks(false);
+    return;
+  }
   WriteBlock(&r->data_block, &r->pending_handle);
   if (ok()) {
     r->pending_index_entry = true;
@@ -156,55 +314,138 @@ void TableBuilder::WriteBlock(BlockBuilder* block, BlockHandle* handle) {
   Slice raw = block->Finish();
 
   Slice block_contents;
-  CompressionType type = r->options.compression;
-  // TODO(postrelease): Support more compression options: zlib?
-  switch (type) {
-    case kNoCompression:
-      block_contents = raw;
-      break;
+  // Only meta and index blocks get here in dictionary mode, they are
+  // read before the dictionary and compressed without it
+  CompressionType type = CompressBlock(r->options.compression, raw, Slice(),
+                                       &r->compressed_output, &block_contents);
+  WriteRawBlock(block_contents, type, handle);
+  r->compressed_output.clear();
+  block->Reset();
+  r->saved_size += raw.size() - block_contents.size();
+}
 
-    case kSnappyCompression: {
-      snappy_before_size_counter.Add(raw.size());
-      std::string* compressed = &r->compressed_output;
-      if (port::Snappy_Compress(raw.data(), raw.size(), compressed) &&
-          compressed->size() < raw.size() - (raw.size() / 8u)) {
-        block_contents = *compressed;
-      } else {
-        // Snappy not supported, or compressed less than 12.5%, so just
-        // store uncompressed form
-        block_contents = raw;
-        type = kNoCompression;
-      }
-      snappy_after_size_counter.Add(block_contents.size());
+void TableBuilder::QueueBlock() {
+  Rep* r = rep_;
+  CompressTask* task = new CompressTask;
+  task->mu = &r->compress_mu;
+  task->cv = &r->compress_cv;
+  Slice raw = r->data_block.Finish();
+  task->raw.assign(raw.data(), raw.size());
+  task->type = r->options.compression;
+  task->done = false;
+  task->has_index_key = false;
+  task->filter_keys.swap(r->filter_keys);
+  task->filter_key_starts.swap(r->filter_key_starts);
+  r->data_block.Reset();
+  r->pending_tasks.push_back(task);
+
+  if (r->dict_pending) {
+    // Hold the first blocks as samples for the dictionary
+    r->dict_sample_size += task->raw.size();
+    size_t dict_size = std::min(r->options.compression_dict_size, kMaxDictSize);
+    if (r->dict_sample_size >= dict_size * kDictSampleRatio) {
+      TrainDict();
+    }
+    return;
+  }
+  StartCompress(task);
+}
+
+void TableBuilder::StartCompress(CompressTask* task) {
+  Rep* r = rep_;
+  task->dict = r->compression_dict;
+  if (task->type == kNoCompression) {
+    task->contents = task->raw;
+    task->done = true;
+  } else if (r->options.parallel_compression_threads > 0) {
+    CompressPool(r->options.parallel_compression_threads)->Schedule(
+        &CompressWork, task, 0, 0);
+  } else {
+    CompressWork(task);
+  }
+}
+
+void TableBuilder::TrainDict() {
+  Rep* r = rep_;
+  assert(r->dict_pending);
+  std::vector<Slice> samples;
+  std::deque<CompressTask*>::iterator it = r->pending_tasks.begin();
+  for (; it != r->pending_tasks.end(); ++it) {
+    samples.push_back((*it)->raw);
+  }
+  size_t dict_size = std::min(r->options.compression_dict_size, kMaxDictSize);
+  r->compression_dict = TrainCompressionDict(samples, dict_size);
+  r->dict_pending = false;
+  for (it = r->pending_tasks.begin(); it != r->pending_tasks.end(); ++it) {
+    StartCompress(*it);
+  }
+}
+
+void TableBuilder::WritePendingBlocks(bool wait_all) {
+  Rep* r = rep_;
+  // Bound the memory held by blocks in flight
+  const size_t max_pending = 2 * r->options.parallel_compression_threads + 1;
+  if (r->dict_pending) {
+    return;  // Nothing is compressed before the dictionary
+  }
+  while (!r->pending_tasks.empty()) {
+    CompressTask* task = r->pending_tasks.front();
+    if (!task->has_index_key) {
+      // The last block waits for the first key of the next one
+      assert(r->pending_tasks.size() == 1);
       break;
     }
-    case kBmzCompression: {
-      std::string* compressed = &r->compressed_output;
-      if (port::Bmz_Compress(raw.data(), raw.size(), compressed) &&
-          compressed->size() < raw.size() - (raw.size() / 8u)) {
-        block_contents = *compressed;
-      } else {
-        block_contents = raw;
-        type = kNoCompression;
+    {
+      MutexLock l(&r->compress_mu);
+      while (!task->done) {
+        if (!wait_all && r->pending_tasks.size() <= max_pending) {
+          return;
+        }
+        r->compress_cv.Wait();
       }
-      break;
     }
-    case kLZ4Compression: {
-      std::string* compressed = &r->compressed_output;
-      if (port::Lz4_Compress(raw.data(), raw.size(), compressed) &&
-          compressed->size() < raw.size()) {
-        block_contents = *compressed;
-      } else {
-        block_contents = raw;
-        type = kNoCompression;
+    r->pending_tasks.pop_front();
+
+    if (ok()) {
+      if (r->filter_block != NULL) {
+        const std::vector<size_t>& starts = task->filter_key_starts;
+        for (size_t i = 0; i < starts.size(); i++) {
+          size_t end = (i + 1 < starts.size()) ? starts[i + 1]
+                                               : task->filter_keys.size();
+          r->filter_block->AddKey(Slice(task->filter_keys.data() + starts[i],
+                                        end - starts[i]));
+        }
+      }
+      BlockHandle handle;
+      WriteRawBlock(task->contents, task->type, &handle);
+      if (ok()) {
+        std::string handle_encoding;
+        handle.EncodeTo(&handle_encoding);
+        r->index_block.Add(task->index_key, Slice(handle_encoding));
+        r->saved_size += task->raw.size() - task->contents.size();
+        r->status = r->file->Flush();
+      }
+      if (r->filter_block != NULL) {
+        r->filter_block->StartBlock(r->offset);
       }
-      break;
     }
+    delete task;
+  }
+}
+
+void TableBuilder::AbandonPendingBlocks() {
+  Rep* r = rep_;
+  while (!r->pending_tasks.empty()) {
+    CompressTask* task = r->pending_tasks.front();
+    if (!r->dict_pending) {
+      MutexLock l(&r->compress_mu);
+      while (!task->done) {
+        r->compress_cv.Wait();
+      }
+    }
+    r->pending_tasks.pop_front();
+    delete task;
   }
-  WriteRawBlock(block_contents, type, handle);
-  r->compressed_output.clear();
-  block->Reset();
-  r->saved_size += raw.size() - block_contents.size();
 }
 
 void TableBuilder::WriteRawBlock(const Slice& block_contents,
@@ -237,7 +478,22 @@ Status TableBuilder::Finish() {
   assert(!r->closed);
   r->closed = true;
 
-  BlockHandle filter_block_handle, metaindex_block_handle, index_block_handle;
+  if (r->pipelined) {
+    if (r->pending_index_entry) {
+      r->options.comparator->FindShortSuccessor(&r->last_key);
+      r->pending_tasks.back()->index_key = r->last_key;
+      r->pending_tasks.back()->has_index_key = true;
+      r->pending_index_entry = false;
+    }
+    if (r->dict_pending && ok()) {
+      TrainDict();  // Small table, train with all its blocks
+    }
+    WritePendingBlocks(true);
+    AbandonPendingBlocks();  // Left over only if an error stopped Flush()
+  }
+
+  BlockHandle filter_block_handle, dict_block_handle;
+  BlockHandle metaindex_block_handle, index_block_handle;
 
   // Write filter block
   if (ok() && r->filter_block != NULL) {
@@ -245,9 +501,22 @@ Status TableBuilder::Finish() {
                   &filter_block_handle);
   }
 
+  // Write compression dictionary block
+  if (ok() && !r->compression_dict.empty()) {
+    WriteRawBlock(r->compression_dict, kNoCompression, &dict_block_handle);
+  }
+
   // Write metaindex block
   if (ok()) {
-    BlockBuilder meta_index_block(&r->options);
+    Options meta_index_options = r->options;
+    meta_index_options.block_hash_index = false;
+    BlockBuilder meta_index_block(&meta_index_options);
+    if (!r->compression_dict.empty()) {
+      // Add mapping from "compression.dict" to location of the dictionary
+      std::string handle_encoding;
+      dict_block_handle.EncodeTo(&handle_encoding);
+      meta_index_block.Add("compression.dict", handle_encoding);
+    }
     if (r->filter_block != NULL) {
       // Add mapping from "filter.Name" to location of filter data
       std::string key = "filter.";
@@ -292,6 +561,7 @@ void TableBuilder::Abandon() {
   Rep* r = rep_;
   assert(!r->closed);
   r->closed = true;
+  AbandonPendingBlocks();
 }
 
 uint64_t TableBuilder::NumEntries() const {
@@ -16,6 +16,7 @@
 #include "leveldb/db.h"
 #include "leveldb/env.h"
 #include "leveldb/iterator.h"
+#include "leveldb/raw_key_operator.h"
 #include "leveldb/table_builder.h"
 #include "table/block.h"
 #include "table/block_builder.h"
@@ -411,6 +412,8 @@ struct TestArgs {
   TestType type;
   bool reverse_compare;
   int restart_interval;
+  int compression_threads;
+  bool dict_compression;
 };
 
 static const TestArgs kTestArgList[] = {
@@ -421,6 +424,14 @@ static const TestArgs kTestArgList[] = {
   { TABLE_TEST, true, 1 },
   { TABLE_TEST, true, 1024 },
 
+  // Compress data blocks in parallel
+  { TABLE_TEST, false, 16, 4 },
+  { TABLE_TEST, true, 16, 4 },
+
+  // Compress data blocks with a trained dictionary
+  { TABLE_TEST, false, 16, 0, true },
+  { TABLE_TEST, true, 16, 4, true },
+
   { BLOCK_TEST, false, 16 },
   { BLOCK_TEST, false, 1 },
   { BLOCK_TEST, false, 1024 },
@@ -451,6 +462,14 @@ class Harness {
     // Use shorter block size for tests to exercise block boundary
     // conditions more.
     options_.block_size = 256;
+    if (args.compression_threads > 0) {
+      options_.compression = kBmzCompression;
+      options_.parallel_compression_threads = args.compression_threads;
+    }
+    if (args.dict_compression) {
+      options_.compression = kZlibDictCompression;
+      options_.compression_dict_size = 1024;
+    }
     if (args.reverse_compare) {
       options_.comparator = &reverse_key_comparator;
     }
@@ -865,6 +884,157 @@ TEST(TableTest, ApproximateOffsetOfCompressed) {
   ASSERT_TRUE(Between(c.ApproximateOffsetOf("xyz"),    4000,   6000));
 }
 
+static bool ZlibDictCompressionSupported() {
+  std::string out;
+  Slice in = "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa";
+  return port::ZlibDict_Compress(in.data(), in.size(), in.data(), in.size(),
+                                 &out);
+}
+
+TEST(TableTest, DictCompressionOfSmallValues) {
+  if (!ZlibDictCompressionSupported()) {
+    fprintf(stderr, "skipping dictionary compression tests\n");
+    return;
+  }
+
+  // Many small similar records, each block alone compresses poorly
+  TableConstructor c(BytewiseComparator());
+  size_t raw_size = 0;
+  for (int i = 0; i < 2000; i++) {
+    char key[16];
+    char value[128];
+    snprintf(key, sizeof(key), "k%06d", i);
+    snprintf(value, sizeof(value),
+             "{\"user_id\":%d,\"status\":\"active\",\"region\":\"r%d\","
+             "\"score\":%d}", i * 7919, i % 13, i % 101);
+    c.Add(key, value);
+    raw_size += strlen(key) + strlen(value);
+  }
+  std::vector<std::string> keys;
+  KVMap kvmap;
+  Options options;
+  options.block_size = 256;
+  options.compression = kZlibDictCompression;
+  options.compression_dict_size = 4096;
+  c.Finish(options, &keys, &kvmap);
+
+  ASSERT_LT(c.ApproximateOffsetOf("xyz"), raw_size / 2);
+
+  Iterator* iter = c.NewIterator();
+  iter->SeekToFirst();
+  for (KVMap::const_iterator it = kvmap.begin(); it != kvmap.end(); ++it) {
+    ASSERT_TRUE(iter->Valid());
+    ASSERT_EQ(it->first, iter->key().ToString());
+    ASSERT_EQ(it->second, iter->value().ToString());
+    iter->Next();
+  }
+  ASSERT_TRUE(!iter->Valid());
+  ASSERT_OK(iter->status());
+  delete iter;
+}
+
+class BlockHashIndexTest {
+ public:
+  // Rows sharing their first 8 bytes, with some columns each
+  static std::string UserKey(RawKeyFormat format, int row, int column) {
+    char row_key[32];
+    char qualifier[16];
+    snprintf(row_key, sizeof(row_key), "row_key_%06d", row);
+    snprintf(qualifier, sizeof(qualifier), "q%d", column);
+    std::string key;
+    switch (format) {
+      case kReadable:
+        ReadableRawKeyOperator()->EncodeTeraKey(row_key, "cf", qualifier, 0,
+                                                TKT_VALUE, &key);
+        break;
+      case kBinary:
+        BinaryRawKeyOperator()->EncodeTeraKey(row_key, "cf", qualifier, 0,
+                                              TKT_VALUE, &key);
+        break;
+      case kTTLKv:
+        KvRawKeyOperator()->EncodeTeraKey(row_key, "", "", column,
+                                          TKT_VALUE, &key);
+        break;
+    }
+    return key;
+  }
+
+  // Seeks of a block with a hash index must land where they do in the
+  // same block without one
+  static void Check(RawKeyFormat format, const Comparator* user_comparator,
+                    int restart_interval, int num_rows) {
+    InternalKeyComparator cmp(user_comparator);
+    BlockConstructor with_index(&cmp);
+    BlockConstructor without_index(&cmp);
+    std::vector<std::string> targets;
+    for (int row = 0; row < num_rows; row++) {
+      for (int column = 0; column < 3; column++) {
+        // leave every fourth row out
+        std::string key = InternalKey(UserKey(format, row, column),
+                                      100, kTypeValue).Encode().ToString();
+        if (row % 4 != 0) {
+          with_index.Add(key, "v");
+          without_index.Add(key, "v");
+        }
+        targets.push_back(key);
+        targets.push_back(InternalKey(UserKey(format, row, column),
+                                      kMaxSequenceNumber,
+                                      kValueTypeForSeek).Encode().ToString());
+      }
+    }
+    Options options;
+    options.comparator = &cmp;
+    options.raw_key_format = format;
+    options.block_restart_interval = restart_interval;
+    std::vector<std::string> keys;
+    KVMap kvmap;
+    without_index.Finish(options, &keys, &kvmap);
+    options.block_hash_index = true;
+    with_index.Finish(options, &keys, &kvmap);
+
+    Iterator* iter = with_index.NewIterator();
+    Iterator* expected = without_index.NewIterator();
+    for (size_t i = 0; i < targets.size(); i++) {
+      iter->Seek(targets[i]);
+      expected->Seek(targets[i]);
+      ASSERT_EQ(expected->Valid(), iter->Valid());
+      if (iter->Valid()) {
+        ASSERT_EQ(expected->key().ToString(), iter->key().ToString());
+      }
+      ASSERT_OK(iter->status());
+    }
+    iter->SeekToFirst();
+    for (size_t i = 0; i < keys.size(); i++) {
+      ASSERT_TRUE(iter->Valid());
+      ASSERT_EQ(keys[i], iter->key().ToString());
+      iter->Next();
+    }
+    ASSERT_TRUE(!iter->Valid());
+    delete iter;
+    delete expected;
+  }
+};
+
+TEST(BlockHashIndexTest, Readable) {
+  Check(kReadable, BytewiseComparator(), 16, 100);
+  Check(kReadable, BytewiseComparator(), 1, 10);
+}
+
+TEST(BlockHashIndexTest, Binary) {
+  Check(kBinary, TeraBinaryComparator(), 16, 100);
+  Check(kBinary, TeraBinaryComparator(), 1, 10);
+}
+
+TEST(BlockHashIndexTest, TTLKv) {
+  Check(kTTLKv, TeraTTLKvComparator(), 16, 100);
+  Check(kTTLKv, TeraTTLKvComparator(), 1, 10);
+}
+
+TEST(BlockHashIndexTest, TooManyRestarts) {
+  // No buckets, only the row prefixes
+  Check(kReadable, BytewiseComparator(), 1, 200);
+}
+
 }  // namespace leveldb
 
 int main(int argc, char** argv) {
@@ -8,6 +8,7 @@
 
 #include "util/arena.h"
 #include <assert.h>
+#include "util/mutexlock.h"
 
 namespace leveldb {
 
@@ -62,6 +63,37 @@ char* Arena::AllocateAligned(size_t bytes) {
   return result;
 }
 
+// Shard used by the calling thread, assigned round-robin on first use
+static __thread int tls_arena_shard = -1;
+static uint32_t next_arena_shard = 0;
+
+char* Arena::AllocateAlignedConcurrently(size_t bytes) {
+  const size_t align = sizeof(void*);
+  // Round up so that the shard blocks stay aligned
+  bytes = (bytes + align - 1) & ~(align - 1);
+  if (bytes > kBlockSize / 4) {
+    MutexLock l(&mu_);
+    return AllocateNewBlock(bytes);
+  }
+
+  if (tls_arena_shard < 0) {
+    tls_arena_shard = __sync_fetch_and_add(&next_arena_shard, 1) % kNumShards;
+  }
+  Shard* shard = &shards_[tls_arena_shard];
+  MutexLock shard_lock(&shard->mu);
+  if (bytes > shard->alloc_bytes_remaining) {
+    // We waste the remaining space in the shard's current block.
+    MutexLock l(&mu_);
+    shard->alloc_ptr = AllocateNewBlock(kBlockSize);
+    shard->alloc_bytes_remaining = kBlockSize;
+  }
+  char* result = shard->alloc_ptr;
+  shard->alloc_ptr += bytes;
+  shard->alloc_bytes_remaining -= bytes;
+  assert((reinterpret_cast<uintptr_t>(result) & (align-1)) == 0);
+  return result;
+}
+
 char* Arena::AllocateNewBlock(size_t block_bytes) {
   char* result = new char[block_bytes];
   blocks_memory_ += block_bytes;
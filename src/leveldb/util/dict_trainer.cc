@@ -0,0 +1,119 @@
+// Copyright (c) 2015, Baidu.com, Inc. All Rights Reserved
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "util/dict_trainer.h"
+
+#include <stdint.h>
+#include <string.h>
+#include <queue>
+
+namespace leveldb {
+
+namespace {
+
+// Content is compared by hashed 8-byte grams, and picked in 64-byte
+// segments, which fits many small similar values such as json records.
+const size_t kGramSize = 8;
+const size_t kSegmentSize = 64;
+const int kHashBits = 18;
+
+inline uint32_t GramHash(const char* p) {
+  uint64_t v;
+  memcpy(&v, p, sizeof(v));
+  return static_cast<uint32_t>((v * 0x9E3779B97F4A7C15ull) >> (64 - kHashBits));
+}
+
+// Sum of the number of other samples sharing each gram of the segment
+uint32_t SegmentScore(const char* p, const std::vector<uint32_t>& freq) {
+  uint32_t score = 0;
+  for (size_t i = 0; i + kGramSize <= kSegmentSize; i++) {
+    uint32_t f = freq[GramHash(p + i)];
+    if (f > 1) {
+      score += f - 1;
+    }
+  }
+  return score;
+}
+
+struct Segment {
+  uint32_t score;
+  const char* data;
+  bool operator<(const Segment& s) const {
+    return score < s.score;
+  }
+};
+
+}  // namespace
+
+std::string TrainCompressionDict(const std::vector<Slice>& samples,
+                                 size_t dict_size) {
+  std::string dict;
+  size_t total_size = 0;
+  for (size_t i = 0; i < samples.size(); i++) {
+    total_size += samples[i].size();
+  }
+  if (total_size <= dict_size) {
+    for (size_t i = 0; i < samples.size(); i++) {
+      dict.append(samples[i].data(), samples[i].size());
+    }
+    return dict;
+  }
+
+  // Count each gram once per sample, so that content shared by many
+  // samples ranks above content repeated inside a single one.
+  std::vector<uint32_t> freq(1 << kHashBits, 0);
+  std::vector<uint32_t> last_sample(1 << kHashBits, ~0u);
+  for (size_t i = 0; i < samples.size(); i++) {
+    const Slice& s = samples[i];
+    for (size_t p = 0; p + kGramSize <= s.size(); p++) {
+      uint32_t h = GramHash(s.data() + p);
+      if (last_sample[h] != static_cast<uint32_t>(i)) {
+        last_sample[h] = i;
+        freq[h]++;
+      }
+    }
+  }
+
+  std::priority_queue<Segment> candidates;
+  for (size_t i = 0; i < samples.size(); i++) {
+    const Slice& s = samples[i];
+    for (size_t p = 0; p + kSegmentSize <= s.size(); p += kSegmentSize / 2) {
+      Segment seg;
+      seg.data = s.data() + p;
+      seg.score = SegmentScore(seg.data, freq);
+      if (seg.score > 0) {
+        candidates.push(seg);
+      }
+    }
+  }
+
+  // Greedily take the best segment, then forget its grams so that
+  // overlapping segments are not taken again.  Scores only decrease,
+  // so a stale top is rescored and pushed back.
+  std::vector<const char*> chosen;
+  while (!candidates.empty() && (chosen.size() + 1) * kSegmentSize <= dict_size) {
+    Segment seg = candidates.top();
+    candidates.pop();
+    uint32_t score = SegmentScore(seg.data, freq);
+    if (score != seg.score) {
+      if (score > 0) {
+        seg.score = score;
+        candidates.push(seg);
+      }
+      continue;
+    }
+    chosen.push_back(seg.data);
+    for (size_t i = 0; i + kGramSize <= kSegmentSize; i++) {
+      freq[GramHash(seg.data + i)] = 0;
+    }
+  }
+
+  // Deflate encodes nearer matches cheaper, put the best segments last
+  for (size_t i = chosen.size(); i > 0; i--) {
+    dict.append(chosen[i - 1], kSegmentSize);
+  }
+  return dict;
+}
+
+}  // namespace leveldb
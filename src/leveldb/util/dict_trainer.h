@@ -0,0 +1,24 @@
+// Copyright (c) 2015, Baidu.com, Inc. All Rights Reserved
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// Builds a preset dictionary for block compression from sample blocks
+
+#ifndef STORAGE_LEVELDB_UTIL_DICT_TRAINER_H_
+#define STORAGE_LEVELDB_UTIL_DICT_TRAINER_H_
+
+#include <string>
+#include <vector>
+#include "leveldb/slice.h"
+
+namespace leveldb {
+
+// Return a dictionary of at most "dict_size" bytes made of the sample
+// segments that share the most content with the other samples.  The
+// most valuable segments are placed at the end of the dictionary.
+extern std::string TrainCompressionDict(const std::vector<Slice>& samples,
+                                        size_t dict_size);
+
+}
+
+#endif  // STORAGE_LEVELDB_UTIL_DICT_TRAINER_H_
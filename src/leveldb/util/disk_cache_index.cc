@@ -0,0 +1,316 @@
+// Copyright (c) 2015, Baidu.com, Inc. All Rights Reserved
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "util/disk_cache_index.h"
+
+#include <map>
+
+#include "db/log_reader.h"
+#include "db/log_writer.h"
+#include "leveldb/env.h"
+#include "leveldb/slog.h"
+#include "util/coding.h"
+#include "util/mutexlock.h"
+
+namespace leveldb {
+
+// Record types of the journal
+enum DiskCacheIndexType {
+    kIndexHeader = 1,
+    kIndexInsert = 2,
+    kIndexDrop = 3
+};
+
+DiskCacheIndex::DiskCacheIndex(const std::string& index_name,
+                               uint32_t block_size, uint32_t blocks_num,
+                               uint32_t file_num)
+    : index_name_(index_name), block_size_(block_size),
+      blocks_num_(blocks_num), file_num_(file_num), generation_(0),
+      file_(NULL), log_(NULL), records_(0), compacting_(false),
+      compact_cv_(&mutex_) {}
+
+DiskCacheIndex::~DiskCacheIndex() {
+    MutexLock l(&mutex_);
+    while (compacting_) {
+        compact_cv_.Wait();
+    }
+    CloseJournal();
+}
+
+Status DiskCacheIndex::Load(std::vector<Entry>* entries) {
+    uint64_t generation = 0;
+    Status s = Load(entries, &generation);
+    MutexLock l(&mutex_);
+    generation_ = generation;
+    return s;
+}
+
+Status DiskCacheIndex::Load(std::vector<Entry>* entries, uint64_t* generation) {
+    entries->clear();
+    entries->resize(blocks_num_);
+    Env* env = Env::Default();
+    if (!env->FileExists(index_name_)) {
+        return Status::OK();
+    }
+    SequentialFile* file = NULL;
+    Status s = env->NewSequentialFile(index_name_, &file);
+    if (!s.ok()) {
+        return s;
+    }
+
+    // a torn tail is expected after crash, so ignore corruption
+    log::Reader reader(file, NULL, true, 0);
+    std::map<std::string, uint32_t> key_to_local;
+    bool header_checked = false;
+    Slice record;
+    std::string scratch;
+    while (reader.ReadRecord(&record, &scratch)) {
+        if (record.size() < 1) {
+            continue;
+        }
+        uint8_t type = record[0];
+        record.remove_prefix(1);
+        if (!header_checked) {
+            uint32_t block_size = 0;
+            uint32_t blocks_num = 0;
+            uint32_t file_num = 0;
+            if (type != kIndexHeader
+                || !GetVarint64(&record, generation)
+                || !GetVarint32(&record, &block_size)
+                || !GetVarint32(&record, &blocks_num)
+                || !GetVarint32(&record, &file_num)) {
+                s = Status::Corruption("bad disk-cache index header");
+                break;
+            }
+            if (block_size != block_size_ || blocks_num != blocks_num_
+                || file_num != file_num_) {
+                s = Status::InvalidArgument("disk-cache geometry changed");
+                break;
+            }
+            header_checked = true;
+            continue;
+        }
+
+        uint32_t local_no = 0;
+        if (!GetVarint32(&record, &local_no) || local_no >= blocks_num_) {
+            continue;
+        }
+        Entry& entry = (*entries)[local_no];
+        if (type == kIndexDrop) {
+            entry.valid = false;
+            continue;
+        }
+        Slice fname;
+        if (type != kIndexInsert
+            || !GetLengthPrefixedSlice(&record, &fname)
+            || !GetVarint32(&record, &entry.block_no)
+            || !GetVarint32(&record, &entry.size)
+            || !GetVarint32(&record, &entry.crc)
+            || !GetVarint64(&record, &entry.file_size)) {
+            continue;
+        }
+        entry.fname = fname.ToString();
+        entry.valid = true;
+
+        // the same remote block may only be cached once
+        std::string key = entry.fname;
+        PutFixed32(&key, entry.block_no);
+        std::map<std::string, uint32_t>::iterator it = key_to_local.find(key);
+        if (it != key_to_local.end() && it->second != local_no) {
+            (*entries)[it->second].valid = false;
+        }
+        key_to_local[key] = local_no;
+    }
+    delete file;
+    return s;
+}
+
+Status DiskCacheIndex::Reset(const std::vector<Entry>& entries) {
+    const uint64_t generation = Generation() + 1;
+    WritableFile* file = NULL;
+    log::Writer* log = NULL;
+    Status s = WriteJournal(entries, generation, &file, &log);
+    MutexLock l(&mutex_);
+    CloseJournal();
+    if (s.ok()) {
+        s = InstallJournal(file, log);
+    }
+    if (s.ok()) {
+        generation_ = generation;
+    }
+    return s;
+}
+
+static void EncodeInsert(uint32_t local_no, const std::string& fname,
+                         uint32_t block_no, uint32_t size, uint32_t crc,
+                         uint64_t file_size, std::string* record) {
+    record->clear();
+    record->push_back(kIndexInsert);
+    PutVarint32(record, local_no);
+    PutLengthPrefixedSlice(record, fname);
+    PutVarint32(record, block_no);
+    PutVarint32(record, size);
+    PutVarint32(record, crc);
+    PutVarint64(record, file_size);
+}
+
+void DiskCacheIndex::LogInsert(uint32_t local_no, const std::string& fname,
+                               uint32_t block_no, uint32_t size, uint32_t crc,
+                               uint64_t file_size) {
+    std::string record;
+    EncodeInsert(local_no, fname, block_no, size, crc, file_size, &record);
+    MutexLock l(&mutex_);
+    AddRecord(record);
+}
+
+void DiskCacheIndex::LogDrop(uint32_t local_no) {
+    std::string record;
+    record.push_back(kIndexDrop);
+    PutVarint32(&record, local_no);
+    MutexLock l(&mutex_);
+    AddRecord(record);
+}
+
+uint64_t DiskCacheIndex::Generation() {
+    MutexLock l(&mutex_);
+    return generation_;
+}
+
+// Write a compact journal of "entries" to a temporary file
+Status DiskCacheIndex::WriteJournal(const std::vector<Entry>& entries,
+                                    uint64_t generation,
+                                    WritableFile** file, log::Writer** log) {
+    *file = NULL;
+    *log = NULL;
+    Env* env = Env::Default();
+    Status s = env->NewWritableFile(index_name_ + ".tmp", file);
+    if (!s.ok()) {
+        *file = NULL;
+        return s;
+    }
+    *log = new log::Writer(*file);
+
+    std::string record;
+    record.push_back(kIndexHeader);
+    PutVarint64(&record, generation);
+    PutVarint32(&record, block_size_);
+    PutVarint32(&record, blocks_num_);
+    PutVarint32(&record, file_num_);
+    s = (*log)->AddRecord(record);
+    for (uint32_t i = 0; s.ok() && i < entries.size(); ++i) {
+        const Entry& entry = entries[i];
+        if (!entry.valid) {
+            continue;
+        }
+        EncodeInsert(i, entry.fname, entry.block_no, entry.size, entry.crc,
+                     entry.file_size, &record);
+        s = (*log)->AddRecord(record);
+    }
+    if (!s.ok()) {
+        delete *log;
+        delete *file;
+        *log = NULL;
+        *file = NULL;
+    }
+    return s;
+}
+
+// Append the records kept during compaction to the journal written by
+// WriteJournal(), and make it the current one.
+// REQUIRES: mutex_ held
+Status DiskCacheIndex::InstallJournal(WritableFile* file, log::Writer* log) {
+    Status s;
+    for (size_t i = 0; s.ok() && i < pending_records_.size(); ++i) {
+        s = log->AddRecord(pending_records_[i]);
+    }
+    if (s.ok()) {
+        s = file->Sync();
+    }
+    if (s.ok()) {
+        s = Env::Default()->RenameFile(index_name_ + ".tmp", index_name_);
+    }
+    if (!s.ok()) {
+        delete log;
+        file->Close();
+        delete file;
+        return s;
+    }
+    file_ = file;
+    log_ = log;
+    records_ = pending_records_.size();
+    pending_records_.clear();
+    return s;
+}
+
+// REQUIRES: mutex_ held
+void DiskCacheIndex::AddRecord(const std::string& record) {
+    if (compacting_) {
+        pending_records_.push_back(record);
+        return;
+    }
+    if (log_ == NULL) {
+        return;
+    }
+    Status s = log_->AddRecord(record);
+    if (!s.ok()) {
+        // stop journaling, blocks of this run will not survive restart
+        LDB_SLOG(WARNING, "fail to write disk-cache index: %s",
+             s.ToString().c_str());
+        CloseJournal();
+        return;
+    }
+    if (++records_ < 2 * (uint64_t)blocks_num_ + 1024) {
+        return;
+    }
+    // Records may be logged under locks of the cache, so the journal is
+    // closed here and replayed in the background
+    compacting_ = true;
+    CloseJournal();
+    Env::Default()->Schedule(&DiskCacheIndex::CompactWrapper, this);
+}
+
+void DiskCacheIndex::CompactWrapper(void* index) {
+    reinterpret_cast<DiskCacheIndex*>(index)->Compact();
+}
+
+// Rewrite the journal with live blocks only
+void DiskCacheIndex::Compact() {
+    std::vector<Entry> entries;
+    uint64_t generation = 0;
+    Status s = Load(&entries, &generation);
+    WritableFile* file = NULL;
+    log::Writer* log = NULL;
+    if (s.ok()) {
+        s = WriteJournal(entries, generation + 1, &file, &log);
+    }
+
+    MutexLock l(&mutex_);
+    if (s.ok()) {
+        s = InstallJournal(file, log);
+    }
+    if (s.ok()) {
+        generation_ = generation + 1;
+    } else {
+        LDB_SLOG(WARNING, "fail to compact disk-cache index: %s",
+             s.ToString().c_str());
+    }
+    compacting_ = false;
+    pending_records_.clear();
+    compact_cv_.SignalAll();
+}
+
+// REQUIRES: mutex_ held
+void DiskCacheIndex::CloseJournal() {
+    if (log_ != NULL) {
+        delete log_;
+        log_ = NULL;
+    }
+    if (file_ != NULL) {
+        file_->Close();
+        delete file_;
+        file_ = NULL;
+    }
+}
+
+}  // namespace leveldb
@@ -0,0 +1,95 @@
+// Copyright (c) 2015, Baidu.com, Inc. All Rights Reserved
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef STORAGE_LEVELDB_UTIL_DISK_CACHE_INDEX_H_
+#define STORAGE_LEVELDB_UTIL_DISK_CACHE_INDEX_H_
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "leveldb/status.h"
+#include "port/port.h"
+
+namespace leveldb {
+
+class WritableFile;
+
+namespace log {
+class Writer;
+}
+
+// Journal of the blocks held by a disk cache, in the leveldb log format,
+// which lets the cache reattach its blocks after a restart.
+//
+// Every insert or drop of a local block appends a record. Once the journal
+// grows past twice the number of blocks, it is rewritten with the live
+// blocks only, under a new generation. The rewrite runs in the background
+// without blocking writers, whose records are kept in memory meanwhile.
+class DiskCacheIndex {
+public:
+    // One slot per local block
+    struct Entry {
+        bool valid;
+        std::string fname;
+        uint32_t block_no;
+        uint32_t size;
+        uint32_t crc;
+        uint64_t file_size;
+        Entry() : valid(false), block_no(0), size(0), crc(0), file_size(0) {}
+    };
+
+    DiskCacheIndex(const std::string& index_name, uint32_t block_size,
+                   uint32_t blocks_num, uint32_t file_num);
+    ~DiskCacheIndex();
+
+    // Replay the journal into one entry per local block. Returns a non-ok
+    // status if the journal is unreadable or was written for another
+    // geometry (block size, block number or file number).
+    Status Load(std::vector<Entry>* entries);
+
+    // Start a new journal, of a new generation, holding the valid "entries"
+    Status Reset(const std::vector<Entry>& entries);
+
+    void LogInsert(uint32_t local_no, const std::string& fname,
+                   uint32_t block_no, uint32_t size, uint32_t crc,
+                   uint64_t file_size);
+    void LogDrop(uint32_t local_no);
+
+    uint64_t Generation();
+
+private:
+    Status Load(std::vector<Entry>* entries, uint64_t* generation);
+    Status WriteJournal(const std::vector<Entry>& entries, uint64_t generation,
+                        WritableFile** file, log::Writer** log);
+    Status InstallJournal(WritableFile* file, log::Writer* log);
+    void AddRecord(const std::string& record);
+    static void CompactWrapper(void* index);
+    void Compact();
+    void CloseJournal();
+
+    const std::string index_name_;
+    const uint32_t block_size_;
+    const uint32_t blocks_num_;
+    const uint32_t file_num_;
+
+    port::Mutex mutex_;
+    uint64_t generation_;
+    WritableFile* file_;
+    log::Writer* log_;
+    uint64_t records_;
+    // records written while the journal is compacted
+    bool compacting_;
+    std::vector<std::string> pending_records_;
+    port::CondVar compact_cv_;
+
+    // No copying allowed
+    DiskCacheIndex(const DiskCacheIndex&);
+    void operator=(const DiskCacheIndex&);
+};
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_UTIL_DISK_CACHE_INDEX_H_
@@ -16,6 +16,7 @@
 #include "leveldb/table_utils.h"
 #include "util/coding.h"
 #include "util/crc32c.h"
+#include "util/disk_cache_index.h"
 #include "util/hash.h"
 // #include "util/md5.h" // just for debug, so not svn-ci
 #include "util/mutexlock.h"
@@ -28,6 +29,7 @@ uint32_t CacheEnv::s_disk_cache_size_in_MB_(1);
 uint32_t CacheEnv::s_block_size_(8 * 1024);
 uint32_t CacheEnv::s_disk_cache_file_num_(1);
 std::string CacheEnv::s_disk_cache_file_name_("tera.cache");
+bool CacheEnv::s_disk_cache_persistent_(false);
 
 const char* paths[] = {"./cache_dir_1/", "./cache_dir_2/"};
 std::vector<std::string> CacheEnv::cache_paths_(paths, paths + 2);
@@ -145,8 +147,8 @@ public:
     }
 
 protected:
-    virtual Slice HashKey(const std::string& fname,
-                          uint32_t block_no) {
+    virtual std::string HashKey(const std::string& fname,
+                                uint32_t block_no) {
         return fname + "###" + Uint64ToString(block_no);
     }
 
@@ -225,14 +227,24 @@ class LRU_DiskCache;
 static LRU_DiskCache* g_disk_cache;
 static LRU_MemCache* g_mem_cache;
 
+// Meta of a cached block kept in the lru index:
+//   local block no, block size, crc32c of data, remote file size
+static const uint32_t kDiskCacheMetaSize = sizeof(uint32_t) * 3 + sizeof(uint64_t);
+
 class LRU_DiskCache : public LRU_BlockCache {
 public:
     LRU_DiskCache(const std::string& cache_fname, uint32_t block_size,
                   uint32_t cache_size_in_MB, uint32_t file_num = 1,
-                  Cache* global_lru_cache = NULL)
+                  Cache* global_lru_cache = NULL, bool persistent = false)
         : LRU_BlockCache(block_size, &LRU_DiskCache::Deleter, global_lru_cache),
-          fname_(cache_fname), blocks_num_(0), file_num_(file_num) {
+          fname_(cache_fname), blocks_num_(0), file_num_(file_num),
+          persistent_(persistent), index_(NULL) {
         blocks_num_ = ((((uint64_t)cache_size_in_MB) << 20) + block_size - 1) / block_size;
+        if (persistent_) {
+            index_ = new DiskCacheIndex(
+                CacheEnv::GetCachePaths()[0] + fname_ + ".index",
+                block_size_, blocks_num_, file_num_);
+        }
         Status s = OpenFile();
         if (!s.ok()) {
             LDB_SLOG(FATAL, "fail to create cache file: %s, status: #%s",
@@ -243,15 +255,20 @@ public:
     virtual ~LRU_DiskCache() {
         Close();
         delete[] fps_;
-        CleanFile();
+        if (persistent_) {
+            delete index_;
+        } else {
+            CleanFile();
+        }
     }
 
     static void Deleter(const Slice& key, void* v) {
         uint32_t block = 0;
         uint32_t size = 0;;
         uint32_t crc32c = 0;
+        uint64_t file_size = 0;
         Slice buf = UnpackSlice((char*)v);
-        UnpackCacheSlice(buf, &block, &size, &crc32c);
+        UnpackCacheSlice(buf, &block, &size, &crc32c, &file_size);
         LDB_SLOG(TRACE, "disk-cache: delete key: %s [local block #%d]",
              key.ToString().c_str(), block);
 
@@ -259,8 +276,53 @@ public:
         delete[] (char*)v;
     }
 
+    // Reattach the blocks recorded by the index journal of last run.
+    // Must be called before any read or write, and after g_disk_cache
+    // is set, since evictions during recovery go through Deleter().
+    Status Recover() {
+        if (!persistent_) {
+            return Status::OK();
+        }
+        std::vector<DiskCacheIndex::Entry> entries;
+        Status s = index_->Load(&entries);
+        if (!s.ok()) {
+            LDB_SLOG(WARNING, "fail to load disk-cache index, drop all blocks: %s",
+                 s.ToString().c_str());
+            entries.clear();
+            entries.resize(blocks_num_);
+        }
+
+        uint32_t reattached = 0;
+        {
+            MutexLock l(&mutex_);
+            blocks_free_.clear();
+            for (uint32_t i = 0; i < blocks_num_; ++i) {
+                if (!entries[i].valid) {
+                    blocks_free_.push_back(i);
+                }
+            }
+        }
+        for (uint32_t i = 0; i < blocks_num_; ++i) {
+            const DiskCacheIndex::Entry& entry = entries[i];
+            if (!entry.valid) {
+                continue;
+            }
+            char meta[kDiskCacheMetaSize];
+            Slice cache_slice = PackCacheSlice(i, entry.size, entry.crc,
+                                               entry.file_size, meta);
+            WriteBlockCache(entry.fname, entry.block_no, cache_slice);
+            reattached++;
+        }
+
+        s = index_->Reset(entries);
+        LDB_SLOG(INFO, "disk-cache reattach %u blocks, generation %lu, status: %s",
+             reattached, index_->Generation(), s.ToString().c_str());
+        return s;
+    }
+
     Status WriteBlock(const std::string& fname, uint32_t block_no,
-                      const Slice& data, bool force = false) {
+                      const Slice& data, bool force = false,
+                      uint64_t file_size = 0) {
         Status s;
         if (IsCacheLoaded(fname, block_no)) {
             Slice cache_slice;
@@ -271,7 +333,9 @@ public:
                 uint32_t local_no = 0;
                 uint32_t local_size = 0;
                 uint32_t crc32c = 0;
-                UnpackCacheSlice(cache_slice, &local_no, &local_size, &crc32c);
+                uint64_t local_file_size = 0;
+                UnpackCacheSlice(cache_slice, &local_no, &local_size, &crc32c,
+                                 &local_file_size);
                 if (crc32c == crc32c::Value(data.data(), data.size())) {
                     return Status::OK();
                 }
@@ -286,9 +350,12 @@ public:
         }
 
         uint32_t free_block_no = blocks_num_ + 1;
-        if (blocks_free_.size() > 0) {
-            free_block_no = blocks_free_.front();
-            blocks_free_.pop_front();
+        {
+            MutexLock l(&mutex_);
+            if (blocks_free_.size() > 0) {
+                free_block_no = blocks_free_.front();
+                blocks_free_.pop_front();
+            }
         }
 
         LDB_SLOG(TRACE, "write block #%d to disk-cache block #%d",
@@ -298,15 +365,21 @@ public:
             LDB_SLOG(TRACE, "fail to write block to disk-cache: %s", s.ToString().c_str());
             return s;
         }
-        Slice cache_slice = PackCacheSlice(free_block_no, data.size(),
-                                           crc32c::Value(data.data(), data.size()));
+        uint32_t crc = crc32c::Value(data.data(), data.size());
+        if (index_ != NULL) {
+            index_->LogInsert(free_block_no, fname, block_no, data.size(), crc,
+                              file_size);
+        }
+        char meta[kDiskCacheMetaSize];
+        Slice cache_slice = PackCacheSlice(free_block_no, data.size(), crc,
+                                           file_size, meta);
         s = WriteBlockCache(fname, block_no, cache_slice);
         return s;
     }
 
     Status ReadBlock(const std::string& fname, uint32_t block_no,
                      uint64_t block_offset, uint64_t n,
-                     Slice* result, char* scratch) {
+                     Slice* result, char* scratch, uint64_t file_size = 0) {
         Slice cache_slice;
         Status s = ReadBlockCache(fname, block_no, 0, block_size_, &cache_slice);
         if (!s.ok()) {
@@ -318,11 +391,17 @@ public:
         uint32_t local_block_no = 0;
         uint32_t local_block_size = 0;
         uint32_t crc32c = 0;
+        uint64_t local_file_size = 0;
         bool check_crc32 = false;
         if (UnpackCacheSlice(cache_slice, &local_block_no,
-                             &local_block_size, &crc32c)) {
+                             &local_block_size, &crc32c, &local_file_size)) {
             check_crc32 = true;
         }
+        if (file_size > 0 && local_file_size > 0 && file_size != local_file_size) {
+            // the remote file has been replaced since the block was cached
+            DropBlock(fname, block_no);
+            return Status::IOError("stale block #" + Uint64ToString(block_no));
+        }
         if (block_offset + n > local_block_size) {
             return Status::IOError("offset beyond existing block size");
         }
@@ -336,6 +415,8 @@ public:
             return s;
         }
         if (check_crc32 && crc32c != crc32c::Value(block_slice.data(), block_slice.size())) {
+            // drop it, so the block can be reloaded from remote
+            DropBlock(fname, block_no);
             return Status::IOError("data corruption, local block #"
                                    + Uint64ToString(local_block_no));
         }
@@ -344,6 +425,11 @@ public:
     }
 
     Status DropBlock(uint32_t cache_block_no) {
+        // journal the drop before the block can be reused
+        if (index_ != NULL) {
+            index_->LogDrop(cache_block_no);
+        }
+        MutexLock l(&mutex_);
         blocks_free_.push_front(cache_block_no);
         return Status::OK();
     }
@@ -358,11 +444,12 @@ public:
         uint32_t local_block_no = 0;
         uint32_t local_block_size = 0;
         uint32_t crc32c = 0;
+        uint64_t file_size = 0;
         UnpackCacheSlice(cache_slice, &local_block_no,
-                         &local_block_size, &crc32c);
+                         &local_block_size, &crc32c, &file_size);
         LDB_SLOG(TRACE, "drop local block #%d for block #%d", local_block_no, block_no);
+        // local block is released by Deleter()
         DropBlockCache(fname, block_no);
-        DropBlock(local_block_no);
     }
 
     Status Append(const std::string& fname,
@@ -377,7 +464,8 @@ public:
             uint32_t local_no = 0;
             uint32_t local_size = 0;
             uint32_t crc32c = 0;
-            UnpackCacheSlice(cache_slice, &local_no, &local_size, &crc32c);
+            uint64_t file_size = 0;
+            UnpackCacheSlice(cache_slice, &local_no, &local_size, &crc32c, &file_size);
             if (local_size != block_size_) {
                 char scratch[block_size_];
                 Slice result;
@@ -451,7 +539,7 @@ public:
 
     void Reset() {
         // just for test
-        ResetCache((blocks_num_ * sizeof(uint32_t) * 3));
+        ResetCache((blocks_num_ * (kDiskCacheMetaSize + sizeof(uint32_t))));
     }
 
 private:
@@ -460,16 +548,20 @@ private:
 
 public:
     static Slice PackCacheSlice(uint32_t block_no, uint32_t block_size,
-                                uint32_t crc32) {
-        char* buf = new char[sizeof(uint32_t) * 3];
+                                uint32_t crc32, uint64_t file_size, char* buf) {
         memcpy(buf, &block_no, sizeof(uint32_t));
         memcpy(buf + sizeof(uint32_t), &block_size, sizeof(uint32_t));
         memcpy(buf + sizeof(uint32_t) * 2, &crc32, sizeof(uint32_t));
-        return Slice(buf, sizeof(uint32_t) * 3);
+        memcpy(buf + sizeof(uint32_t) * 3, &file_size, sizeof(uint64_t));
+        return Slice(buf, kDiskCacheMetaSize);
     }
 
     static bool UnpackCacheSlice(const Slice& slice, uint32_t* block_no,
-                                 uint32_t* block_size, uint32_t* crc32c) {
+                                 uint32_t* block_size, uint32_t* crc32c,
+                                 uint64_t* file_size) {
+        if (slice.size() >= kDiskCacheMetaSize) {
+            memcpy(file_size, slice.data() + sizeof(uint32_t) * 3, sizeof(uint64_t));
+        }
         if (slice.size() >= sizeof(uint32_t) * 3) {
             memcpy(block_no, slice.data(), sizeof(uint32_t));
             memcpy(block_size, slice.data() + sizeof(uint32_t), sizeof(uint32_t));
@@ -491,7 +583,14 @@ private:
         fps_ = (FILE**)malloc(file_num_ * sizeof(FILE));
         for (uint32_t i = 0; i < file_num_; ++i) {
             std::string cache_file = CacheName(fname_, i);
-            fps_[i] = fopen(cache_file.c_str(), "w+");
+            fps_[i] = NULL;
+            if (persistent_) {
+                // reuse blocks of last run
+                fps_[i] = fopen(cache_file.c_str(), "r+");
+            }
+            if (fps_[i] == NULL) {
+                fps_[i] = fopen(cache_file.c_str(), "w+");
+            }
             if (fps_[i] == NULL) {
                 return IOError(cache_file, errno);
             }
@@ -575,7 +674,13 @@ private:
     uint32_t blocks_num_;
     const uint32_t file_num_;
 
+    // protect blocks_free_
+    port::Mutex mutex_;
     std::deque<uint32_t> blocks_free_;
+
+    const bool persistent_;
+    // journal of cached blocks, if persistent_
+    DiskCacheIndex* index_;
 };
 
 class DiskCacheReader {
@@ -725,12 +830,13 @@ private:
     }
 
     Status LoadMissingFromLocal(uint32_t block_no, Slice* result, char* scratch) {
-        return disk_cache_->ReadBlock(fname_hdfs_, block_no, 0, block_size_, result, scratch);
+        return disk_cache_->ReadBlock(fname_hdfs_, block_no, 0, block_size_,
+                                      result, scratch, size_);
     }
 
     Status SetupMissingToLocal(uint32_t block_no, const Slice& data,
                                bool force = false) {
-        return disk_cache_->WriteBlock(fname_hdfs_, block_no, data, force);
+        return disk_cache_->WriteBlock(fname_hdfs_, block_no, data, force, size_);
     }
 
 private:
@@ -1089,11 +1195,17 @@ static void InitGlobalCache() {
 
     uint32_t blocks_num = ((((uint64_t)CacheEnv::s_disk_cache_size_in_MB_) << 20)
         + CacheEnv::s_block_size_ - 1) / CacheEnv::s_block_size_;
-    // meta value size is sizeof(uint32_t) * 3
-    g_disk_cache_meta = NewLRUCache(blocks_num * sizeof(uint32_t) * 3);
+    // charge of each meta value is its size plus a length prefix
+    g_disk_cache_meta = NewLRUCache(blocks_num * (kDiskCacheMetaSize + sizeof(uint32_t)));
     g_disk_cache = new LRU_DiskCache(CacheEnv::s_disk_cache_file_name_,
         CacheEnv::s_block_size_, CacheEnv::s_disk_cache_size_in_MB_,
-        CacheEnv::s_disk_cache_file_num_, g_disk_cache_meta);
+        CacheEnv::s_disk_cache_file_num_, g_disk_cache_meta,
+        CacheEnv::s_disk_cache_persistent_);
+    Status s = g_disk_cache->Recover();
+    if (!s.ok()) {
+        LDB_SLOG(WARNING, "fail to recover disk-cache, status: %s",
+             s.ToString().c_str());
+    }
 }
 
 static void InitCacheEnv()
@@ -832,6 +832,10 @@ class PosixEnv : public Env {
     return thread_pool_.GetThreadNumber();
   }
 
+  virtual void SetBackgroundThreadsCpuAffinity(const std::vector<int>& cpus) {
+    thread_pool_.SetCpuAffinity(cpus);
+  }
+
  private:
   static void PthreadCall(const char* label, int result) {
     if (result != 0) {
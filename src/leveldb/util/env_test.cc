@@ -7,11 +7,14 @@
 // found in the LICENSE file. See the AUTHORS file for names of contributors.
 
 
+#include <sched.h>
+
 #include "leveldb/env_cache.h"
 
 #include "leveldb/env.h"
 #include "leveldb/slog.h"
 #include "port/port.h"
+#include "util/disk_cache_index.h"
 #include "util/string_ext.h"
 #include "util/testharness.h"
 #include "util/testutil.h"
@@ -109,6 +112,138 @@ TEST(EnvPosixTest, StartThread) {
     ASSERT_EQ(state.val, 3);
 }
 
+static void GetCpuAffinity(void* arg) {
+    cpu_set_t* cpu_set = reinterpret_cast<cpu_set_t*>(arg);
+    CPU_ZERO(cpu_set);
+    sched_getaffinity(0, sizeof(*cpu_set), cpu_set);
+}
+
+TEST(EnvPosixTest, BackgroundThreadsCpuAffinity) {
+    Env* env = NewPosixEnv();
+    env->SetBackgroundThreads(1);
+    cpu_set_t cpu_set;
+    env->Schedule(&GetCpuAffinity, &cpu_set);
+    Env::Default()->SleepForMicroseconds(kDelayMicros);
+    const int cpu_num = CPU_COUNT(&cpu_set);
+
+    // the started thread is bound
+    std::vector<int> cpus(1, 0);
+    env->SetBackgroundThreadsCpuAffinity(cpus);
+    env->Schedule(&GetCpuAffinity, &cpu_set);
+    Env::Default()->SleepForMicroseconds(kDelayMicros);
+    ASSERT_EQ(CPU_COUNT(&cpu_set), 1);
+    ASSERT_TRUE(CPU_ISSET(0, &cpu_set));
+
+    // and unbound
+    env->SetBackgroundThreadsCpuAffinity(std::vector<int>());
+    env->Schedule(&GetCpuAffinity, &cpu_set);
+    Env::Default()->SleepForMicroseconds(kDelayMicros);
+    ASSERT_EQ(CPU_COUNT(&cpu_set), cpu_num);
+    delete env;
+
+    // threads started later are bound as well
+    env = NewPosixEnv();
+    env->SetBackgroundThreadsCpuAffinity(cpus);
+    env->Schedule(&GetCpuAffinity, &cpu_set);
+    Env::Default()->SleepForMicroseconds(kDelayMicros);
+    ASSERT_EQ(CPU_COUNT(&cpu_set), 1);
+    ASSERT_TRUE(CPU_ISSET(0, &cpu_set));
+    delete env;
+}
+
+class DiskCacheIndexTest {
+public:
+    std::string index_name_;
+    std::vector<DiskCacheIndex::Entry> entries_;
+
+    DiskCacheIndexTest() : index_name_(test::TmpDir() + "/disk_cache.index") {
+        Env::Default()->DeleteFile(index_name_);
+    }
+
+    ~DiskCacheIndexTest() {
+        Env::Default()->DeleteFile(index_name_);
+    }
+
+    Status Reload(uint32_t block_size = 4096, uint32_t blocks_num = 8) {
+        DiskCacheIndex index(index_name_, block_size, blocks_num, 1);
+        return index.Load(&entries_);
+    }
+};
+
+TEST(DiskCacheIndexTest, Replay) {
+    {
+        DiskCacheIndex index(index_name_, 4096, 8, 1);
+        ASSERT_OK(index.Load(&entries_));
+        ASSERT_OK(index.Reset(entries_));
+        index.LogInsert(0, "/table/tablet00000001/0/00000001.sst", 3, 4096, 11, 80000);
+        index.LogInsert(1, "/table/tablet00000001/0/00000001.sst", 4, 4096, 12, 80000);
+        index.LogInsert(2, "/table/tablet00000001/0/00000002.sst", 0, 100, 13, 100);
+        index.LogDrop(1);
+        // the same remote block cached again
+        index.LogInsert(5, "/table/tablet00000001/0/00000002.sst", 0, 100, 14, 100);
+    }
+    ASSERT_OK(Reload());
+    ASSERT_EQ(entries_.size(), 8U);
+    ASSERT_TRUE(entries_[0].valid);
+    ASSERT_EQ(entries_[0].fname, "/table/tablet00000001/0/00000001.sst");
+    ASSERT_EQ(entries_[0].block_no, 3U);
+    ASSERT_EQ(entries_[0].size, 4096U);
+    ASSERT_EQ(entries_[0].crc, 11U);
+    ASSERT_EQ(entries_[0].file_size, 80000U);
+    ASSERT_TRUE(!entries_[1].valid);
+    ASSERT_TRUE(!entries_[2].valid);
+    ASSERT_TRUE(entries_[5].valid);
+    ASSERT_EQ(entries_[5].crc, 14U);
+    for (uint32_t i = 0; i < entries_.size(); ++i) {
+        if (i != 0 && i != 5) {
+            ASSERT_TRUE(!entries_[i].valid) << i;
+        }
+    }
+}
+
+TEST(DiskCacheIndexTest, GeometryChanged) {
+    {
+        DiskCacheIndex index(index_name_, 4096, 8, 1);
+        ASSERT_OK(index.Load(&entries_));
+        ASSERT_OK(index.Reset(entries_));
+        index.LogInsert(0, "00000001.sst", 0, 4096, 11, 80000);
+    }
+    ASSERT_OK(Reload(4096, 8));
+    ASSERT_TRUE(entries_[0].valid);
+    ASSERT_TRUE(!Reload(8192, 8).ok());
+    ASSERT_TRUE(!Reload(4096, 16).ok());
+}
+
+TEST(DiskCacheIndexTest, Compact) {
+    const uint32_t kBlocksNum = 8;
+    uint64_t generation = 0;
+    {
+        DiskCacheIndex index(index_name_, 4096, kBlocksNum, 1);
+        ASSERT_OK(index.Load(&entries_));
+        ASSERT_OK(index.Reset(entries_));
+        generation = index.Generation();
+        // enough records to compact the journal several times
+        for (uint32_t i = 0; i < 10000; ++i) {
+            index.LogInsert(i % kBlocksNum, "00000001.sst", i, 4096, i, 80000);
+            if (i % 3 == 0) {
+                index.LogDrop(i % kBlocksNum);
+            }
+        }
+    }
+    DiskCacheIndex index(index_name_, 4096, kBlocksNum, 1);
+    ASSERT_OK(index.Load(&entries_));
+    // compacted journals are of later generations
+    ASSERT_GT(index.Generation(), generation);
+    for (uint32_t i = 10000 - kBlocksNum; i < 10000; ++i) {
+        const DiskCacheIndex::Entry& entry = entries_[i % kBlocksNum];
+        ASSERT_EQ(entry.valid, i % 3 != 0) << i;
+        if (entry.valid) {
+            ASSERT_EQ(entry.block_no, i);
+            ASSERT_EQ(entry.crc, i);
+        }
+    }
+}
+
 #if 0 // disable by anqin, because it needs HDFS env
 
 #define TEST_DATA_SIZE  384 // will cross buffer boundary
@@ -21,13 +21,19 @@ Options::Options()
       env(Env::Default()),
       info_log(NULL),
       write_buffer_size(4 << 20),
+      max_imm_num(1),
       l0_slowdown_writes_trigger(10),
+      l0_throttle_writes_trigger(6),
+      pending_compaction_throttle_bytes(1ULL << 30),
+      pending_compaction_limit_bytes(4ULL << 30),
+      max_write_delay_micros(100000),
       max_open_files(1000),
       table_cache(NULL),
       block_cache(NULL),
       block_size(kDefaultBlockSize),
       block_restart_interval(16),
       compression(kSnappyCompression),
+      compression_dict_size(16 << 10),
       filter_policy(NULL),
       exist_lg_list(NULL),
       lg_info_list(NULL),
@@ -46,8 +52,13 @@ Options::Options()
       use_memtable_on_leveldb(false),
       memtable_ldb_write_buffer_size(1 << 20),
       memtable_ldb_block_size(kDefaultBlockSize),
+      use_concurrent_memtable(false),
+      memtable_hash_index(false),
+      parallel_compression_threads(0),
+      parallel_recover_threads(0),
       drop_base_level_del_in_compaction(true),
-      sst_size(8000000) {
+      sst_size(8000000),
+      block_hash_index(false) {
 }
 
 }  // namespace leveldb
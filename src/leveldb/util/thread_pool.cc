@@ -4,8 +4,12 @@
 //
 // Author: leiliyuan@baidu.com
 
-#include "leveldb/env.h"
 #include "util/thread_pool.h"
+
+#include <sched.h>
+#include <string.h>
+
+#include "leveldb/env.h"
 #include "util/mutexlock.h"
 #include "port/port_posix.h"
 
@@ -65,6 +69,9 @@ int64_t ThreadPool::Schedule(void (*function)(void*), void* arg,
     pthread_t t;
     pthread_create(&t, NULL, &ThreadPool::BGThreadWrapper, this);
     bg_threads_.push_back(t);
+    if (!cpus_.empty()) {
+      BindThread(t);
+    }
   }
   
   int64_t now_time = static_cast<int64_t>(Env::Default()->NowMicros() / 1000);
@@ -103,6 +110,32 @@ int ThreadPool::GetThreadNumber() {
   return total_threads_limit_;
 }
 
+void ThreadPool::SetCpuAffinity(const std::vector<int>& cpus) {
+  MutexLock lock(&mutex_);
+  cpus_ = cpus;
+  for (size_t i = 0; i < bg_threads_.size(); ++i) {
+    BindThread(bg_threads_[i]);
+  }
+}
+
+// REQUIRES: mutex_ held
+void ThreadPool::BindThread(pthread_t thread) {
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  if (cpus_.empty()) {
+    for (int i = 0; i < CPU_SETSIZE; ++i) {
+      CPU_SET(i, &cpu_set);
+    }
+  }
+  for (size_t i = 0; i < cpus_.size(); ++i) {
+    CPU_SET(cpus_[i], &cpu_set);
+  }
+  int err = pthread_setaffinity_np(thread, sizeof(cpu_set), &cpu_set);
+  if (err != 0) {
+    Log(info_log_, "[ThreadPool] fail to set cpu affinity: %s", strerror(err));
+  }
+}
+
 void ThreadPool::Timer() {
   while (true) {
     BGItem bg_item;
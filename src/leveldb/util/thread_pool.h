@@ -9,6 +9,7 @@
 
 #include <map>
 #include <queue>
+#include <vector>
 #include <pthread.h>
 #include "leveldb/env.h"
 #include "port/port_posix.h"
@@ -31,6 +32,9 @@ public:
   void SetBackgroundThreads(int num);
   // Return maximal allowed thread number
   int GetThreadNumber();
+  // Bind the background threads, started or not, to "cpus", an empty
+  // list unbinds them
+  void SetCpuAffinity(const std::vector<int>& cpus);
   void SetLogger(Logger* info_log) { info_log_ = info_log; }
 
 private:  
@@ -58,6 +62,7 @@ private:
   void Timer();
   void BGThread();
   void PutInQueue(BGItem& bg_item, int64_t wait_time_millisec);
+  void BindThread(pthread_t thread);
   bool IsLatest(const BGItem& latest, double priority, int64_t exe_time);
 
   static void* TimerWrapper(void* arg);
@@ -78,6 +83,7 @@ private:
   BGQueue pri_queue_;
   BGQueue time_queue_;
   BGMap latest_;
+  std::vector<int> cpus_;
 };
 
 } // namespace leveldb
@@ -0,0 +1,292 @@
+// Copyright (c) 2015, Baidu.com, Inc. All Rights Reserved
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "master/cost_scheduler.h"
+
+#include <algorithm>
+#include <map>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include "master/tablet_manager.h"
+
+DECLARE_string(tera_master_meta_table_name);
+DECLARE_bool(tera_master_meta_isolate_enabled);
+DECLARE_int32(tera_master_max_load_concurrency);
+DECLARE_double(tera_master_cost_balance_min_gain);
+DECLARE_double(tera_master_cost_balance_read_weight);
+DECLARE_double(tera_master_cost_balance_write_weight);
+DECLARE_double(tera_master_cost_balance_scan_weight);
+DECLARE_double(tera_master_cost_balance_size_weight);
+DECLARE_double(tera_master_cost_balance_cpu_weight);
+
+namespace tera {
+namespace master {
+
+CostScheduler::Load::Load() {
+    for (int i = 0; i < kDimensionNum; ++i) {
+        value[i] = 0;
+    }
+}
+
+void CostScheduler::Load::Add(const Load& load, double sign) {
+    for (int i = 0; i < kDimensionNum; ++i) {
+        value[i] += sign * load.value[i];
+    }
+}
+
+CostScheduler::CostScheduler() {
+    m_weight[kReadRows] = FLAGS_tera_master_cost_balance_read_weight;
+    m_weight[kWriteSize] = FLAGS_tera_master_cost_balance_write_weight;
+    m_weight[kScanSize] = FLAGS_tera_master_cost_balance_scan_weight;
+    m_weight[kDataSize] = FLAGS_tera_master_cost_balance_size_weight;
+    m_weight[kCpuUsage] = FLAGS_tera_master_cost_balance_cpu_weight;
+    LOG(INFO) << "cost schduling is activated";
+}
+
+CostScheduler::~CostScheduler() {}
+
+double CostScheduler::NodeCost(const Load& load, const Load& mean) {
+    double cost = 0;
+    for (int i = 0; i < kDimensionNum; ++i) {
+        if (mean.value[i] <= 0) {
+            continue;
+        }
+        double deviation = (load.value[i] - mean.value[i]) / mean.value[i];
+        cost += m_weight[i] * deviation * deviation;
+    }
+    return cost;
+}
+
+double CostScheduler::NodeScore(const Load& load, const Load& mean) {
+    double score = 0;
+    for (int i = 0; i < kDimensionNum; ++i) {
+        if (mean.value[i] <= 0) {
+            continue;
+        }
+        score += m_weight[i] * load.value[i] / mean.value[i];
+    }
+    return score;
+}
+
+void CostScheduler::GetNodeLoads(const std::vector<TabletNodePtr>& node_list,
+                                 std::vector<Load>* loads, Load* mean) {
+    loads->resize(node_list.size());
+    for (size_t i = 0; i < node_list.size(); ++i) {
+        TabletNodeInfo info = node_list[i]->GetInfo();
+        Load& load = (*loads)[i];
+        load.value[kReadRows] = info.read_rows();
+        load.value[kWriteSize] = info.write_size();
+        load.value[kScanSize] = info.scan_size();
+        load.value[kDataSize] = node_list[i]->GetSize();
+        load.value[kCpuUsage] = info.cpu_usage();
+        mean->Add(load, 1.0 / node_list.size());
+    }
+}
+
+struct ScoreLess {
+    bool operator() (const std::pair<double, TabletNodePtr>& i,
+                     const std::pair<double, TabletNodePtr>& j) {
+        return i.first < j.first;
+    }
+};
+
+struct ScoreGreater {
+    bool operator() (const std::pair<double, TabletNodePtr>& i,
+                     const std::pair<double, TabletNodePtr>& j) {
+        return i.first > j.first;
+    }
+};
+
+bool CostScheduler::FindBestNode(const std::vector<TabletNodePtr>& node_list,
+                                 std::string* node_addr) {
+    if (node_list.size() == 0) {
+        return false;
+    }
+    std::vector<Load> loads;
+    Load mean;
+    GetNodeLoads(node_list, &loads, &mean);
+
+    size_t best = 0;
+    double best_score = NodeScore(loads[0], mean);
+    double worst_score = best_score;
+    for (size_t i = 1; i < node_list.size(); ++i) {
+        double score = NodeScore(loads[i], mean);
+        if (score < best_score) {
+            best = i;
+            best_score = score;
+        }
+        worst_score = std::max(worst_score, score);
+    }
+    // all nodes look the same (e.g. when master starts), round-robin
+    if (worst_score - best_score < 1e-6) {
+        return WorkloadScheduler::FindBestNode(node_list, node_addr);
+    }
+    *node_addr = node_list[best]->GetAddr();
+    return true;
+}
+
+void CostScheduler::AscendingSort(std::vector<TabletNodePtr>& node_list) {
+    std::vector<Load> loads;
+    Load mean;
+    GetNodeLoads(node_list, &loads, &mean);
+    std::vector<std::pair<double, TabletNodePtr> > scores;
+    for (size_t i = 0; i < node_list.size(); ++i) {
+        scores.push_back(std::make_pair(NodeScore(loads[i], mean), node_list[i]));
+    }
+    std::stable_sort(scores.begin(), scores.end(), ScoreLess());
+    for (size_t i = 0; i < scores.size(); ++i) {
+        node_list[i] = scores[i].second;
+    }
+}
+
+void CostScheduler::DescendingSort(std::vector<TabletNodePtr>& node_list) {
+    std::vector<Load> loads;
+    Load mean;
+    GetNodeLoads(node_list, &loads, &mean);
+    std::vector<std::pair<double, TabletNodePtr> > scores;
+    for (size_t i = 0; i < node_list.size(); ++i) {
+        scores.push_back(std::make_pair(NodeScore(loads[i], mean), node_list[i]));
+    }
+    std::stable_sort(scores.begin(), scores.end(), ScoreGreater());
+    for (size_t i = 0; i < scores.size(); ++i) {
+        node_list[i] = scores[i].second;
+    }
+}
+
+bool CostScheduler::PlanMoves(const std::vector<TabletNodePtr>& node_list,
+                              const std::vector<TabletPtr>& tablet_list,
+                              size_t max_move_num, MovePlan* plan) {
+    std::map<std::string, size_t> node_index;
+    std::vector<TabletNodePtr> nodes;
+    for (size_t i = 0; i < node_list.size(); ++i) {
+        if (node_list[i]->GetState() == kReady) {
+            node_index[node_list[i]->GetAddr()] = nodes.size();
+            nodes.push_back(node_list[i]);
+        }
+    }
+    size_t node_num = nodes.size();
+    if (node_num < 2) {
+        return true;
+    }
+
+    // the load of a node is the sum of its tablets, but cpu usage is only
+    // known per node, so it is shared by tablets in proportion to rows
+    std::vector<Load> loads(node_num);
+    std::vector<double> node_rows(node_num, 0);
+    std::vector<std::vector<std::pair<TabletPtr, Load> > > tablets(node_num);
+    std::vector<bool> can_move_in(node_num, true);
+    for (size_t i = 0; i < tablet_list.size(); ++i) {
+        TabletPtr tablet = tablet_list[i];
+        std::map<std::string, size_t>::iterator it =
+            node_index.find(tablet->GetServerAddr());
+        if (it == node_index.end()) {
+            continue;
+        }
+        size_t node = it->second;
+        const TabletCounter& counter = tablet->GetCounter();
+        double rows = counter.read_rows() + counter.write_rows() + counter.scan_rows();
+        Load load;
+        load.value[kReadRows] = counter.read_rows();
+        load.value[kWriteSize] = counter.write_size();
+        load.value[kScanSize] = counter.scan_size();
+        load.value[kDataSize] = std::max(tablet->GetDataSize(), (int64_t)0);
+        load.value[kCpuUsage] = rows;
+        loads[node].Add(load, 1);
+        node_rows[node] += rows;
+
+        if (tablet->GetTableName() == FLAGS_tera_master_meta_table_name) {
+            if (FLAGS_tera_master_meta_isolate_enabled) {
+                can_move_in[node] = false;
+            }
+            continue;
+        }
+        if (tablet->GetStatus() != kTableReady || !tablet->IsBound()
+            || tablet->GetTable()->GetStatus() != kTableEnable) {
+            continue;
+        }
+        tablets[node].push_back(std::make_pair(tablet, load));
+    }
+
+    Load mean;
+    std::vector<int32_t> move_in_quota(node_num, 0);
+    for (size_t i = 0; i < node_num; ++i) {
+        double cpu = nodes[i]->GetInfo().cpu_usage();
+        for (size_t j = 0; j < tablets[i].size(); ++j) {
+            double& tablet_cpu = tablets[i][j].second.value[kCpuUsage];
+            tablet_cpu = node_rows[i] > 0 ? cpu * tablet_cpu / node_rows[i] : 0;
+        }
+        loads[i].value[kCpuUsage] = cpu;
+        mean.Add(loads[i], 1.0 / node_num);
+
+        if (can_move_in[i] && nodes[i]->MayLoadNow()) {
+            move_in_quota[i] = FLAGS_tera_master_max_load_concurrency
+                - nodes[i]->GetPlanToMoveInCount();
+        }
+    }
+
+    double total_cost = 0;
+    for (size_t i = 0; i < node_num; ++i) {
+        total_cost += NodeCost(loads[i], mean);
+    }
+    double mean_score = NodeScore(mean, mean);
+    VLOG(5) << "[cost balance] nodes: " << node_num << ", cost: " << total_cost;
+
+    while (plan->size() < max_move_num) {
+        double best_gain = 0;
+        size_t best_src = 0, best_tablet = 0, best_dst = 0;
+        for (size_t src = 0; src < node_num; ++src) {
+            // only nodes loaded above the mean give tablets away
+            if (NodeScore(loads[src], mean) <= mean_score) {
+                continue;
+            }
+            double src_cost = NodeCost(loads[src], mean);
+            for (size_t t = 0; t < tablets[src].size(); ++t) {
+                const Load& tablet_load = tablets[src][t].second;
+                Load src_load = loads[src];
+                src_load.Add(tablet_load, -1);
+                double src_gain = src_cost - NodeCost(src_load, mean);
+                if (src_gain <= 0) {
+                    continue;
+                }
+                for (size_t dst = 0; dst < node_num; ++dst) {
+                    if (dst == src || move_in_quota[dst] <= 0) {
+                        continue;
+                    }
+                    Load dst_load = loads[dst];
+                    dst_load.Add(tablet_load, 1);
+                    double gain = src_gain + NodeCost(loads[dst], mean)
+                        - NodeCost(dst_load, mean);
+                    if (gain > best_gain) {
+                        best_gain = gain;
+                        best_src = src;
+                        best_tablet = t;
+                        best_dst = dst;
+                    }
+                }
+            }
+        }
+        if (best_gain <= 0
+            || best_gain < FLAGS_tera_master_cost_balance_min_gain * total_cost) {
+            break;
+        }
+
+        std::pair<TabletPtr, Load> moved = tablets[best_src][best_tablet];
+        tablets[best_src][best_tablet] = tablets[best_src].back();
+        tablets[best_src].pop_back();
+        loads[best_src].Add(moved.second, -1);
+        loads[best_dst].Add(moved.second, 1);
+        move_in_quota[best_dst]--;
+        total_cost -= best_gain;
+        plan->push_back(std::make_pair(moved.first, nodes[best_dst]->GetAddr()));
+        VLOG(5) << "[cost balance] plan to move " << moved.first
+            << " to " << nodes[best_dst]->GetAddr() << ", gain: " << best_gain
+            << ", cost: " << total_cost;
+    }
+    return true;
+}
+
+} // namespace master
+} // namespace tera
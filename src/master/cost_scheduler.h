@@ -0,0 +1,63 @@
+// Copyright (c) 2015, Baidu.com, Inc. All Rights Reserved
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef TERA_MASTER_COST_SCHEDULER_H_
+#define TERA_MASTER_COST_SCHEDULER_H_
+
+#include <string>
+#include <vector>
+
+#include "master/workload_scheduler.h"
+
+namespace tera {
+namespace master {
+
+// Balances tabletnodes on read rows, write bytes, scan bytes, data size
+// and cpu together. The imbalance cost of a cluster is the weighted sum
+// over all dimensions of the squared relative deviation of every node
+// from the mean, and moves are planned greedily by the largest decrease
+// of the cost. Per-table schedule is inherited from WorkloadScheduler.
+class CostScheduler : public WorkloadScheduler {
+public:
+    enum Dimension {
+        kReadRows = 0,
+        kWriteSize,
+        kScanSize,
+        kDataSize,
+        kCpuUsage,
+        kDimensionNum
+    };
+    struct Load {
+        double value[kDimensionNum];
+        Load();
+        void Add(const Load& load, double sign);
+    };
+
+    CostScheduler();
+    ~CostScheduler();
+
+    bool FindBestNode(const std::vector<TabletNodePtr>& node_list,
+                      std::string* node_addr);
+    void AscendingSort(std::vector<TabletNodePtr>& node_list);
+    void DescendingSort(std::vector<TabletNodePtr>& node_list);
+
+    bool PlanMoves(const std::vector<TabletNodePtr>& node_list,
+                   const std::vector<TabletPtr>& tablet_list,
+                   size_t max_move_num, MovePlan* plan);
+
+private:
+    // weighted cost of one node, "mean" is the mean load of all nodes
+    double NodeCost(const Load& load, const Load& mean);
+    // weighted sum of normalized load, used to rank nodes
+    double NodeScore(const Load& load, const Load& mean);
+    void GetNodeLoads(const std::vector<TabletNodePtr>& node_list,
+                      std::vector<Load>* loads, Load* mean);
+
+    double m_weight[kDimensionNum];
+};
+
+} // namespace master
+} // namespace tera
+
+#endif // TERA_MASTER_COST_SCHEDULER_H_
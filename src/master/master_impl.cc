@@ -16,6 +16,7 @@
 #include "io/io_utils.h"
 #include "io/utils_leveldb.h"
 #include "leveldb/status.h"
+#include "master/cost_scheduler.h"
 #include "master/master_zk_adapter.h"
 #include "master/workload_scheduler.h"
 #include "proto/kv_helper.h"
@@ -49,6 +50,9 @@ DECLARE_bool(tera_zk_enabled);
 
 DECLARE_int64(tera_master_split_tablet_size);
 DECLARE_int64(tera_master_merge_tablet_size);
+DECLARE_bool(tera_master_load_split_enabled);
+DECLARE_int64(tera_master_load_split_qps);
+DECLARE_int64(tera_master_load_split_min_size);
 DECLARE_bool(tera_master_kick_tabletnode_enabled);
 DECLARE_int32(tera_master_kick_tabletnode_query_fail_times);
 
@@ -61,9 +65,15 @@ DECLARE_int32(tera_master_load_balance_period);
 DECLARE_bool(tera_master_load_balance_table_grained);
 DECLARE_int32(tera_master_load_rpc_timeout);
 DECLARE_int32(tera_master_unload_rpc_timeout);
+DECLARE_int32(tera_master_prewarm_rpc_timeout);
+DECLARE_bool(tera_master_move_prewarm_enabled);
+DECLARE_int32(tera_master_meta_write_max_inflight);
+DECLARE_int32(tera_master_meta_write_batch_rows);
 DECLARE_int32(tera_master_split_rpc_timeout);
 DECLARE_int32(tera_master_tabletnode_timeout);
 DECLARE_bool(tera_master_move_tablet_enabled);
+DECLARE_bool(tera_master_cost_balance_enabled);
+DECLARE_int32(tera_master_cost_balance_max_moves);
 DECLARE_int32(tera_master_load_slow_retry_times);
 
 DECLARE_int32(tera_max_pre_assign_tablet_num);
@@ -92,12 +102,14 @@ MasterImpl::MasterImpl()
     : m_status(kNotInited), m_restored(false),
       m_tablet_manager(new TabletManager(&m_this_sequence_id, this, m_thread_pool.get())),
       m_tabletnode_manager(new TabletNodeManager(this)),
-      m_scheduler(new WorkloadScheduler),
+      m_scheduler(FLAGS_tera_master_cost_balance_enabled
+                  ? new CostScheduler : new WorkloadScheduler),
       m_zk_adapter(NULL),
       m_release_cache_timer_id(kInvalidTimerId),
       m_query_tabletnode_timer_id(kInvalidTimerId),
       m_load_balance_timer_id(kInvalidTimerId),
       m_thread_pool(new ThreadPool(FLAGS_tera_master_impl_thread_max_num)),
+      m_meta_write_inflight(0),
       m_is_stat_table(false),
       m_stat_table(NULL),
       m_gc_query_enable(false) {
@@ -694,13 +706,16 @@ void MasterImpl::UpdateTable(const UpdateTableRequest* request,
         return;
     }
 
-    table->SetSchema(request->schema());
+    // row keys of a hashed table are laid out at creation, keep the bucket num
+    TableSchema schema(request->schema());
+    schema.set_hash_bucket_num(table->GetSchema().hash_bucket_num());
+    table->SetSchema(schema);
     const LocalityGroupSchema& lg0 = request->schema().locality_groups(0);
     LOG(INFO) << "New table schema is updated: " << request->table_name()
         << ", store_medium: " << lg0.store_type()
         << ", compress: " << lg0.compress_type()
         << ", raw_key: " << request->schema().raw_key()
-        << ", schema: " << request->schema().ShortDebugString();
+        << ", schema: " << schema.ShortDebugString();
 
     // write meta tablet
     WriteClosure* closure =
@@ -1065,11 +1080,12 @@ bool MasterImpl::GetMetaTabletAddr(std::string* addr) {
 /////////// load balance //////////
 
 void MasterImpl::QueryTabletNode() {
-    MutexLock locker(&m_mutex);
-
-    std::vector<TabletNodePtr> tabletnode_array;
-    m_tabletnode_manager->GetAllTabletNodeInfo(&tabletnode_array);
-
+    bool gc_query_enable = false;
+    m_mutex.Lock();
+    if (m_gc_query_enable) {
+        gc_query_enable = true;
+        m_gc_query_enable = false;
+    }
     if (FLAGS_tera_master_stat_table_enabled && !m_is_stat_table) {
         CreateStatTable();
         ErrorCode err;
@@ -1086,8 +1102,12 @@ void MasterImpl::QueryTabletNode() {
             m_stat_table = NULL;
         }
     }
+    m_mutex.Unlock();
 
-    if (m_gc_query_enable) {
+    std::vector<TabletNodePtr> tabletnode_array;
+    m_tabletnode_manager->GetAllTabletNodeInfo(&tabletnode_array);
+
+    if (gc_query_enable) {
         std::vector<TabletNodePtr>::iterator it = tabletnode_array.begin();
         for (; it != tabletnode_array.end(); ++it) {
             TabletNodePtr tabletnode = *it;
@@ -1109,14 +1129,14 @@ void MasterImpl::QueryTabletNode() {
         }
         QueryClosure* done =
             NewClosure(this, &MasterImpl::QueryTabletNodeCallback, tabletnode->m_addr);
+        // gc needs the full tablet list
+        uint64_t version = gc_query_enable ? 0 : tabletnode->GetQueryVersion();
         QueryTabletNodeAsync(tabletnode->m_addr,
                              FLAGS_tera_master_query_tabletnode_period,
-                             m_gc_query_enable, done);
+                             gc_query_enable, done, version);
     }
 
-    if (m_gc_query_enable) {
-        m_gc_query_enable = false;
-    }
+    MutexLock locker(&m_mutex);
     m_query_tabletnode_timer_id = kInvalidTimerId;
     EnableQueryTabletNodeTimer();
 }
@@ -1153,11 +1173,18 @@ void MasterImpl::DisableLoadBalanceTimer() {
 
 void MasterImpl::LoadBalance() {
     VLOG(5) << "LoadBalance()";
+    // only one balance round runs at a time, m_mutex is not held while
+    // scanning so that queries are not blocked by balancing
+    DoLoadBalance();
+
     MutexLock locker(&m_mutex);
+    m_load_balance_timer_id = kInvalidTimerId;
+    EnableLoadBalanceTimer();
+}
 
+void MasterImpl::DoLoadBalance() {
     std::vector<TablePtr> all_table_list;
-    std::vector<TabletPtr> all_tablet_list;
-    m_tablet_manager->ShowTable(&all_table_list, &all_tablet_list);
+    m_tablet_manager->ShowTable(&all_table_list, NULL);
 
     std::vector<TabletNodePtr> all_node_list;
     m_tabletnode_manager->GetAllTabletNodeInfo(&all_node_list);
@@ -1193,24 +1220,28 @@ void MasterImpl::LoadBalance() {
             }
         }
     } else {
-        std::map<std::string, std::vector<TabletPtr> > node_tablet_list;
-        std::vector<TabletPtr>::iterator it;
-        for (it = all_tablet_list.begin(); it != all_tablet_list.end(); ++it) {
-            TabletPtr tablet = *it;
-            node_tablet_list[tablet->GetServerAddr()].push_back(tablet);
-        }
         m_scheduler->DescendingSort(all_node_list);
         std::vector<TabletNodePtr>::iterator node_it = all_node_list.begin();
         for (; node_it != all_node_list.end(); ++node_it) {
             TabletNodePtr node = *node_it;
             const std::string& addr = node->GetAddr();
-            const std::vector<TabletPtr>& tablet_list = node_tablet_list[addr];
+            std::vector<TabletPtr> tablet_list;
+            m_tablet_manager->FindTablet(addr, &tablet_list);
             TabletNodeLoadBalance(addr, tablet_list);
         }
     }
 
-    m_load_balance_timer_id = kInvalidTimerId;
-    EnableLoadBalanceTimer();
+    // move tablets by a global plan instead of one tablet per node
+    if (FLAGS_tera_master_move_tablet_enabled && FLAGS_tera_master_cost_balance_enabled) {
+        std::vector<TabletPtr> all_tablet_list;
+        m_tablet_manager->ShowTable(NULL, &all_tablet_list);
+        Scheduler::MovePlan plan;
+        m_scheduler->PlanMoves(all_node_list, all_tablet_list,
+                               FLAGS_tera_master_cost_balance_max_moves, &plan);
+        for (size_t i = 0; i < plan.size(); ++i) {
+            TryMoveTablet(plan[i].first, plan[i].second);
+        }
+    }
 }
 
 void MasterImpl::TabletNodeLoadBalance(const std::string& tabletnode_addr,
@@ -1256,6 +1287,22 @@ void MasterImpl::TabletNodeLoadBalance(const std::string& tabletnode_addr,
             TryMergeTablet(tablet);
             continue;
         }
+        // split hot tablet at the median of its accessed keys, but never
+        // into halves small enough to be merged back
+        if (FLAGS_tera_master_load_split_enabled
+            && tablet->GetDataSize() > (std::max(FLAGS_tera_master_load_split_min_size,
+                                                 2 * merge_size) << 20)) {
+            const TabletCounter& counter = tablet->GetCounter();
+            int64_t row_qps = counter.read_rows() + counter.scan_rows()
+                + counter.write_rows();
+            if (row_qps > FLAGS_tera_master_load_split_qps) {
+                LOG(INFO) << "split hot tablet " << tablet->GetPath()
+                    << ", row qps: " << row_qps;
+                TrySplitTablet(tablet, true);
+                any_tablet_split = true;
+                continue;
+            }
+        }
         if (tablet->GetStatus() == kTableReady) {
             if (smallest_tablet_it == tablet_list.end()
                 || (*smallest_tablet_it)->GetDataSize() > tablet->GetDataSize()) {
@@ -1266,6 +1313,7 @@ void MasterImpl::TabletNodeLoadBalance(const std::string& tabletnode_addr,
 
     // if any tablet is splitting, no need to move tablet
     if (!FLAGS_tera_master_move_tablet_enabled || any_tablet_split
+        || FLAGS_tera_master_cost_balance_enabled
         || smallest_tablet_it == tablet_list.end()) {
         return;
     }
@@ -1868,18 +1916,13 @@ bool MasterImpl::LoadTabletSync(const TabletMeta& meta,
     return false;
 }
 
-void MasterImpl::LoadTabletAsync(TabletPtr tablet, LoadClosure* done, uint64_t) {
-    tabletnode::TabletNodeClient node_client(tablet->GetServerAddr(),
-                                            FLAGS_tera_master_load_rpc_timeout);
-    LoadTabletRequest* request = new LoadTabletRequest;
-    LoadTabletResponse* response = new LoadTabletResponse;
+void MasterImpl::FillLoadTabletRequest(TabletPtr tablet, LoadTabletRequest* request) {
     request->set_tablet_name(tablet->GetTableName());
     request->set_sequence_id(m_this_sequence_id.Inc());
     request->mutable_key_range()->set_key_start(tablet->GetKeyStart());
     request->mutable_key_range()->set_key_end(tablet->GetKeyEnd());
     request->set_path(tablet->GetPath());
     request->mutable_schema()->CopyFrom(tablet->GetSchema());
-    request->set_session_id(tablet->GetServerId());
 
     TablePtr table = tablet->GetTable();
     std::vector<uint64_t> snapshot_id;
@@ -1898,6 +1941,15 @@ void MasterImpl::LoadTabletAsync(TabletPtr tablet, LoadClosure* done, uint64_t)
     for (int32_t i = 0; i < meta.parent_tablets_size(); ++i) {
         request->add_parent_tablets(meta.parent_tablets(i));
     }
+}
+
+void MasterImpl::LoadTabletAsync(TabletPtr tablet, LoadClosure* done, uint64_t) {
+    tabletnode::TabletNodeClient node_client(tablet->GetServerAddr(),
+                                            FLAGS_tera_master_load_rpc_timeout);
+    LoadTabletRequest* request = new LoadTabletRequest;
+    LoadTabletResponse* response = new LoadTabletResponse;
+    FillLoadTabletRequest(tablet, request);
+    request->set_session_id(tablet->GetServerId());
 
     LOG(INFO) << "LoadTabletAsync id: " << request->sequence_id() << ", "
         << tablet;
@@ -2504,7 +2556,8 @@ void MasterImpl::ClearUnusedSnapshots(TabletPtr tablet, const TabletMeta& meta)
 }
 
 void MasterImpl::QueryTabletNodeAsync(std::string addr, int32_t timeout,
-                                      bool is_gc, QueryClosure* done) {
+                                      bool is_gc, QueryClosure* done,
+                                      uint64_t tablet_list_version) {
     tabletnode::TabletNodeClient node_client(addr, timeout);
 
     QueryRequest* request = new QueryRequest;
@@ -2514,6 +2567,9 @@ void MasterImpl::QueryTabletNodeAsync(std::string addr, int32_t timeout,
     if (is_gc) {
         request->set_is_gc_query(true);
     }
+    if (tablet_list_version > 0) {
+        request->set_tablet_list_version(tablet_list_version);
+    }
 
     VLOG(5) << "QueryAsync id: " << request->sequence_id() << ", "
         << "server: " << addr;
@@ -2544,7 +2600,8 @@ void MasterImpl::QueryTabletNodeCallback(std::string addr, QueryRequest* request
             TryKickTabletNode(addr);
         }
     } else {
-        // update tablet meta
+        // update tablet meta, a delta response only holds changed tablets
+        bool mismatch = false;
         uint32_t meta_num = response->tabletmeta_list().meta_size();
         for (uint32_t i = 0; i < meta_num; i++) {
             const TabletMeta& meta = response->tabletmeta_list().meta(i);
@@ -2577,8 +2634,16 @@ void MasterImpl::QueryTabletNodeCallback(std::string addr, QueryRequest* request
                     << ", " << DebugString(key_end)
                     << "], size: " << meta.table_size()
                     << ", addr: " << meta.server_addr();
+                mismatch = true;
             }
         }
+        // master and tabletnode disagree, ask for a full list next time
+        if (mismatch) {
+            node->SetQueryVersion(0, false);
+        } else {
+            node->SetQueryVersion(response->tablet_list_version(),
+                                  response->is_delta());
+        }
 
         // update tabletnode info
         timeval update_time;
@@ -2730,7 +2795,7 @@ void MasterImpl::RetryCollectTabletInfo(std::string addr,
     QueryTabletNodeAsync(addr, FLAGS_tera_master_collect_info_timeout, false, done);
 }
 
-void MasterImpl::SplitTabletAsync(TabletPtr tablet) {
+void MasterImpl::SplitTabletAsync(TabletPtr tablet, bool by_load) {
     const std::string& table_name = tablet->GetTableName();
     const std::string& server_addr = tablet->GetServerAddr();
     const std::string& key_start = tablet->GetKeyStart();
@@ -2747,6 +2812,7 @@ void MasterImpl::SplitTabletAsync(TabletPtr tablet) {
     request->mutable_key_range()->set_key_end(key_end);
     request->add_child_tablets(tablet->GetTable()->GetNextTabletNo());
     request->add_child_tablets(tablet->GetTable()->GetNextTabletNo());
+    request->set_split_by_load(by_load);
 
     tablet->ToMeta(request->mutable_tablet_meta());
     std::vector<uint64_t> snapshots;
@@ -3011,7 +3077,7 @@ void MasterImpl::RetryUnloadTablet(TabletPtr tablet, int32_t retry_times) {
     UnloadTabletAsync(tablet, done);
 }
 
-bool MasterImpl::TrySplitTablet(TabletPtr tablet) {
+bool MasterImpl::TrySplitTablet(TabletPtr tablet, bool by_load) {
     const std::string& server_addr = tablet->GetServerAddr();
 
     // abort if server down
@@ -3036,7 +3102,7 @@ bool MasterImpl::TrySplitTablet(TabletPtr tablet) {
     // if server down here, let split callback take care of status switch
     LOG(INFO) << "begin split table " << tablet->GetPath();
     tablet->SetServerId(node->m_uuid);
-    SplitTabletAsync(tablet);
+    SplitTabletAsync(tablet, by_load);
     return true;
 }
 
@@ -3175,8 +3241,8 @@ void MasterImpl::MergeTabletAsyncPhase2(TabletPtr tablet_p1, TabletPtr tablet_p2
     WriteClosure* done =
         NewClosure(this, &MasterImpl::MergeTabletWriteMetaCallback, new_meta,
                    tablet_p1, tablet_p2, FLAGS_tera_master_meta_retry_times);
-    tabletnode::TabletNodeClient meta_node_client(meta_addr);
-    meta_node_client.WriteTablet(request, response, done);
+    QueueMetaWrite(request, response, done);
+    FlushMetaWrite();
 }
 
 void MasterImpl::MergeTabletUnloadCallback(TabletPtr tablet, TabletPtr tablet2, Mutex* mutex,
@@ -3303,8 +3369,10 @@ void MasterImpl::MergeTabletWriteMetaCallback(TabletMeta new_meta,
                 WriteClosure* done =
                     NewClosure(this, &MasterImpl::MergeTabletWriteMetaCallback, new_meta,
                                tablet_p1, tablet_p2, retry_times - 1);
-                tabletnode::TabletNodeClient meta_node_client(meta_addr);
-                meta_node_client.WriteTablet(request, response, done);
+                // the row status of the pipeline are appended to the response
+                response->Clear();
+                QueueMetaWrite(request, response, done);
+                FlushMetaWrite();
                 return;
             } else {
                 LOG(WARNING) << "[merge] meta table not ready.";
@@ -3377,7 +3445,14 @@ void MasterImpl::BatchWriteMetaTableAsync(TablePtr table,
         SuspendMetaOperation(table, tablets, is_delete, done);
         return;
     }
+    if (QueueMetaWrite(table, tablets, is_delete, done)) {
+        FlushMetaWrite();
+    }
+}
 
+bool MasterImpl::QueueMetaWrite(TablePtr table,
+                                const std::vector<TabletPtr>& tablets,
+                                bool is_delete, WriteClosure* done) {
     WriteTabletRequest* request = new WriteTabletRequest;
     WriteTabletResponse* response = new WriteTabletResponse;
     request->set_sequence_id(m_this_sequence_id.Inc());
@@ -3419,7 +3494,7 @@ void MasterImpl::BatchWriteMetaTableAsync(TablePtr table,
     if (request->row_list_size() == 0) {
         delete request;
         delete response;
-        return;
+        return false;
     }
 
     if (tablets.size() > 0) {
@@ -3429,8 +3504,104 @@ void MasterImpl::BatchWriteMetaTableAsync(TablePtr table,
         LOG(INFO) << "WriteMetaTableAsync id: " << request->sequence_id()
             << ", " << table;
     }
-    tabletnode::TabletNodeClient meta_node_client(meta_addr);
-    meta_node_client.WriteTablet(request, response, done);
+    QueueMetaWrite(request, response, done);
+    return true;
+}
+
+void MasterImpl::QueueMetaWrite(WriteTabletRequest* request,
+                                WriteTabletResponse* response,
+                                WriteClosure* done) {
+    MetaWriteTask task;
+    task.m_request = request;
+    task.m_response = response;
+    task.m_done = done;
+    MutexLock lock(&m_meta_write_mutex);
+    m_meta_write_queue.push_back(task);
+}
+
+void MasterImpl::FlushMetaWrite() {
+    while (true) {
+        std::vector<MetaWriteTask>* group = NULL;
+        WriteTabletRequest* request = NULL;
+        {
+            MutexLock lock(&m_meta_write_mutex);
+            if (m_meta_write_queue.empty() ||
+                m_meta_write_inflight >= FLAGS_tera_master_meta_write_max_inflight) {
+                return;
+            }
+            // group pending writes in order, a write larger than the batch
+            // limit is still sent as a whole
+            group = new std::vector<MetaWriteTask>;
+            request = new WriteTabletRequest;
+            request->set_sequence_id(m_this_sequence_id.Inc());
+            request->set_tablet_name(FLAGS_tera_master_meta_table_name);
+            request->set_is_sync(true);
+            request->set_is_instant(true);
+            while (!m_meta_write_queue.empty()) {
+                const MetaWriteTask& task = m_meta_write_queue.front();
+                if (group->size() > 0 && request->row_list_size()
+                    + task.m_request->row_list_size()
+                    > FLAGS_tera_master_meta_write_batch_rows) {
+                    break;
+                }
+                request->mutable_row_list()->MergeFrom(task.m_request->row_list());
+                group->push_back(task);
+                m_meta_write_queue.pop_front();
+            }
+            m_meta_write_inflight++;
+        }
+
+        WriteTabletResponse* response = new WriteTabletResponse;
+        WriteClosure* done =
+            NewClosure(this, &MasterImpl::MetaWriteCallback, group);
+        std::string meta_addr;
+        if (!m_tablet_manager->GetMetaTabletAddr(&meta_addr)) {
+            done->Run(request, response, true,
+                      sofa::pbrpc::RPC_ERROR_SERVER_UNAVAILABLE);
+            return;
+        }
+        VLOG(5) << "meta write id: " << request->sequence_id() << ", group "
+            << group->size() << " writes, " << request->row_list_size() << " rows";
+        tabletnode::TabletNodeClient meta_node_client(meta_addr);
+        meta_node_client.WriteTablet(request, response, done);
+    }
+}
+
+void MasterImpl::MetaWriteCallback(std::vector<MetaWriteTask>* group,
+                                   WriteTabletRequest* request,
+                                   WriteTabletResponse* response,
+                                   bool failed, int error_code) {
+    if (failed) {
+        LOG(WARNING) << "fail to write meta, id: " << request->sequence_id()
+            << ", " << sofa::pbrpc::RpcErrorCodeToString(error_code);
+    }
+    {
+        MutexLock lock(&m_meta_write_mutex);
+        m_meta_write_inflight--;
+    }
+
+    // split the response back to every write of the group
+    int row_index = 0;
+    for (size_t i = 0; i < group->size(); ++i) {
+        MetaWriteTask& task = (*group)[i];
+        if (!failed) {
+            task.m_response->set_status(response->status());
+            task.m_response->set_sequence_id(task.m_request->sequence_id());
+            for (int j = 0; j < task.m_request->row_list_size(); ++j, ++row_index) {
+                if (row_index < response->row_status_list_size()) {
+                    task.m_response->add_row_status_list(
+                        response->row_status_list(row_index));
+                } else {
+                    task.m_response->add_row_status_list(response->status());
+                }
+            }
+        }
+        task.m_done->Run(task.m_request, task.m_response, failed, error_code);
+    }
+    delete group;
+    delete request;
+    delete response;
+    FlushMetaWrite();
 }
 
 void MasterImpl::AddMetaCallback(TablePtr table,
@@ -3950,8 +4121,8 @@ void MasterImpl::RepairMetaTableAsync(TabletPtr tablet,
 
     LOG(INFO) << "RepairMetaTableAsync id: " << request->sequence_id() << ", "
         << tablet;
-    tabletnode::TabletNodeClient meta_node_client(meta_addr);
-    meta_node_client.WriteTablet(request, response, done);
+    QueueMetaWrite(request, response, done);
+    FlushMetaWrite();
 }
 
 void MasterImpl::RepairMetaAfterSplitCallback(TabletPtr tablet,
@@ -4077,9 +4248,10 @@ void MasterImpl::ResumeMetaOperation() {
     while (!m_meta_task_queue.empty()) {
         MetaTask* task = m_meta_task_queue.front();
         if (task->m_type == kWrite) {
+            // suspended writes are sent in groups after all are queued
             WriteTask* write_task = (WriteTask*)task;
-            BatchWriteMetaTableAsync(write_task->m_table, write_task->m_tablet,
-                                     write_task->m_is_delete, write_task->m_done);
+            QueueMetaWrite(write_task->m_table, write_task->m_tablet,
+                           write_task->m_is_delete, write_task->m_done);
             delete write_task;
         } else if (task->m_type == kScan) {
             ScanTask* scan_task = (ScanTask*)task;
@@ -4096,6 +4268,7 @@ void MasterImpl::ResumeMetaOperation() {
         m_meta_task_queue.pop();
     }
     m_meta_task_mutex.Unlock();
+    FlushMetaWrite();
 }
 
 void MasterImpl::TryMoveTablet(TabletPtr tablet, const std::string& server_addr) {
@@ -4104,6 +4277,27 @@ void MasterImpl::TryMoveTablet(TabletPtr tablet, const std::string& server_addr)
     }
     LOG(INFO) << "Move " << tablet << " from " << tablet->GetServerAddr()
         << " to " << server_addr;
+    // warm up the destination while the source still serves the tablet,
+    // so that the tablet is offline only for unload and a warm load
+    TabletNodePtr node;
+    if (FLAGS_tera_master_move_prewarm_enabled && !server_addr.empty()
+        && tablet->GetStatus() == kTableReady
+        && m_tabletnode_manager->FindTabletNode(server_addr, &node)) {
+        {
+            MutexLock lock(&m_prewarm_mutex);
+            if (!m_prewarm_tablets.insert(tablet->GetPath()).second) {
+                LOG(INFO) << "tablet is prewarming, abort move " << tablet;
+                return;
+            }
+        }
+        node->PlanToMoveIn();
+        PrewarmTabletAsync(tablet, node);
+        return;
+    }
+    UnloadTabletForMove(tablet, server_addr);
+}
+
+void MasterImpl::UnloadTabletForMove(TabletPtr tablet, const std::string& server_addr) {
     if (tablet->SetStatusIf(kTableUnLoading, kTableReady)) {
         tablet->SetExpectServerAddr(server_addr);
         TabletNodePtr node;
@@ -4118,6 +4312,44 @@ void MasterImpl::TryMoveTablet(TabletPtr tablet, const std::string& server_addr)
     }
 }
 
+void MasterImpl::PrewarmTabletAsync(TabletPtr tablet, TabletNodePtr node) {
+    tabletnode::TabletNodeClient node_client(node->GetAddr(),
+                                            FLAGS_tera_master_prewarm_rpc_timeout);
+    LoadTabletRequest* request = new LoadTabletRequest;
+    LoadTabletResponse* response = new LoadTabletResponse;
+    FillLoadTabletRequest(tablet, request);
+    request->set_session_id(node->m_uuid);
+
+    LOG(INFO) << "PrewarmTabletAsync id: " << request->sequence_id() << ", "
+        << tablet << ", on " << node->GetAddr();
+    LoadClosure* done = NewClosure(this, &MasterImpl::PrewarmTabletCallback,
+                                   tablet, node->GetAddr());
+    node_client.PrewarmTablet(request, response, done);
+}
+
+void MasterImpl::PrewarmTabletCallback(TabletPtr tablet, std::string server_addr,
+                                       LoadTabletRequest* request,
+                                       LoadTabletResponse* response,
+                                       bool failed, int error_code) {
+    // prewarm is best effort, move the tablet anyway
+    if (failed || response->status() != kTabletNodeOk) {
+        LOG(WARNING) << "fail to prewarm " << tablet << " on " << server_addr
+            << ", status: " << (failed ? sofa::pbrpc::RpcErrorCodeToString(error_code)
+                                : StatusCodeToString(response->status()));
+    }
+    delete request;
+    delete response;
+    {
+        MutexLock lock(&m_prewarm_mutex);
+        m_prewarm_tablets.erase(tablet->GetPath());
+    }
+    TabletNodePtr node;
+    if (m_tabletnode_manager->FindTabletNode(server_addr, &node)) {
+        node->DoneMoveIn();
+    }
+    UnloadTabletForMove(tablet, server_addr);
+}
+
 void MasterImpl::ProcessOffLineTablet(TabletPtr tablet) {
     if (!tablet->IsBound()) {
         return;
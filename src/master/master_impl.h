@@ -7,6 +7,7 @@
 
 #include <stdint.h>
 #include <semaphore.h>
+#include <deque>
 #include <string>
 #include <vector>
 
@@ -166,6 +167,13 @@ private:
         TabletPtr m_tablet;
         ScanTabletResponse* m_scan_resp;
     };
+    // a meta write waiting in the pipeline, "request" and "response" are
+    // handed to "done" as if the write was sent alone
+    struct MetaWriteTask {
+        WriteTabletRequest* m_request;
+        WriteTabletResponse* m_response;
+        WriteClosure* m_done;
+    };
     struct SnapshotTask {
         const GetSnapshotRequest* request;
         GetSnapshotResponse* response;
@@ -198,9 +206,15 @@ private:
 
     void RetryLoadTablet(TabletPtr tablet, int32_t retry_times);
     void RetryUnloadTablet(TabletPtr tablet, int32_t retry_times);
-    bool TrySplitTablet(TabletPtr tablet);
+    bool TrySplitTablet(TabletPtr tablet, bool by_load = false);
     bool TryMergeTablet(TabletPtr tablet);
     void TryMoveTablet(TabletPtr tablet, const std::string& server_addr = "");
+    void UnloadTabletForMove(TabletPtr tablet, const std::string& server_addr);
+    void PrewarmTabletAsync(TabletPtr tablet, TabletNodePtr node);
+    void PrewarmTabletCallback(TabletPtr tablet, std::string server_addr,
+                               LoadTabletRequest* request,
+                               LoadTabletResponse* response,
+                               bool failed, int error_code);
 
     void TryReleaseCache(bool enbaled_debug = false);
     void ReleaseCacheWrapper();
@@ -213,6 +227,7 @@ private:
 
     bool CreateAndLoadTable(const std::string& table_name,
                             bool compress, StoreMedium store, StatusCode* status);
+    void FillLoadTabletRequest(TabletPtr tablet, LoadTabletRequest* request);
     void LoadTabletAsync(TabletPtr tablet, LoadClosure* done,
                          uint64_t timer_id = 0);
     void LoadTabletCallback(TabletPtr tablet, int32_t retry,
@@ -236,6 +251,7 @@ private:
                               bool failed, int error_code);
 
     void LoadBalance();
+    void DoLoadBalance();
     void TabletNodeLoadBalance(const std::string& tabletnode_addr,
                                const std::vector<TabletPtr>& tablet_list);
     void TabletNodeLoadBalance(const std::string& tabletnode_addr,
@@ -268,7 +284,8 @@ private:
                              bool failed, int error_code);
     void QueryTabletNode();
     void QueryTabletNodeAsync(std::string addr, int32_t timeout,
-                              bool is_gc, QueryClosure* done);
+                              bool is_gc, QueryClosure* done,
+                              uint64_t tablet_list_version = 0);
 
     void ReleaseSnpashot(TabletPtr tablet, uint64_t snapshot);
     void ReleaseSnapshotCallback(ReleaseSnapshotRequest* request,
@@ -293,7 +310,7 @@ private:
                                 sem_t* finish_counter, Mutex* mutex);
     void RetryQueryNewTabletNode(std::string addr);
 
-    void SplitTabletAsync(TabletPtr tablet);
+    void SplitTabletAsync(TabletPtr tablet, bool by_load = false);
     void SplitTabletCallback(TabletPtr tablet, SplitTabletRequest* request,
                              SplitTabletResponse* response, bool failed,
                              int error_code);
@@ -320,6 +337,19 @@ private:
     void BatchWriteMetaTableAsync(TablePtr table,
                                   const std::vector<TabletPtr>& tablets,
                                   bool is_delete, WriteClosure* done);
+    // queue the write in the meta write pipeline, return false if there is
+    // nothing to write
+    bool QueueMetaWrite(TablePtr table, const std::vector<TabletPtr>& tablets,
+                        bool is_delete, WriteClosure* done);
+    // queue a write built by the caller, e.g. for merge or repair
+    void QueueMetaWrite(WriteTabletRequest* request,
+                        WriteTabletResponse* response, WriteClosure* done);
+    // group pending meta writes into rpcs until the in-flight window is full
+    void FlushMetaWrite();
+    void MetaWriteCallback(std::vector<MetaWriteTask>* group,
+                           WriteTabletRequest* request,
+                           WriteTabletResponse* response,
+                           bool failed, int error_code);
     void AddMetaCallback(TablePtr table, std::vector<TabletPtr> tablets,
                          int32_t retry_times,
                          const CreateTableRequest* rpc_request,
@@ -469,11 +499,20 @@ private:
     mutable Mutex m_meta_task_mutex;
     std::queue<MetaTask*> m_meta_task_queue;
 
+    // meta writes waiting for a free slot of the in-flight window
+    Mutex m_meta_write_mutex;
+    std::deque<MetaWriteTask> m_meta_write_queue;
+    int32_t m_meta_write_inflight;
+
     mutable Mutex m_tabletnode_timer_mutex;
     std::map<std::string, int64_t> m_tabletnode_timer_id_map;
 
     mutable Mutex m_tablet_mutex;
 
+    // path of tablets being prewarmed on the destination of a move
+    Mutex m_prewarm_mutex;
+    std::set<std::string> m_prewarm_tablets;
+
     // stat table
     bool m_is_stat_table;
     std::map<std::string, int64_t> m_ts_stat_update_time;
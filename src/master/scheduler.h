@@ -7,6 +7,8 @@
 
 #include <map>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "master/tabletnode_manager.h"
 
@@ -31,6 +33,16 @@ public:
                                std::vector<TabletNodePtr>& node_list) = 0;
     virtual void DescendingSort(const std::string& table_name,
                                 std::vector<TabletNodePtr>& node_list) = 0;
+
+    // global schedule, plan at most "max_move_num" moves of tablets in
+    // "tablet_list" as (tablet, dest node) pairs. Return false if the
+    // scheduler only balances node by node.
+    typedef std::vector<std::pair<TabletPtr, std::string> > MovePlan;
+    virtual bool PlanMoves(const std::vector<TabletNodePtr>& node_list,
+                           const std::vector<TabletPtr>& tablet_list,
+                           size_t max_move_num, MovePlan* plan) {
+        return false;
+    }
 };
 
 } // namespace master
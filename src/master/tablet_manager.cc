@@ -57,12 +57,12 @@ std::ostream& operator << (std::ostream& o, const TabletPtr& tablet) {
     return o;
 }
 
-Tablet::Tablet() {}
+Tablet::Tablet() : m_index(NULL) {}
 
-Tablet::Tablet(const TabletMeta& meta) : m_meta(meta) {}
+Tablet::Tablet(const TabletMeta& meta) : m_meta(meta), m_index(NULL) {}
 
 Tablet::Tablet(const TabletMeta& meta, TablePtr table)
-    : m_meta(meta), m_table(table) {}
+    : m_meta(meta), m_table(table), m_index(NULL) {}
 
 Tablet::~Tablet() {
     m_table.reset();
@@ -167,7 +167,9 @@ void Tablet::SetCompactStatus(CompactStatus compact_status) {
 
 void Tablet::SetAddr(const std::string& server_addr) {
     MutexLock lock(&m_mutex);
+    std::string old_addr = m_meta.server_addr();
     m_meta.set_server_addr(server_addr);
+    UpdateIndex(old_addr, m_meta.status());
 }
 
 void Tablet::SetServerId(const std::string& server_id) {
@@ -186,7 +188,9 @@ bool Tablet::SetStatus(TabletStatus new_status, TabletStatus* old_status) {
         *old_status = m_meta.status();
     }
     if (CheckStatusSwitch(m_meta.status(), new_status)) {
+        TabletStatus status = m_meta.status();
         m_meta.set_status(new_status);
+        UpdateIndex(m_meta.server_addr(), status);
         return true;
     }
     return false;
@@ -201,6 +205,7 @@ bool Tablet::SetStatusIf(TabletStatus new_status, TabletStatus if_status,
     if (m_meta.status() == if_status
         && CheckStatusSwitch(m_meta.status(), new_status)) {
         m_meta.set_status(new_status);
+        UpdateIndex(m_meta.server_addr(), if_status);
         return true;
     }
     return false;
@@ -219,6 +224,7 @@ bool Tablet::SetStatusIf(TabletStatus new_status, TabletStatus if_status,
     if (m_meta.status() == if_status && m_table->m_status == if_table_status
         && CheckStatusSwitch(m_meta.status(), new_status)) {
         m_meta.set_status(new_status);
+        UpdateIndex(m_meta.server_addr(), if_status);
         return true;
     }
     return false;
@@ -231,7 +237,9 @@ bool Tablet::SetAddrIf(const std::string& server_addr, TabletStatus if_status,
         *old_status = m_meta.status();
     }
     if (m_meta.status() == if_status) {
+        std::string old_addr = m_meta.server_addr();
         m_meta.set_server_addr(server_addr);
+        UpdateIndex(old_addr, if_status);
         return true;
     }
     return false;
@@ -245,8 +253,11 @@ bool Tablet::SetAddrAndStatus(const std::string& server_addr,
         *old_status = m_meta.status();
     }
     if (CheckStatusSwitch(m_meta.status(), new_status)) {
+        std::string old_addr = m_meta.server_addr();
+        TabletStatus old = m_meta.status();
         m_meta.set_status(new_status);
         m_meta.set_server_addr(server_addr);
+        UpdateIndex(old_addr, old);
         return true;
     }
     return false;
@@ -261,8 +272,10 @@ bool Tablet::SetAddrAndStatusIf(const std::string& server_addr,
     }
     if (m_meta.status() == if_status
         && CheckStatusSwitch(m_meta.status(), new_status)) {
+        std::string old_addr = m_meta.server_addr();
         m_meta.set_status(new_status);
         m_meta.set_server_addr(server_addr);
+        UpdateIndex(old_addr, if_status);
         return true;
     }
     return false;
@@ -319,6 +332,14 @@ void Tablet::ToMetaTableKeyValue(std::string* packed_key,
     MakeMetaTableKeyValue(m_meta, packed_key, packed_value);
 }
 
+void Tablet::UpdateIndex(const std::string& old_addr, TabletStatus old_status) {
+    m_mutex.AssertHeld();
+    if (m_index != NULL) {
+        m_index->Update(this, old_addr, old_status,
+                        m_meta.server_addr(), m_meta.status());
+    }
+}
+
 bool Tablet::CheckStatusSwitch(TabletStatus old_status,
                                TabletStatus new_status) {
     if (new_status == kTableDeleted) {
@@ -426,6 +447,105 @@ bool Tablet::CheckStatusSwitch(TabletStatus old_status,
     return false;
 }
 
+TabletIndex::TabletIndex() : m_tablet_num(0) {}
+
+void TabletIndex::Add(const TabletPtr& tablet, const std::string& server_addr,
+                      TabletStatus status) {
+    MutexLock lock(&m_mutex);
+    m_addr_index[server_addr][tablet.get()] = tablet;
+    m_status_index[status][tablet.get()] = tablet;
+    m_tablet_num++;
+}
+
+void TabletIndex::Remove(Tablet* tablet, const std::string& server_addr,
+                         TabletStatus status) {
+    MutexLock lock(&m_mutex);
+    std::map<std::string, TabletSet>::iterator addr_it = m_addr_index.find(server_addr);
+    if (addr_it != m_addr_index.end() && addr_it->second.erase(tablet) > 0) {
+        m_tablet_num--;
+        if (addr_it->second.empty()) {
+            m_addr_index.erase(addr_it);
+        }
+    }
+    std::map<TabletStatus, TabletSet>::iterator status_it = m_status_index.find(status);
+    if (status_it != m_status_index.end()) {
+        status_it->second.erase(tablet);
+    }
+}
+
+void TabletIndex::Update(Tablet* tablet, const std::string& old_addr,
+                         TabletStatus old_status, const std::string& new_addr,
+                         TabletStatus new_status) {
+    MutexLock lock(&m_mutex);
+    if (old_addr != new_addr) {
+        MoveTablet(tablet, &m_addr_index[old_addr], &m_addr_index[new_addr]);
+        if (m_addr_index[old_addr].empty()) {
+            m_addr_index.erase(old_addr);
+        }
+    }
+    if (old_status != new_status) {
+        MoveTablet(tablet, &m_status_index[old_status], &m_status_index[new_status]);
+    }
+}
+
+void TabletIndex::MoveTablet(Tablet* tablet, TabletSet* from, TabletSet* to) {
+    TabletSet::iterator it = from->find(tablet);
+    if (it == from->end()) {
+        // caller holds the lock of tablet, do not print it
+        LOG(ERROR) << "tablet not indexed: " << static_cast<void*>(tablet);
+        return;
+    }
+    (*to)[tablet] = it->second;
+    from->erase(it);
+}
+
+void TabletIndex::Clear() {
+    MutexLock lock(&m_mutex);
+    m_addr_index.clear();
+    m_status_index.clear();
+    m_tablet_num = 0;
+}
+
+void TabletIndex::FindByAddr(const std::string& server_addr,
+                             std::vector<TabletPtr>* tablet_list) {
+    MutexLock lock(&m_mutex);
+    std::map<std::string, TabletSet>::iterator it = m_addr_index.find(server_addr);
+    if (it == m_addr_index.end()) {
+        return;
+    }
+    TabletSet::iterator it2 = it->second.begin();
+    for (; it2 != it->second.end(); ++it2) {
+        tablet_list->push_back(it2->second);
+    }
+}
+
+void TabletIndex::FindByStatus(TabletStatus status,
+                               std::vector<TabletPtr>* tablet_list) {
+    MutexLock lock(&m_mutex);
+    std::map<TabletStatus, TabletSet>::iterator it = m_status_index.find(status);
+    if (it == m_status_index.end()) {
+        return;
+    }
+    TabletSet::iterator it2 = it->second.begin();
+    for (; it2 != it->second.end(); ++it2) {
+        tablet_list->push_back(it2->second);
+    }
+}
+
+uint32_t TabletIndex::CountByStatus(TabletStatus status) {
+    MutexLock lock(&m_mutex);
+    std::map<TabletStatus, TabletSet>::iterator it = m_status_index.find(status);
+    if (it == m_status_index.end()) {
+        return 0;
+    }
+    return it->second.size();
+}
+
+uint32_t TabletIndex::Count() {
+    MutexLock lock(&m_mutex);
+    return m_tablet_num;
+}
+
 std::ostream& operator << (std::ostream& o, const Table& table) {
     MutexLock lock(&table.m_mutex);
     o << "table: " << table.m_name << ", schema: "
@@ -715,6 +835,8 @@ bool TabletManager::AddTablet(const TabletMeta& meta, const TableSchema& schema,
     }
     TablePtr table = it->second;
     tablet->reset(new Tablet(meta, table));
+    (*tablet)->m_index = &m_tablet_index;
+    m_tablet_index.Add(*tablet, meta.server_addr(), meta.status());
     uint64_t tablet_num = leveldb::GetTabletNumFromPath(meta.path());
     if (table->m_max_tablet_no < tablet_num) {
         table->m_max_tablet_no = tablet_num;
@@ -777,23 +899,12 @@ bool TabletManager::FindTablet(const std::string& table_name,
 
 void TabletManager::FindTablet(const std::string& server_addr,
                                std::vector<TabletPtr>* tablet_meta_list) {
-    m_mutex.Lock();
-    TableList::iterator it = m_all_tables.begin();
-    for (; it != m_all_tables.end(); ++it) {
-        Table& table = *it->second;
-        table.m_mutex.Lock();
-        Table::TabletList::iterator it2 = table.m_tablets_list.begin();
-        for (; it2 != table.m_tablets_list.end(); ++it2) {
-            TabletPtr tablet = it2->second;
-            tablet->m_mutex.Lock();
-            if (tablet->m_meta.server_addr() == server_addr) {
-                tablet_meta_list->push_back(tablet);
-            }
-            tablet->m_mutex.Unlock();
-        }
-        table.m_mutex.Unlock();
-    }
-    m_mutex.Unlock();
+    m_tablet_index.FindByAddr(server_addr, tablet_meta_list);
+}
+
+void TabletManager::FindTablet(TabletStatus status,
+                               std::vector<TabletPtr>* tablet_meta_list) {
+    m_tablet_index.FindByStatus(status, tablet_meta_list);
 }
 
 bool TabletManager::FindTable(const std::string& table_name,
@@ -852,21 +963,23 @@ int64_t TabletManager::SearchTable(std::vector<TabletPtr>* tablet_meta_list,
         return 0;
     }
 
-    m_mutex.Lock();
-
-    TableList::iterator lower_it = m_all_tables.lower_bound(start_table_name);
-    TableList::iterator upper_it = m_all_tables.upper_bound(prefix_table_name + "\xFF");
-    if (upper_it == m_all_tables.begin() || lower_it == m_all_tables.end()) {
+    std::vector<TablePtr> table_list;
+    GetTableList(start_table_name, &table_list);
+    const std::string upper_table_name = prefix_table_name + "\xFF";
+    if (table_list.empty() || table_list[0]->m_name > upper_table_name) {
         SetStatusCode(kTableNotFound, ret_status);
         return -1;
     }
 
     uint32_t found_num = 0;
-    for (TableList::iterator it = lower_it; it != upper_it; ++it) {
-        Table& table = *it->second;
+    for (size_t i = 0; i < table_list.size(); ++i) {
+        Table& table = *table_list[i];
+        if (table.m_name > upper_table_name) {
+            break;
+        }
         Table::TabletList::iterator it2;
         table.m_mutex.Lock();
-        if (start_table_name == it->first) {
+        if (start_table_name == table.m_name) {
             it2 = table.m_tablets_list.lower_bound(start_tablet_key);
         } else {
             it2 = table.m_tablets_list.begin();
@@ -884,8 +997,6 @@ int64_t TabletManager::SearchTable(std::vector<TabletPtr>* tablet_meta_list,
             break;
         }
     }
-
-    m_mutex.Unlock();
     return found_num;
 }
 
@@ -896,12 +1007,9 @@ bool TabletManager::ShowTable(std::vector<TablePtr>* table_meta_list,
                               uint32_t max_table_found,
                               uint32_t max_tablet_found,
                               bool* is_more, StatusCode* ret_status) {
-    // lock table list
-    m_mutex.Lock();
-
-    TableList::iterator it = m_all_tables.lower_bound(start_table_name);
-    if (it == m_all_tables.end()) {
-        m_mutex.Unlock();
+    std::vector<TablePtr> table_list;
+    GetTableList(start_table_name, &table_list);
+    if (table_list.empty()) {
         LOG(ERROR) << "table not found: " << start_table_name;
         SetStatusCode(kTableNotFound, ret_status);
         return false;
@@ -909,8 +1017,8 @@ bool TabletManager::ShowTable(std::vector<TablePtr>* table_meta_list,
 
     uint32_t table_found_num = 0;
     uint32_t tablet_found_num = 0;
-    for (; it != m_all_tables.end(); ++it) {
-        TablePtr table = it->second;
+    for (size_t i = 0; i < table_list.size(); ++i) {
+        TablePtr table = table_list[i];
         Table::TabletList::iterator it2;
 
         table->m_mutex.Lock();
@@ -935,11 +1043,33 @@ bool TabletManager::ShowTable(std::vector<TablePtr>* table_meta_list,
             break;
         }
     }
-
-    m_mutex.Unlock();
     return true;
 }
 
+void TabletManager::GetTableList(const std::string& start_table_name,
+                                 std::vector<TablePtr>* table_list) {
+    MutexLock lock(&m_mutex);
+    TableList::iterator it = m_all_tables.lower_bound(start_table_name);
+    for (; it != m_all_tables.end(); ++it) {
+        table_list->push_back(it->second);
+    }
+}
+
+void TabletManager::UnbindTablets(Table* table) {
+    MutexLock lock(&table->m_mutex);
+    Table::TabletList::iterator it = table->m_tablets_list.begin();
+    for (; it != table->m_tablets_list.end(); ++it) {
+        Tablet& tablet = *it->second;
+        MutexLock tablet_lock(&tablet.m_mutex);
+        if (tablet.m_index != NULL) {
+            tablet.m_index->Remove(&tablet, tablet.m_meta.server_addr(),
+                                   tablet.m_meta.status());
+            tablet.m_index = NULL;
+        }
+    }
+    table->m_tablets_list.clear();
+}
+
 bool TabletManager::DeleteTable(const std::string& table_name,
                                 StatusCode* ret_status) {
     // lock table list
@@ -955,10 +1085,7 @@ bool TabletManager::DeleteTable(const std::string& table_name,
     Table& table = *it->second;
 
     // make sure no other thread ref this table
-    table.m_mutex.Lock();
-    table.m_mutex.Unlock();
-
-    table.m_tablets_list.clear();
+    UnbindTablets(&table);
 //    // delete every tablet
 //    Table::TabletList::iterator it2 = table.m_tablets_list.begin();
 //    for (; it2 != table.m_tablets_list.end(); ++it) {
@@ -989,11 +1116,13 @@ bool TabletManager::DeleteTablet(const std::string& table_name,
         SetStatusCode(kTableNotFound, ret_status);
         return true;
     }
-    Table& table = *it->second;
+    // the table outlives its erase from the table list below
+    TablePtr table_ptr = it->second;
+    Table& table = *table_ptr;
 
-    // make sure no other thread ref this table
-    table.m_mutex.Lock();
-    table.m_mutex.Unlock();
+    // tablets are iterated under the table lock, so hold it from the
+    // search to the erase
+    MutexLock table_lock(&table.m_mutex);
 
     // search tablet
     Table::TabletList::iterator it2 = table.m_tablets_list.find(key_start);
@@ -1008,6 +1137,14 @@ bool TabletManager::DeleteTablet(const std::string& table_name,
 //    tablet.m_mutex.Lock();
 //    tablet.m_mutex.Unlock();
 //    delete &tablet;
+    Tablet& tablet = *it2->second;
+    tablet.m_mutex.Lock();
+    if (tablet.m_index != NULL) {
+        tablet.m_index->Remove(&tablet, tablet.m_meta.server_addr(),
+                               tablet.m_meta.status());
+        tablet.m_index = NULL;
+    }
+    tablet.m_mutex.Unlock();
     table.m_tablets_list.erase(it2);
 
     if (table.m_tablets_list.empty()) {
@@ -1388,13 +1525,11 @@ void TabletManager::ClearTableList() {
     MutexLock lock(&m_mutex);
     TableList::iterator it = m_all_tables.begin();
     for (; it != m_all_tables.end(); ++it) {
-        Table& table = *it->second;
-        table.m_mutex.Lock();
-        table.m_mutex.Unlock();
-        table.m_tablets_list.clear();
+        UnbindTablets(it->second.get());
         //delete &table;
     }
     m_all_tables.clear();
+    m_tablet_index.Clear();
 }
 
 void TabletManager::PackTabletMeta(TabletMeta* meta,
@@ -1603,23 +1738,8 @@ void TabletManager::MajorCompactCallback(Tablet* tb, int32_t retry,
 }
 
 double TabletManager::OfflineTabletRatio() {
-    uint32_t offline_tablet_count = 0, tablet_count = 0;
-    m_mutex.Lock();
-    TableList::iterator it = m_all_tables.begin();
-    for (; it != m_all_tables.end(); ++it) {
-        Table& table = *it->second;
-        table.m_mutex.Lock();
-        Table::TabletList::iterator it2 = table.m_tablets_list.begin();
-        for (; it2 != table.m_tablets_list.end(); ++it2) {
-            TabletPtr tablet = it2->second;
-            if (tablet->GetStatus() == kTableOffLine) {
-                offline_tablet_count++;
-            }
-            tablet_count++;
-        }
-        table.m_mutex.Unlock();
-    }
-    m_mutex.Unlock();
+    uint32_t offline_tablet_count = m_tablet_index.CountByStatus(kTableOffLine);
+    uint32_t tablet_count = m_tablet_index.Count();
 
     if (tablet_count == 0) {
         return 0;
@@ -47,6 +47,7 @@ namespace master {
 
 class MasterImpl;
 class Table;
+class TabletIndex;
 typedef sofa::pbrpc::shared_ptr<Table> TablePtr;
 
 class Tablet {
@@ -120,15 +121,50 @@ private:
     static bool CheckStatusSwitch(TabletStatus old_status,
                                   TabletStatus new_status);
 
+    // must be called with m_mutex held after server_addr or status changed
+    void UpdateIndex(const std::string& old_addr, TabletStatus old_status);
+
     mutable Mutex m_mutex;
     TabletMeta m_meta;
     TabletCounter m_counter;
     TablePtr m_table;
     std::string m_server_id;
     std::string m_expect_server_addr;
+    TabletIndex* m_index;
 };
 
 typedef class sofa::pbrpc::shared_ptr<Tablet> TabletPtr;
+
+// secondary index of tablets by server address and by status,
+// kept up to date by the setters of Tablet
+class TabletIndex {
+public:
+    TabletIndex();
+
+    void Add(const TabletPtr& tablet, const std::string& server_addr,
+             TabletStatus status);
+    void Remove(Tablet* tablet, const std::string& server_addr,
+                TabletStatus status);
+    void Update(Tablet* tablet, const std::string& old_addr,
+                TabletStatus old_status, const std::string& new_addr,
+                TabletStatus new_status);
+    void Clear();
+
+    void FindByAddr(const std::string& server_addr,
+                    std::vector<TabletPtr>* tablet_list);
+    void FindByStatus(TabletStatus status, std::vector<TabletPtr>* tablet_list);
+    uint32_t CountByStatus(TabletStatus status);
+    uint32_t Count();
+
+private:
+    typedef std::map<Tablet*, TabletPtr> TabletSet;
+    static void MoveTablet(Tablet* tablet, TabletSet* from, TabletSet* to);
+
+    mutable Mutex m_mutex;
+    std::map<std::string, TabletSet> m_addr_index;
+    std::map<TabletStatus, TabletSet> m_status_index;
+    uint32_t m_tablet_num;
+};
 std::ostream& operator << (std::ostream& o, const TabletPtr& tablet);
 std::ostream& operator << (std::ostream& o, const TablePtr& table);
 
@@ -220,6 +256,9 @@ public:
     void FindTablet(const std::string& server_addr,
                     std::vector<TabletPtr>* tablet_meta_list);
 
+    void FindTablet(TabletStatus status,
+                    std::vector<TabletPtr>* tablet_meta_list);
+
     bool FindTable(const std::string& table_name,
                    std::vector<TabletPtr>* tablet_meta_list,
                    StatusCode* ret_status = NULL);
@@ -287,10 +326,19 @@ private:
     void WriteToStream(std::ofstream& ofs, const std::string& key,
                        const std::string& value);
 
+    // copy the tables from "start_table_name" so that scans of tablets
+    // hold only the lock of one table at a time
+    void GetTableList(const std::string& start_table_name,
+                      std::vector<TablePtr>* table_list);
+    void UnbindTablets(Table* table);
+
 private:
     typedef std::map<std::string, TablePtr> TableList;
+    // m_mutex only guards the table list, tablets are guarded by the lock
+    // of their table
     TableList m_all_tables;
     mutable Mutex m_mutex;
+    TabletIndex m_tablet_index;
     Counter* m_this_sequence_id;
     MasterImpl* m_master_impl;
 };
@@ -14,13 +14,16 @@ DECLARE_int32(tera_master_max_split_concurrency);
 DECLARE_int32(tera_master_load_interval);
 DECLARE_double(tera_master_load_balance_size_overload_ratio);
 DECLARE_bool(tera_master_meta_isolate_enabled);
+DECLARE_bool(tera_master_query_delta_enabled);
+DECLARE_int32(tera_master_query_full_interval);
 
 namespace tera {
 namespace master {
 
 TabletNode::TabletNode() : m_state(kOffLine),
     m_report_status(kTabletNodeInit), m_data_size(0), m_load(0),
-    m_update_time(0), m_query_fail_count(0), m_onload_count(0),
+    m_update_time(0), m_query_fail_count(0), m_query_version(0),
+    m_delta_query_count(0), m_onload_count(0),
     m_onsplit_count(0), m_plan_move_in_count(0) {
     m_info.set_addr("");
 }
@@ -28,7 +31,8 @@ TabletNode::TabletNode() : m_state(kOffLine),
 TabletNode::TabletNode(const std::string& addr, const std::string& uuid)
     : m_addr(addr), m_uuid(uuid), m_state(kOffLine),
       m_report_status(kTabletNodeInit), m_data_size(0), m_load(0),
-      m_update_time(0), m_query_fail_count(0), m_onload_count(0),
+      m_update_time(0), m_query_fail_count(0), m_query_version(0),
+      m_delta_query_count(0), m_onload_count(0),
       m_onsplit_count(0), m_plan_move_in_count(0) {
     m_info.set_addr(addr);
 }
@@ -246,6 +250,25 @@ void TabletNode::ResetQueryFailCount() {
     m_query_fail_count = 0;
 }
 
+uint64_t TabletNode::GetQueryVersion() {
+    MutexLock lock(&m_mutex);
+    if (!FLAGS_tera_master_query_delta_enabled
+        || m_delta_query_count >= (uint32_t)FLAGS_tera_master_query_full_interval) {
+        return 0;
+    }
+    return m_query_version;
+}
+
+void TabletNode::SetQueryVersion(uint64_t version, bool is_delta) {
+    MutexLock lock(&m_mutex);
+    m_query_version = version;
+    if (is_delta) {
+        m_delta_query_count++;
+    } else {
+        m_delta_query_count = 0;
+    }
+}
+
 TabletNodeManager::TabletNodeManager(MasterImpl* master_impl)
     : m_master_impl(master_impl) {}
 
@@ -45,6 +45,8 @@ struct TabletNode {
     std::map<std::string, uint64_t> m_table_size;
 
     uint32_t m_query_fail_count;
+    uint64_t m_query_version;
+    uint32_t m_delta_query_count;
     uint32_t m_onload_count;
     uint32_t m_onsplit_count;
     uint32_t m_plan_move_in_count;
@@ -90,6 +92,10 @@ struct TabletNode {
     uint32_t IncQueryFailCount();
     void ResetQueryFailCount();
 
+    // the tablet list version to query with, 0 for a full list
+    uint64_t GetQueryVersion();
+    void SetQueryVersion(uint64_t version, bool is_delta);
+
 private:
     TabletNode(const TabletNode& t);
     TabletNode& operator=(const TabletNode& t);
@@ -34,6 +34,14 @@ bool TabletNodeClient::LoadTablet(const LoadTabletRequest* request,
                                 m_rpc_timeout, m_thread_pool);
 }
 
+bool TabletNodeClient::PrewarmTablet(const LoadTabletRequest* request,
+                                     LoadTabletResponse* response,
+                                     Closure<void, LoadTabletRequest*, LoadTabletResponse*, bool, int>* done) {
+    return SendMessageWithRetry(&TabletNodeServer::Stub::PrewarmTablet,
+                                request, response, done, "PrewarmTablet",
+                                m_rpc_timeout, m_thread_pool);
+}
+
 bool TabletNodeClient::UnloadTablet(const UnloadTabletRequest* request,
                                          UnloadTabletResponse* response,
                                          Closure<void, UnloadTabletRequest*, UnloadTabletResponse*, bool, int>* done) {
@@ -114,5 +122,13 @@ bool TabletNodeClient::CompactTablet(const CompactTabletRequest* request,
                                 m_rpc_timeout, m_thread_pool);
 }
 
+bool TabletNodeClient::BulkLoadTablet(const BulkLoadTabletRequest* request,
+                                      BulkLoadTabletResponse* response,
+                                      Closure<void, BulkLoadTabletRequest*, BulkLoadTabletResponse*, bool, int>* done) {
+    return SendMessageWithRetry(&TabletNodeServer::Stub::BulkLoadTablet,
+                                request, response, done, "BulkLoadTablet",
+                                m_rpc_timeout, m_thread_pool);
+}
+
 } // namespace tabletnode
 } // namespace tera
@@ -37,6 +37,10 @@ public:
                     LoadTabletResponse* response,
                     Closure<void, LoadTabletRequest*, LoadTabletResponse*, bool, int>* done = NULL);
 
+    bool PrewarmTablet(const LoadTabletRequest* request,
+                       LoadTabletResponse* response,
+                       Closure<void, LoadTabletRequest*, LoadTabletResponse*, bool, int>* done = NULL);
+
     bool UnloadTablet(const UnloadTabletRequest* request,
                       UnloadTabletResponse* response,
                       Closure<void, UnloadTabletRequest*, UnloadTabletResponse*, bool, int>* done = NULL);
@@ -76,6 +80,10 @@ public:
                        CompactTabletResponse* response,
                        Closure<void, CompactTabletRequest*, CompactTabletResponse*, bool, int>* done = NULL);
 
+    bool BulkLoadTablet(const BulkLoadTabletRequest* request,
+                        BulkLoadTabletResponse* response,
+                        Closure<void, BulkLoadTabletRequest*, BulkLoadTabletResponse*, bool, int>* done = NULL);
+
 private:
     int32_t m_rpc_timeout;
     static ThreadPool* m_thread_pool;
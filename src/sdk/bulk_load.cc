@@ -0,0 +1,274 @@
+// Copyright (c) 2015, Baidu.com, Inc. All Rights Reserved
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "sdk/bulk_load.h"
+
+#include <algorithm>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include "common/base/string_number.h"
+#include "leveldb/comparator.h"
+#include "leveldb/filter_policy.h"
+#include "leveldb/table_file_writer.h"
+#include "proto/proto_helper.h"
+#include "proto/tabletnode_client.h"
+#include "sdk/client_impl.h"
+#include "sdk/sdk_utils.h"
+#include "types.h"
+#include "utils/timer.h"
+
+DECLARE_string(tera_tabletnode_path_prefix);
+DECLARE_int64(tera_sdk_bulk_load_buffer_size);
+
+namespace tera {
+
+namespace {
+
+struct KeyValueLess {
+    explicit KeyValueLess(const leveldb::Comparator* cmp) : m_cmp(cmp) {}
+    bool operator() (const std::pair<std::string, std::string>& a,
+                     const std::pair<std::string, std::string>& b) const {
+        return m_cmp->Compare(a.first, b.first) < 0;
+    }
+    const leveldb::Comparator* m_cmp;
+};
+
+struct TabletStartLess {
+    bool operator() (const TabletMeta& a, const TabletMeta& b) const {
+        return a.key_range().key_start() < b.key_range().key_start();
+    }
+};
+
+} // namespace
+
+BulkLoader::BulkLoader(ClientImpl* client, const std::string& table_name,
+                       const std::string& work_dir, leveldb::Env* env)
+    : m_client(client), m_table_name(table_name), m_work_dir(work_dir),
+      m_env(env), m_kv_only(false), m_key_operator(NULL),
+      m_load_timestamp(0), m_buffer_size(0), m_file_num(0) {}
+
+BulkLoader::~BulkLoader() {
+    if (!m_lg_options.empty()) {
+        delete m_lg_options[0].filter_policy;
+    }
+}
+
+bool BulkLoader::Init(ErrorCode* err) {
+    TabletMetaList tablet_list;
+    if (!m_client->ShowTablesInfo(m_table_name, &m_table_meta, &tablet_list, err)) {
+        LOG(ERROR) << "fail to get meta of table: " << m_table_name;
+        return false;
+    }
+    for (int32_t i = 0; i < tablet_list.meta_size(); ++i) {
+        m_tablets.push_back(tablet_list.meta(i));
+    }
+    std::sort(m_tablets.begin(), m_tablets.end(), TabletStartLess());
+    if (m_tablets.empty()) {
+        err->SetFailed(ErrorCode::kSystem, "table has no tablet");
+        return false;
+    }
+
+    const TableSchema& schema = m_table_meta.schema();
+    leveldb::Options options;
+    m_kv_only = schema.kv_only() || schema.column_families_size() == 0;
+    if (schema.raw_key() == Binary) {
+        m_key_operator = leveldb::BinaryRawKeyOperator();
+        options.comparator = leveldb::TeraBinaryComparator();
+    } else if (schema.raw_key() == TTLKv) {
+        m_key_operator = leveldb::KvRawKeyOperator();
+        options.comparator = leveldb::TeraTTLKvComparator();
+    } else {
+        m_key_operator = leveldb::ReadableRawKeyOperator();
+        options.comparator = leveldb::BytewiseComparator();
+    }
+    // the same filter as the tablets, see TabletIO::SetupOptions
+    if (m_kv_only && schema.raw_key() == TTLKv) {
+        options.filter_policy = leveldb::NewTTLKvBloomFilterPolicy(10);
+    } else {
+        options.filter_policy = leveldb::NewBloomFilterPolicy(10);
+    }
+    options.env = m_env;
+
+    std::map<std::string, uint32_t> lg_id_map;
+    for (int32_t i = 0; i < schema.locality_groups_size(); ++i) {
+        const LocalityGroupSchema& lg_schema = schema.locality_groups(i);
+        lg_id_map[lg_schema.name()] = i;
+        leveldb::Options lg_options = options;
+        if (lg_schema.compress_type() && lg_schema.compress_with_dict()) {
+            lg_options.compression = leveldb::kZlibDictCompression;
+            lg_options.compression_dict_size = lg_schema.compress_dict_size() * 1024;
+        } else if (lg_schema.compress_type()) {
+            lg_options.compression = leveldb::kSnappyCompression;
+        }
+        lg_options.block_size = lg_schema.block_size() * 1024;
+        m_lg_options.push_back(lg_options);
+    }
+    if (m_lg_options.empty()) {
+        m_lg_options.push_back(options);
+    }
+    for (int32_t i = 0; i < schema.column_families_size(); ++i) {
+        const ColumnFamilySchema& cf_schema = schema.column_families(i);
+        std::map<std::string, uint32_t>::iterator it =
+            lg_id_map.find(cf_schema.locality_group());
+        m_cf_lg_map[cf_schema.name()] = (it == lg_id_map.end()) ? 0 : it->second;
+    }
+    m_load_timestamp = get_micros();
+    LOG(INFO) << "bulk load table: " << m_table_name << ", tablets: "
+        << m_tablets.size() << ", lgs: " << m_lg_options.size();
+    return true;
+}
+
+int32_t BulkLoader::FindTablet(const std::string& row_key) {
+    int32_t begin = 0;
+    int32_t end = m_tablets.size();
+    // the last tablet whose start key is not after row_key
+    while (end - begin > 1) {
+        int32_t mid = (begin + end) / 2;
+        if (m_tablets[mid].key_range().key_start() <= row_key) {
+            begin = mid;
+        } else {
+            end = mid;
+        }
+    }
+    return begin;
+}
+
+bool BulkLoader::Put(const std::string& user_row_key, const std::string& family,
+                     const std::string& qualifier, int64_t timestamp,
+                     const std::string& value, ErrorCode* err) {
+    std::string row_key =
+        EncodeHashRowKey(user_row_key, m_table_meta.schema().hash_bucket_num());
+    std::string key;
+    uint32_t lg_id = 0;
+    if (m_kv_only) {
+        if (m_table_meta.schema().raw_key() == TTLKv) {
+            int64_t expire = (timestamp < 0) ? kLatestTs
+                : m_load_timestamp / 1000000 + timestamp;
+            m_key_operator->EncodeTeraKey(row_key, "", "", expire,
+                                          leveldb::TKT_FORSEEK, &key);
+        } else {
+            key = row_key;
+        }
+    } else {
+        std::map<std::string, uint32_t>::iterator it = m_cf_lg_map.find(family);
+        if (it == m_cf_lg_map.end()) {
+            err->SetFailed(ErrorCode::kBadParam, "column family not found: " + family);
+            return false;
+        }
+        lg_id = it->second;
+        if (timestamp <= 0) {
+            timestamp = m_load_timestamp;
+        }
+        m_key_operator->EncodeTeraKey(row_key, family, qualifier, timestamp,
+                                      leveldb::TKT_VALUE, &key);
+    }
+
+    TabletLG tablet_lg(FindTablet(row_key), lg_id);
+    m_buffer_size += key.size() + value.size();
+    m_buffers[tablet_lg].push_back(std::make_pair(key, value));
+    if (m_buffer_size >= FLAGS_tera_sdk_bulk_load_buffer_size << 20) {
+        return FlushBuffers(err);
+    }
+    return true;
+}
+
+bool BulkLoader::FlushBuffers(ErrorCode* err) {
+    std::map<TabletLG, std::vector<KeyValue> >::iterator it = m_buffers.begin();
+    for (; it != m_buffers.end(); ++it) {
+        if (!WriteFile(it->first, &it->second, err)) {
+            return false;
+        }
+    }
+    m_buffers.clear();
+    m_buffer_size = 0;
+    return true;
+}
+
+bool BulkLoader::WriteFile(const TabletLG& tablet_lg, std::vector<KeyValue>* kvs,
+                           ErrorCode* err) {
+    const leveldb::Options& options = m_lg_options[tablet_lg.second];
+    // the last put of the same key wins
+    std::stable_sort(kvs->begin(), kvs->end(), KeyValueLess(options.comparator));
+
+    const TabletMeta& tablet = m_tablets[tablet_lg.first];
+    std::string dir = m_work_dir + "/" + tablet.path() + "/"
+        + NumberToString(tablet_lg.second);
+    std::string path = dir + "/" + NumberToString(m_file_num) + ".sst";
+    std::string full_dir = FLAGS_tera_tabletnode_path_prefix + "/" + dir;
+    m_env->CreateDir(full_dir);
+
+    leveldb::TableFileWriter writer(options,
+                                    FLAGS_tera_tabletnode_path_prefix + "/" + path);
+    leveldb::Status s = writer.Open();
+    for (size_t i = 0; s.ok() && i < kvs->size(); ++i) {
+        if (i + 1 < kvs->size()
+            && options.comparator->Compare((*kvs)[i].first, (*kvs)[i + 1].first) == 0) {
+            continue;
+        }
+        s = writer.Add((*kvs)[i].first, (*kvs)[i].second);
+    }
+    if (s.ok()) {
+        s = writer.Finish();
+    }
+    if (!s.ok()) {
+        LOG(ERROR) << "fail to write bulk load file: " << path << ", " << s.ToString();
+        err->SetFailed(ErrorCode::kSystem, "fail to write file: " + s.ToString());
+        return false;
+    }
+    VLOG(5) << "bulk load file: " << path << ", entries: " << writer.NumEntries()
+        << ", size: " << writer.FileSize();
+    m_files[tablet_lg.first][tablet_lg.second].push_back(path);
+    m_file_num++;
+    return true;
+}
+
+bool BulkLoader::LoadTablet(int32_t tablet, ErrorCode* err) {
+    const TabletMeta& meta = m_tablets[tablet];
+    BulkLoadTabletRequest request;
+    BulkLoadTabletResponse response;
+    request.set_sequence_id(0);
+    request.set_tablet_name(meta.table_name());
+    request.mutable_key_range()->CopyFrom(meta.key_range());
+    std::map<uint32_t, std::vector<std::string> >& lg_files = m_files[tablet];
+    std::map<uint32_t, std::vector<std::string> >::iterator it = lg_files.begin();
+    for (; it != lg_files.end(); ++it) {
+        LocalityGroupFiles* files = request.add_lg_files();
+        files->set_lg_id(it->first);
+        for (size_t i = 0; i < it->second.size(); ++i) {
+            files->add_path(it->second[i]);
+        }
+    }
+
+    tabletnode::TabletNodeClient node_client(meta.server_addr());
+    if (!node_client.BulkLoadTablet(&request, &response)) {
+        err->SetFailed(ErrorCode::kSystem, "fail to connect " + meta.server_addr());
+        return false;
+    }
+    if (response.status() != kTabletNodeOk) {
+        LOG(ERROR) << "fail to bulk load tablet: " << meta.path() << ", status: "
+            << StatusCodeToString(response.status());
+        err->SetFailed(ErrorCode::kSystem, "fail to load tablet " + meta.path()
+                       + ": " + StatusCodeToString(response.status()));
+        return false;
+    }
+    LOG(INFO) << "bulk load tablet: " << meta.path() << " on " << meta.server_addr();
+    return true;
+}
+
+bool BulkLoader::Finish(ErrorCode* err) {
+    if (!FlushBuffers(err)) {
+        return false;
+    }
+    std::map<int32_t, std::map<uint32_t, std::vector<std::string> > >::iterator it;
+    for (it = m_files.begin(); it != m_files.end(); ++it) {
+        if (!LoadTablet(it->first, err)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace tera
@@ -0,0 +1,85 @@
+// Copyright (c) 2015, Baidu.com, Inc. All Rights Reserved
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef TERA_SDK_BULK_LOAD_H_
+#define TERA_SDK_BULK_LOAD_H_
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "leveldb/env.h"
+#include "leveldb/options.h"
+#include "leveldb/raw_key_operator.h"
+#include "proto/table_meta.pb.h"
+#include "sdk/tera.h"
+
+namespace tera {
+
+class ClientImpl;
+
+// Loads a large amount of data into an existing table without going
+// through the write path: cells are partitioned by the current tablet
+// ranges, sorted and written into sst files of each locality group under
+// "work_dir" (relative to the tabletnode path prefix), and the files are
+// added to the tablets by BulkLoadTablet rpc on Finish().
+//
+// Loaded cells are older than any cell written to the table, so a cell
+// with the same row, column and timestamp written online is kept.
+// Tablets should not split or merge during a load, a tablet whose range
+// changed fails to load and the load is to be retried.
+class BulkLoader {
+public:
+    BulkLoader(ClientImpl* client, const std::string& table_name,
+               const std::string& work_dir, leveldb::Env* env);
+    ~BulkLoader();
+
+    bool Init(ErrorCode* err);
+
+    // add a cell, a non-positive timestamp is replaced by the time the load
+    // starts. For a kv table, family and qualifier are ignored and timestamp
+    // is the ttl in seconds of the value, -1 means never expires.
+    bool Put(const std::string& row_key, const std::string& family,
+             const std::string& qualifier, int64_t timestamp,
+             const std::string& value, ErrorCode* err);
+
+    // write out all buffered cells and load the files to the tablets
+    bool Finish(ErrorCode* err);
+
+    int64_t GetFileNum() const { return m_file_num; }
+
+private:
+    typedef std::pair<std::string, std::string> KeyValue;
+    typedef std::pair<int32_t, uint32_t> TabletLG;
+
+    int32_t FindTablet(const std::string& row_key);
+    bool FlushBuffers(ErrorCode* err);
+    bool WriteFile(const TabletLG& tablet_lg, std::vector<KeyValue>* kvs,
+                   ErrorCode* err);
+    bool LoadTablet(int32_t tablet, ErrorCode* err);
+
+    ClientImpl* m_client;
+    std::string m_table_name;
+    std::string m_work_dir;
+    leveldb::Env* m_env;
+
+    TableMeta m_table_meta;
+    std::vector<TabletMeta> m_tablets;    // sorted by start key
+    bool m_kv_only;
+    const leveldb::RawKeyOperator* m_key_operator;
+    std::vector<leveldb::Options> m_lg_options;
+    std::map<std::string, uint32_t> m_cf_lg_map;
+    int64_t m_load_timestamp;
+
+    std::map<TabletLG, std::vector<KeyValue> > m_buffers;
+    int64_t m_buffer_size;
+    // files written for each tablet, by lg id
+    std::map<int32_t, std::map<uint32_t, std::vector<std::string> > > m_files;
+    int64_t m_file_num;
+};
+
+} // namespace tera
+
+#endif // TERA_SDK_BULK_LOAD_H_
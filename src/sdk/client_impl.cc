@@ -79,6 +79,13 @@ bool ClientImpl::CreateTable(const TableDescriptor& desc,
     request.set_table_name(desc.TableName());
     TableSchema* schema = request.mutable_schema();
 
+    // rows of a hashed table are stored under their bucket id, so split
+    // points on the row keys of the user mean nothing
+    if (desc.HashBucketNum() > 0 && !tablet_delim.empty()) {
+        err->SetFailed(ErrorCode::kBadParam,
+                       "delimiters are not supported on a hashed table");
+        return false;
+    }
     TableDescToSchema(desc, schema);
     // add delimiter
     size_t delim_num = tablet_delim.size();
@@ -86,6 +93,12 @@ bool ClientImpl::CreateTable(const TableDescriptor& desc,
         const string& delim = tablet_delim[i];
         request.add_delimiters(delim);
     }
+    // one tablet per hash bucket by default
+    if (delim_num == 0) {
+        for (int32_t i = 1; i < desc.HashBucketNum(); ++i) {
+            request.add_delimiters(HashBucketPrefix(i));
+        }
+    }
     string reason;
     if (master_client.CreateTable(&request, &response)) {
         switch (response.status()) {
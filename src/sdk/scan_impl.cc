@@ -12,6 +12,7 @@
 
 #include "sdk/table_impl.h"
 #include "sdk/filter_utils.h"
+#include "sdk/sdk_utils.h"
 #include "utils/atomic.h"
 #include "utils/timer.h"
 
@@ -311,10 +312,13 @@ ResultStreamSyncImpl::ResultStreamSyncImpl(TableImpl* table,
       _result_pos(0),
       _finish_cond(&_finish_mutex),
       _finish(false) {
-    _table_ptr->ScanTabletSync(this);
+    // wait for the first batch in Done(), so that several streams, e.g. the
+    // buckets of a hashed table, fetch it at the same time
+    _table_ptr->ScanTabletAsync(this);
 }
 
 ResultStreamSyncImpl::~ResultStreamSyncImpl() {
+    Wait();
     if (_response != NULL) {
         delete _response;
     }
@@ -325,6 +329,7 @@ bool ResultStreamSyncImpl::LookUp(const string& row_key) {
 }
 
 bool ResultStreamSyncImpl::Done() {
+    Wait();
     while (1) {
         const string& scan_end_key = _scan_desc_impl->GetEndRowKey();
         /// scan failed
@@ -442,6 +447,75 @@ void ResultStreamSyncImpl::Reset() {
     _finish = false;
 }
 
+///////////////////////// ResultStreamMergeImpl ///////////////////////
+
+ResultStreamMergeImpl::ResultStreamMergeImpl(const std::vector<ResultStream*>& streams)
+    : _streams(streams), _cur_stream(NULL) {
+    PickStream();
+}
+
+ResultStreamMergeImpl::~ResultStreamMergeImpl() {
+    for (size_t i = 0; i < _streams.size(); ++i) {
+        delete _streams[i];
+    }
+}
+
+bool ResultStreamMergeImpl::LookUp(const string& row_key) {
+    return true;
+}
+
+bool ResultStreamMergeImpl::Done() {
+    return _cur_stream == NULL;
+}
+
+void ResultStreamMergeImpl::Next() {
+    _cur_stream->Next();
+    // a row lives in a single bucket, keep reading it from there
+    if (!_cur_stream->Done()
+        && DecodeHashRowKey(_cur_stream->RowName()) == _cur_row) {
+        return;
+    }
+    PickStream();
+}
+
+void ResultStreamMergeImpl::PickStream() {
+    _cur_stream = NULL;
+    for (size_t i = 0; i < _streams.size(); ++i) {
+        if (_streams[i]->Done()) {
+            continue;
+        }
+        string row = DecodeHashRowKey(_streams[i]->RowName());
+        if (_cur_stream == NULL || row < _cur_row) {
+            _cur_stream = _streams[i];
+            _cur_row = row;
+        }
+    }
+}
+
+string ResultStreamMergeImpl::RowName() const {
+    return _cur_row;
+}
+
+string ResultStreamMergeImpl::Family() const {
+    return _cur_stream->Family();
+}
+
+string ResultStreamMergeImpl::ColumnName() const {
+    return _cur_stream->ColumnName();
+}
+
+string ResultStreamMergeImpl::Qualifier() const {
+    return _cur_stream->Qualifier();
+}
+
+int64_t ResultStreamMergeImpl::Timestamp() const {
+    return _cur_stream->Timestamp();
+}
+
+string ResultStreamMergeImpl::Value() const {
+    return _cur_stream->Value();
+}
+
 ///////////////////////// ScanDescImpl ///////////////////////
 
 ScanDescImpl::ScanDescImpl(const string& rowkey)
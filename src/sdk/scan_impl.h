@@ -150,6 +150,33 @@ private:
     bool _finish;
 };
 
+// Merges the scans of all hash buckets of a table, see EncodeHashRowKey().
+// Rows come out in the order of their user keys, without the bucket prefix.
+class ResultStreamMergeImpl : public ResultStream {
+public:
+    ResultStreamMergeImpl(const std::vector<ResultStream*>& streams);
+    virtual ~ResultStreamMergeImpl();
+
+    bool LookUp(const std::string& row_key);
+    bool Done();
+    void Next();
+
+    std::string RowName() const;
+    std::string Family() const;
+    std::string ColumnName() const;
+    std::string Qualifier() const;
+    int64_t Timestamp() const;
+    std::string Value() const;
+
+private:
+    void PickStream();
+
+private:
+    std::vector<ResultStream*> _streams;
+    ResultStream* _cur_stream;
+    std::string _cur_row;
+};
+
 struct ScanTask : public SdkTask {
     ResultStreamImpl* stream;
     tera::ScanTabletRequest* request;
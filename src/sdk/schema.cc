@@ -111,6 +111,22 @@ int64_t TableDescriptor::MergeSize() const {
     return _impl->MergeSize();
 }
 
+void TableDescriptor::SetScheduleWeight(int32_t weight) {
+    _impl->SetScheduleWeight(weight);
+}
+
+int32_t TableDescriptor::ScheduleWeight() const {
+    return _impl->ScheduleWeight();
+}
+
+void TableDescriptor::SetHashBucketNum(int32_t bucket_num) {
+    _impl->SetHashBucketNum(bucket_num);
+}
+
+int32_t TableDescriptor::HashBucketNum() const {
+    return _impl->HashBucketNum();
+}
+
 int32_t TableDescriptor::AddSnapshot(uint64_t snapshot) {
     return _impl->AddSnapshot(snapshot);
 }
@@ -104,6 +104,8 @@ LGDescImpl::LGDescImpl(const std::string& lg_name, int32_t id)
       _use_memtable_on_leveldb(false),
       _memtable_ldb_write_buffer_size(0),
       _memtable_ldb_block_size(0),
+      _block_hash_index(false),
+      _compress_dict_size(kDefaultCompressDictSize),
       _sst_size(FLAGS_tera_tablet_ldb_sst_size << 20){
 }
 
@@ -176,6 +178,22 @@ void LGDescImpl::SetMemtableLdbBlockSize(int32_t block_size) {
     _memtable_ldb_block_size = block_size;
 }
 
+bool LGDescImpl::BlockHashIndex() const {
+    return _block_hash_index;
+}
+
+void LGDescImpl::SetBlockHashIndex(bool block_hash_index) {
+    _block_hash_index = block_hash_index;
+}
+
+int32_t LGDescImpl::CompressDictSize() const {
+    return _compress_dict_size;
+}
+
+void LGDescImpl::SetCompressDictSize(int32_t dict_size) {
+    _compress_dict_size = dict_size;
+}
+
 int32_t LGDescImpl::SstSize() const {
     return _sst_size;
 }
@@ -192,7 +210,9 @@ TableDescImpl::TableDescImpl(const std::string& tb_name, bool is_kv)
       _next_cf_id(0),
       _raw_key_type(kReadable),
       _split_size(FLAGS_tera_master_split_tablet_size),
-      _merge_size(FLAGS_tera_master_merge_tablet_size) {
+      _merge_size(FLAGS_tera_master_merge_tablet_size),
+      _schedule_weight(1),
+      _hash_bucket_num(0) {
 }
 
 /*
@@ -397,6 +417,22 @@ int64_t TableDescImpl::MergeSize() const {
     return _merge_size;
 }
 
+void TableDescImpl::SetScheduleWeight(int32_t weight) {
+    _schedule_weight = weight;
+}
+
+int32_t TableDescImpl::ScheduleWeight() const {
+    return _schedule_weight;
+}
+
+void TableDescImpl::SetHashBucketNum(int32_t bucket_num) {
+    _hash_bucket_num = bucket_num;
+}
+
+int32_t TableDescImpl::HashBucketNum() const {
+    return _hash_bucket_num;
+}
+
 /// 插入snapshot
 int32_t TableDescImpl::AddSnapshot(uint64_t snapshot) {
     _snapshots.push_back(snapshot);
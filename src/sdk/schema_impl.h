@@ -65,6 +65,11 @@ private:
     std::string _type;
 };
 
+/// zlib_dict 字典大小(KB), 同 LocalityGroupSchema.compress_dict_size 的默认值
+const int32_t kDefaultCompressDictSize = 16;
+/// zlib 字典不能超过压缩窗口(32KB)
+const int32_t kMaxCompressDictSize = 32;
+
 /// 局部性群组描述
 class LGDescImpl : public LocalityGroupDescriptor {
 public:
@@ -112,6 +117,16 @@ public:
 
     void SetMemtableLdbBlockSize(int32_t block_size);
 
+    /// Hash index of row keys in each block (disable/enable)
+    bool BlockHashIndex() const;
+
+    void SetBlockHashIndex(bool block_hash_index);
+
+    /// Dictionary size of zlib_dict compress, in KB
+    int32_t CompressDictSize() const;
+
+    void SetCompressDictSize(int32_t dict_size);
+
     /// sst file size, in Bytes
     int32_t SstSize() const;
     void SetSstSize(int32_t sst_size);
@@ -126,6 +141,8 @@ private:
     bool            _use_memtable_on_leveldb;
     int32_t         _memtable_ldb_write_buffer_size;
     int32_t         _memtable_ldb_block_size;
+    bool            _block_hash_index;
+    int32_t         _compress_dict_size; // in KB
     int32_t         _sst_size; // in bytes
 };
 
@@ -171,6 +188,12 @@ public:
     void SetMergeSize(int64_t size);
     int64_t MergeSize() const;
 
+    void SetScheduleWeight(int32_t weight);
+    int32_t ScheduleWeight() const;
+
+    void SetHashBucketNum(int32_t bucket_num);
+    int32_t HashBucketNum() const;
+
     /// 插入snapshot
     int32_t AddSnapshot(uint64_t snapshot);
     /// 获取snapshot
@@ -197,6 +220,8 @@ private:
     RawKeyType      _raw_key_type;
     int64_t         _split_size;
     int64_t         _merge_size;
+    int32_t         _schedule_weight;
+    int32_t         _hash_bucket_num;
 };
 
 } // namespace tera
@@ -9,12 +9,14 @@
 #include <iostream>
 
 #include "common/base/string_ext.h"
+#include "common/base/string_format.h"
 #include "common/base/string_number.h"
 #include "common/file/file_path.h"
 #include "gflags/gflags.h"
 #include "glog/logging.h"
 
 #include "sdk/filter_utils.h"
+#include "sdk/schema_impl.h"
 DECLARE_int64(tera_tablet_write_block_size);
 DECLARE_int64(tera_tablet_ldb_sst_size);
 DECLARE_int64(tera_master_merge_tablet_size);
@@ -65,6 +67,12 @@ void ShowTableSchema(const TableSchema& schema, bool is_x) {
         if (is_x || schema.merge_size() != FLAGS_tera_master_merge_tablet_size) {
             ss << "mergesize=" << schema.merge_size() << ",";
         }
+        if (is_x || schema.schedule_weight() != 1) {
+            ss << "weight=" << schema.schedule_weight() << ",";
+        }
+        if (is_x || schema.hash_bucket_num() != 0) {
+            ss << "hashbucket=" << schema.hash_bucket_num() << ",";
+        }
         if (is_x || lg_schema.store_type() != DiskStore) {
             ss << "storage=" << LgProp2Str(lg_schema.store_type()) << ",";
         }
@@ -84,6 +92,12 @@ void ShowTableSchema(const TableSchema& schema, bool is_x) {
     if (is_x || schema.merge_size() != FLAGS_tera_master_merge_tablet_size) {
         ss << "mergesize=" << schema.merge_size() << ",";
     }
+    if (is_x || schema.schedule_weight() != 1) {
+        ss << "weight=" << schema.schedule_weight() << ",";
+    }
+    if (is_x || schema.hash_bucket_num() != 0) {
+        ss << "hashbucket=" << schema.hash_bucket_num() << ",";
+    }
     ss << "\b> {" << std::endl;
 
     size_t lg_num = schema.locality_groups_size();
@@ -92,6 +106,12 @@ void ShowTableSchema(const TableSchema& schema, bool is_x) {
         const LocalityGroupSchema& lg_schema = schema.locality_groups(lg_no);
         ss << "      " << lg_schema.name() << " <";
         ss << "storage=" << LgProp2Str(lg_schema.store_type()) << ",";
+        if (lg_schema.compress_type() && lg_schema.compress_with_dict()) {
+            ss << "compress=zlib_dict,";
+            if (is_x || lg_schema.compress_dict_size() != kDefaultCompressDictSize) {
+                ss << "compress_dict_size=" << lg_schema.compress_dict_size() << ",";
+            }
+        }
         if (is_x || lg_schema.block_size() != FLAGS_tera_tablet_write_block_size) {
             ss << "blocksize=" << lg_schema.block_size() << ",";
         }
@@ -106,6 +126,9 @@ void ShowTableSchema(const TableSchema& schema, bool is_x) {
                 << ",memtable_ldb_block_size="
                 << lg_schema.memtable_ldb_block_size() << ",";
         }
+        if (lg_schema.block_hash_index()) {
+            ss << "block_hash_index=true,";
+        }
         ss << "\b> {" << std::endl;
         for (size_t cf_no = 0; cf_no < cf_num; ++cf_no) {
             const ColumnFamilySchema& cf_schema = schema.column_families(cf_no);
@@ -170,6 +193,8 @@ void TableDescToSchema(const TableDescriptor& desc, TableSchema* schema) {
     }
     schema->set_split_size(desc.SplitSize());
     schema->set_merge_size(desc.MergeSize());
+    schema->set_schedule_weight(desc.ScheduleWeight());
+    schema->set_hash_bucket_num(desc.HashBucketNum());
     schema->set_kv_only(desc.IsKv());
 
     // add lg
@@ -179,6 +204,7 @@ void TableDescToSchema(const TableDescriptor& desc, TableSchema* schema) {
         const LocalityGroupDescriptor* lgdesc = desc.LocalityGroup(i);
         lg->set_block_size(lgdesc->BlockSize());
         lg->set_compress_type(lgdesc->Compress() != kNoneCompress);
+        lg->set_compress_with_dict(lgdesc->Compress() == kZlibDictCompress);
         lg->set_name(lgdesc->Name());
         // printf("add lg %s\n", lgdesc->Name().c_str());
         switch (lgdesc->Store()) {
@@ -197,6 +223,8 @@ void TableDescToSchema(const TableDescriptor& desc, TableSchema* schema) {
             lg->set_memtable_ldb_write_buffer_size(lgdesc->MemtableLdbWriteBufferSize());
             lg->set_memtable_ldb_block_size(lgdesc->MemtableLdbBlockSize());
         }
+        lg->set_block_hash_index(lgdesc->BlockHashIndex());
+        lg->set_compress_dict_size(lgdesc->CompressDictSize());
         lg->set_sst_size(lgdesc->SstSize());
         lg->set_id(lgdesc->Id());
     }
@@ -236,6 +264,12 @@ void TableSchemaToDesc(const TableSchema& schema, TableDescriptor* desc) {
     if (schema.has_merge_size()) {
         desc->SetMergeSize(schema.merge_size());
     }
+    if (schema.has_schedule_weight()) {
+        desc->SetScheduleWeight(schema.schedule_weight());
+    }
+    if (schema.has_hash_bucket_num()) {
+        desc->SetHashBucketNum(schema.hash_bucket_num());
+    }
 
     int32_t lg_num = schema.locality_groups_size();
     for (int32_t i = 0; i < lg_num; i++) {
@@ -256,11 +290,19 @@ void TableSchemaToDesc(const TableSchema& schema, TableDescriptor* desc) {
                 lgd->SetStore(kInDisk);
                 break;
         }
-        lgd->SetCompress(lg.compress_type() ? kSnappyCompress : kNoneCompress);
+        if (!lg.compress_type()) {
+            lgd->SetCompress(kNoneCompress);
+        } else if (lg.compress_with_dict()) {
+            lgd->SetCompress(kZlibDictCompress);
+        } else {
+            lgd->SetCompress(kSnappyCompress);
+        }
         lgd->SetUseBloomfilter(lg.use_bloom_filter());
         lgd->SetUseMemtableOnLeveldb(lg.use_memtable_on_leveldb());
         lgd->SetMemtableLdbWriteBufferSize(lg.memtable_ldb_write_buffer_size());
         lgd->SetMemtableLdbBlockSize(lg.memtable_ldb_block_size());
+        lgd->SetBlockHashIndex(lg.block_hash_index());
+        lgd->SetCompressDictSize(lg.compress_dict_size());
         lgd->SetSstSize(lg.sst_size());
     }
     int32_t cf_num = schema.column_families_size();
@@ -330,6 +372,8 @@ bool SetLgProperties(const PropertyList& props, LocalityGroupDescriptor* desc) {
                 desc->SetCompress(kNoneCompress);
             } else if (prop.second == "snappy") {
                 desc->SetCompress(kSnappyCompress);
+            } else if (prop.second == "zlib_dict") {
+                desc->SetCompress(kZlibDictCompress);
             } else {
                 LOG(ERROR) << "illegal value: " << prop.second
                     << " for property: " << prop.first;
@@ -381,6 +425,24 @@ bool SetLgProperties(const PropertyList& props, LocalityGroupDescriptor* desc) {
                 return false;
             }
             desc->SetMemtableLdbBlockSize(block_size);
+        } else if (prop.first == "compress_dict_size") {
+            int32_t dict_size = atoi(prop.second.c_str()); //KB
+            if (dict_size <= 0 || dict_size > kMaxCompressDictSize) {
+                LOG(ERROR) << "illegal value: " << prop.second
+                           << " for property: " << prop.first;
+                return false;
+            }
+            desc->SetCompressDictSize(dict_size);
+        } else if (prop.first == "block_hash_index") {
+            if (prop.second == "true") {
+                desc->SetBlockHashIndex(true);
+            } else if (prop.second == "false") {
+                desc->SetBlockHashIndex(false);
+            } else {
+                LOG(ERROR) << "illegal value: " << prop.second
+                           << " for property: " << prop.first;
+                return false;
+            }
         } else if (prop.first == "sst_size") {
             int32_t sst_size = atoi(prop.second.c_str());
             if (sst_size <= 0) {
@@ -428,6 +490,23 @@ bool SetTableProperties(const PropertyList& props, TableDescriptor* desc) {
                 return false;
             }
             desc->SetMergeSize(mergesize);
+        } else if (prop.first == "weight") {
+            int weight = atoi(prop.second.c_str());
+            if (weight <= 0) {
+                LOG(ERROR) << "illegal value: " << prop.second
+                    << " for property: " << prop.first;
+                return false;
+            }
+            desc->SetScheduleWeight(weight);
+        } else if (prop.first == "hashbucket") {
+            int64_t bucket_num = atoll(prop.second.c_str());
+            // bucket_num == 0 : not hashed
+            if (bucket_num < 0 || bucket_num > kMaxHashBucketNum) {
+                LOG(ERROR) << "illegal value: " << prop.second
+                    << " for property: " << prop.first;
+                return false;
+            }
+            desc->SetHashBucketNum(bucket_num);
         } else {
             LOG(ERROR) << "illegal table property: " << prop.first;
             return false;
@@ -476,6 +555,8 @@ bool SetLgProperties(const string& name, const string& value,
             desc->SetCompress(kNoneCompress);
         } else if (value == "snappy") {
             desc->SetCompress(kSnappyCompress);
+        } else if (value == "zlib_dict") {
+            desc->SetCompress(kZlibDictCompress);
         } else {
             return false;
         }
@@ -515,6 +596,20 @@ bool SetLgProperties(const string& name, const string& value,
             return false;
         }
         desc->SetMemtableLdbBlockSize(block_size);
+    } else if (name == "compress_dict_size") {
+        int32_t dict_size = atoi(value.c_str()); //KB
+        if (dict_size <= 0 || dict_size > kMaxCompressDictSize) {
+            return false;
+        }
+        desc->SetCompressDictSize(dict_size);
+    } else if (name == "block_hash_index") {
+        if (value == "true") {
+            desc->SetBlockHashIndex(true);
+        } else if (value == "false") {
+            desc->SetBlockHashIndex(false);
+        } else {
+            return false;
+        }
     } else if (name == "sst_size") {
         int32_t sst_size = atoi(value.c_str());
         if (sst_size <= 0) {
@@ -551,6 +646,19 @@ bool SetTableProperties(const string& name, const string& value,
             return false;
         }
         desc->SetMergeSize(mergesize);
+    } else if (name == "weight") {
+        int weight = atoi(value.c_str());
+        if (weight <= 0) {
+            return false;
+        }
+        desc->SetScheduleWeight(weight);
+    } else if (name == "hashbucket") {
+        int64_t bucket_num = atoll(value.c_str());
+        // bucket_num == 0 : not hashed
+        if (bucket_num < 0 || bucket_num > kMaxHashBucketNum) {
+            return false;
+        }
+        desc->SetHashBucketNum(bucket_num);
     } else {
         return false;
     }
@@ -574,7 +682,8 @@ bool ParsePrefixPropertyValue(const string& pair, string& prefix, string& proper
 string PrefixType(const std::string& property) {
     string lg_prop[] = {
         "compress", "storage", "blocksize", "use_memtable_on_leveldb",
-        "memtable_ldb_write_buffer_size", "memtable_ldb_block_size", "sst_size"};
+        "memtable_ldb_write_buffer_size", "memtable_ldb_block_size", "sst_size",
+        "block_hash_index", "compress_dict_size"};
     string cf_prop[] = {"ttl", "maxversions", "minversions", "diskquota"};
 
     std::set<string> lgset(lg_prop, lg_prop + sizeof(lg_prop) / sizeof(lg_prop[0]));
@@ -905,4 +1014,56 @@ bool BuildSchema(TableDescriptor* table_desc, string* schema) {
     }
     return true;
 }
+
+// copy from leveldb/util/hash.h
+uint32_t Hash(const char* data, size_t n, uint32_t seed) {
+    // Similar to murmur hash
+    const uint32_t m = 0xc6a4a793;
+    const uint32_t r = 24;
+    const char* limit = data + n;
+    uint32_t h = seed ^ (n * m);
+
+    // Pick up four bytes at a time
+    while (data + 4 <= limit) {
+        uint32_t w = *(uint32_t*)data;
+        data += 4;
+        h += w;
+        h *= m;
+        h ^= (h >> 16);
+    }
+
+    // Pick up remaining bytes
+    switch (limit - data) {
+    case 3:
+        h += data[2] << 16;
+    case 2:
+        h += data[1] << 8;
+    case 1:
+        h += data[0];
+        h *= m;
+        h ^= (h >> r);
+    break;
+    }
+    return h;
+}
+
+string HashBucketPrefix(int32_t bucket) {
+    return StringFormat("%08d", bucket);
+}
+
+string EncodeHashRowKey(const string& row_key, int32_t bucket_num) {
+    if (bucket_num <= 0) {
+        return row_key;
+    }
+    int32_t bucket = Hash(row_key.data(), row_key.size(), 0) % bucket_num;
+    return HashBucketPrefix(bucket) + row_key;
+}
+
+string DecodeHashRowKey(const string& key) {
+    if (key.size() < kHashBucketPrefixLen) {
+        return key;
+    }
+    return key.substr(kHashBucketPrefixLen);
+}
+
 } // namespace tera
@@ -51,5 +51,22 @@ bool ParsePrefixPropertyValue(const string& pair, string& prefix, string& proper
 
 string PrefixType(const std::string& property);
 
+// copy from leveldb/util/hash.h
+uint32_t Hash(const char* data, size_t n, uint32_t seed);
+
+// A table with hash buckets stores every row under the zero-padded id of
+// its bucket, e.g. "00000003" + row_key, so that each bucket is a
+// contiguous key range and can be pre-split into its own tablet.
+const size_t kHashBucketPrefixLen = 8;
+// bucket ids must fit in the prefix
+const int64_t kMaxHashBucketNum = 99999999;
+
+string HashBucketPrefix(int32_t bucket);
+
+// returns row_key itself if bucket_num is 0
+string EncodeHashRowKey(const string& row_key, int32_t bucket_num);
+
+string DecodeHashRowKey(const string& key);
+
 } // namespace tera
 #endif // TERA_SDK_SDK_UTILS_H_
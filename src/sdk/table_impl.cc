@@ -25,6 +25,7 @@
 #include "sdk/read_impl.h"
 #include "sdk/scan_impl.h"
 #include "sdk/schema_impl.h"
+#include "sdk/sdk_utils.h"
 #include "sdk/sdk_zk.h"
 #include "sdk/tera.h"
 #include "utils/string_util.h"
@@ -48,6 +49,7 @@ DECLARE_bool(tera_sdk_cookie_enabled);
 DECLARE_string(tera_sdk_cookie_path);
 DECLARE_int32(tera_sdk_cookie_update_interval);
 DECLARE_bool(tera_sdk_pend_request_while_scan_meta_enabled);
+DECLARE_bool(tera_sdk_read_coalescing_enabled);
 
 namespace tera {
 
@@ -234,8 +236,16 @@ ResultStream* TableImpl::Scan(const ScanDescriptor& desc, ErrorCode* err) {
             return NULL;
         }
     }
+    int32_t bucket_num = HashBucketNum();
+    if (bucket_num > 0) {
+        return ScanHashBuckets(impl, bucket_num);
+    }
+    return NewResultStream(impl);
+}
+
+ResultStream* TableImpl::NewResultStream(ScanDescImpl* impl) {
     ResultStream * results = NULL;
-    if (desc.IsAsync() && !IsKvOnlyTable()) {
+    if (impl->IsAsync() && !IsKvOnlyTable()) {
         VLOG(6) << "activate async-scan";
         results = new ResultStreamAsyncImpl(this, impl);
     } else {
@@ -245,6 +255,28 @@ ResultStream* TableImpl::Scan(const ScanDescriptor& desc, ErrorCode* err) {
     return results;
 }
 
+ResultStream* TableImpl::ScanHashBuckets(ScanDescImpl* impl, int32_t bucket_num) {
+    // a user key range maps to the same range in every bucket,
+    // scan them all at once and merge by user key
+    std::vector<ResultStream*> streams;
+    for (int32_t i = 0; i < bucket_num; ++i) {
+        std::string prefix = HashBucketPrefix(i);
+        ScanDescImpl bucket_impl(*impl);
+        bucket_impl.SetStart(prefix + impl->GetStartRowKey(),
+                             impl->GetStartColumnFamily(),
+                             impl->GetStartQualifier(),
+                             impl->GetStartTimeStamp());
+        if (impl->GetEndRowKey() != "") {
+            bucket_impl.SetEnd(prefix + impl->GetEndRowKey());
+        } else if (i + 1 < bucket_num) {
+            bucket_impl.SetEnd(HashBucketPrefix(i + 1));
+        }
+        streams.push_back(NewResultStream(&bucket_impl));
+    }
+    VLOG(6) << "scan " << bucket_num << " hash buckets";
+    return new ResultStreamMergeImpl(streams);
+}
+
 void TableImpl::ScanTabletSync(ResultStreamSyncImpl* stream) {
     ScanTabletAsync(stream);
     stream->Wait();
@@ -306,6 +338,13 @@ void TableImpl::CommitScan(ScanTask* scan_task,
         tera::ColumnFamily* column_family = request->add_cf_list();
         column_family->CopyFrom(*(impl->GetColumnFamily(i)));
     }
+    // scans have no timeout of their own, the table timeout is used
+    int64_t timeout = _timeout;
+    if (timeout > 0 && timeout < FLAGS_tera_rpc_timeout_period) {
+        request->set_timeout(timeout);
+    } else {
+        request->set_timeout(FLAGS_tera_rpc_timeout_period);
+    }
 
     Closure<void, ScanTabletRequest*, ScanTabletResponse*, bool, int>* done =
         NewClosure(this, &TableImpl::ScanCallBack, scan_task);
@@ -386,6 +425,14 @@ bool TableImpl::IsKvOnlyTable() {
     return false;
 }
 
+int32_t TableImpl::HashBucketNum() {
+    return _table_schema.hash_bucket_num();
+}
+
+std::string TableImpl::EncodeRowKey(const std::string& row_key) {
+    return EncodeHashRowKey(row_key, HashBucketNum());
+}
+
 bool TableImpl::OpenInternal(ErrorCode* err) {
     if (!UpdateTableMeta(err)) {
         return false;
@@ -439,7 +486,7 @@ void TableImpl::ApplyMutation(const std::vector<RowMutationImpl*>& mu_list,
         }
 
         std::string server_addr;
-        if (!GetTabletAddrOrScheduleUpdateMeta(row_mutation->RowKey(),
+        if (!GetTabletAddrOrScheduleUpdateMeta(EncodeRowKey(row_mutation->RowKey()),
                                                row_mutation, &server_addr)) {
             continue;
         }
@@ -556,7 +603,7 @@ void TableImpl::CommitMutation(const std::string& server_addr,
     for (uint32_t i = 0; i < mu_list->size(); ++i) {
         RowMutationImpl* row_mutation = (*mu_list)[i];
         RowMutationSequence* mu_seq = request->add_row_list();
-        mu_seq->set_row_key(row_mutation->RowKey());
+        mu_seq->set_row_key(EncodeRowKey(row_mutation->RowKey()));
         for (uint32_t j = 0; j < row_mutation->MutationNum(); j++) {
             const RowMutation::Mutation& mu = row_mutation->GetMutation(j);
             tera::Mutation* mutation = mu_seq->add_mutation_sequence();
@@ -613,7 +660,7 @@ void TableImpl::MutateCallBack(std::vector<RowMutationImpl*>* mu_list,
             row_mutation->RunCallback();
         } else if (row_mutation->RetryTimes() >= static_cast<uint32_t>(FLAGS_tera_sdk_retry_times)) {
             if (err == kKeyNotInRange || err == kConnectError) {
-                ScheduleUpdateMeta(row_mutation->RowKey(),
+                ScheduleUpdateMeta(EncodeRowKey(row_mutation->RowKey()),
                                    row_mutation->GetMetaTimeStamp());
             }
             std::string err_reason = StringFormat("Reach the limit of retry times, error: %s",
@@ -707,7 +754,7 @@ void TableImpl::ReadRows(const std::vector<RowReaderImpl*>& row_reader_list,
         }
 
         std::string server_addr;
-        if (!GetTabletAddrOrScheduleUpdateMeta(row_reader->RowName(), row_reader,
+        if (!GetTabletAddrOrScheduleUpdateMeta(EncodeRowKey(row_reader->RowName()), row_reader,
                                                &server_addr)) {
             continue;
         }
@@ -802,19 +849,67 @@ void TableImpl::CommitReaders(const std::string server_addr,
     ReadTabletResponse* response = new ReadTabletResponse;
     request->set_sequence_id(_last_sequence_id++);
     request->set_tablet_name(_name);
+    std::vector<uint32_t>* slot_list = new std::vector<uint32_t>;
+    PackReaders(*reader_list, request, slot_list);
+    if (request->row_info_list_size() < static_cast<int>(reader_list->size())) {
+        VLOG(10) << "coalesce " << reader_list->size() << " readers into "
+            << request->row_info_list_size() << " rows";
+    }
+
+    // the rpc is useless to the client once the last reader times out,
+    // -1 if some reader never times out
+    int64_t max_timeout = 0;
     for (uint32_t i = 0; i < reader_list->size(); ++i) {
         RowReaderImpl* row_reader = (*reader_list)[i];
-        RowReaderInfo* row_reader_info = request->add_row_info_list();
-        request->set_snapshot_id(row_reader->GetSnapshot());
-        row_reader->ToProtoBuf(row_reader_info);
-        // row_reader_info->CopyFrom(row_reader->GetRowReaderInfo());
+        int64_t row_timeout = row_reader->TimeOut() > 0 ? row_reader->TimeOut() : _timeout;
+        if (row_timeout <= 0) {
+            max_timeout = -1;
+        } else if (max_timeout >= 0 && row_timeout > max_timeout) {
+            max_timeout = row_timeout;
+        }
+    }
+    if (max_timeout > 0 && max_timeout < FLAGS_tera_rpc_timeout_period) {
+        request->set_timeout(max_timeout);
+    } else {
+        request->set_timeout(FLAGS_tera_rpc_timeout_period);
     }
     Closure<void, ReadTabletRequest*, ReadTabletResponse*, bool, int>* done =
-        NewClosure(this, &TableImpl::ReaderCallBack, reader_list);
+        NewClosure(this, &TableImpl::ReaderCallBack, reader_list, slot_list);
     tabletnode_client_async.ReadTablet(request, response, done);
 }
 
+void TableImpl::PackReaders(const std::vector<RowReaderImpl*>& reader_list,
+                            ReadTabletRequest* request,
+                            std::vector<uint32_t>* slot_list) {
+    // readers of the same row, columns, time range and snapshot are sent
+    // once and share the result
+    typedef std::map<std::pair<uint64_t, std::string>, uint32_t> SlotMap;
+    SlotMap slot_map;
+    slot_list->resize(reader_list.size());
+    for (uint32_t i = 0; i < reader_list.size(); ++i) {
+        RowReaderImpl* row_reader = reader_list[i];
+        RowReaderInfo row_reader_info;
+        row_reader->ToProtoBuf(&row_reader_info);
+        row_reader_info.set_key(EncodeRowKey(row_reader->RowName()));
+        uint32_t slot = request->row_info_list_size();
+        if (FLAGS_tera_sdk_read_coalescing_enabled) {
+            std::pair<SlotMap::iterator, bool> insert_ret = slot_map.insert(
+                std::make_pair(std::make_pair(row_reader->GetSnapshot(),
+                                              row_reader_info.SerializeAsString()),
+                               slot));
+            if (!insert_ret.second) {
+                (*slot_list)[i] = insert_ret.first->second;
+                continue;
+            }
+        }
+        (*slot_list)[i] = slot;
+        request->set_snapshot_id(row_reader->GetSnapshot());
+        request->add_row_info_list()->Swap(&row_reader_info);
+    }
+}
+
 void TableImpl::ReaderCallBack(std::vector<RowReaderImpl*>* reader_list,
+                               std::vector<uint32_t>* slot_list,
                                ReadTabletRequest* request,
                                ReadTabletResponse* response,
                                bool failed, int error_code) {
@@ -836,10 +931,12 @@ void TableImpl::ReaderCallBack(std::vector<RowReaderImpl*>* reader_list,
         }
     }
 
-    std::map<uint32_t, std::vector<RowReaderImpl*>* > retry_times_list;
-    std::vector<RowReaderImpl*>* not_in_range_list = NULL;
-    uint32_t row_result_num = 0;
-    for (uint32_t i = 0; i < reader_list->size(); ++i) {
+    // status and index in row_result of each row in the request
+    int32_t row_num = request->row_info_list_size();
+    std::vector<StatusCode> row_status(row_num);
+    std::vector<int32_t> row_result_index(row_num, -1);
+    int32_t row_result_num = 0;
+    for (int32_t i = 0; i < row_num; ++i) {
         StatusCode err = response->status();
         if (err == kTabletNodeOk) {
             err = response->detail().status(i);
@@ -848,11 +945,22 @@ void TableImpl::ReaderCallBack(std::vector<RowReaderImpl*>* reader_list,
             VLOG(10) << "fail to read table: " << _name
                 << " errcode: " << StatusCodeToString(err);
         }
+        row_status[i] = err;
+        if (err == kTabletNodeOk) {
+            row_result_index[i] = row_result_num++;
+        }
+    }
+
+    std::map<uint32_t, std::vector<RowReaderImpl*>* > retry_times_list;
+    std::vector<RowReaderImpl*>* not_in_range_list = NULL;
+    for (uint32_t i = 0; i < reader_list->size(); ++i) {
+        uint32_t slot = (*slot_list)[i];
+        StatusCode err = row_status[slot];
 
         RowReaderImpl* row_reader = (*reader_list)[i];
         row_reader->SetInternalError(err);
         if (err == kTabletNodeOk) {
-            row_reader->SetResult(response->detail().row_result(row_result_num++));
+            row_reader->SetResult(response->detail().row_result(row_result_index[slot]));
             row_reader->SetError(ErrorCode::kOK);
             row_reader->RunCallback();
             // only for flow control
@@ -869,7 +977,7 @@ void TableImpl::ReaderCallBack(std::vector<RowReaderImpl*>* reader_list,
             _cur_reader_pending_counter.Dec();
         } else if (row_reader->RetryTimes() >= static_cast<uint32_t>(FLAGS_tera_sdk_retry_times)) {
             if (err == kKeyNotInRange || err == kConnectError) {
-                ScheduleUpdateMeta(row_reader->RowName(),
+                ScheduleUpdateMeta(EncodeRowKey(row_reader->RowName()),
                                    row_reader->GetMetaTimeStamp());
             }
             std::string err_reason = StringFormat("Reach the limit of retry times, error: %s",
@@ -914,6 +1022,7 @@ void TableImpl::ReaderCallBack(std::vector<RowReaderImpl*>* reader_list,
     delete request;
     delete response;
     delete reader_list;
+    delete slot_list;
 }
 
 void TableImpl::RetryReadRows(std::vector<RowReaderImpl*>* retry_reader_list) {
@@ -1804,38 +1913,6 @@ void TableImpl::EnableCookieUpdateTimer() {
     _thread_pool->DelayTask(FLAGS_tera_sdk_cookie_update_interval * 1000, closure);
 }
 
-// copy from leveldb/util/hash.h
-static uint32_t Hash(const char* data, size_t n, uint32_t seed) {
-    // Similar to murmur hash
-    const uint32_t m = 0xc6a4a793;
-    const uint32_t r = 24;
-    const char* limit = data + n;
-    uint32_t h = seed ^ (n * m);
-
-    // Pick up four bytes at a time
-    while (data + 4 <= limit) {
-        uint32_t w = *(uint32_t*)data;
-        data += 4;
-        h += w;
-        h *= m;
-        h ^= (h >> 16);
-    }
-
-    // Pick up remaining bytes
-    switch (limit - data) {
-    case 3:
-        h += data[2] << 16;
-    case 2:
-        h += data[1] << 8;
-    case 1:
-        h += data[0];
-        h *= m;
-        h ^= (h >> r);
-    break;
-    }
-    return h;
-}
-
 std::string TableImpl::GetCookieFileName(const std::string& tablename,
                                          const std::string& zk_addr,
                                          const std::string& zk_path) {
@@ -186,7 +186,16 @@ public:
 
     bool IsKvOnlyTable();
 
+    int32_t HashBucketNum();
+
+    // the key a row is stored under, see EncodeHashRowKey()
+    std::string EncodeRowKey(const std::string& row_key);
+
 private:
+    ResultStream* NewResultStream(ScanDescImpl* impl);
+
+    ResultStream* ScanHashBuckets(ScanDescImpl* impl, int32_t bucket_num);
+
     bool ScanTabletNode(const TabletMeta & tablet_meta,
                         const std::string& key_start,
                         const std::string& key_end,
@@ -223,7 +232,15 @@ private:
     void CommitReaders(const std::string server_addr,
                        std::vector<RowReaderImpl*>* reader_list);
 
+    // add the rows of "reader_list" to "request", one row per distinct read,
+    // slot_list[i] is the row read for reader_list[i]
+    void PackReaders(const std::vector<RowReaderImpl*>& reader_list,
+                     ReadTabletRequest* request,
+                     std::vector<uint32_t>* slot_list);
+
+    // slot_list[i] is the row in request read for reader_list[i]
     void ReaderCallBack(std::vector<RowReaderImpl*>* reader_list,
+                        std::vector<uint32_t>* slot_list,
                         ReadTabletRequest* request,
                         ReadTabletResponse* response,
                         bool failed, int error_code);
@@ -45,6 +45,7 @@ const char* strerr(ErrorCode error_code);
 enum CompressType {
     kNoneCompress = 1,
     kSnappyCompress = 2,
+    kZlibDictCompress = 3,
 };
 
 enum StoreType {
@@ -132,6 +133,12 @@ public:
     /// Memtable-LDB Block Size
     virtual int32_t MemtableLdbBlockSize() const = 0;
     virtual void SetMemtableLdbBlockSize(int32_t block_size) = 0;
+    /// Hash index of row keys in each block (disable/enable)
+    virtual bool BlockHashIndex() const = 0;
+    virtual void SetBlockHashIndex(bool block_hash_index) = 0;
+    /// Dictionary size of zlib_dict compress, in KB
+    virtual int32_t CompressDictSize() const = 0;
+    virtual void SetCompressDictSize(int32_t dict_size) = 0;
 
     /// sst file size, in Bytes
     virtual int32_t SstSize() const = 0;
@@ -187,6 +194,14 @@ public:
     void SetMergeSize(int64_t size);
     int64_t MergeSize() const;
 
+    /// 读/scan请求调度的权重, 默认为1
+    void SetScheduleWeight(int32_t weight);
+    int32_t ScheduleWeight() const;
+
+    /// hash分桶数, 大于0时rowkey按hash分散到各桶, 默认为0(不分桶)
+    void SetHashBucketNum(int32_t bucket_num);
+    int32_t HashBucketNum() const;
+
     /// 插入snapshot
     int32_t AddSnapshot(uint64_t snapshot);
     /// 获取snapshot
@@ -133,4 +133,49 @@ TEST_F(ScanDescImplTest, ParseFilterString) {
     EXPECT_FALSE(ParseFilterString());
 }
 
+// a bucket scan result of (row, qualifier) cells
+class FakeResultStream : public ResultStream {
+public:
+    FakeResultStream(const std::vector<std::pair<string, string> >& cells)
+        : _cells(cells), _pos(0) {}
+
+    bool LookUp(const string& row_key) { return true; }
+    bool Done() { return _pos >= _cells.size(); }
+    void Next() { ++_pos; }
+
+    string RowName() const { return _cells[_pos].first; }
+    string Family() const { return "cf"; }
+    string ColumnName() const { return "cf:" + Qualifier(); }
+    string Qualifier() const { return _cells[_pos].second; }
+    int64_t Timestamp() const { return 0; }
+    string Value() const { return ""; }
+
+private:
+    std::vector<std::pair<string, string> > _cells;
+    size_t _pos;
+};
+
+TEST(ResultStreamMergeImplTest, MergeBuckets) {
+    std::vector<std::pair<string, string> > bucket0, bucket1, bucket2;
+    bucket0.push_back(std::make_pair("00000000b", "q1"));
+    bucket0.push_back(std::make_pair("00000000b", "q2"));
+    bucket0.push_back(std::make_pair("00000000e", "q1"));
+    bucket1.push_back(std::make_pair("00000001a", "q1"));
+    bucket1.push_back(std::make_pair("00000001c", "q1"));
+    bucket1.push_back(std::make_pair("00000001c", "q2"));
+
+    std::vector<ResultStream*> streams;
+    streams.push_back(new FakeResultStream(bucket0));
+    streams.push_back(new FakeResultStream(bucket1));
+    streams.push_back(new FakeResultStream(bucket2));
+    ResultStreamMergeImpl stream(streams);
+
+    string result;
+    while (!stream.Done()) {
+        result += stream.RowName() + ":" + stream.Qualifier() + ",";
+        stream.Next();
+    }
+    EXPECT_EQ(result, "a:q1,b:q1,b:q2,c:q1,c:q2,e:q1,");
+}
+
 } // namespace tera
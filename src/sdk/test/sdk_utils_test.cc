@@ -4,6 +4,9 @@
 
 #include "sdk/sdk_utils.h"
 
+#include <set>
+
+#include "common/base/string_format.h"
 #include "sdk/scan_impl.h"
 #include "gtest/gtest.h"
 
@@ -195,6 +198,7 @@ TEST(SdkUtils, PrefixType) {
     EXPECT_TRUE(PrefixType("compress") == "lg");
     EXPECT_TRUE(PrefixType("storage") == "lg");
     EXPECT_TRUE(PrefixType("blocksize") == "lg");
+    EXPECT_TRUE(PrefixType("compress_dict_size") == "lg");
     EXPECT_TRUE(PrefixType("ttl") == "cf");
     EXPECT_TRUE(PrefixType("maxversions") == "cf");
     EXPECT_TRUE(PrefixType("minversions") == "cf");
@@ -217,5 +221,51 @@ TEST(SdkUtils, ParsePrefixPropertyValue) {
     EXPECT_FALSE(ParsePrefixPropertyValue("cf123:ttl:3", prefix, property, value));
 }
 
+TEST(SdkUtils, EncodeHashRowKey) {
+    EXPECT_EQ(EncodeHashRowKey("row", 0), "row");
+    EXPECT_EQ(HashBucketPrefix(3), "00000003");
+
+    string key = EncodeHashRowKey("row", 16);
+    EXPECT_EQ(key.size(), kHashBucketPrefixLen + 3);
+    EXPECT_EQ(key, EncodeHashRowKey("row", 16));
+    EXPECT_LT(atoi(key.substr(0, kHashBucketPrefixLen).c_str()), 16);
+    EXPECT_EQ(DecodeHashRowKey(key), "row");
+
+    // monotonic keys spread over the buckets
+    std::set<string> buckets;
+    for (int i = 0; i < 1000; ++i) {
+        key = EncodeHashRowKey(StringFormat("row%08d", i), 16);
+        buckets.insert(key.substr(0, kHashBucketPrefixLen));
+    }
+    EXPECT_EQ(buckets.size(), 16U);
+}
+
+TEST(SdkUtils, SetHashBucketNum) {
+    TableDescriptor desc("t1");
+    EXPECT_TRUE(SetTableProperties("hashbucket", "99999999", &desc));
+    EXPECT_EQ(desc.HashBucketNum(), 99999999);
+    EXPECT_FALSE(SetTableProperties("hashbucket", "100000000", &desc));
+    EXPECT_FALSE(SetTableProperties("hashbucket", "-1", &desc));
+    EXPECT_EQ(desc.HashBucketNum(), 99999999);
+}
+
+TEST(SdkUtils, SetCompressDictSize) {
+    TableDescriptor desc("t1");
+    LocalityGroupDescriptor* lg = desc.AddLocalityGroup("lg0");
+    EXPECT_EQ(lg->CompressDictSize(), 16);
+    EXPECT_TRUE(SetLgProperties("compress", "zlib_dict", lg));
+    EXPECT_TRUE(SetLgProperties("compress_dict_size", "8", lg));
+    EXPECT_FALSE(SetLgProperties("compress_dict_size", "0", lg));
+    EXPECT_FALSE(SetLgProperties("compress_dict_size", "33", lg));
+    EXPECT_EQ(lg->CompressDictSize(), 8);
+
+    TableSchema schema;
+    TableDescToSchema(desc, &schema);
+    EXPECT_EQ(schema.locality_groups(0).compress_dict_size(), 8);
+    TableDescriptor desc2("t1");
+    TableSchemaToDesc(schema, &desc2);
+    EXPECT_EQ(desc2.LocalityGroup("lg0")->CompressDictSize(), 8);
+}
+
 } // namespace sdk
 } // namespace tera
@@ -0,0 +1,232 @@
+// Copyright (c) 2015, Baidu.com, Inc. All Rights Reserved
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#define private public
+
+#include "sdk/table_impl.h"
+
+#include <gflags/gflags.h>
+#include <sofa/pbrpc/pbrpc.h>
+
+#include "common/this_thread.h"
+#include "common/thread_pool.h"
+#include "gtest/gtest.h"
+#include "sdk/read_impl.h"
+
+DECLARE_bool(tera_sdk_cookie_enabled);
+DECLARE_bool(tera_sdk_read_coalescing_enabled);
+DECLARE_int32(tera_sdk_delay_send_internal);
+
+namespace tera {
+
+class TableImplTest : public ::testing::Test {
+public:
+    TableImplTest() : m_thread_pool(2) {
+        FLAGS_tera_sdk_cookie_enabled = false;
+        FLAGS_tera_sdk_read_coalescing_enabled = true;
+        m_table = new TableImpl("table", "", "", &m_thread_pool);
+        // keep the retried readers in the buffers
+        m_table->_commit_size = 10000;
+        m_table->_commit_timeout = 3600000;
+    }
+
+    ~TableImplTest() {
+        m_thread_pool.Stop(false);
+        std::map<std::string, TableImpl::ReaderBuffer>::iterator it =
+            m_table->_reader_buffers.begin();
+        for (; it != m_table->_reader_buffers.end(); ++it) {
+            delete it->second._reader_list;
+        }
+        delete m_table;
+        for (uint32_t i = 0; i < m_readers.size(); ++i) {
+            delete m_readers[i];
+        }
+    }
+
+    RowReaderImpl* NewReader(const std::string& row) {
+        RowReaderImpl* reader = new RowReaderImpl(m_table, row);
+        reader->AddColumnFamily("cf");
+        m_readers.push_back(reader);
+        return reader;
+    }
+
+    // the whole table is served by "server_addr" since "update_time"
+    void SetMeta(const std::string& server_addr, int64_t update_time) {
+        TableImpl::TabletMetaNode& node = m_table->_tablet_meta_list[""];
+        node.meta.set_server_addr(server_addr);
+        node.meta.mutable_key_range()->set_key_start("");
+        node.meta.mutable_key_range()->set_key_end("");
+        node.update_time = update_time;
+    }
+
+    size_t BufferedNum(const std::string& server_addr) {
+        MutexLock lock(&m_table->_reader_buffer_mutex);
+        std::map<std::string, TableImpl::ReaderBuffer>::iterator it =
+            m_table->_reader_buffers.find(server_addr);
+        if (it == m_table->_reader_buffers.end()) {
+            return 0;
+        }
+        return it->second._reader_list->size();
+    }
+
+    void AddResult(ReadTabletResponse* response, const std::string& value) {
+        KeyValuePair* kv = response->mutable_detail()->add_row_result()->add_key_values();
+        kv->set_key("row");
+        kv->set_value(value);
+    }
+
+protected:
+    ThreadPool m_thread_pool;
+    TableImpl* m_table;
+    std::vector<RowReaderImpl*> m_readers;
+};
+
+TEST_F(TableImplTest, PackReaders) {
+    std::vector<RowReaderImpl*> reader_list;
+    reader_list.push_back(NewReader("a"));
+    reader_list.push_back(NewReader("b"));
+    reader_list.push_back(NewReader("a"));
+    reader_list.push_back(NewReader("a"));
+    reader_list.back()->AddColumn("cf", "qu");
+    reader_list.push_back(NewReader("a"));
+    reader_list.back()->SetSnapshot(2);
+    reader_list.push_back(NewReader("b"));
+
+    ReadTabletRequest request;
+    std::vector<uint32_t> slot_list;
+    m_table->PackReaders(reader_list, &request, &slot_list);
+    // the readers of another column or snapshot are not duplicates
+    ASSERT_EQ(request.row_info_list_size(), 4);
+    ASSERT_EQ(slot_list.size(), 6U);
+    EXPECT_EQ(slot_list[0], 0U);
+    EXPECT_EQ(slot_list[1], 1U);
+    EXPECT_EQ(slot_list[2], 0U);
+    EXPECT_EQ(slot_list[3], 2U);
+    EXPECT_EQ(slot_list[4], 3U);
+    EXPECT_EQ(slot_list[5], 1U);
+    EXPECT_EQ(request.row_info_list(0).key(), "a");
+    EXPECT_EQ(request.row_info_list(1).key(), "b");
+
+    FLAGS_tera_sdk_read_coalescing_enabled = false;
+    ReadTabletRequest single_request;
+    m_table->PackReaders(reader_list, &single_request, &slot_list);
+    ASSERT_EQ(single_request.row_info_list_size(), 6);
+    for (uint32_t i = 0; i < slot_list.size(); ++i) {
+        EXPECT_EQ(slot_list[i], i);
+    }
+}
+
+TEST_F(TableImplTest, ReaderCallBackBySlot) {
+    std::vector<RowReaderImpl*>* reader_list = new std::vector<RowReaderImpl*>;
+    reader_list->push_back(NewReader("a"));
+    reader_list->push_back(NewReader("b"));
+    reader_list->push_back(NewReader("a"));
+    reader_list->push_back(NewReader("c"));
+    reader_list->push_back(NewReader("b"));
+    std::vector<RowReaderImpl*> readers(*reader_list);
+
+    ReadTabletRequest* request = new ReadTabletRequest;
+    std::vector<uint32_t>* slot_list = new std::vector<uint32_t>;
+    m_table->PackReaders(*reader_list, request, slot_list);
+    ASSERT_EQ(request->row_info_list_size(), 3);
+
+    // a row not found has no row_result, the result of "c" is the second
+    ReadTabletResponse* response = new ReadTabletResponse;
+    response->set_status(kTabletNodeOk);
+    response->mutable_detail()->add_status(kTabletNodeOk);
+    response->mutable_detail()->add_status(kKeyNotExist);
+    response->mutable_detail()->add_status(kTabletNodeOk);
+    AddResult(response, "value_a");
+    AddResult(response, "value_c");
+    m_table->ReaderCallBack(reader_list, slot_list, request, response, false, 0);
+
+    for (uint32_t i = 0; i < readers.size(); ++i) {
+        EXPECT_TRUE(readers[i]->IsFinished());
+    }
+    EXPECT_EQ(readers[0]->GetError().GetType(), ErrorCode::kOK);
+    EXPECT_EQ(readers[0]->Value(), "value_a");
+    EXPECT_EQ(readers[2]->GetError().GetType(), ErrorCode::kOK);
+    EXPECT_EQ(readers[2]->Value(), "value_a");
+    EXPECT_EQ(readers[3]->GetError().GetType(), ErrorCode::kOK);
+    EXPECT_EQ(readers[3]->Value(), "value_c");
+    EXPECT_EQ(readers[1]->GetError().GetType(), ErrorCode::kNotFound);
+    EXPECT_EQ(readers[4]->GetError().GetType(), ErrorCode::kNotFound);
+}
+
+TEST_F(TableImplTest, ReaderCallBackRetry) {
+    int32_t delay_send_internal = FLAGS_tera_sdk_delay_send_internal;
+    FLAGS_tera_sdk_delay_send_internal = 0;
+    // the tablets moved to "ts2" after the readers were sent
+    SetMeta("ts2:2200", 1);
+
+    std::vector<RowReaderImpl*>* reader_list = new std::vector<RowReaderImpl*>;
+    reader_list->push_back(NewReader("a"));
+    reader_list->push_back(NewReader("b"));
+    reader_list->push_back(NewReader("a"));
+    reader_list->push_back(NewReader("c"));
+    std::vector<RowReaderImpl*> readers(*reader_list);
+
+    ReadTabletRequest* request = new ReadTabletRequest;
+    std::vector<uint32_t>* slot_list = new std::vector<uint32_t>;
+    m_table->PackReaders(*reader_list, request, slot_list);
+    ASSERT_EQ(request->row_info_list_size(), 3);
+
+    ReadTabletResponse* response = new ReadTabletResponse;
+    response->set_status(kTabletNodeOk);
+    response->mutable_detail()->add_status(kKeyNotInRange);
+    response->mutable_detail()->add_status(kTabletNodeIsBusy);
+    response->mutable_detail()->add_status(kTabletNodeOk);
+    AddResult(response, "value_c");
+    m_table->ReaderCallBack(reader_list, slot_list, request, response, false, 0);
+
+    EXPECT_TRUE(readers[3]->IsFinished());
+    EXPECT_EQ(readers[3]->Value(), "value_c");
+
+    // both readers of "a" are sent to the new tabletnode at once
+    EXPECT_EQ(BufferedNum("ts2:2200"), 2U);
+    EXPECT_FALSE(readers[0]->IsFinished());
+    EXPECT_FALSE(readers[2]->IsFinished());
+    EXPECT_EQ(readers[0]->RetryTimes(), 1U);
+    EXPECT_EQ(readers[2]->RetryTimes(), 1U);
+
+    // the busy one after a delay
+    while (BufferedNum("ts2:2200") < 3) {
+        ThisThread::Sleep(1);
+    }
+    EXPECT_FALSE(readers[1]->IsFinished());
+    EXPECT_EQ(readers[1]->RetryTimes(), 1U);
+    EXPECT_EQ(readers[1]->GetInternalError(), kTabletNodeIsBusy);
+
+    FLAGS_tera_sdk_delay_send_internal = delay_send_internal;
+}
+
+TEST_F(TableImplTest, ReaderCallBackRpcFailed) {
+    int32_t delay_send_internal = FLAGS_tera_sdk_delay_send_internal;
+    FLAGS_tera_sdk_delay_send_internal = 0;
+    SetMeta("ts1:2200", 0);
+
+    std::vector<RowReaderImpl*>* reader_list = new std::vector<RowReaderImpl*>;
+    reader_list->push_back(NewReader("a"));
+    reader_list->push_back(NewReader("a"));
+    std::vector<RowReaderImpl*> readers(*reader_list);
+
+    ReadTabletRequest* request = new ReadTabletRequest;
+    std::vector<uint32_t>* slot_list = new std::vector<uint32_t>;
+    m_table->PackReaders(*reader_list, request, slot_list);
+    ASSERT_EQ(request->row_info_list_size(), 1);
+
+    // every reader sharing the row is retried
+    ReadTabletResponse* response = new ReadTabletResponse;
+    m_table->ReaderCallBack(reader_list, slot_list, request, response,
+                            true, sofa::pbrpc::RPC_ERROR_REQUEST_TIMEOUT);
+    while (BufferedNum("ts1:2200") < 2) {
+        ThisThread::Sleep(1);
+    }
+    EXPECT_EQ(readers[0]->GetInternalError(), kRPCTimeout);
+    EXPECT_EQ(readers[1]->GetInternalError(), kRPCTimeout);
+
+    FLAGS_tera_sdk_delay_send_internal = delay_send_internal;
+}
+
+} // namespace tera
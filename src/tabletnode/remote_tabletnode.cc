@@ -11,14 +11,24 @@
 
 #include "tabletnode/tabletnode_impl.h"
 #include "utils/counter.h"
+#include "utils/cpu_affinity.h"
 #include "utils/timer.h"
 
 DECLARE_int32(tera_tabletnode_write_thread_num);
 DECLARE_int32(tera_tabletnode_read_thread_num);
 DECLARE_int32(tera_tabletnode_scan_thread_num);
 DECLARE_int32(tera_tabletnode_manual_compact_thread_num);
+DECLARE_string(tera_tabletnode_write_thread_cpu_set);
+DECLARE_string(tera_tabletnode_read_thread_cpu_set);
+DECLARE_string(tera_tabletnode_scan_thread_cpu_set);
+DECLARE_string(tera_tabletnode_compact_thread_cpu_set);
 DECLARE_int32(tera_request_pending_limit);
 DECLARE_int32(tera_scan_request_pending_limit);
+DECLARE_int32(tera_rpc_timeout_period);
+DECLARE_string(tera_tabletnode_rpc_schedule_policy);
+DECLARE_bool(tera_tabletnode_rpc_drop_expired);
+DECLARE_bool(tera_tabletnode_rpc_work_stealing);
+DECLARE_int32(tera_tabletnode_rpc_steal_max_num);
 
 extern tera::Counter read_pending_counter;
 extern tera::Counter write_pending_counter;
@@ -44,8 +54,8 @@ struct ReadRpc : public RpcTask {
     ReadRpc(google::protobuf::RpcController* ctrl,
             const ReadTabletRequest* req, ReadTabletResponse* resp,
             google::protobuf::Closure* done, ReadRpcTimer* timer,
-            int64_t start_micros)
-      : RpcTask(RPC_READ), controller(ctrl), request(req),
+            int64_t start_micros, int64_t deadline)
+      : RpcTask(RPC_READ, deadline), controller(ctrl), request(req),
         response(resp), done(done), timer(timer),
         start_micros(start_micros) {}
 };
@@ -58,8 +68,8 @@ struct ScanRpc : public RpcTask {
 
     ScanRpc(google::protobuf::RpcController* ctrl,
             const ScanTabletRequest* req, ScanTabletResponse* resp,
-            google::protobuf::Closure* done)
-      : RpcTask(RPC_SCAN), controller(ctrl), request(req),
+            google::protobuf::Closure* done, int64_t deadline)
+      : RpcTask(RPC_SCAN, deadline), controller(ctrl), request(req),
         response(resp), done(done) {}
 };
 
@@ -69,8 +79,23 @@ RemoteTabletNode::RemoteTabletNode(TabletNodeImpl* tabletnode_impl)
       m_read_thread_pool(new ThreadPool(FLAGS_tera_tabletnode_read_thread_num)),
       m_scan_thread_pool(new ThreadPool(FLAGS_tera_tabletnode_scan_thread_num)),
       m_compact_thread_pool(new ThreadPool(FLAGS_tera_tabletnode_manual_compact_thread_num)),
-      m_read_rpc_schedule(new RpcSchedule(new FairSchedulePolicy)),
-      m_scan_rpc_schedule(new RpcSchedule(new FairSchedulePolicy)) {}
+      m_read_rpc_schedule(new RpcSchedule(
+              NewSchedulePolicy(FLAGS_tera_tabletnode_rpc_schedule_policy))),
+      m_scan_rpc_schedule(new RpcSchedule(
+              NewSchedulePolicy(FLAGS_tera_tabletnode_rpc_schedule_policy))) {
+    utils::SetThreadPoolCpuAffinity(m_write_thread_pool.get(),
+                                    FLAGS_tera_tabletnode_write_thread_num,
+                                    FLAGS_tera_tabletnode_write_thread_cpu_set);
+    utils::SetThreadPoolCpuAffinity(m_read_thread_pool.get(),
+                                    FLAGS_tera_tabletnode_read_thread_num,
+                                    FLAGS_tera_tabletnode_read_thread_cpu_set);
+    utils::SetThreadPoolCpuAffinity(m_scan_thread_pool.get(),
+                                    FLAGS_tera_tabletnode_scan_thread_num,
+                                    FLAGS_tera_tabletnode_scan_thread_cpu_set);
+    utils::SetThreadPoolCpuAffinity(m_compact_thread_pool.get(),
+                                    FLAGS_tera_tabletnode_manual_compact_thread_num,
+                                    FLAGS_tera_tabletnode_compact_thread_cpu_set);
+}
 
 RemoteTabletNode::~RemoteTabletNode() {}
 
@@ -84,6 +109,16 @@ void RemoteTabletNode::LoadTablet(google::protobuf::RpcController* controller,
     m_write_thread_pool->AddPriorityTask(callback);
 }
 
+void RemoteTabletNode::PrewarmTablet(google::protobuf::RpcController* controller,
+                                     const LoadTabletRequest* request,
+                                     LoadTabletResponse* response,
+                                     google::protobuf::Closure* done) {
+    boost::function<void ()> callback =
+        boost::bind(&RemoteTabletNode::DoPrewarmTablet, this, controller,
+                   request, response, done);
+    m_compact_thread_pool->AddTask(callback);
+}
+
 void RemoteTabletNode::UnloadTablet(google::protobuf::RpcController* controller,
                                     const UnloadTabletRequest* request,
                                     UnloadTabletResponse* response,
@@ -115,11 +150,15 @@ void RemoteTabletNode::ReadTablet(google::protobuf::RpcController* controller,
         ReadRpcTimer* timer = new ReadRpcTimer(request, response, done, start_micros);
         RpcTimerList::Instance()->Push(timer);
 
+        int64_t timeout = request->has_timeout() ? request->timeout()
+            : FLAGS_tera_rpc_timeout_period;
         ReadRpc* rpc = new ReadRpc(controller, request, response, done,
-                                   timer, start_micros);
+                                   timer, start_micros, start_micros + timeout * 1000);
         m_read_rpc_schedule->EnqueueRpc(request->tablet_name(), rpc);
         m_read_thread_pool->AddTask(boost::bind(&RemoteTabletNode::DoScheduleRpc, this,
                                                 m_read_rpc_schedule.get()));
+        ScheduleStealRpc(m_read_thread_pool.get(), m_scan_thread_pool.get(),
+                         &m_scan_pool_steal_num, m_read_rpc_schedule.get());
     }
 }
 
@@ -192,10 +231,15 @@ void RemoteTabletNode::ScanTablet(google::protobuf::RpcController* controller,
         done->Run();
     } else {
         scan_pending_counter.Inc();
-        ScanRpc* rpc = new ScanRpc(controller, request, response, done);
+        int64_t timeout = request->has_timeout() ? request->timeout()
+            : FLAGS_tera_rpc_timeout_period;
+        ScanRpc* rpc = new ScanRpc(controller, request, response, done,
+                                   get_micros() + timeout * 1000);
         m_scan_rpc_schedule->EnqueueRpc(request->table_name(), rpc);
         m_scan_thread_pool->AddTask(boost::bind(&RemoteTabletNode::DoScheduleRpc,
                                                 this, m_scan_rpc_schedule.get()));
+        ScheduleStealRpc(m_scan_thread_pool.get(), m_read_thread_pool.get(),
+                         &m_read_pool_steal_num, m_scan_rpc_schedule.get());
     }
 }
 
@@ -230,16 +274,42 @@ void RemoteTabletNode::CompactTablet(google::protobuf::RpcController* controller
     m_compact_thread_pool->AddTask(callback);
 }
 
+void RemoteTabletNode::BulkLoadTablet(google::protobuf::RpcController* controller,
+                                      const BulkLoadTabletRequest* request,
+                                      BulkLoadTabletResponse* response,
+                                      google::protobuf::Closure* done) {
+    boost::function<void ()> callback =
+        boost::bind(&RemoteTabletNode::DoBulkLoadTablet, this, controller,
+                   request, response, done);
+    m_compact_thread_pool->AddTask(callback);
+}
+
 void RemoteTabletNode::DoLoadTablet(google::protobuf::RpcController* controller,
                                     const LoadTabletRequest* request,
                                     LoadTabletResponse* response,
                                     google::protobuf::Closure* done) {
     uint64_t id = request->sequence_id();
     LOG(INFO) << "accept RPC (LoadTablet) id: " << id;
+    // the schema of a table only changes by reloading its tablets
+    if (request->has_schema()) {
+        int32_t weight = request->schema().schedule_weight();
+        m_read_rpc_schedule->SetTableWeight(request->tablet_name(), weight);
+        m_scan_rpc_schedule->SetTableWeight(request->tablet_name(), weight);
+    }
     m_tabletnode_impl->LoadTablet(request, response, done);
     LOG(INFO) << "finish RPC (LoadTablet) id: " << id;
 }
 
+void RemoteTabletNode::DoPrewarmTablet(google::protobuf::RpcController* controller,
+                                       const LoadTabletRequest* request,
+                                       LoadTabletResponse* response,
+                                       google::protobuf::Closure* done) {
+    uint64_t id = request->sequence_id();
+    LOG(INFO) << "accept RPC (PrewarmTablet) id: " << id;
+    m_tabletnode_impl->PrewarmTablet(request, response, done);
+    LOG(INFO) << "finish RPC (PrewarmTablet) id: " << id;
+}
+
 void RemoteTabletNode::DoUnloadTablet(google::protobuf::RpcController* controller,
                                       const UnloadTabletRequest* request,
                                       UnloadTabletResponse* response,
@@ -348,12 +418,58 @@ void RemoteTabletNode::DoCompactTablet(google::protobuf::RpcController* controll
     LOG(INFO) << "finish RPC (CompactTablet) id: " << id;
 }
 
+void RemoteTabletNode::DoBulkLoadTablet(google::protobuf::RpcController* controller,
+                                        const BulkLoadTabletRequest* request,
+                                        BulkLoadTabletResponse* response,
+                                        google::protobuf::Closure* done) {
+    uint64_t id = request->sequence_id();
+    LOG(INFO) << "accept RPC (BulkLoadTablet) id: " << id;
+    m_tabletnode_impl->BulkLoadTablet(request, response, done);
+    LOG(INFO) << "finish RPC (BulkLoadTablet) id: " << id;
+}
+
+void RemoteTabletNode::ScheduleStealRpc(ThreadPool* owner_pool,
+                                        ThreadPool* helper_pool,
+                                        Counter* steal_num,
+                                        RpcSchedule* rpc_schedule) {
+    // all threads of the owner pool are busy and the helper pool seems
+    // idle, let the helper pool run the pending rpcs of the owner as well
+    if (!FLAGS_tera_tabletnode_rpc_work_stealing
+        || owner_pool->PendingNum() == 0 || helper_pool->PendingNum() > 0) {
+        return;
+    }
+    // keep most threads of the helper pool for its own rpcs
+    if (steal_num->Inc() > FLAGS_tera_tabletnode_rpc_steal_max_num) {
+        steal_num->Dec();
+        return;
+    }
+    helper_pool->AddTask(boost::bind(&RemoteTabletNode::DoStealRpc, this,
+                                     steal_num, rpc_schedule));
+}
+
+void RemoteTabletNode::DoStealRpc(Counter* steal_num, RpcSchedule* rpc_schedule) {
+    DoScheduleRpc(rpc_schedule);
+    steal_num->Dec();
+}
+
 void RemoteTabletNode::DoScheduleRpc(RpcSchedule* rpc_schedule) {
     RpcTask* rpc = NULL;
-    bool status = rpc_schedule->DequeueRpc(&rpc);
-    CHECK(status);
+    if (!rpc_schedule->DequeueRpc(&rpc)) {
+        // the rpc has been run by a thread of the other pool
+        return;
+    }
+    bool status = false;
     std::string table_name;
 
+    if (FLAGS_tera_tabletnode_rpc_drop_expired && get_micros() > rpc->deadline) {
+        // the client has given up, do not waste a thread on it
+        DropExpiredRpc(rpc, &table_name);
+        delete rpc;
+        status = rpc_schedule->FinishRpc(table_name);
+        CHECK(status);
+        return;
+    }
+
     switch (rpc->rpc_type) {
     case RPC_READ: {
         ReadRpc* read_rpc = (ReadRpc*)rpc;
@@ -377,5 +493,39 @@ void RemoteTabletNode::DoScheduleRpc(RpcSchedule* rpc_schedule) {
     CHECK(status);
 }
 
+void RemoteTabletNode::DropExpiredRpc(RpcTask* rpc, std::string* table_name) {
+    static uint32_t last_print = time(NULL);
+    uint32_t now_time = time(NULL);
+    if (now_time > last_print) {
+        LOG(WARNING) << "rpc expires before executed, drop it";
+        last_print = now_time;
+    }
+
+    switch (rpc->rpc_type) {
+    case RPC_READ: {
+        ReadRpc* read_rpc = (ReadRpc*)rpc;
+        *table_name = read_rpc->request->tablet_name();
+        read_pending_counter.Sub(read_rpc->request->row_info_list_size());
+        read_rpc->response->set_sequence_id(read_rpc->request->sequence_id());
+        read_rpc->response->set_status(kRPCTimeout);
+        read_rpc->done->Run();
+        if (NULL != read_rpc->timer) {
+            RpcTimerList::Instance()->Erase(read_rpc->timer);
+            delete read_rpc->timer;
+        }
+    } break;
+    case RPC_SCAN: {
+        ScanRpc* scan_rpc = (ScanRpc*)rpc;
+        *table_name = scan_rpc->request->table_name();
+        scan_pending_counter.Dec();
+        scan_rpc->response->set_sequence_id(scan_rpc->request->sequence_id());
+        scan_rpc->response->set_status(kRPCTimeout);
+        scan_rpc->done->Run();
+    } break;
+    default:
+        abort();
+    }
+}
+
 } // namespace tabletnode
 } // namespace tera
@@ -10,6 +10,7 @@
 
 #include "proto/tabletnode_rpc.pb.h"
 #include "tabletnode/rpc_schedule.h"
+#include "utils/counter.h"
 #include "utils/rpc_timer_list.h"
 
 namespace tera {
@@ -27,6 +28,11 @@ public:
                     LoadTabletResponse* response,
                     google::protobuf::Closure* done);
 
+    void PrewarmTablet(google::protobuf::RpcController* controller,
+                       const LoadTabletRequest* request,
+                       LoadTabletResponse* response,
+                       google::protobuf::Closure* done);
+
     void UnloadTablet(google::protobuf::RpcController* controller,
                       const UnloadTabletRequest* request,
                       UnloadTabletResponse* response,
@@ -77,12 +83,22 @@ public:
                        CompactTabletResponse* response,
                        google::protobuf::Closure* done);
 
+    void BulkLoadTablet(google::protobuf::RpcController* controller,
+                        const BulkLoadTabletRequest* request,
+                        BulkLoadTabletResponse* response,
+                        google::protobuf::Closure* done);
+
 private:
     void DoLoadTablet(google::protobuf::RpcController* controller,
                       const LoadTabletRequest* request,
                       LoadTabletResponse* response,
                       google::protobuf::Closure* done);
 
+    void DoPrewarmTablet(google::protobuf::RpcController* controller,
+                         const LoadTabletRequest* request,
+                         LoadTabletResponse* response,
+                         google::protobuf::Closure* done);
+
     void DoUnloadTablet(google::protobuf::RpcController* controller,
                         const UnloadTabletRequest* request,
                         UnloadTabletResponse* response,
@@ -135,8 +151,22 @@ private:
                          CompactTabletResponse* response,
                          google::protobuf::Closure* done);
 
+    void DoBulkLoadTablet(google::protobuf::RpcController* controller,
+                          const BulkLoadTabletRequest* request,
+                          BulkLoadTabletResponse* response,
+                          google::protobuf::Closure* done);
+
     void DoScheduleRpc(RpcSchedule* rpc_schedule);
 
+    // pending read and scan rpcs may run on the thread pool of each other,
+    // "steal_num" counts the rpcs borrowed by "helper_pool" in flight
+    void ScheduleStealRpc(ThreadPool* owner_pool, ThreadPool* helper_pool,
+                          Counter* steal_num, RpcSchedule* rpc_schedule);
+    void DoStealRpc(Counter* steal_num, RpcSchedule* rpc_schedule);
+
+    // answer an rpc whose client has timed out without executing it
+    void DropExpiredRpc(RpcTask* rpc, std::string* table_name);
+
 private:
     TabletNodeImpl* m_tabletnode_impl;
     scoped_ptr<ThreadPool> m_write_thread_pool;
@@ -145,6 +175,8 @@ private:
     scoped_ptr<ThreadPool> m_compact_thread_pool;
     scoped_ptr<RpcSchedule> m_read_rpc_schedule;
     scoped_ptr<RpcSchedule> m_scan_rpc_schedule;
+    Counter m_read_pool_steal_num;
+    Counter m_scan_pool_steal_num;
 };
 
 } // namespace tabletnode
@@ -16,6 +16,15 @@ RpcSchedule::~RpcSchedule() {
     delete m_policy;
 }
 
+void RpcSchedule::SetTableWeight(const std::string& table_name, int32_t weight) {
+    MutexLock lock(&m_mutex);
+    m_table_weights[table_name] = weight;
+    TableList::iterator it = m_table_list.find(table_name);
+    if (it != m_table_list.end()) {
+        it->second->weight = weight;
+    }
+}
+
 void RpcSchedule::EnqueueRpc(const std::string& table_name, RpcTask* rpc) {
     MutexLock lock(&m_mutex);
 
@@ -25,6 +34,11 @@ void RpcSchedule::EnqueueRpc(const std::string& table_name, RpcTask* rpc) {
         entity = it->second;
     } else {
         entity = m_table_list[table_name] = m_policy->NewScheEntity(new TaskQueue);
+        std::map<TableName, int32_t>::iterator weight_it =
+            m_table_weights.find(table_name);
+        if (weight_it != m_table_weights.end()) {
+            entity->weight = weight_it->second;
+        }
     }
 
     TaskQueue* task_queue = (TaskQueue*)entity->user_ptr;
@@ -34,6 +48,7 @@ void RpcSchedule::EnqueueRpc(const std::string& table_name, RpcTask* rpc) {
     m_pending_task_count++;
 
     if (task_queue->pending_count == 1) {
+        entity->deadline = rpc->deadline;
         m_policy->Enable(entity);
     }
 }
@@ -60,7 +75,10 @@ bool RpcSchedule::DequeueRpc(RpcTask** rpc) {
     m_running_task_count++;
 
     if (task_queue->pending_count == 0) {
+        entity->deadline = INT64_MAX;
         m_policy->Disable(entity);
+    } else {
+        entity->deadline = task_queue->front()->deadline;
     }
     return true;
 }
@@ -17,7 +17,9 @@ namespace tabletnode {
 
 struct RpcTask {
     uint8_t rpc_type;
-    RpcTask(uint8_t type) : rpc_type(type) {}
+    int64_t deadline; // in us
+    RpcTask(uint8_t type, int64_t deadline = INT64_MAX)
+        : rpc_type(type), deadline(deadline) {}
 };
 
 class RpcSchedule {
@@ -25,6 +27,9 @@ public:
     RpcSchedule(SchedulePolicy* policy);
     ~RpcSchedule();
 
+    // the weight of the table in the schedule, see TableSchema, 1 if not set
+    void SetTableWeight(const std::string& table_name, int32_t weight);
+
     void EnqueueRpc(const std::string& table_name, RpcTask* rpc);
 
     bool DequeueRpc(RpcTask** rpc);
@@ -46,6 +51,7 @@ private:
     typedef std::map<TableName, ScheduleEntity*> TableList;
 
     TableList m_table_list;
+    std::map<TableName, int32_t> m_table_weights;
     uint64_t m_pending_task_count;
     uint64_t m_running_task_count;
 };
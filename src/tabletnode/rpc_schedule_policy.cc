@@ -72,10 +72,64 @@ void FairSchedulePolicy::Disable(ScheduleEntity* entity) {
 
 void FairSchedulePolicy::UpdateEntity(FairScheduleEntity* entity) {
     int64_t now = get_micros();
-    entity->elapse_time += (now - entity->last_update_time) * entity->running_count;
+    // a table of weight n takes n times the running time of a table of
+    // weight 1 before it is behind
+    int64_t weight = entity->weight > 0 ? entity->weight : 1;
+    entity->elapse_time += (now - entity->last_update_time) * entity->running_count / weight;
     entity->last_update_time = now;
 }
 
+DeadlineSchedulePolicy::DeadlineSchedulePolicy() {}
+
+DeadlineSchedulePolicy::~DeadlineSchedulePolicy() {}
+
+ScheduleEntity* DeadlineSchedulePolicy::NewScheEntity(void* user_ptr) {
+    return new DeadlineScheduleEntity(user_ptr);
+}
+
+SchedulePolicy::ScheduleEntityList::iterator DeadlineSchedulePolicy::Pick(
+                                             ScheduleEntityList* entity_list) {
+    ScheduleEntityList::iterator pick = entity_list->end();
+    int64_t min_deadline = INT64_MAX;
+
+    ScheduleEntityList::iterator it = entity_list->begin();
+    for (; it != entity_list->end(); ++it) {
+        DeadlineScheduleEntity* entity = (DeadlineScheduleEntity*)it->second;
+        if (!entity->pickable) {
+            continue;
+        }
+        if (pick == entity_list->end() || min_deadline > entity->deadline) {
+            min_deadline = entity->deadline;
+            pick = it;
+        }
+    }
+    return pick;
+}
+
+void DeadlineSchedulePolicy::Done(ScheduleEntity* entity) {}
+
+void DeadlineSchedulePolicy::Enable(ScheduleEntity* entity) {
+    DeadlineScheduleEntity* deadline_entity = (DeadlineScheduleEntity*)entity;
+    CHECK(!deadline_entity->pickable);
+    deadline_entity->pickable = true;
+}
+
+void DeadlineSchedulePolicy::Disable(ScheduleEntity* entity) {
+    DeadlineScheduleEntity* deadline_entity = (DeadlineScheduleEntity*)entity;
+    CHECK(deadline_entity->pickable);
+    deadline_entity->pickable = false;
+}
+
+SchedulePolicy* NewSchedulePolicy(const std::string& name) {
+    if (name == "deadline") {
+        return new DeadlineSchedulePolicy;
+    }
+    if (name != "fair") {
+        LOG(WARNING) << "unknown rpc schedule policy: " << name << ", use fair";
+    }
+    return new FairSchedulePolicy;
+}
+
 } // namespace tabletnode
 } // namespace tera
 
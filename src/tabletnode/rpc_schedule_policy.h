@@ -17,8 +17,13 @@ namespace tabletnode {
 
 struct ScheduleEntity {
     void* user_ptr;
+    // maintained by RpcSchedule: the weight of the table, and the deadline
+    // (in us) of the first pending rpc, INT64_MAX if none
+    int32_t weight;
+    int64_t deadline;
 
-    ScheduleEntity(void* user_ptr) : user_ptr(user_ptr) {}
+    ScheduleEntity(void* user_ptr)
+        : user_ptr(user_ptr), weight(1), deadline(INT64_MAX) {}
     virtual ~ScheduleEntity() {}
 };
 
@@ -77,6 +82,36 @@ private:
     int64_t m_min_elapse_time;
 };
 
+struct DeadlineScheduleEntity : public ScheduleEntity {
+    bool pickable;
+
+    DeadlineScheduleEntity(void* user_ptr)
+        : ScheduleEntity(user_ptr),
+          pickable(false) {}
+};
+
+// earliest deadline first, the table whose first pending rpc expires
+// soonest is picked
+class DeadlineSchedulePolicy : public SchedulePolicy {
+public:
+    DeadlineSchedulePolicy();
+
+    ~DeadlineSchedulePolicy();
+
+    ScheduleEntity* NewScheEntity(void* user_ptr = NULL);
+
+    ScheduleEntityList::iterator Pick(ScheduleEntityList* entity_list);
+
+    void Done(ScheduleEntity* entity);
+
+    void Enable(ScheduleEntity* entity);
+
+    void Disable(ScheduleEntity* entity);
+};
+
+// "fair" or "deadline"
+SchedulePolicy* NewSchedulePolicy(const std::string& name);
+
 } // namespace tabletnode
 } // namespace tera
 
@@ -99,6 +99,7 @@ bool TabletNodeEntry::Run() {
 
     m_tabletnode_impl->RefreshSysInfo();
     m_tabletnode_impl->GetSysInfo().DumpLog();
+    m_tabletnode_impl->ReleaseIdleScans();
 
     int64_t now_time = get_micros();
     int64_t earliest_rpc_time = now_time;
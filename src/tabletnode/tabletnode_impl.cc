@@ -4,6 +4,7 @@
 
 #include "tabletnode/tabletnode_impl.h"
 
+#include <map>
 #include <set>
 #include <vector>
 
@@ -12,6 +13,7 @@
 #include <glog/logging.h>
 #include <gperftools/malloc_extension.h>
 
+#include "common/base/string_ext.h"
 #include "db/filename.h"
 #include "db/table_cache.h"
 #include "io/io_utils.h"
@@ -29,6 +31,7 @@
 #include "tabletnode/tabletnode_zk_adapter.h"
 #include "types.h"
 #include "utils/counter.h"
+#include "utils/cpu_affinity.h"
 #include "utils/string_util.h"
 #include "utils/timer.h"
 #include "utils/utils_cmd.h"
@@ -60,6 +63,7 @@ DECLARE_int32(tera_tabletnode_scan_pack_max_size);
 DECLARE_int32(tera_tabletnode_block_cache_size);
 DECLARE_int32(tera_tabletnode_table_cache_size);
 DECLARE_int32(tera_tabletnode_compact_thread_num);
+DECLARE_string(tera_tabletnode_compact_thread_cpu_set);
 DECLARE_string(tera_tabletnode_path_prefix);
 
 // cache-related
@@ -70,7 +74,9 @@ DECLARE_string(tera_tabletnode_cache_name);
 DECLARE_int32(tera_tabletnode_cache_mem_size);
 DECLARE_int32(tera_tabletnode_cache_disk_size);
 DECLARE_int32(tera_tabletnode_cache_disk_filenum);
+DECLARE_bool(tera_tabletnode_cache_disk_persistent);
 DECLARE_int32(tera_tabletnode_cache_log_level);
+DECLARE_int32(tera_tabletnode_prewarm_expire_period);
 
 DECLARE_string(tera_leveldb_env_type);
 
@@ -87,11 +93,18 @@ TabletNodeImpl::TabletNodeImpl(const TabletNodeInfo& tabletnode_info,
       m_zk_adapter(NULL),
       m_release_cache_timer_id(kInvalidTimerId),
       m_sysinfo(tabletnode_info),
-      m_thread_pool(new ThreadPool(FLAGS_tera_tabletnode_impl_thread_max_num)) {
+      m_thread_pool(new ThreadPool(FLAGS_tera_tabletnode_impl_thread_max_num)),
+      m_prewarm_cv(&m_prewarm_mutex) {
     m_local_addr = utils::GetLocalHostName() + ":" + FLAGS_tera_tabletnode_port;
     TabletNodeClient::SetThreadPool(m_thread_pool.get());
 
     leveldb::Env::Default()->SetBackgroundThreads(FLAGS_tera_tabletnode_compact_thread_num);
+    std::vector<int32_t> compact_cpu_list;
+    if (!FLAGS_tera_tabletnode_compact_thread_cpu_set.empty()
+        && utils::ParseCpuSet(FLAGS_tera_tabletnode_compact_thread_cpu_set,
+                              &compact_cpu_list)) {
+        leveldb::Env::Default()->SetBackgroundThreadsCpuAffinity(compact_cpu_list);
+    }
     leveldb::Env::Default()->RenameFile(FLAGS_tera_leveldb_log_path,
                                         FLAGS_tera_leveldb_log_path + ".bak");
     leveldb::Status s =
@@ -123,7 +136,8 @@ TabletNodeImpl::TabletNodeImpl(const TabletNodeInfo& tabletnode_info,
 }
 
 TabletNodeImpl::~TabletNodeImpl() {
-    if (FLAGS_tera_tabletnode_cache_enabled) {
+    if (FLAGS_tera_tabletnode_cache_enabled
+        && !FLAGS_tera_tabletnode_cache_disk_persistent) {
         leveldb::CacheEnv::RemoveCachePaths();
     }
 }
@@ -156,6 +170,7 @@ void TabletNodeImpl::InitCacheSystem() {
     leveldb::CacheEnv::s_block_size_ = FLAGS_tera_tabletnode_cache_block_size;
     leveldb::CacheEnv::s_disk_cache_file_num_ = FLAGS_tera_tabletnode_cache_disk_filenum;
     leveldb::CacheEnv::s_disk_cache_file_name_ = FLAGS_tera_tabletnode_cache_name;
+    leveldb::CacheEnv::s_disk_cache_persistent_ = FLAGS_tera_tabletnode_cache_disk_persistent;
 
     if (FLAGS_tera_tabletnode_cache_log_level < 3) {
         LEVELDB_SET_LOG_LEVEL(WARNING);
@@ -181,6 +196,7 @@ bool TabletNodeImpl::Exit() {
         LOG(INFO) << "unload tablet [" << tablet_meta->path() << "] return " << ret;
         delete tablet_meta;
     }
+    ReleasePrewarmedTablets(get_micros());
     return true;
 }
 
@@ -227,6 +243,7 @@ void TabletNodeImpl::LoadTablet(const LoadTabletRequest* request,
         parent_tablets.push_back(request->parent_tablets(i));
     }
 
+    io::TabletIO* prewarm_io = TakePrewarmedTablet(request->path(), key_start, key_end);
     io::TabletIO* tablet_io = NULL;
     StatusCode status = kTabletNodeOk;
     if (!m_tablet_manager->AddTablet(request->tablet_name(), request->path(),
@@ -237,32 +254,196 @@ void TabletNodeImpl::LoadTablet(const LoadTabletRequest* request,
             << StatusCodeToString(status);
         response->set_status((StatusCode)tablet_io->GetStatus());
         tablet_io->DecRef();
-    } else if (!tablet_io->Load(schema, key_start, key_end,
-                                request->path(), parent_tablets, snapshots, m_ldb_logger,
-                                m_ldb_block_cache, m_ldb_table_cache, &status)) {
-        tablet_io->DecRef();
-        LOG(ERROR) << "fail to load tablet: " << request->path()
-            << " [" << DebugString(key_start) << ", "
-            << DebugString(key_end) << "], status: "
-            << StatusCodeToString(status);
-        if (!m_tablet_manager->RemoveTablet(request->tablet_name(), key_start,
-                                            key_end, &status)) {
-            LOG(ERROR) << "fail to remove tablet: " << request->path()
+    } else {
+        if (prewarm_io != NULL) {
+            tablet_io->SetPrewarmed(prewarm_io);
+        }
+        if (!tablet_io->Load(schema, key_start, key_end,
+                             request->path(), parent_tablets, snapshots, m_ldb_logger,
+                             m_ldb_block_cache, m_ldb_table_cache, &status)) {
+            tablet_io->DecRef();
+            LOG(ERROR) << "fail to load tablet: " << request->path()
                 << " [" << DebugString(key_start) << ", "
                 << DebugString(key_end) << "], status: "
                 << StatusCodeToString(status);
+            if (!m_tablet_manager->RemoveTablet(request->tablet_name(), key_start,
+                                                key_end, &status)) {
+                LOG(ERROR) << "fail to remove tablet: " << request->path()
+                    << " [" << DebugString(key_start) << ", "
+                    << DebugString(key_end) << "], status: "
+                    << StatusCodeToString(status);
+            }
+            response->set_status(kIOError);
+        } else {
+            tablet_io->DecRef();
+            response->set_status(kTabletNodeOk);
         }
-        response->set_status(kIOError);
-    } else {
-        tablet_io->DecRef();
-        response->set_status(kTabletNodeOk);
     }
+    if (prewarm_io != NULL) {
+        prewarm_io->DecRef();
+    }
+    FinishLoadTablet(request->path());
 
     LOG(INFO) << "load tablet: " << request->path() << " ["
         << DebugString(key_start) << ", " << DebugString(key_end) << "]";
     done->Run();
 }
 
+void TabletNodeImpl::PrewarmTablet(const LoadTabletRequest* request,
+                                   LoadTabletResponse* response,
+                                   google::protobuf::Closure* done) {
+    response->set_sequence_id(request->sequence_id());
+    if (!request->has_session_id() || request->session_id() != GetSessionId()) {
+        LOG(WARNING) << "prewarm session id not match: "
+            << request->session_id() << ", " << GetSessionId();
+        response->set_status(kIllegalAccess);
+        done->Run();
+        return;
+    }
+    if (request->schema().locality_groups_size() < 1) {
+        LOG(WARNING) << "No localitygroups in schema: " << request->tablet_name();
+        response->set_status(kIllegalAccess);
+        done->Run();
+        return;
+    }
+
+    const std::string& key_start = request->key_range().key_start();
+    const std::string& key_end = request->key_range().key_end();
+    std::vector<uint64_t> parent_tablets;
+    for (int i = 0; i < request->parent_tablets_size(); ++i) {
+        CHECK(i < 2) << "parent_tablets should less than 2: " << i;
+        parent_tablets.push_back(request->parent_tablets(i));
+    }
+
+    // A late prewarm, e.g. one whose rpc timed out on master, must not open
+    // tables for a tablet loaded meanwhile: they would be freed with the
+    // prewarmed tablet while the loaded one still reads them.
+    StatusCode status = kTabletNodeOk;
+    io::TabletIO* old_io = NULL;
+    {
+        MutexLock lock(&m_prewarm_mutex);
+        io::TabletIO* loaded_io = m_tablet_manager->GetTablet(
+            request->tablet_name(), key_start, key_end, &status);
+        std::map<std::string, PrewarmedTablet>::iterator it =
+            m_prewarm_tablets.find(request->path());
+        if (loaded_io != NULL || m_loading_tablets.count(request->path()) > 0
+            || (it != m_prewarm_tablets.end() && it->second.tablet_io == NULL)) {
+            status = kTableIsBusy;
+        } else {
+            status = kTabletNodeOk;
+            if (it != m_prewarm_tablets.end()) {
+                old_io = it->second.tablet_io;
+            }
+            m_prewarm_tablets[request->path()] = PrewarmedTablet();
+        }
+        if (loaded_io != NULL) {
+            loaded_io->DecRef();
+        }
+    }
+    if (old_io != NULL) {
+        old_io->DecRef();
+    }
+    if (status != kTabletNodeOk) {
+        LOG(WARNING) << "skip prewarm of loaded or loading tablet: "
+            << request->path();
+        response->set_status(status);
+        done->Run();
+        return;
+    }
+
+    io::TabletIO* tablet_io = new io::TabletIO();
+    bool warmed = tablet_io->Prewarm(request->schema(), key_start, key_end,
+                                     request->path(), parent_tablets, m_ldb_logger,
+                                     m_ldb_block_cache, m_ldb_table_cache, &status);
+    if (!warmed) {
+        LOG(WARNING) << "fail to prewarm tablet: " << request->path()
+            << " [" << DebugString(key_start) << ", "
+            << DebugString(key_end) << "], status: "
+            << StatusCodeToString(status);
+        tablet_io->DecRef();
+    }
+
+    int64_t now = get_micros();
+    {
+        MutexLock lock(&m_prewarm_mutex);
+        if (warmed) {
+            PrewarmedTablet& prewarmed = m_prewarm_tablets[request->path()];
+            prewarmed.tablet_io = tablet_io;
+            prewarmed.time = now;
+        } else {
+            m_prewarm_tablets.erase(request->path());
+        }
+        m_prewarm_cv.Broadcast();
+    }
+    if (!warmed) {
+        response->set_status(status);
+        done->Run();
+        return;
+    }
+    ReleasePrewarmedTablets(now - FLAGS_tera_tabletnode_prewarm_expire_period * 1000000LL);
+
+    LOG(INFO) << "prewarm tablet: " << request->path() << " ["
+        << DebugString(key_start) << ", " << DebugString(key_end) << "]";
+    response->set_status(kTabletNodeOk);
+    done->Run();
+}
+
+io::TabletIO* TabletNodeImpl::TakePrewarmedTablet(const std::string& path,
+                                                  const std::string& key_start,
+                                                  const std::string& key_end) {
+    io::TabletIO* tablet_io = NULL;
+    {
+        MutexLock lock(&m_prewarm_mutex);
+        m_loading_tablets.insert(path);
+        std::map<std::string, PrewarmedTablet>::iterator it =
+            m_prewarm_tablets.find(path);
+        while (it != m_prewarm_tablets.end() && it->second.tablet_io == NULL) {
+            LOG(INFO) << "wait for prewarm of loading tablet: " << path;
+            m_prewarm_cv.Wait();
+            it = m_prewarm_tablets.find(path);
+        }
+        if (it != m_prewarm_tablets.end()) {
+            tablet_io = it->second.tablet_io;
+            m_prewarm_tablets.erase(it);
+        }
+    }
+    if (tablet_io != NULL && (tablet_io->GetStartKey() != key_start
+                              || tablet_io->GetEndKey() != key_end)) {
+        tablet_io->DecRef();
+        tablet_io = NULL;
+    }
+    ReleasePrewarmedTablets(get_micros() - FLAGS_tera_tabletnode_prewarm_expire_period * 1000000LL);
+    return tablet_io;
+}
+
+void TabletNodeImpl::FinishLoadTablet(const std::string& path) {
+    MutexLock lock(&m_prewarm_mutex);
+    std::multiset<std::string>::iterator it = m_loading_tablets.find(path);
+    if (it != m_loading_tablets.end()) {
+        m_loading_tablets.erase(it);
+    }
+}
+
+void TabletNodeImpl::ReleasePrewarmedTablets(int64_t expire_time) {
+    std::vector<io::TabletIO*> expired;
+    {
+        MutexLock lock(&m_prewarm_mutex);
+        std::map<std::string, PrewarmedTablet>::iterator it = m_prewarm_tablets.begin();
+        while (it != m_prewarm_tablets.end()) {
+            if (it->second.tablet_io != NULL && it->second.time <= expire_time) {
+                expired.push_back(it->second.tablet_io);
+                m_prewarm_tablets.erase(it++);
+            } else {
+                ++it;
+            }
+        }
+    }
+    for (size_t i = 0; i < expired.size(); ++i) {
+        LOG(INFO) << "release prewarmed tablet: " << expired[i]->GetTablePath();
+        expired[i]->DecRef();
+    }
+}
+
 bool TabletNodeImpl::UnloadTablet(const std::string& tablet_name,
                                   const std::string& start,
                                   const std::string& end,
@@ -346,6 +527,71 @@ void TabletNodeImpl::CompactTablet(const CompactTabletRequest* request,
     done->Run();
 }
 
+// The files are moved into the tablet, so they must stay under the path
+// prefix and out of the directory of the table.
+static bool IsValidBulkLoadPath(const std::string& path,
+                                const std::string& tablet_path) {
+    if (path.empty() || path[0] == '/') {
+        return false;
+    }
+    std::vector<std::string> parts;
+    SplitString(path, "/", &parts);
+    for (size_t i = 0; i < parts.size(); ++i) {
+        if (parts[i] == ".." || parts[i] == ".") {
+            return false;
+        }
+    }
+    std::vector<std::string> tablet_parts;
+    SplitString(tablet_path, "/", &tablet_parts);
+    return parts.size() > 1
+        && (tablet_parts.empty() || parts[0] != tablet_parts[0]);
+}
+
+void TabletNodeImpl::BulkLoadTablet(const BulkLoadTabletRequest* request,
+                                    BulkLoadTabletResponse* response,
+                                    google::protobuf::Closure* done) {
+    response->set_sequence_id(request->sequence_id());
+    StatusCode status = kTabletNodeOk;
+    io::TabletIO* tablet_io = m_tablet_manager->GetTablet(
+        request->tablet_name(), request->key_range().key_start(),
+        request->key_range().key_end(), &status);
+    if (tablet_io == NULL) {
+        LOG(WARNING) << "bulk load fail to get tablet: " << request->tablet_name()
+            << " [" << DebugString(request->key_range().key_start())
+            << ", " << DebugString(request->key_range().key_end())
+            << "], status: " << StatusCodeToString(status);
+        response->set_status(kKeyNotInRange);
+        done->Run();
+        return;
+    }
+
+    std::map<uint32_t, std::vector<std::string> > lg_files;
+    for (int32_t i = 0; i < request->lg_files_size(); ++i) {
+        const LocalityGroupFiles& files = request->lg_files(i);
+        std::vector<std::string>& paths = lg_files[files.lg_id()];
+        for (int32_t j = 0; j < files.path_size(); ++j) {
+            if (!IsValidBulkLoadPath(files.path(j), tablet_io->GetTablePath())) {
+                LOG(WARNING) << "bulk load refuses path: " << files.path(j)
+                    << ", tablet: " << tablet_io->GetTablePath();
+                response->set_status(kInvalidArgument);
+                tablet_io->DecRef();
+                done->Run();
+                return;
+            }
+            paths.push_back(files.path(j));
+        }
+    }
+    tablet_io->IngestFiles(lg_files, &status);
+    response->set_status(status);
+    LOG(INFO) << "bulk load tablet: " << tablet_io->GetTablePath()
+        << " [" << DebugString(tablet_io->GetStartKey())
+        << ", " << DebugString(tablet_io->GetEndKey())
+        << "], lg num: " << lg_files.size()
+        << ", status: " << StatusCodeToString(status);
+    tablet_io->DecRef();
+    done->Run();
+}
+
 void TabletNodeImpl::ReadTablet(int64_t start_micros,
                                 const ReadTabletRequest* request,
                                 ReadTabletResponse* response,
@@ -586,7 +832,11 @@ void TabletNodeImpl::Query(const QueryRequest* request,
     TabletNodeInfo* ts_info = response->mutable_tabletnode_info();
     m_sysinfo.GetTabletNodeInfo(ts_info);
     TabletMetaList* meta_list = response->mutable_tabletmeta_list();
-    m_sysinfo.GetTabletMetaList(meta_list);
+    uint64_t version = 0;
+    bool is_delta = m_sysinfo.GetTabletMetaList(request->tablet_list_version(),
+                                                meta_list, &version);
+    response->set_tablet_list_version(version);
+    response->set_is_delta(is_delta);
 
     if (request->has_is_gc_query() && request->is_gc_query()) {
         std::vector<InheritedLiveFiles> inherited;
@@ -609,6 +859,15 @@ void TabletNodeImpl::RefreshSysInfo() {
     VLOG(15) << "collect sysinfo finished, time used: " << get_micros() - cur_ts << " us.";
 }
 
+void TabletNodeImpl::ReleaseIdleScans() {
+    std::vector<io::TabletIO*> tablet_ios;
+    m_tablet_manager->GetAllTablets(&tablet_ios);
+    for (size_t i = 0; i < tablet_ios.size(); ++i) {
+        tablet_ios[i]->ReleaseIdleScans();
+        tablet_ios[i]->DecRef();
+    }
+}
+
 void TabletNodeImpl::ScanTablet(const ScanTabletRequest* request,
                                 ScanTabletResponse* response,
                                 google::protobuf::Closure* done) {
@@ -662,6 +921,9 @@ void TabletNodeImpl::SplitTablet(const SplitTabletRequest* request,
         return;
     }
 
+    if (request->split_by_load() && !tablet_io->FindLoadSplitKey(&split_key)) {
+        VLOG(5) << "no load split key, split by size: " << tablet_io->GetTablePath();
+    }
     if (!tablet_io->Split(&split_key, &status)) {
         LOG(ERROR) << "fail to split tablet: " << tablet_io->GetTablePath()
             << " [" << DebugString(tablet_io->GetStartKey())
@@ -5,6 +5,8 @@
 #ifndef TERA_TABLETNODE_TABLETNODE_IMPL_H_
 #define TERA_TABLETNODE_TABLETNODE_IMPL_H_
 
+#include <map>
+#include <set>
 #include <string>
 
 #include "common/base/scoped_ptr.h"
@@ -48,6 +50,12 @@ public:
                     LoadTabletResponse* response,
                     google::protobuf::Closure* done);
 
+    // warm up a tablet before it is moved in, the next load of the same
+    // tablet starts with warm caches
+    void PrewarmTablet(const LoadTabletRequest* request,
+                       LoadTabletResponse* response,
+                       google::protobuf::Closure* done);
+
     bool UnloadTablet(const std::string& tablet_name,
                       const std::string& start, const std::string& end,
                       StatusCode* status);
@@ -60,6 +68,10 @@ public:
                        CompactTabletResponse* response,
                        google::protobuf::Closure* done);
 
+    void BulkLoadTablet(const BulkLoadTabletRequest* request,
+                        BulkLoadTabletResponse* response,
+                        google::protobuf::Closure* done);
+
     void ReadTablet(int64_t start_micros,
                     const ReadTabletRequest* request,
                     ReadTabletResponse* response,
@@ -111,6 +123,9 @@ public:
 
     void RefreshSysInfo();
 
+    // release the resources of scans not resumed by the clients in time
+    void ReleaseIdleScans();
+
     void TryReleaseMallocCache();
 
 private:
@@ -145,7 +160,25 @@ private:
 
     void GetInheritedLiveFiles(std::vector<InheritedLiveFiles>& inherited);
 
+    // return the prewarmed tablet io of the path if it covers the same
+    // range, or NULL. The expired ones are released meanwhile.
+    // A prewarm of the path in progress is waited for, and no new one
+    // starts until FinishLoadTablet(), as the loaded tablet may read the
+    // tables it opens.
+    io::TabletIO* TakePrewarmedTablet(const std::string& path,
+                                      const std::string& key_start,
+                                      const std::string& key_end);
+    void FinishLoadTablet(const std::string& path);
+    void ReleasePrewarmedTablets(int64_t expire_time);
+
 private:
+    struct PrewarmedTablet {
+        // NULL while warming up
+        io::TabletIO* tablet_io;
+        int64_t time;
+        PrewarmedTablet() : tablet_io(NULL), time(0) {}
+    };
+
     mutable Mutex m_status_mutex;
     TabletNodeStatus m_status;
     Mutex m_mutex;
@@ -167,6 +200,11 @@ private:
     leveldb::Logger* m_ldb_logger;
     leveldb::Cache* m_ldb_block_cache;
     leveldb::TableCache* m_ldb_table_cache;
+
+    Mutex m_prewarm_mutex;
+    CondVar m_prewarm_cv;
+    std::map<std::string, PrewarmedTablet> m_prewarm_tablets;
+    std::multiset<std::string> m_loading_tablets;
 };
 
 } // namespace tabletnode
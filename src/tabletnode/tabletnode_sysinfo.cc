@@ -86,6 +86,7 @@ extern tera::Counter ssd_write_size_counter;
 tera::Counter rand_read_delay;
 tera::Counter row_read_delay;
 tera::Counter range_error_counter;
+tera::Counter negative_cache_hit_counter;
 tera::Counter read_pending_counter;
 tera::Counter write_pending_counter;
 tera::Counter scan_pending_counter;
@@ -101,7 +102,9 @@ TabletNodeSysInfo::TabletNodeSysInfo()
       m_net_tx_total(0),
       m_net_rx_total(0),
       m_cpu_check_ts(0),
-      m_tablet_check_ts(0) {
+      m_tablet_check_ts(0),
+      m_first_version(get_micros() + 1),
+      m_tablet_list_version(m_first_version - 1) {
 }
 
 TabletNodeSysInfo::TabletNodeSysInfo(const TabletNodeInfo& info)
@@ -111,7 +114,9 @@ TabletNodeSysInfo::TabletNodeSysInfo(const TabletNodeInfo& info)
       m_net_tx_total(0),
       m_net_rx_total(0),
       m_cpu_check_ts(0),
-      m_tablet_check_ts(0) {
+      m_tablet_check_ts(0),
+      m_first_version(get_micros() + 1),
+      m_tablet_list_version(m_first_version - 1) {
 }
 
 TabletNodeSysInfo::~TabletNodeSysInfo() {
@@ -146,6 +151,9 @@ void TabletNodeSysInfo::CollectTabletNodeInfo(TabletManager* tablet_manager,
     m_tablet_check_ts = cur_ts;
 
     m_tablet_list.Clear();
+    m_tablet_versions.clear();
+    uint64_t version = ++m_tablet_list_version;
+    TabletDigestMap tablet_digests;
     int64_t total_size = 0;
     int32_t low_read_cell = 0;
     int32_t scan_rows = 0;
@@ -192,7 +200,20 @@ void TabletNodeSysInfo::CollectTabletNodeInfo(TabletManager* tablet_manager,
             busy_cnt++;
         }
         tablet_io->DecRef();
+
+        // an idle tablet keeps the version at which it last changed
+        std::pair<std::string, uint64_t>& digest = tablet_digests[tablet_meta->path()];
+        tablet_meta->AppendToString(&digest.first);
+        counter->AppendToString(&digest.first);
+        digest.second = version;
+        TabletDigestMap::iterator old_digest = m_tablet_digests.find(tablet_meta->path());
+        if (old_digest != m_tablet_digests.end()
+            && old_digest->second.first == digest.first) {
+            digest.second = old_digest->second.second;
+        }
+        m_tablet_versions.push_back(digest.second);
     }
+    m_tablet_digests.swap(tablet_digests);
     m_info.set_low_read_cell(low_read_cell);
     m_info.set_scan_rows(scan_rows);
     m_info.set_scan_kvs(scan_kvs);
@@ -248,6 +269,11 @@ void TabletNodeSysInfo::CollectTabletNodeInfo(TabletManager* tablet_manager,
     einfo->set_name("range_error");
     einfo->set_value(tmp);
 
+    einfo = m_info.add_extra_info();
+    tmp = negative_cache_hit_counter.Clear() * 1000000 / interval;
+    einfo->set_name("negative_cache_hit");
+    einfo->set_value(tmp);
+
     einfo = m_info.add_extra_info();
     tmp = read_pending_counter.Get();
     einfo->set_name("read_pending");
@@ -441,6 +467,25 @@ void TabletNodeSysInfo::GetTabletMetaList(TabletMetaList* meta_list) {
     meta_list->CopyFrom(m_tablet_list);
 }
 
+bool TabletNodeSysInfo::GetTabletMetaList(uint64_t base_version,
+                                          TabletMetaList* meta_list,
+                                          uint64_t* version) {
+    MutexLock lock(&m_mutex);
+    *version = m_tablet_list_version;
+    if (base_version < m_first_version || base_version > m_tablet_list_version) {
+        meta_list->CopyFrom(m_tablet_list);
+        return false;
+    }
+    meta_list->Clear();
+    for (int i = 0; i < m_tablet_list.meta_size(); ++i) {
+        if (m_tablet_versions[i] > base_version) {
+            meta_list->add_meta()->CopyFrom(m_tablet_list.meta(i));
+            meta_list->add_counter()->CopyFrom(m_tablet_list.counter(i));
+        }
+    }
+    return true;
+}
+
 void TabletNodeSysInfo::SetStatus(TabletNodeStatus status) {
     MutexLock lock(&m_mutex);
     m_info.set_status_t(kTabletNodeRegistered);
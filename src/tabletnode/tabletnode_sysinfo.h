@@ -9,6 +9,7 @@
 
 #include <map>
 #include <string>
+#include <vector>
 
 #include "common/mutex.h"
 #include "proto/tabletnode.pb.h"
@@ -45,6 +46,12 @@ public:
 
     void GetTabletMetaList(TabletMetaList* meta_list);
 
+    // Copy the tablets changed after "base_version" into "meta_list" and
+    // return true. If "base_version" is 0 or unknown to this node, copy
+    // the whole list and return false.
+    bool GetTabletMetaList(uint64_t base_version, TabletMetaList* meta_list,
+                           uint64_t* version);
+
     void DumpLog();
 
 private:
@@ -58,6 +65,16 @@ private:
     int64_t m_cpu_check_ts;
 
     int64_t m_tablet_check_ts;
+
+    // the tablet list is versioned by collection, versions begin from the
+    // start time so that a restarted node never matches an old base version
+    uint64_t m_first_version;
+    uint64_t m_tablet_list_version;
+    // version at which each entry of m_tablet_list last changed
+    std::vector<uint64_t> m_tablet_versions;
+    // tablet path -> (serialized meta and counter, version)
+    typedef std::map<std::string, std::pair<std::string, uint64_t> > TabletDigestMap;
+    TabletDigestMap m_tablet_digests;
     mutable Mutex m_mutex;
 };
 } // namespace tabletnode
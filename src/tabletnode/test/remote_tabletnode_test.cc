@@ -0,0 +1,103 @@
+// Copyright (c) 2015, Baidu.com, Inc. All Rights Reserved
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#define private public
+#include "tabletnode/remote_tabletnode.h"
+
+#include <boost/bind.hpp>
+#include <gflags/gflags.h>
+#include <google/protobuf/stubs/common.h>
+
+#include "common/mutex.h"
+#include "common/this_thread.h"
+#include "gtest/gtest.h"
+
+DECLARE_int32(tera_tabletnode_read_thread_num);
+DECLARE_int32(tera_tabletnode_scan_thread_num);
+DECLARE_bool(tera_tabletnode_rpc_drop_expired);
+DECLARE_bool(tera_tabletnode_rpc_work_stealing);
+DECLARE_int32(tera_tabletnode_rpc_steal_max_num);
+
+namespace tera {
+namespace tabletnode {
+
+// rpcs hold the threads running them until released
+class BlockedRpcs {
+public:
+    BlockedRpcs() : m_cond(&m_mutex), m_running(0), m_released(false) {}
+
+    void Run() {
+        MutexLock lock(&m_mutex);
+        m_running++;
+        while (!m_released) {
+            m_cond.Wait();
+        }
+        m_running--;
+    }
+
+    void Release() {
+        MutexLock lock(&m_mutex);
+        m_released = true;
+        m_cond.Broadcast();
+    }
+
+    int Running() {
+        MutexLock lock(&m_mutex);
+        return m_running;
+    }
+
+private:
+    Mutex m_mutex;
+    CondVar m_cond;
+    int m_running;
+    bool m_released;
+};
+
+TEST(RemoteTabletNodeTest, StealRpcMaxNum) {
+    FLAGS_tera_tabletnode_read_thread_num = 1;
+    FLAGS_tera_tabletnode_scan_thread_num = 4;
+    FLAGS_tera_tabletnode_rpc_drop_expired = true;
+    FLAGS_tera_tabletnode_rpc_work_stealing = true;
+    FLAGS_tera_tabletnode_rpc_steal_max_num = 2;
+
+    RemoteTabletNode node(NULL);
+    BlockedRpcs blocked;
+    const int kRpcNum = 4;
+    ReadTabletRequest requests[kRpcNum];
+    ReadTabletResponse responses[kRpcNum];
+
+    // the only read thread is busy
+    node.m_read_thread_pool->AddTask(boost::bind(&BlockedRpcs::Run, &blocked));
+
+    // the idle scan pool borrows the pending read rpcs, but no more than
+    // tera_tabletnode_rpc_steal_max_num at the same time; the rpcs expire
+    // at once, and are answered without a tabletnode
+    for (int i = 0; i < kRpcNum; ++i) {
+        requests[i].set_sequence_id(i);
+        requests[i].set_tablet_name("table");
+        requests[i].set_timeout(0);
+        node.ReadTablet(NULL, &requests[i], &responses[i],
+                        google::protobuf::NewCallback(&blocked, &BlockedRpcs::Run));
+        while (node.m_scan_thread_pool->PendingNum() > 0) {
+            ThisThread::Sleep(1);
+        }
+    }
+    while (blocked.Running() < 3) {
+        ThisThread::Sleep(1);
+    }
+    ThisThread::Sleep(10);
+    EXPECT_EQ(blocked.Running(), 3);
+    EXPECT_EQ(node.m_scan_pool_steal_num.Get(), 2);
+
+    blocked.Release();
+    node.m_read_thread_pool->Stop(true);
+    node.m_scan_thread_pool->Stop(true);
+    EXPECT_EQ(node.m_scan_pool_steal_num.Get(), 0);
+    for (int i = 0; i < kRpcNum; ++i) {
+        EXPECT_EQ(responses[i].status(), kRPCTimeout);
+    }
+}
+
+} // namespace tabletnode
+} // namespace tera
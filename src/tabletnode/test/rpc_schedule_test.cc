@@ -0,0 +1,107 @@
+// Copyright (c) 2015, Baidu.com, Inc. All Rights Reserved
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "tabletnode/rpc_schedule.h"
+
+#include "common/this_thread.h"
+#include "gtest/gtest.h"
+
+namespace tera {
+namespace tabletnode {
+
+static const std::string& PickTable(RpcSchedule* schedule,
+                                    const std::map<RpcTask*, std::string>& tables) {
+    RpcTask* rpc = NULL;
+    EXPECT_TRUE(schedule->DequeueRpc(&rpc));
+    std::map<RpcTask*, std::string>::const_iterator it = tables.find(rpc);
+    EXPECT_TRUE(it != tables.end());
+    return it->second;
+}
+
+class RpcScheduleTest : public ::testing::Test {
+public:
+    ~RpcScheduleTest() {
+        std::map<RpcTask*, std::string>::iterator it = m_tables.begin();
+        for (; it != m_tables.end(); ++it) {
+            delete it->first;
+        }
+    }
+
+    void Enqueue(RpcSchedule* schedule, const std::string& table_name,
+                 int64_t deadline) {
+        RpcTask* rpc = new RpcTask(0, deadline);
+        m_tables[rpc] = table_name;
+        schedule->EnqueueRpc(table_name, rpc);
+    }
+
+protected:
+    std::map<RpcTask*, std::string> m_tables;
+};
+
+TEST_F(RpcScheduleTest, EarliestDeadlineFirst) {
+    RpcSchedule schedule(new DeadlineSchedulePolicy);
+    Enqueue(&schedule, "a", 300);
+    Enqueue(&schedule, "a", 50);
+    Enqueue(&schedule, "b", 100);
+    Enqueue(&schedule, "c", 200);
+
+    EXPECT_EQ(PickTable(&schedule, m_tables), "b");
+    EXPECT_EQ(PickTable(&schedule, m_tables), "c");
+    EXPECT_EQ(PickTable(&schedule, m_tables), "a");
+    // the next rpc of "a" expires the soonest
+    Enqueue(&schedule, "b", 100);
+    EXPECT_EQ(PickTable(&schedule, m_tables), "a");
+    EXPECT_EQ(PickTable(&schedule, m_tables), "b");
+
+    RpcTask* rpc = NULL;
+    EXPECT_FALSE(schedule.DequeueRpc(&rpc));
+}
+
+TEST_F(RpcScheduleTest, WeightedFairShare) {
+    RpcSchedule schedule(new FairSchedulePolicy);
+    schedule.SetTableWeight("heavy", 4);
+    const int kRpcNum = 50;
+    for (int i = 0; i < kRpcNum; ++i) {
+        Enqueue(&schedule, "light", INT64_MAX);
+        Enqueue(&schedule, "heavy", INT64_MAX);
+    }
+
+    // every rpc runs for the same time, one at a time
+    int heavy_count = 0;
+    for (int i = 0; i < kRpcNum; ++i) {
+        const std::string& table_name = PickTable(&schedule, m_tables);
+        if (table_name == "heavy") {
+            heavy_count++;
+        }
+        ThisThread::Sleep(1);
+        EXPECT_TRUE(schedule.FinishRpc(table_name));
+    }
+    // the heavy table is picked about 4 times as often
+    EXPECT_GT(heavy_count, 3 * (kRpcNum - heavy_count));
+    EXPECT_LT(heavy_count, kRpcNum);
+}
+
+TEST_F(RpcScheduleTest, SetWeightOfQueuedTable) {
+    RpcSchedule schedule(new FairSchedulePolicy);
+    const int kRpcNum = 50;
+    for (int i = 0; i < kRpcNum; ++i) {
+        Enqueue(&schedule, "light", INT64_MAX);
+        Enqueue(&schedule, "heavy", INT64_MAX);
+    }
+    schedule.SetTableWeight("heavy", 4);
+
+    int heavy_count = 0;
+    for (int i = 0; i < kRpcNum; ++i) {
+        const std::string& table_name = PickTable(&schedule, m_tables);
+        if (table_name == "heavy") {
+            heavy_count++;
+        }
+        ThisThread::Sleep(1);
+        EXPECT_TRUE(schedule.FinishRpc(table_name));
+    }
+    EXPECT_GT(heavy_count, 3 * (kRpcNum - heavy_count));
+}
+
+} // namespace tabletnode
+} // namespace tera
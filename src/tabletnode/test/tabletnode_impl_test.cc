@@ -369,6 +369,46 @@ TEST_F(TabletNodeImplTest, CompactTabletSuccess) {
     EXPECT_EQ(response.status(), kTabletNodeOk);
 }
 
+TEST_F(TabletNodeImplTest, BulkLoadTabletFailureForNotReady) {
+    EXPECT_CALL(*m_tablet_manager, GetTablet(_, _, _, _))
+        .WillRepeatedly(Invoke(this, &TabletNodeImplTest::GetTablet));
+
+    BulkLoadTabletRequest request;
+    BulkLoadTabletResponse response;
+    request.set_sequence_id(1);
+    request.set_tablet_name("bulk_load_table");
+    CreateKeyRange("", "", request.mutable_key_range());
+    LocalityGroupFiles* files = request.add_lg_files();
+    files->set_lg_id(0);
+    files->add_path("bulk_load/path/0/0.sst");
+
+    CreateCallback();
+    m_tabletnode_impl.BulkLoadTablet(&request, &response, m_done);
+    EXPECT_NE(response.status(), kTabletNodeOk);
+}
+
+TEST_F(TabletNodeImplTest, BulkLoadTabletFailureForBadPath) {
+    EXPECT_CALL(*m_tablet_manager, GetTablet(_, _, _, _))
+        .WillRepeatedly(Invoke(this, &TabletNodeImplTest::GetTablet));
+
+    const char* bad_paths[] = {"", "/bulk_load/0/0.sst", "0.sst",
+                               "bulk_load/../../0/0.sst"};
+    for (size_t i = 0; i < sizeof(bad_paths) / sizeof(bad_paths[0]); ++i) {
+        BulkLoadTabletRequest request;
+        BulkLoadTabletResponse response;
+        request.set_sequence_id(1);
+        request.set_tablet_name("bulk_load_table");
+        CreateKeyRange("", "", request.mutable_key_range());
+        LocalityGroupFiles* files = request.add_lg_files();
+        files->set_lg_id(0);
+        files->add_path(bad_paths[i]);
+
+        CreateCallback();
+        m_tabletnode_impl.BulkLoadTablet(&request, &response, m_done);
+        EXPECT_EQ(response.status(), kInvalidArgument);
+    }
+}
+
 TEST_F(TabletNodeImplTest, ReadTabletSuccessOfKeyList) {
     EXPECT_CALL(*m_tablet_manager, GetTablet(_, _, _))
         .WillRepeatedly(Invoke(this, &TabletNodeImplTest::GetTablet2));
@@ -5,9 +5,12 @@
 #define private public
 
 #include "tabletnode_sysinfo.h"
+#include "tabletnode/test/mock_tablet_manager.h"
 #include "utils/timer.h"
 #include "gtest/gtest.h"
 
+using ::testing::_;
+
 namespace tera {
 namespace tabletnode {
 
@@ -15,6 +18,13 @@ class TabletNodeSysInfoTest : public ::testing::Test, public TabletNodeSysInfo {
 public:
     TabletNodeSysInfoTest() {}
     ~TabletNodeSysInfoTest() {}
+
+    void AddTablet(const std::string& path, uint64_t version) {
+        TabletMeta* meta = m_tablet_list.add_meta();
+        meta->set_path(path);
+        m_tablet_list.add_counter();
+        m_tablet_versions.push_back(version);
+    }
 };
 
 TEST_F(TabletNodeSysInfoTest, CollectHardwareInfo) {
@@ -28,5 +38,65 @@ TEST_F(TabletNodeSysInfoTest, ToString) {
     SetCurrentTime();
     AddExtraInfo("read", 100);
 }
+
+TEST_F(TabletNodeSysInfoTest, CollectBumpsTabletListVersion) {
+    MockTabletManager tablet_manager;
+    EXPECT_CALL(tablet_manager, GetAllTablets(_)).Times(2);
+
+    uint64_t version = 0;
+    TabletMetaList meta_list;
+    EXPECT_FALSE(GetTabletMetaList(0, &meta_list, &version));
+    EXPECT_EQ(version, m_first_version - 1);
+
+    CollectTabletNodeInfo(&tablet_manager, "127.0.0.1:2200");
+    EXPECT_FALSE(GetTabletMetaList(0, &meta_list, &version));
+    EXPECT_EQ(version, m_first_version);
+    uint64_t base_version = version;
+
+    CollectTabletNodeInfo(&tablet_manager, "127.0.0.1:2200");
+    EXPECT_TRUE(GetTabletMetaList(base_version, &meta_list, &version));
+    EXPECT_EQ(version, base_version + 1);
+    EXPECT_EQ(meta_list.meta_size(), 0);
+}
+
+TEST_F(TabletNodeSysInfoTest, GetTabletMetaListDelta) {
+    const uint64_t v = m_first_version;
+    m_tablet_list_version = v + 2;
+    AddTablet("table/tablet00000001", v);
+    AddTablet("table/tablet00000002", v + 1);
+    AddTablet("table/tablet00000003", v + 2);
+
+    uint64_t version = 0;
+    TabletMetaList meta_list;
+    EXPECT_TRUE(GetTabletMetaList(v, &meta_list, &version));
+    EXPECT_EQ(version, v + 2);
+    ASSERT_EQ(meta_list.meta_size(), 2);
+    ASSERT_EQ(meta_list.counter_size(), 2);
+    EXPECT_EQ(meta_list.meta(0).path(), "table/tablet00000002");
+    EXPECT_EQ(meta_list.meta(1).path(), "table/tablet00000003");
+
+    EXPECT_TRUE(GetTabletMetaList(v + 2, &meta_list, &version));
+    EXPECT_EQ(meta_list.meta_size(), 0);
+}
+
+TEST_F(TabletNodeSysInfoTest, GetTabletMetaListUnknownBase) {
+    const uint64_t v = m_first_version;
+    m_tablet_list_version = v + 1;
+    AddTablet("table/tablet00000001", v);
+    AddTablet("table/tablet00000002", v + 1);
+
+    uint64_t version = 0;
+    TabletMetaList meta_list;
+    // never queried
+    EXPECT_FALSE(GetTabletMetaList(0, &meta_list, &version));
+    EXPECT_EQ(meta_list.meta_size(), 2);
+    // queried before this node restarted
+    EXPECT_FALSE(GetTabletMetaList(v - 1, &meta_list, &version));
+    EXPECT_EQ(meta_list.meta_size(), 2);
+    // ahead of this node
+    EXPECT_FALSE(GetTabletMetaList(v + 2, &meta_list, &version));
+    EXPECT_EQ(meta_list.meta_size(), 2);
+    EXPECT_EQ(version, v + 1);
+}
 } // namespace tabletnode
 } // namespace tera
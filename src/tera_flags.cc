@@ -33,13 +33,18 @@ DEFINE_int64(tera_tablet_write_log_time_out, 5, "max time(sec) to wait for log w
 DEFINE_bool(tera_log_async_mode, true, "enable async mode for log writing and sync");
 DEFINE_int64(tera_tablet_log_file_size, 32, "the log file size (in MB) for tablet");
 DEFINE_int64(tera_tablet_write_buffer_size, 32, "the buffer size (in MB) for tablet write buffer");
+DEFINE_int32(tera_tablet_max_imm_memtable_num, 1, "the max number of immutable memtables waiting to be dumped");
 DEFINE_int64(tera_tablet_write_block_size, 4, "the block size (in KB) for teblet write block");
 DEFINE_int64(tera_tablet_living_period, -1, "the living period of tablet");
 DEFINE_int32(tera_tablet_flush_log_num, 100000, "the max log number before flush memtable");
 DEFINE_bool(tera_tablet_use_memtable_on_leveldb, false, "enable memtable based on in-memory leveldb");
+DEFINE_bool(tera_tablet_use_concurrent_memtable, false, "let the writers of a write group insert into memtable in parallel");
+DEFINE_bool(tera_tablet_kv_memtable_hash_index, false, "enable hash index of memtable for kv tables without ttl");
+DEFINE_int32(tera_tablet_load_sample_interval, 16, "sample one of every N accessed rows for load-based split, 0 to disable");
 DEFINE_int64(tera_tablet_memtable_ldb_write_buffer_size, 1, "the buffer size(in MB) for memtable on leveldb");
 DEFINE_int64(tera_tablet_memtable_ldb_block_size, 4, "the block size (in KB) for memtable on leveldb");
 DEFINE_int64(tera_tablet_ldb_sst_size, 8, "the sstable file size (in MB) on leveldb");
+DEFINE_int64(tera_tablet_prewarm_data_size, 64, "the max data size (in MB) read into block cache when prewarm a tablet");
 
 DEFINE_string(tera_dfs_so_path, "", "the dfs implementation path");
 DEFINE_string(tera_dfs_conf, "", "the dfs configuration file path");
@@ -72,8 +77,12 @@ DEFINE_int32(tera_master_connect_retry_times, 5, "the max retry times when conne
 DEFINE_int32(tera_master_connect_retry_period, 1000, "the retry period (in ms) between two master connection");
 DEFINE_int32(tera_master_connect_timeout_period, 5000, "the timeout period (in ms) for each master connection");
 DEFINE_int32(tera_master_query_tabletnode_period, 10000, "the period (in ms) for query tabletnode status" );
+DEFINE_bool(tera_master_query_delta_enabled, true, "enable master to query only the tablets changed since last query");
+DEFINE_int32(tera_master_query_full_interval, 30, "the number of delta queries between two full queries of a tabletnode");
 DEFINE_int32(tera_master_common_retry_period, 1000, "the period (in ms) for common operation" );
 DEFINE_int32(tera_master_meta_retry_times, 5, "the max retry times when master read/write meta");
+DEFINE_int32(tera_master_meta_write_max_inflight, 8, "the max number of concurrent write rpcs to meta tablet, pending writes are grouped into one rpc");
+DEFINE_int32(tera_master_meta_write_batch_rows, 1000, "the max number of rows grouped into one meta write rpc");
 //DEFINE_int32(tera_master_meta_retry_period, 1000, "the retry period (in ms) for master read/write meta" );
 DEFINE_bool(tera_master_meta_recovery_enabled, false, "whether recovery meta tablet at startup");
 DEFINE_string(tera_master_meta_recovery_file, "../data/meta.bak", "path of meta table recovery file");
@@ -97,6 +106,9 @@ DEFINE_int64(tera_master_merge_tablet_size, 0, "the size (in MB) of tablet to tr
 // deprecated
 DEFINE_int64(tera_master_merge_size_threshold, 10, "the size (in MB) of tablet to trigger merge");
 DEFINE_int64(tera_master_merge_timer_period, 180, "the actived time (in sec) for merge timer");
+DEFINE_bool(tera_master_load_split_enabled, false, "enable splitting tablets by access load");
+DEFINE_int64(tera_master_load_split_qps, 20000, "the rows (read + scan + write) per second of tablet to trigger load split");
+DEFINE_int64(tera_master_load_split_min_size, 64, "the min size (in MB) of tablet to be split by load");
 
 DEFINE_int32(tera_master_max_split_concurrency, 1, "the max concurrency of tabletnode for split tablet");
 DEFINE_int32(tera_master_max_load_concurrency, 5, "the max concurrency of tabletnode for load tablet");
@@ -106,6 +118,15 @@ DEFINE_bool(tera_master_load_balance_table_grained, true, "whether the load bala
 DEFINE_double(tera_safemode_tablet_locality_ratio, 0.9, "the tablet locality ratio threshold of safemode");
 DEFINE_double(tera_master_load_balance_size_overload_ratio, 1.2, "the overload ratio of data size to average size");
 DEFINE_bool(tera_master_move_tablet_enabled, true, "enable master to auto move tablet");
+DEFINE_bool(tera_master_move_prewarm_enabled, true, "enable master to prewarm tablet on the destination before unload it for move");
+DEFINE_bool(tera_master_cost_balance_enabled, false, "enable master to balance tabletnodes on read, write, scan, data size and cpu together");
+DEFINE_int32(tera_master_cost_balance_max_moves, 8, "the max number of tablets moved in one cost balance round");
+DEFINE_double(tera_master_cost_balance_min_gain, 0.05, "the min ratio of imbalance cost a move should reduce");
+DEFINE_double(tera_master_cost_balance_read_weight, 1.0, "the weight of read rows in cost balance");
+DEFINE_double(tera_master_cost_balance_write_weight, 1.0, "the weight of write size in cost balance");
+DEFINE_double(tera_master_cost_balance_scan_weight, 0.5, "the weight of scan size in cost balance");
+DEFINE_double(tera_master_cost_balance_size_weight, 1.0, "the weight of data size in cost balance");
+DEFINE_double(tera_master_cost_balance_cpu_weight, 1.0, "the weight of cpu usage in cost balance");
 DEFINE_int32(tera_master_load_slow_retry_times, 60, "the max retry times when master load very slow tablet");
 DEFINE_bool(tera_master_meta_isolate_enabled, false, "enable master to reserve a tabletnode for meta");
 
@@ -114,6 +135,7 @@ DEFINE_int32(tera_master_kick_tabletnode_query_fail_times, 10, "the number of qu
 DEFINE_int32(tera_master_control_tabletnode_retry_period, 60000, "the retry period (in ms) for master control tabletnode");
 DEFINE_int32(tera_master_load_rpc_timeout, 60000, "the timeout period (in ms) for load rpc");
 DEFINE_int32(tera_master_unload_rpc_timeout, 60000, "the timeout period (in ms) for unload rpc");
+DEFINE_int32(tera_master_prewarm_rpc_timeout, 60000, "the timeout period (in ms) for prewarm rpc");
 DEFINE_int32(tera_master_split_rpc_timeout, 120000, "the timeout period (in ms) for split rpc");
 DEFINE_int32(tera_master_tabletnode_timeout, 60000, "the timeout period (in ms) for move tablet after tabletnode down");
 DEFINE_int32(tera_master_collect_info_timeout, 3000, "the timeout period (in ms) for collect tabletnode info");
@@ -144,6 +166,8 @@ DEFINE_int32(tera_tabletnode_manual_compact_thread_num, 2, "the manual compact t
 DEFINE_int32(tera_tabletnode_impl_thread_min_num, 1, "the min thread number for tablet node impl operations");
 DEFINE_int32(tera_tabletnode_impl_thread_max_num, 10, "the max thread number for tablet node impl operations");
 DEFINE_int32(tera_tabletnode_compact_thread_num, 10, "the max thread number for leveldb compaction");
+DEFINE_int32(tera_tabletnode_compress_thread_num, 0, "the thread number to compress sstable blocks in parallel, 0 to compress inline");
+DEFINE_int32(tera_tabletnode_log_recover_thread_num, 4, "the thread number to read and replay log files in parallel when loading tablets, 0 to replay them one by one");
 
 DEFINE_int32(tera_tabletnode_connect_retry_times, 5, "the max retry times when connect to tablet node");
 DEFINE_int32(tera_tabletnode_connect_retry_period, 1000, "the retry period (in ms) between retry two tablet node connection");
@@ -152,15 +176,26 @@ DEFINE_string(tera_tabletnode_path_prefix, "../data/", "the path prefix for tabl
 DEFINE_int32(tera_tabletnode_block_cache_size, 100, "the cache size of tablet (in MB)");
 DEFINE_int32(tera_tabletnode_table_cache_size, 10000, "the table cache size, means the max num of files keeping open in this tabletnode.");
 DEFINE_int32(tera_tabletnode_scan_pack_max_size, 10240, "the max size(KB) of the package for scan rpc");
+DEFINE_int32(tera_tabletnode_scan_cursor_cache_num, 16, "the max number of iterators of paged scans cached in a tablet, 0 to disable");
+DEFINE_int64(tera_tabletnode_scan_cursor_cache_timeout, 10000, "the time (in ms) an iterator of a paged scan is cached waiting for the next page");
+DEFINE_int64(tera_tabletnode_negative_cache_size, 32768, "the max memory (in KB) of row keys known to be absent cached in all tablets of a tabletnode, 0 to disable");
 
 DEFINE_int32(tera_asyncwriter_pending_limit, 10000, "the max pending data size (KB) in async writer");
 DEFINE_bool(tera_enable_level0_limit, true, "enable level0 limit");
 DEFINE_int32(tera_tablet_level0_file_limit, 20, "the max level0 file num before write busy");
+DEFINE_int32(tera_tablet_level0_file_throttle, 10, "the level0 file num to start delaying writes");
+DEFINE_int64(tera_tablet_pending_compaction_throttle_size, 1024, "the pending compaction size (in MB) to start delaying writes");
+DEFINE_int64(tera_tablet_pending_compaction_limit_size, 4096, "the pending compaction size (in MB) at which write delay reaches max");
+DEFINE_int32(tera_tablet_max_write_delay, 100, "the max delay (in ms) injected before flushing a write batch, 0 to disable");
 DEFINE_int32(tera_asyncwriter_sync_interval, 100, "the interval (in ms) to sync write buffer to disk");
 DEFINE_int32(tera_asyncwriter_sync_size_threshold, 1024, "force sync per X KB");
 DEFINE_int32(tera_asyncwriter_batch_size, 1024, "write batch to leveldb per X KB");
 DEFINE_int32(tera_request_pending_limit, 100000, "the max read/write request pending");
 DEFINE_int32(tera_scan_request_pending_limit, 1000, "the max scan request pending");
+DEFINE_string(tera_tabletnode_rpc_schedule_policy, "fair", "the schedule policy of read/scan rpcs among tables: fair (by the schedule weight of tables) or deadline (earliest client deadline first)");
+DEFINE_bool(tera_tabletnode_rpc_work_stealing, true, "let idle read threads run pending scan rpcs and idle scan threads run pending read rpcs");
+DEFINE_int32(tera_tabletnode_rpc_steal_max_num, 2, "the max number of rpcs of the other pool a read or scan thread pool runs at the same time");
+DEFINE_bool(tera_tabletnode_rpc_drop_expired, true, "answer read/scan rpcs whose client timeout has passed with timeout instead of executing them");
 DEFINE_int32(tera_garbage_collect_period, 1800, "garbage collect period in s");
 
 DEFINE_int32(tera_tabletnode_write_meta_rpc_timeout, 60000, "the timeout period (in ms) for tabletnode write meta");
@@ -171,6 +206,11 @@ DEFINE_int32(tera_tabletnode_rpc_server_max_outflow, -1, "the max output flow (i
 
 DEFINE_bool(tera_tabletnode_cpu_affinity_enabled, false, "enable cpu affinity or not");
 DEFINE_string(tera_tabletnode_cpu_affinity_set, "1,2", "the cpu set of cpu affinity setting");
+DEFINE_string(tera_tabletnode_write_thread_cpu_set, "", "the cpus (e.g. 0-7,16-23) to bind write threads to, empty for no binding");
+DEFINE_string(tera_tabletnode_read_thread_cpu_set, "", "the cpus (e.g. 0-7,16-23) to bind read threads to, empty for no binding");
+DEFINE_string(tera_tabletnode_scan_thread_cpu_set, "", "the cpus (e.g. 0-7,16-23) to bind scan threads to, empty for no binding");
+DEFINE_string(tera_tabletnode_compact_thread_cpu_set, "", "the cpus (e.g. 0-7,16-23) to bind compaction threads to, both the leveldb background threads and the manual compact threads, empty for no binding");
+DEFINE_string(tera_tabletnode_writer_cpu_set, "", "the cpus (e.g. 0-7,16-23) to bind tablet writer threads to, empty for no binding");
 DEFINE_bool(tera_tabletnode_hang_detect_enabled, false, "enable detect read/write hang");
 DEFINE_int32(tera_tabletnode_hang_detect_threshold, 60000, "read/write hang detect threshold (in ms)");
 
@@ -181,10 +221,12 @@ DEFINE_string(tera_tabletnode_cache_name, "tera.cache", "prefix name for cache n
 DEFINE_int32(tera_tabletnode_cache_mem_size, 2048, "the maximal size (in KB) of mem cache");
 DEFINE_int32(tera_tabletnode_cache_disk_size, 1024, "the maximal size (in MB) of disk cache");
 DEFINE_int32(tera_tabletnode_cache_disk_filenum, 1, "the file num of disk cache storage");
+DEFINE_bool(tera_tabletnode_cache_disk_persistent, false, "keep disk cache and its block index across tabletnode restarts");
 DEFINE_int32(tera_tabletnode_cache_log_level, 1, "the log level [0 - 5] for cache system (0: FATAL, 1: ERROR, 2: WARN, 3: INFO, 5: DEBUG).");
 
 DEFINE_bool(tera_tabletnode_tcm_cache_release_enabled, true, "enable the timer to release tcmalloc cache");
 DEFINE_int32(tera_tabletnode_tcm_cache_release_period, 180, "the period (in sec) to try release tcmalloc cache");
+DEFINE_int32(tera_tabletnode_prewarm_expire_period, 600, "the period (in sec) to keep a prewarmed tablet waiting for its load");
 
 ///////// SDK  /////////
 DEFINE_string(tera_sdk_impl_type, "tera", "the activated type of SDK impl");
@@ -226,5 +268,7 @@ DEFINE_int32(tera_sdk_cookie_update_interval, 600, "the interval of cookie updat
 
 DEFINE_int64(tera_sdk_scan_async_cache_size, 16, "the max buffer size (in MB) for cached scan results");
 DEFINE_int32(tera_sdk_scan_async_parallel_max_num, 500, "the max number of concurrent task sending");
+DEFINE_bool(tera_sdk_read_coalescing_enabled, true, "send identical readers buffered for the same tabletnode only once");
+DEFINE_int64(tera_sdk_bulk_load_buffer_size, 256, "the max buffer size (in MB) of cells sorted in memory before written to a file in bulk load");
 
 DEFINE_bool(tera_sdk_pend_request_while_scan_meta_enabled, true, "pend request util meta-scan operation finished");
@@ -18,10 +18,12 @@
 #include "common/base/string_number.h"
 #include "common/file/file_path.h"
 #include "io/coding.h"
+#include "io/utils_leveldb.h"
 #include "proto/kv_helper.h"
 #include "proto/proto_helper.h"
 #include "proto/tabletnode.pb.h"
 #include "proto/tabletnode_client.h"
+#include "sdk/bulk_load.h"
 #include "sdk/client_impl.h"
 #include "sdk/sdk_utils.h"
 #include "sdk/sdk_zk.h"
@@ -34,6 +36,7 @@
 
 DECLARE_string(flagfile);
 DECLARE_string(log_dir);
+DECLARE_string(tera_leveldb_env_type);
 DECLARE_string(tera_master_meta_table_name);
 DECLARE_string(tera_zk_addr_list);
 DECLARE_string(tera_zk_root_path);
@@ -112,6 +115,10 @@ void Usage(const std::string& prg_name) {
                                                                             \n\
        batchget <tablename> <input file>                                    \n\
                                                                             \n\
+       bulkload <tablename> <input file> <work dir>                         \n\
+                load the input file of batchput format by building sst      \n\
+                files in work dir (relative to tabletnode path prefix).     \n\
+                                                                            \n\
        show[x]  [<tablename>]                                               \n\
                 show table list or tablets info.                            \n\
                 (show more detail when using suffix \"x\")                  \n\
@@ -725,17 +732,17 @@ int32_t ShowTabletList(const TabletMetaList& tablet_list, bool is_server_addr, b
     std::vector<string> row;
     if (is_x) {
         if (is_server_addr) {
-            cols = 14;
+            cols = 15;
             printer.Reset(cols);
             printer.AddRow(cols,
                            " ", "server_addr", "path", "status", "size",
-                           "isbusy", "lread", "read", "rspeed", "write",
+                           "isbusy", "wdelay", "lread", "read", "rspeed", "write",
                            "wspeed", "scan", "sspeed", "startkey");
         } else {
-            cols = 13;
+            cols = 14;
             printer.Reset(cols);
             printer.AddRow(cols,
-                           " ", "path", "status", "size", "isbusy",
+                           " ", "path", "status", "size", "isbusy", "wdelay",
                            "lread", "read", "rspeed", "write", "wspeed",
                            "scan", "sspeed", "startkey");
         }
@@ -758,6 +765,12 @@ int32_t ShowTabletList(const TabletMetaList& tablet_list, bool is_server_addr, b
                 } else {
                     row.push_back("false");
                 }
+                if (counter.write_delay() > 0) {
+                    row.push_back(NumberToString(counter.write_delay() / 1000) + "ms("
+                                  + counter.write_delay_reason() + ")");
+                } else {
+                    row.push_back("-");
+                }
                 row.push_back(NumberToString(counter.low_read_cell()));
                 row.push_back(NumberToString(counter.read_rows()));
                 row.push_back(utils::ConvertByteToString(counter.read_size()) + "B/s");
@@ -1196,6 +1209,63 @@ int32_t BatchPutOp(Client* client, int32_t argc, char** argv, ErrorCode* err) {
     return 0;
 }
 
+int32_t BulkLoadOp(Client* client, int32_t argc, char** argv, ErrorCode* err) {
+    if (argc != 5) {
+        LOG(ERROR) << "args number error: " << argc << ", need 5.";
+        Usage(argv[0]);
+        return -1;
+    }
+
+    std::string tablename = argv[2];
+    std::string record_file = argv[3];
+    std::string work_dir = argv[4];
+    if (FLAGS_tera_leveldb_env_type != "local") {
+        io::InitDfsEnv();
+    }
+    tera::ClientImpl* client_impl = static_cast<tera::ClientImpl*>(client);
+    BulkLoader loader(client_impl, tablename, work_dir, io::LeveldbEnv());
+    if (!loader.Init(err)) {
+        LOG(ERROR) << "fail to init bulk load";
+        return -1;
+    }
+    const int32_t buf_size = 1024 * 1024;
+    char buf[buf_size];
+    std::ifstream stream(record_file.c_str());
+
+    // the same format as batchput: rowkey columnfamily:qualifier value
+    // or: key value
+    std::vector<std::string> input_v;
+    g_start_time = time(NULL);
+    while (stream.getline(buf, buf_size)) {
+        SplitString(buf, " ", &input_v);
+        if (input_v.size() != 3 && input_v.size() != 2) {
+            LOG(ERROR) << "input file format error, skip it: " << buf;
+            continue;
+        }
+        std::string family;
+        std::string qualifier;
+        if (input_v.size() == 3) {
+            ParseCfQualifier(input_v[1], &family, &qualifier);
+        }
+        if (!loader.Put(input_v[0], family, qualifier, -1,
+                        input_v[input_v.size() - 1], err)) {
+            LOG(ERROR) << "fail to bulk load: " << buf;
+            return -1;
+        }
+        g_key_num++;
+    }
+    if (!loader.Finish(err)) {
+        LOG(ERROR) << "fail to finish bulk load";
+        return -1;
+    }
+
+    g_end_time = time(NULL);
+    g_used_time = g_end_time - g_start_time;
+    LOG(INFO) << "Bulk load done, key_num=" << g_key_num << " file_num="
+        << loader.GetFileNum() << " used_time=" << g_used_time;
+    return 0;
+}
+
 void BatchGetCallBack(RowReader* reader) {
     while (!reader->Done()) {
         {
@@ -1774,6 +1844,8 @@ int main(int argc, char* argv[]) {
         ret = DeleteOp(client, argc, argv, &error_code);
     } else if (cmd == "batchput") {
         ret = BatchPutOp(client, argc, argv, &error_code);
+    } else if (cmd == "bulkload") {
+        ret = BulkLoadOp(client, argc, argv, &error_code);
     } else if (cmd == "batchget") {
         ret = BatchGetOp(client, argc, argv, &error_code);
     } else if (cmd == "scan" || cmd == "scanallv") {
@@ -0,0 +1,99 @@
+// Copyright (c) 2015, Baidu.com, Inc. All Rights Reserved
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "utils/cpu_affinity.h"
+
+#include <boost/bind.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include "common/base/string_ext.h"
+#include "common/base/string_number.h"
+#include "common/mutex.h"
+#include "common/thread_attributes.h"
+#include "glog/logging.h"
+
+namespace tera {
+namespace utils {
+
+bool ParseCpuSet(const std::string& cpu_set, std::vector<int32_t>* cpu_list) {
+    std::vector<std::string> items;
+    SplitString(cpu_set, ",", &items);
+    for (size_t i = 0; i < items.size(); ++i) {
+        std::vector<std::string> range;
+        SplitString(items[i], "-", &range);
+        int32_t first = 0;
+        int32_t last = 0;
+        if (range.size() == 1 && StringToNumber(range[0], &first)) {
+            last = first;
+        } else if (range.size() != 2 || !StringToNumber(range[0], &first)
+                   || !StringToNumber(range[1], &last) || first > last) {
+            return false;
+        }
+        for (int32_t cpu_id = first; cpu_id <= last; ++cpu_id) {
+            cpu_list->push_back(cpu_id);
+        }
+    }
+    return !cpu_list->empty();
+}
+
+bool SetThreadCpuAffinity(const std::string& cpu_set) {
+    if (cpu_set.empty()) {
+        return true;
+    }
+    std::vector<int32_t> cpu_list;
+    if (!ParseCpuSet(cpu_set, &cpu_list)) {
+        LOG(ERROR) << "invalid cpu set: " << cpu_set;
+        return false;
+    }
+    ThreadAttributes thread_attr;
+    thread_attr.ResetCpuMask();
+    for (size_t i = 0; i < cpu_list.size(); ++i) {
+        thread_attr.SetCpuMask(cpu_list[i]);
+    }
+    if (!thread_attr.SetCpuAffinity()) {
+        LOG(ERROR) << "fail to set cpu affinity: " << cpu_set;
+        return false;
+    }
+    return true;
+}
+
+namespace {
+
+struct ThreadBarrier {
+    Mutex mutex;
+    CondVar cond;
+    int32_t waiting_num;
+
+    explicit ThreadBarrier(int32_t num) : cond(&mutex), waiting_num(num) {}
+};
+
+// keep the thread until every thread of the pool gets one of these tasks
+void SetPoolThreadCpuAffinity(const std::string& cpu_set,
+                              boost::shared_ptr<ThreadBarrier> barrier) {
+    SetThreadCpuAffinity(cpu_set);
+    MutexLock lock(&barrier->mutex);
+    if (--barrier->waiting_num == 0) {
+        barrier->cond.Broadcast();
+    }
+    while (barrier->waiting_num > 0) {
+        barrier->cond.Wait();
+    }
+}
+
+} // namespace
+
+void SetThreadPoolCpuAffinity(common::ThreadPool* thread_pool, int32_t thread_num,
+                              const std::string& cpu_set) {
+    if (cpu_set.empty()) {
+        return;
+    }
+    boost::shared_ptr<ThreadBarrier> barrier(new ThreadBarrier(thread_num));
+    for (int32_t i = 0; i < thread_num; ++i) {
+        thread_pool->AddTask(boost::bind(&SetPoolThreadCpuAffinity, cpu_set, barrier));
+    }
+    LOG(INFO) << "bind " << thread_num << " threads to cpu: " << cpu_set;
+}
+
+} // namespace utils
+} // namespace tera
@@ -0,0 +1,32 @@
+// Copyright (c) 2015, Baidu.com, Inc. All Rights Reserved
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef TERA_UTILS_CPU_AFFINITY_H_
+#define TERA_UTILS_CPU_AFFINITY_H_
+
+#include <string>
+#include <vector>
+
+#include "common/base/stdint.h"
+#include "common/thread_pool.h"
+
+namespace tera {
+namespace utils {
+
+// parse a cpu set like "0,2,8-15"
+bool ParseCpuSet(const std::string& cpu_set, std::vector<int32_t>* cpu_list);
+
+// bind the calling thread to the cpus of "cpu_set", an empty set
+// leaves the thread as it is
+bool SetThreadCpuAffinity(const std::string& cpu_set);
+
+// bind every thread of "thread_pool", which has "thread_num" threads and
+// no task yet, to the cpus of "cpu_set"
+void SetThreadPoolCpuAffinity(common::ThreadPool* thread_pool, int32_t thread_num,
+                              const std::string& cpu_set);
+
+} // namespace utils
+} // namespace tera
+
+#endif // TERA_UTILS_CPU_AFFINITY_H_
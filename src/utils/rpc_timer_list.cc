@@ -6,56 +6,74 @@
 
 namespace tera {
 
-RpcTimerList::RpcTimerList()
-    : m_head(NULL), m_tail(NULL), m_size(0) {}
+RpcTimerList::RpcTimerList() {}
 
 RpcTimerList::~RpcTimerList() {}
 
 bool RpcTimerList::TopTime(int64_t* time) {
-    MutexLock lock(&m_mutex);
-    if (NULL == m_head) {
-        return false;
+    bool found = false;
+    for (size_t i = 0; i < kShardNum; ++i) {
+        Shard* shard = &m_shards[i];
+        MutexLock lock(&shard->mutex);
+        if (NULL != shard->head && (!found || shard->head->time < *time)) {
+            *time = shard->head->time;
+            found = true;
+        }
     }
-    *time = m_head->time;
-    return true;
+    return found;
 }
 
 void RpcTimerList::Push(RpcTimer* item) {
-    MutexLock lock(&m_mutex);
-    item->prev = m_tail;
+    Shard* shard = GetShard(item);
+    MutexLock lock(&shard->mutex);
+    item->prev = shard->tail;
     item->next = NULL;
-    if (NULL != m_tail) {
-        m_tail->next = item;
+    if (NULL != shard->tail) {
+        shard->tail->next = item;
     }
-    m_tail = item;
-    if (NULL == m_head) {
-        m_head = item;
+    shard->tail = item;
+    if (NULL == shard->head) {
+        shard->head = item;
     }
-    m_size++;
+    shard->size++;
 }
 
 void RpcTimerList::Erase(RpcTimer* item) {
-    MutexLock lock(&m_mutex);
+    Shard* shard = GetShard(item);
+    MutexLock lock(&shard->mutex);
     if (NULL != item->prev) {
         item->prev->next = item->next;
     }
     if (NULL != item->next) {
         item->next->prev = item->prev;
     }
-    if (m_head == item) {
-        m_head = item->next;
+    if (shard->head == item) {
+        shard->head = item->next;
     }
-    if (m_tail == item) {
-        m_tail = item->prev;
+    if (shard->tail == item) {
+        shard->tail = item->prev;
     }
     item->prev = NULL;
     item->next = NULL;
-    m_size--;
+    shard->size--;
 }
 
 size_t RpcTimerList::Size() {
-    MutexLock lock(&m_mutex);
-    return m_size;
+    size_t size = 0;
+    for (size_t i = 0; i < kShardNum; ++i) {
+        MutexLock lock(&m_shards[i].mutex);
+        size += m_shards[i].size;
+    }
+    return size;
+}
+
+RpcTimerList::Shard* RpcTimerList::GetShard(RpcTimer* item) {
+    // timers of the same size come from the same allocator size class,
+    // so their addresses share a stride; a multiplicative hash spreads
+    // them over all shards
+    uint64_t addr = reinterpret_cast<uint64_t>(item);
+    uint64_t hash = (addr >> 6) * 0x9E3779B97F4A7C15ULL;
+    return &m_shards[hash >> (64 - kShardBits)];
 }
 
 RpcTimerList* RpcTimerList::Instance() {
@@ -46,6 +46,9 @@ struct SpecRpcTimer : public RpcTimer {
 typedef SpecRpcTimer<WriteTabletRequest, WriteTabletResponse> WriteRpcTimer;
 typedef SpecRpcTimer<ReadTabletRequest, ReadTabletResponse> ReadRpcTimer;
 
+// Pending rpcs in the order they arrive, for hang detection. Timers are
+// spread over shards by their address, each shard is a list with its own
+// lock, so that rpc threads do not contend on a single lock.
 class RpcTimerList {
 public:
     RpcTimerList();
@@ -53,6 +56,7 @@ public:
 
     static RpcTimerList* Instance();
 
+    // the time of the oldest pending rpc
     bool TopTime(int64_t* time);
 
     void Push(RpcTimer* item);
@@ -62,10 +66,25 @@ public:
     size_t Size();
 
 private:
-    mutable Mutex m_mutex;
-    RpcTimer* m_head;
-    RpcTimer* m_tail;
-    size_t m_size;
+    static const size_t kCacheLineSize = 64;
+    static const size_t kShardBits = 4;
+    static const size_t kShardNum = 1 << kShardBits;
+
+    // padded so that the fields of neighbouring shards never share a cache
+    // line, wherever the list is allocated
+    struct Shard {
+        mutable Mutex mutex;
+        RpcTimer* head;
+        RpcTimer* tail;
+        size_t size;
+        char padding[kCacheLineSize];
+
+        Shard() : head(NULL), tail(NULL), size(0) {}
+    };
+
+    Shard* GetShard(RpcTimer* item);
+
+    Shard m_shards[kShardNum];
     static RpcTimerList* s_instance;
 };
 
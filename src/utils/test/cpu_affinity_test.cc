@@ -0,0 +1,34 @@
+// Copyright (c) 2015, Baidu.com, Inc. All Rights Reserved
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "gtest/gtest.h"
+
+#include "utils/cpu_affinity.h"
+
+namespace tera {
+namespace utils {
+
+TEST(CpuAffinityTest, ParseCpuSet) {
+    std::vector<int32_t> cpu_list;
+    EXPECT_TRUE(ParseCpuSet("1,3", &cpu_list));
+    ASSERT_EQ(cpu_list.size(), 2U);
+    EXPECT_EQ(cpu_list[0], 1);
+    EXPECT_EQ(cpu_list[1], 3);
+
+    cpu_list.clear();
+    EXPECT_TRUE(ParseCpuSet("0-3,8", &cpu_list));
+    ASSERT_EQ(cpu_list.size(), 5U);
+    EXPECT_EQ(cpu_list[3], 3);
+    EXPECT_EQ(cpu_list[4], 8);
+
+    cpu_list.clear();
+    EXPECT_FALSE(ParseCpuSet("", &cpu_list));
+    cpu_list.clear();
+    EXPECT_FALSE(ParseCpuSet("3-1", &cpu_list));
+    cpu_list.clear();
+    EXPECT_FALSE(ParseCpuSet("a,1", &cpu_list));
+}
+
+} // namespace utils
+} // namespace tera
@@ -0,0 +1,76 @@
+// Copyright (c) 2015, Baidu.com, Inc. All Rights Reserved
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <new>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#define private public
+#include "utils/rpc_timer_list.h"
+
+namespace tera {
+
+TEST(RpcTimerListTest, TopTime) {
+    RpcTimerList timer_list;
+    int64_t time = 0;
+    EXPECT_FALSE(timer_list.TopTime(&time));
+
+    std::vector<RpcTimer*> timers;
+    for (int64_t i = 0; i < 100; ++i) {
+        RpcTimer* timer = new RpcTimer(1000 + i);
+        timers.push_back(timer);
+        timer_list.Push(timer);
+    }
+    EXPECT_EQ(timer_list.Size(), 100U);
+    EXPECT_TRUE(timer_list.TopTime(&time));
+    EXPECT_EQ(time, 1000);
+
+    // the oldest ones finish
+    for (int64_t i = 0; i < 50; ++i) {
+        timer_list.Erase(timers[i]);
+    }
+    EXPECT_EQ(timer_list.Size(), 50U);
+    EXPECT_TRUE(timer_list.TopTime(&time));
+    EXPECT_EQ(time, 1050);
+
+    // finish out of order
+    for (int64_t i = 99; i >= 50; --i) {
+        timer_list.Erase(timers[i]);
+        if (i > 50) {
+            EXPECT_TRUE(timer_list.TopTime(&time));
+            EXPECT_EQ(time, 1050);
+        }
+    }
+    EXPECT_EQ(timer_list.Size(), 0U);
+    EXPECT_FALSE(timer_list.TopTime(&time));
+
+    for (size_t i = 0; i < timers.size(); ++i) {
+        delete timers[i];
+    }
+}
+
+TEST(RpcTimerListTest, SpreadOverShards) {
+    RpcTimerList timer_list;
+    // timers a page apart, like those of a large allocator size class
+    const size_t kStride = 4096;
+    const size_t kTimerNum = 8 * RpcTimerList::kShardNum;
+    std::vector<char> buffer(kStride * kTimerNum);
+    std::vector<RpcTimer*> timers;
+    for (size_t i = 0; i < kTimerNum; ++i) {
+        RpcTimer* timer = new (&buffer[i * kStride]) RpcTimer(i);
+        timers.push_back(timer);
+        timer_list.Push(timer);
+    }
+    for (size_t i = 0; i < RpcTimerList::kShardNum; ++i) {
+        EXPECT_GT(timer_list.m_shards[i].size, 0U);
+    }
+    for (size_t i = 0; i < timers.size(); ++i) {
+        timer_list.Erase(timers[i]);
+        timers[i]->~RpcTimer();
+    }
+    EXPECT_EQ(timer_list.Size(), 0U);
+}
+
+} // namespace tera